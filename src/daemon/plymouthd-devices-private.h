@@ -50,6 +50,7 @@ PLY_PRIVATE plymouthd_devices_t *plymouthd_devices_new (const char
                                                         ply_device_manager_flags_t                flags,
                                                         xkb_keysym_t                              extra_escape_key,
                                                         double                                    device_timeout,
+                                                        const char                               *headless_heads,
                                                         const plymouthd_devices_event_handlers_t *event_handlers,
                                                         void                                     *event_user_data);
 PLY_PRIVATE bool plymouthd_devices_has_displays (plymouthd_devices_t *devices);
@@ -293,6 +293,7 @@ plymouthd_devices_new (const char                               *default_tty,
                        ply_device_manager_flags_t                flags,
                        xkb_keysym_t                              extra_escape_key,
                        double                                    device_timeout,
+                       const char                               *headless_heads,
                        const plymouthd_devices_event_handlers_t *event_handlers,
                        void                                     *event_user_data)
 {
@@ -306,6 +307,8 @@ plymouthd_devices_new (const char                               *default_tty,
                                                           extra_escape_key);
         devices->local_console_terminal =
                 ply_device_manager_get_default_terminal (devices->device_manager);
+        ply_device_manager_use_headless_renderer (devices->device_manager,
+                                                  headless_heads);
 
         ply_device_manager_watch_devices (
                 devices->device_manager,
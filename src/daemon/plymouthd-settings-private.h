@@ -26,6 +26,7 @@ PLY_PRIVATE double plymouthd_settings_get_device_timeout (const plymouthd_settin
 PLY_PRIVATE int plymouthd_settings_get_device_scale (const plymouthd_settings_t *settings);
 PLY_PRIVATE xkb_keysym_t plymouthd_settings_get_extra_escape_key (const plymouthd_settings_t *settings);
 PLY_PRIVATE int plymouthd_settings_get_use_simpledrm (const plymouthd_settings_t *settings);
+PLY_PRIVATE const char *plymouthd_settings_get_headless_heads (const plymouthd_settings_t *settings);
 PLY_PRIVATE const char *plymouthd_settings_get_override_splash_path (const plymouthd_settings_t *settings);
 PLY_PRIVATE const char *plymouthd_settings_get_system_default_splash_path (const plymouthd_settings_t *settings);
 PLY_PRIVATE const char *plymouthd_settings_get_distribution_default_splash_path (const plymouthd_settings_t *settings);
@@ -26,6 +26,7 @@ struct _plymouthd_settings
         int          device_scale;
         xkb_keysym_t extra_esc_key;
         int          use_simpledrm;
+        char        *headless_heads;
 
         char        *override_splash_path;
         char        *system_default_splash_path;
@@ -77,6 +78,7 @@ plymouthd_settings_free (plymouthd_settings_t *settings)
                 return;
 
         clear_settings (settings);
+        free (settings->headless_heads);
         free (settings);
 }
 
@@ -110,6 +112,12 @@ plymouthd_settings_get_use_simpledrm (const plymouthd_settings_t *settings)
         return settings->use_simpledrm;
 }
 
+const char *
+plymouthd_settings_get_headless_heads (const plymouthd_settings_t *settings)
+{
+        return settings->headless_heads;
+}
+
 const char *
 plymouthd_settings_get_override_splash_path (const plymouthd_settings_t *settings)
 {
@@ -187,6 +195,14 @@ plymouthd_settings_apply_config_file (plymouthd_settings_t *settings,
                                                                   XKB_KEY_NoSymbol);
         }
 
+        if (settings->headless_heads == NULL) {
+                settings->headless_heads = ply_key_file_get_value (key_file,
+                                                                   "Daemon",
+                                                                   "HeadlessRenderer");
+                if (settings->headless_heads != NULL)
+                        ply_trace ("Rendering headless to '%s'", settings->headless_heads);
+        }
+
         /*
          * Check the special UseSimpledrmNoLuks config file keyword this enables
          * simpledrm use except when using LUKS. Showing the LUKS unlock screen
@@ -157,6 +157,7 @@ create_devices (plymouthd_t *daemon,
                 flags,
                 plymouthd_settings_get_extra_escape_key (daemon->settings),
                 plymouthd_settings_get_device_timeout (daemon->settings),
+                plymouthd_settings_get_headless_heads (daemon->settings),
                 &device_event_handlers,
                 daemon);
 
@@ -37,6 +37,7 @@
 #include <xkbcommon/xkbcommon.h>
 
 #include "ply-active-console-private.h"
+#include "ply-device-probe-queue-private.h"
 #include "ply-logger.h"
 #include "ply-event-loop.h"
 #include "ply-hashtable.h"
@@ -51,6 +52,11 @@
 
 #ifdef HAVE_UDEV
 static void create_devices_from_udev (ply_device_manager_t *manager);
+static void queue_device_for_probing (ply_device_manager_t *manager,
+                                      struct udev_device   *device);
+static void probe_queued_device (ply_device_manager_t *manager,
+                                 struct udev_device   *device);
+static void unref_queued_device (void *device);
 #endif
 
 static bool create_devices_for_terminal_and_renderer_type (ply_device_manager_t *manager,
@@ -59,6 +65,8 @@ static bool create_devices_for_terminal_and_renderer_type (ply_device_manager_t
                                                            ply_renderer_type_t   renderer_type);
 static void create_pixel_displays_for_renderer (ply_device_manager_t *manager,
                                                 ply_renderer_t       *renderer);
+static void update_pixel_displays_for_renderer (ply_device_manager_t *manager,
+                                                ply_renderer_t       *renderer);
 
 struct _ply_device_manager
 {
@@ -75,12 +83,15 @@ struct _ply_device_manager
         struct udev                        *udev_context;
         struct udev_monitor                *udev_monitor;
         ply_fd_watch_t                     *fd_watch;
+        ply_device_probe_queue_t           *probe_queue;
 
         struct xkb_context                 *xkb_context;
         struct xkb_keymap                  *xkb_keymap;
         struct xkb_state                   *xkb_state;
         xkb_keysym_t                        extra_esc_key;
 
+        char                               *headless_device_name;
+
         ply_keyboard_added_handler_t        keyboard_added_handler;
         ply_keyboard_removed_handler_t      keyboard_removed_handler;
         ply_pixel_display_added_handler_t   pixel_display_added_handler;
@@ -124,6 +135,16 @@ attach_to_event_loop (ply_device_manager_t *manager,
                                        manager);
 }
 
+static bool
+device_is_managed (ply_device_manager_t *manager,
+                   const char           *device_name)
+{
+        if (device_name == NULL)
+                return false;
+
+        return ply_hashtable_lookup (manager->renderers, (void *) device_name) != NULL;
+}
+
 static void
 free_displays_for_renderer (ply_device_manager_t *manager,
                             ply_renderer_t       *renderer)
@@ -283,17 +304,6 @@ remove_input_device_from_renderers (ply_device_manager_t *manager,
 }
 
 #ifdef HAVE_UDEV
-static bool
-drm_device_in_use (ply_device_manager_t *manager,
-                   const char           *device_path)
-{
-        ply_renderer_t *renderer;
-
-        renderer = ply_hashtable_lookup (manager->renderers, (void *) device_path);
-
-        return renderer != NULL;
-}
-
 static bool
 fb_device_has_drm_device (ply_device_manager_t *manager,
                           struct udev_device   *fb_device)
@@ -328,7 +338,7 @@ fb_device_has_drm_device (ply_device_manager_t *manager,
                 card_path = udev_list_entry_get_name (card_entry);
                 card_device = udev_device_new_from_syspath (manager->udev_context, card_path);
                 card_node = udev_device_get_devnode (card_device);
-                if (card_node != NULL && drm_device_in_use (manager, card_node))
+                if (card_node != NULL && device_is_managed (manager, card_node))
                         has_drm_device = true;
                 else
                         ply_trace ("no card node!");
@@ -506,7 +516,14 @@ create_devices_for_subsystem (ply_device_manager_t *manager,
                         node = udev_device_get_devnode (device);
                         if (node != NULL) {
                                 ply_trace ("found node %s", node);
-                                create_devices_for_udev_device (manager, device);
+
+                                /* Graphics devices can take a while to open,
+                                 * so they're opened one per event loop turn
+                                 */
+                                if (strcmp (subsystem, SUBSYSTEM_INPUT) == 0)
+                                        create_devices_for_udev_device (manager, device);
+                                else
+                                        queue_device_for_probing (manager, device);
                         }
                 } else {
                         ply_trace ("it's not initialized");
@@ -542,10 +559,8 @@ on_drm_udev_add_or_change (ply_device_manager_t *manager,
                 return;
 
         changed = ply_renderer_handle_change_event (renderer);
-        if (changed) {
-                free_displays_for_renderer (manager, renderer);
-                create_pixel_displays_for_renderer (manager, renderer);
-        }
+        if (changed)
+                update_pixel_displays_for_renderer (manager, renderer);
 }
 
 static bool
@@ -646,6 +661,8 @@ on_udev_event (ply_device_manager_t *manager)
                  */
                 if (strcmp (action, "remove") == 0) {
                         process_udev_add_or_change_events (manager, pending_events);
+                        if (ply_device_probe_queue_remove (manager->probe_queue, device_path))
+                                ply_trace ("dropping %s before it was probed", device_path);
                         free_devices_from_device_path (manager, device_path, true);
                         goto unref;
                 }
@@ -923,6 +940,14 @@ ply_device_manager_new (const char                *default_tty,
 
         attach_to_event_loop (manager, ply_event_loop_get_default ());
 
+#ifdef HAVE_UDEV
+        manager->probe_queue = ply_device_probe_queue_new (manager->loop,
+                                                           (ply_device_probe_handler_t)
+                                                           probe_queued_device,
+                                                           unref_queued_device,
+                                                           manager);
+#endif
+
         return manager;
 }
 
@@ -960,6 +985,8 @@ ply_device_manager_free (ply_device_manager_t *manager)
                                                   (ply_event_loop_timeout_handler_t)
                                                   create_devices_from_udev, manager);
 
+        ply_device_probe_queue_free (manager->probe_queue);
+
         if (manager->udev_monitor != NULL)
                 udev_monitor_unref (manager->udev_monitor);
 
@@ -967,9 +994,26 @@ ply_device_manager_free (ply_device_manager_t *manager)
                 udev_unref (manager->udev_context);
 #endif
 
+        free (manager->headless_device_name);
         free (manager);
 }
 
+void
+ply_device_manager_use_headless_renderer (ply_device_manager_t *manager,
+                                          const char           *head_descriptions)
+{
+        free (manager->headless_device_name);
+        manager->headless_device_name = NULL;
+
+        if (head_descriptions == NULL)
+                return;
+
+        if (head_descriptions[0] == '\0')
+                manager->headless_device_name = strdup ("headless");
+        else
+                asprintf (&manager->headless_device_name, "headless:%s", head_descriptions);
+}
+
 static bool
 add_consoles_from_file (ply_device_manager_t *manager,
                         const char           *path)
@@ -1002,6 +1046,21 @@ add_consoles_from_file (ply_device_manager_t *manager,
         return has_serial_consoles;
 }
 
+static void
+add_pixel_display_for_head (ply_device_manager_t *manager,
+                            ply_renderer_t       *renderer,
+                            ply_renderer_head_t  *head)
+{
+        ply_pixel_display_t *display;
+
+        display = ply_pixel_display_new (renderer, head);
+
+        ply_list_append_data (manager->pixel_displays, display);
+
+        if (manager->pixel_display_added_handler != NULL)
+                manager->pixel_display_added_handler (manager->event_handler_data, display);
+}
+
 static void
 create_pixel_displays_for_renderer (ply_device_manager_t *manager,
                                     ply_renderer_t       *renderer)
@@ -1018,19 +1077,110 @@ create_pixel_displays_for_renderer (ply_device_manager_t *manager,
         while (node != NULL) {
                 ply_list_node_t *next_node;
                 ply_renderer_head_t *head;
-                ply_pixel_display_t *display;
 
                 head = ply_list_node_get_data (node);
                 next_node = ply_list_get_next_node (heads, node);
 
-                display = ply_pixel_display_new (renderer, head);
+                add_pixel_display_for_head (manager, renderer, head);
+                node = next_node;
+        }
+}
+
+static bool
+pixel_display_matches_head (ply_pixel_display_t *display,
+                            ply_renderer_t      *renderer,
+                            ply_renderer_head_t *head)
+{
+        ply_pixel_buffer_t *pixel_buffer;
+        ply_rectangle_t size;
+
+        pixel_buffer = ply_renderer_get_buffer_for_head (renderer, head);
+        if (pixel_buffer == NULL)
+                return false;
+
+        ply_pixel_buffer_get_size (pixel_buffer, &size);
+
+        return ply_pixel_display_get_width (display) == size.width &&
+               ply_pixel_display_get_height (display) == size.height &&
+               ply_pixel_display_get_device_scale (display) == ply_pixel_buffer_get_device_scale (pixel_buffer);
+}
+
+static ply_pixel_display_t *
+find_pixel_display_for_head (ply_device_manager_t *manager,
+                             ply_renderer_t       *renderer,
+                             ply_renderer_head_t  *head)
+{
+        ply_list_node_t *node;
+
+        ply_list_foreach (manager->pixel_displays, node) {
+                ply_pixel_display_t *display = ply_list_node_get_data (node);
+
+                if (ply_pixel_display_get_renderer (display) == renderer &&
+                    ply_pixel_display_get_renderer_head (display) == head)
+                        return display;
+        }
+
+        return NULL;
+}
+
+/* Only replaces the displays whose heads went away or changed shape, so
+ * plugging in a monitor doesn't make the splash rebuild every view.
+ */
+static void
+update_pixel_displays_for_renderer (ply_device_manager_t *manager,
+                                    ply_renderer_t       *renderer)
+{
+        ply_list_t *heads;
+        ply_list_node_t *node;
+
+        heads = ply_renderer_get_heads (renderer);
+
+        node = ply_list_get_first_node (manager->pixel_displays);
+        while (node != NULL) {
+                ply_list_node_t *next_node;
+                ply_pixel_display_t *display;
+                ply_renderer_head_t *head;
+
+                display = ply_list_node_get_data (node);
+                next_node = ply_list_get_next_node (manager->pixel_displays, node);
+                head = ply_pixel_display_get_renderer_head (display);
+
+                if (ply_pixel_display_get_renderer (display) != renderer) {
+                        node = next_node;
+                        continue;
+                }
+
+                if (ply_list_find_node (heads, head) != NULL &&
+                    pixel_display_matches_head (display, renderer, head)) {
+                        /* A head that got replaced by an identical one can
+                         * land at the same address with an empty buffer,
+                         * so have the splash repaint what it already has
+                         */
+                        ply_pixel_display_draw_area (display, 0, 0,
+                                                     ply_pixel_display_get_width (display),
+                                                     ply_pixel_display_get_height (display));
+                        node = next_node;
+                        continue;
+                }
 
-                ply_list_append_data (manager->pixel_displays, display);
+                ply_trace ("Removing display for head that went away or changed");
+                if (manager->pixel_display_removed_handler != NULL)
+                        manager->pixel_display_removed_handler (manager->event_handler_data, display);
+                ply_pixel_display_free (display);
+                ply_list_remove_node (manager->pixel_displays, node);
 
-                if (manager->pixel_display_added_handler != NULL)
-                        manager->pixel_display_added_handler (manager->event_handler_data, display);
                 node = next_node;
         }
+
+        ply_list_foreach (heads, node) {
+                ply_renderer_head_t *head = ply_list_node_get_data (node);
+
+                if (find_pixel_display_for_head (manager, renderer, head) != NULL)
+                        continue;
+
+                ply_trace ("Adding display for new head");
+                add_pixel_display_for_head (manager, renderer, head);
+        }
 }
 
 static void
@@ -1078,10 +1228,7 @@ create_devices_for_terminal_and_renderer_type (ply_device_manager_t *manager,
         ply_renderer_t *renderer = NULL;
         ply_keyboard_t *keyboard = NULL;
 
-        if (device_path != NULL)
-                renderer = ply_hashtable_lookup (manager->renderers, (void *) device_path);
-
-        if (renderer != NULL) {
+        if (device_is_managed (manager, device_path)) {
                 ply_trace ("ignoring device %s since it's already managed", device_path);
                 return true;
         }
@@ -1107,14 +1254,30 @@ create_devices_for_terminal_and_renderer_type (ply_device_manager_t *manager,
                    device_path ? : "", renderer_type, terminal ? ply_terminal_get_name (terminal) : "none");
 
         if (renderer_type != PLY_RENDERER_TYPE_NONE) {
-                ply_renderer_t *old_renderer = NULL;
                 bool force = manager->device_timeout_elapsed ||
                              (manager->flags & PLY_DEVICE_MANAGER_FLAGS_FORCE_OPEN);
 
                 renderer = ply_renderer_new (renderer_type, device_path,
                                              terminal, manager->local_console_terminal);
 
+                /* The device path may be NULL or not the name the renderer
+                 * ends up using, so check again once the plugin has picked
+                 * its device, but before it goes to the trouble of opening it
+                 */
+                if (renderer != NULL)
+                        ply_renderer_set_device_is_managed_handler (renderer,
+                                                                    (ply_renderer_device_is_managed_handler_t)
+                                                                    device_is_managed,
+                                                                    manager);
+
                 if (renderer != NULL && !ply_renderer_open (renderer, force)) {
+                        if (ply_renderer_is_already_managed (renderer)) {
+                                ply_trace ("ignoring device %s since it's already managed",
+                                           ply_renderer_get_device_name (renderer));
+                                ply_renderer_free (renderer);
+                                return true;
+                        }
+
                         ply_trace ("could not open renderer for %s", device_path);
                         ply_renderer_free (renderer);
                         renderer = NULL;
@@ -1123,21 +1286,8 @@ create_devices_for_terminal_and_renderer_type (ply_device_manager_t *manager,
                                 return false;
                 }
 
-                if (renderer != NULL) {
-                        old_renderer = ply_hashtable_lookup (manager->renderers,
-                                                             (void *) ply_renderer_get_device_name (renderer));
-
-                        if (old_renderer != NULL) {
-                                ply_trace ("ignoring device %s since it's already managed",
-                                           ply_renderer_get_device_name (renderer));
-                                ply_renderer_free (renderer);
-
-                                renderer = NULL;
-                                return true;
-                        }
-
+                if (renderer != NULL)
                         add_input_devices_to_renderer (manager, renderer);
-                }
         }
 
         if (renderer != NULL) {
@@ -1230,6 +1380,43 @@ create_non_graphical_devices (ply_device_manager_t *manager)
 }
 
 #ifdef HAVE_UDEV
+static void
+check_for_graphics_devices (ply_device_manager_t *manager)
+{
+        if (manager->found_drm_device || manager->found_fb_device)
+                return;
+
+        ply_trace ("Creating non-graphical devices, since there's no suitable graphics hardware");
+        create_non_graphical_devices (manager);
+}
+
+static void
+probe_queued_device (ply_device_manager_t *manager,
+                     struct udev_device   *device)
+{
+        create_devices_for_udev_device (manager, device);
+        udev_device_unref (device);
+}
+
+static void
+unref_queued_device (void *device)
+{
+        udev_device_unref (device);
+}
+
+static void
+queue_device_for_probing (ply_device_manager_t *manager,
+                          struct udev_device   *device)
+{
+        const char *device_path = udev_device_get_devnode (device);
+
+        if (device_is_managed (manager, device_path))
+                return;
+
+        if (!ply_device_probe_queue_add (manager->probe_queue, device_path, udev_device_ref (device)))
+                udev_device_unref (device);
+}
+
 static void
 create_devices_from_udev (ply_device_manager_t *manager)
 {
@@ -1246,11 +1433,10 @@ create_devices_from_udev (ply_device_manager_t *manager)
         create_devices_for_subsystem (manager, SUBSYSTEM_DRM);
         create_devices_for_subsystem (manager, SUBSYSTEM_FRAME_BUFFER);
 
-        if (manager->found_drm_device || manager->found_fb_device)
-                return;
-
-        ply_trace ("Creating non-graphical devices, since there's no suitable graphics hardware");
-        create_non_graphical_devices (manager);
+        /* Only once everything found has had its turn */
+        ply_device_probe_queue_call_when_drained (manager->probe_queue,
+                                                  (ply_device_probe_queue_drained_handler_t)
+                                                  check_for_graphics_devices);
 }
 #endif
 
@@ -1297,6 +1483,15 @@ ply_device_manager_watch_devices (ply_device_manager_t               *manager,
                 return;
         }
 
+        if (manager->headless_device_name != NULL) {
+                ply_trace ("Creating headless renderer instead of looking for graphics devices");
+                create_devices_for_terminal_and_renderer_type (manager,
+                                                               manager->headless_device_name,
+                                                               NULL,
+                                                               PLY_RENDERER_TYPE_HEADLESS);
+                return;
+        }
+
         if ((manager->flags & PLY_DEVICE_MANAGER_FLAGS_IGNORE_UDEV)) {
                 ply_trace ("udev support disabled, creating fallback devices");
                 create_fallback_devices (manager);
@@ -1304,13 +1499,16 @@ ply_device_manager_watch_devices (ply_device_manager_t               *manager,
         }
 
 #ifdef HAVE_UDEV
+        /* The timeout counts from now, not from when the devices found
+         * below are done being probed
+         */
         watch_for_udev_events (manager);
-        create_devices_for_subsystem (manager, SUBSYSTEM_INPUT);
-        create_devices_for_subsystem (manager, SUBSYSTEM_DRM);
         ply_event_loop_watch_for_timeout (manager->loop,
                                           device_timeout,
                                           (ply_event_loop_timeout_handler_t)
                                           create_devices_from_udev, manager);
+        create_devices_for_subsystem (manager, SUBSYSTEM_INPUT);
+        create_devices_for_subsystem (manager, SUBSYSTEM_DRM);
 #endif
 }
 
@@ -1440,6 +1638,7 @@ ply_device_manager_pause (ply_device_manager_t *manager)
         ply_trace ("ply_device_manager_pause() called, stopping watching for udev events");
         manager->paused = true;
 #ifdef HAVE_UDEV
+        ply_device_probe_queue_pause (manager->probe_queue);
         stop_watching_for_udev_events (manager);
 #endif
 }
@@ -1454,6 +1653,7 @@ ply_device_manager_unpause (ply_device_manager_t *manager)
                 ply_trace ("ply_device_manager_unpause(): timeout elapsed while paused, looking for udev devices");
                 create_devices_from_udev (manager);
         }
+        ply_device_probe_queue_unpause (manager->probe_queue);
         watch_for_udev_events (manager);
 #endif
 }
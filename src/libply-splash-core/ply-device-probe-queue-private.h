@@ -0,0 +1,52 @@
+/* ply-device-probe-queue-private.h - devices waiting to be opened
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ */
+
+#ifndef PLY_DEVICE_PROBE_QUEUE_PRIVATE_H
+#define PLY_DEVICE_PROBE_QUEUE_PRIVATE_H
+
+#include <stdbool.h>
+
+#include "ply-event-loop.h"
+#include "ply-private.h"
+
+typedef struct _ply_device_probe_queue ply_device_probe_queue_t;
+
+typedef void (*ply_device_probe_handler_t) (void *user_data,
+                                            void *device);
+typedef void (*ply_device_probe_queue_free_handler_t) (void *device);
+typedef void (*ply_device_probe_queue_drained_handler_t) (void *user_data);
+
+/* Queued devices are handed to probe_handler one per event loop turn,
+ * in the order they were added. The queue owns them until then, and
+ * gives them to free_handler if they're dropped instead.
+ */
+PLY_PRIVATE ply_device_probe_queue_t *ply_device_probe_queue_new (ply_event_loop_t                     *loop,
+                                                                  ply_device_probe_handler_t            probe_handler,
+                                                                  ply_device_probe_queue_free_handler_t free_handler,
+                                                                  void                                 *user_data);
+PLY_PRIVATE void ply_device_probe_queue_free (ply_device_probe_queue_t *queue);
+
+PLY_PRIVATE bool ply_device_probe_queue_add (ply_device_probe_queue_t *queue,
+                                             const char               *device_path,
+                                             void                     *device);
+PLY_PRIVATE bool ply_device_probe_queue_remove (ply_device_probe_queue_t *queue,
+                                                const char               *device_path);
+PLY_PRIVATE bool ply_device_probe_queue_is_empty (ply_device_probe_queue_t *queue);
+
+/* Calls drained_handler once everything queued so far has been probed,
+ * or right away if nothing is queued
+ */
+PLY_PRIVATE void ply_device_probe_queue_call_when_drained (ply_device_probe_queue_t                *queue,
+                                                           ply_device_probe_queue_drained_handler_t drained_handler);
+
+PLY_PRIVATE void ply_device_probe_queue_pause (ply_device_probe_queue_t *queue);
+PLY_PRIVATE void ply_device_probe_queue_unpause (ply_device_probe_queue_t *queue);
+
+#endif /* PLY_DEVICE_PROBE_QUEUE_PRIVATE_H */
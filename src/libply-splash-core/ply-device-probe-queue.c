@@ -0,0 +1,250 @@
+/* ply-device-probe-queue.c - devices waiting to be opened
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ */
+
+#include "ply-device-probe-queue-private.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ply-list.h"
+
+#define PROBE_INTERVAL 0.0001
+
+typedef struct
+{
+        char *device_path;
+        void *device;
+} queued_device_t;
+
+struct _ply_device_probe_queue
+{
+        ply_event_loop_t                        *loop;
+        ply_list_t                              *devices;
+
+        ply_device_probe_handler_t               probe_handler;
+        ply_device_probe_queue_free_handler_t    free_handler;
+        ply_device_probe_queue_drained_handler_t drained_handler;
+        void                                    *user_data;
+
+        uint32_t                                 is_paused : 1;
+        uint32_t                                 probe_is_scheduled : 1;
+};
+
+static void schedule_probe (ply_device_probe_queue_t *queue);
+static void on_probe_timeout (ply_device_probe_queue_t *queue);
+
+static void
+detach_from_event_loop (ply_device_probe_queue_t *queue)
+{
+        queue->loop = NULL;
+        queue->probe_is_scheduled = false;
+}
+
+ply_device_probe_queue_t *
+ply_device_probe_queue_new (ply_event_loop_t                     *loop,
+                            ply_device_probe_handler_t            probe_handler,
+                            ply_device_probe_queue_free_handler_t free_handler,
+                            void                                 *user_data)
+{
+        ply_device_probe_queue_t *queue;
+
+        assert (loop != NULL);
+        assert (probe_handler != NULL);
+
+        queue = calloc (1, sizeof(ply_device_probe_queue_t));
+        queue->loop = loop;
+        queue->devices = ply_list_new ();
+        queue->probe_handler = probe_handler;
+        queue->free_handler = free_handler;
+        queue->user_data = user_data;
+
+        ply_event_loop_watch_for_exit (loop, (ply_event_loop_exit_handler_t)
+                                       detach_from_event_loop,
+                                       queue);
+
+        return queue;
+}
+
+static void
+free_queued_device (ply_device_probe_queue_t *queue,
+                    queued_device_t          *queued_device)
+{
+        if (queue->free_handler != NULL)
+                queue->free_handler (queued_device->device);
+
+        free (queued_device->device_path);
+        free (queued_device);
+}
+
+void
+ply_device_probe_queue_free (ply_device_probe_queue_t *queue)
+{
+        ply_list_node_t *node;
+
+        if (queue == NULL)
+                return;
+
+        if (queue->loop != NULL) {
+                if (queue->probe_is_scheduled)
+                        ply_event_loop_stop_watching_for_timeout (queue->loop,
+                                                                  (ply_event_loop_timeout_handler_t)
+                                                                  on_probe_timeout,
+                                                                  queue);
+                ply_event_loop_stop_watching_for_exit (queue->loop,
+                                                       (ply_event_loop_exit_handler_t)
+                                                       detach_from_event_loop,
+                                                       queue);
+        }
+
+        ply_list_foreach (queue->devices, node) {
+                free_queued_device (queue, ply_list_node_get_data (node));
+        }
+        ply_list_free (queue->devices);
+
+        free (queue);
+}
+
+static ply_list_node_t *
+find_device_node (ply_device_probe_queue_t *queue,
+                  const char               *device_path)
+{
+        ply_list_node_t *node;
+
+        ply_list_foreach (queue->devices, node) {
+                queued_device_t *queued_device = ply_list_node_get_data (node);
+
+                if (strcmp (queued_device->device_path, device_path) == 0)
+                        return node;
+        }
+
+        return NULL;
+}
+
+static void
+on_probe_timeout (ply_device_probe_queue_t *queue)
+{
+        ply_device_probe_queue_drained_handler_t drained_handler;
+        ply_list_node_t *node;
+
+        queue->probe_is_scheduled = false;
+
+        if (queue->is_paused)
+                return;
+
+        node = ply_list_get_first_node (queue->devices);
+        if (node != NULL) {
+                queued_device_t *queued_device = ply_list_node_get_data (node);
+
+                ply_list_remove_node (queue->devices, node);
+                queue->probe_handler (queue->user_data, queued_device->device);
+                free (queued_device->device_path);
+                free (queued_device);
+        }
+
+        if (ply_list_get_length (queue->devices) > 0) {
+                schedule_probe (queue);
+                return;
+        }
+
+        drained_handler = queue->drained_handler;
+        queue->drained_handler = NULL;
+
+        if (drained_handler != NULL)
+                drained_handler (queue->user_data);
+}
+
+/* Only one device gets opened per event loop turn, so heads that are
+ * already up get to draw between opens. Each open still blocks the loop
+ * for as long as it takes.
+ */
+static void
+schedule_probe (ply_device_probe_queue_t *queue)
+{
+        if (queue->probe_is_scheduled || queue->is_paused || queue->loop == NULL)
+                return;
+
+        if (ply_list_get_length (queue->devices) == 0 && queue->drained_handler == NULL)
+                return;
+
+        ply_event_loop_watch_for_timeout (queue->loop,
+                                          PROBE_INTERVAL,
+                                          (ply_event_loop_timeout_handler_t)
+                                          on_probe_timeout, queue);
+        queue->probe_is_scheduled = true;
+}
+
+bool
+ply_device_probe_queue_add (ply_device_probe_queue_t *queue,
+                            const char               *device_path,
+                            void                     *device)
+{
+        queued_device_t *queued_device;
+
+        if (find_device_node (queue, device_path) != NULL)
+                return false;
+
+        queued_device = calloc (1, sizeof(queued_device_t));
+        queued_device->device_path = strdup (device_path);
+        queued_device->device = device;
+
+        ply_list_append_data (queue->devices, queued_device);
+        schedule_probe (queue);
+
+        return true;
+}
+
+bool
+ply_device_probe_queue_remove (ply_device_probe_queue_t *queue,
+                               const char               *device_path)
+{
+        ply_list_node_t *node;
+
+        node = find_device_node (queue, device_path);
+        if (node == NULL)
+                return false;
+
+        free_queued_device (queue, ply_list_node_get_data (node));
+        ply_list_remove_node (queue->devices, node);
+
+        return true;
+}
+
+bool
+ply_device_probe_queue_is_empty (ply_device_probe_queue_t *queue)
+{
+        return ply_list_get_length (queue->devices) == 0;
+}
+
+void
+ply_device_probe_queue_call_when_drained (ply_device_probe_queue_t                *queue,
+                                          ply_device_probe_queue_drained_handler_t drained_handler)
+{
+        if (ply_list_get_length (queue->devices) == 0) {
+                queue->drained_handler = NULL;
+                drained_handler (queue->user_data);
+                return;
+        }
+
+        queue->drained_handler = drained_handler;
+}
+
+void
+ply_device_probe_queue_pause (ply_device_probe_queue_t *queue)
+{
+        queue->is_paused = true;
+}
+
+void
+ply_device_probe_queue_unpause (ply_device_probe_queue_t *queue)
+{
+        queue->is_paused = false;
+        schedule_probe (queue);
+}
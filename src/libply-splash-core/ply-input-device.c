@@ -61,6 +61,9 @@ struct _ply_input_device
         ply_trigger_t            *disconnect_trigger;
         ply_fd_watch_t           *fd_watch;
 
+        /* text typed since the last wakeup, reused between them */
+        ply_buffer_t             *input_buffer;
+
         struct xkb_context       *xkb_context;
         struct xkb_keymap        *keymap;
         struct xkb_state         *keyboard_state;
@@ -188,13 +191,31 @@ apply_key_to_input_buffer (ply_input_device_t *input_device,
         }
 }
 
+/* Touchpads, mice and joysticks report their buttons as key events
+ * too, but those never produce text
+ */
+static bool
+is_keyboard_key (unsigned int code)
+{
+        if (code >= BTN_MISC && code < KEY_OK)
+                return false;
+
+        if (code >= BTN_DPAD_UP && code <= BTN_DPAD_RIGHT)
+                return false;
+
+        if (code >= BTN_TRIGGER_HAPPY)
+                return false;
+
+        return true;
+}
+
 static void
 on_input (ply_input_device_t *input_device)
 {
         struct input_event ev;
         int rc;
         unsigned int flags;
-        ply_buffer_t *input_buffer = ply_buffer_new ();
+        ply_buffer_t *input_buffer = input_device->input_buffer;
         static enum { PLY_INPUT_DEVICE_DEBUG_UNKNOWN = -1,
                       PLY_INPUT_DEVICE_DEBUG_DISABLED,
                       PLY_INPUT_DEVICE_DEBUG_ENABLED } debug_key_events = PLY_INPUT_DEVICE_DEBUG_UNKNOWN;
@@ -241,6 +262,9 @@ on_input (ply_input_device_t *input_device)
                 if (!libevdev_event_is_type (&ev, EV_KEY))
                         continue;
 
+                if (!is_keyboard_key (ev.code))
+                        continue;
+
                 /* According to `https://docs.kernel.org/input/event-codes.html#ev-key`:
                  * if ev.value = 2, then the key is being held down. libxkbcommon doesn't appear to define this
                  * if ev.value = 1, then key was pressed down
@@ -289,14 +313,15 @@ on_input (ply_input_device_t *input_device)
         if (rc != -EAGAIN) {
                 ply_error ("There was an error reading events for device '%s': %s",
                            input_device->path, strerror (-rc));
-                goto error;
+                goto out;
         }
-        if (ply_buffer_get_size (input_buffer) != 0) {
+
+        /* Everything typed since the last wakeup goes out together */
+        if (ply_buffer_get_size (input_buffer) != 0)
                 ply_trigger_pull (input_device->input_trigger, ply_buffer_get_bytes (input_buffer));
-        }
 
-error:
-        ply_buffer_free (input_buffer);
+out:
+        ply_buffer_clear (input_buffer);
 }
 
 static bool
@@ -359,6 +384,7 @@ ply_input_device_open (struct xkb_context *xkb_context,
         ply_trigger_set_instance (input_device->input_trigger, input_device);
 
         input_device->leds_changed_trigger = ply_trigger_new (NULL);
+        input_device->input_buffer = ply_buffer_new ();
         input_device->loop = ply_event_loop_get_default ();
         input_device->extra_esc_key = extra_esc_key;
 
@@ -604,6 +630,7 @@ ply_input_device_free (ply_input_device_t *input_device)
         ply_trigger_free (input_device->input_trigger);
         ply_trigger_free (input_device->leds_changed_trigger);
         ply_trigger_free (input_device->disconnect_trigger);
+        ply_buffer_free (input_device->input_buffer);
 
         free (input_device->path);
 
@@ -260,10 +260,10 @@ on_key_event (ply_keyboard_t *keyboard,
 {
         const char *bytes;
         size_t size, i;
-        bool debug_key_events = false;
+        static int debug_key_events = -1;
 
-        if (ply_kernel_command_line_has_argument ("plymouth.debug-key-events"))
-                debug_key_events = true;
+        if (debug_key_events < 0)
+                debug_key_events = ply_kernel_command_line_has_argument ("plymouth.debug-key-events");
 
         bytes = ply_buffer_get_bytes (buffer);
         size = ply_buffer_get_size (buffer);
@@ -275,7 +275,7 @@ on_key_event (ply_keyboard_t *keyboard,
         while (i < size) {
                 ply_utf8_character_byte_type_t character_byte_type;
                 ssize_t character_size;
-                char *keyboard_input;
+                char keyboard_input[PLY_UTF8_CHARACTER_SIZE_MAX + 1];
                 size_t bytes_left = size - i;
 
                 /* Control Sequence Introducer sequences
@@ -346,7 +346,8 @@ on_key_event (ply_keyboard_t *keyboard,
                         break;
                 }
 
-                keyboard_input = strndup (bytes + i, character_size);
+                memcpy (keyboard_input, bytes + i, character_size);
+                keyboard_input[character_size] = '\0';
 
                 if (debug_key_events)
                         ply_trace ("Processing input '%s'", keyboard_input);
@@ -354,8 +355,6 @@ on_key_event (ply_keyboard_t *keyboard,
                 process_keyboard_input (keyboard, keyboard_input, character_size);
 
                 i += character_size;
-
-                free (keyboard_input);
         }
 
         if (i > 0) {
@@ -646,6 +646,56 @@ ply_pixel_buffer_fill_with_hex_color (ply_pixel_buffer_t *buffer,
                                                                 hex_color, 1.0);
 }
 
+/* Interpolation weights are fixed point with 12 fractional bits.  Two
+ * channels are blended at once in the 32-bit halves of a 64-bit word;
+ * 255 times both weights still fits in each half.
+ */
+#define PLY_PIXEL_WEIGHT_BITS 12
+#define PLY_PIXEL_WEIGHT_ONE (1 << PLY_PIXEL_WEIGHT_BITS)
+
+#define PLY_PIXEL_EVEN_CHANNELS(pixel) \
+        (((pixel) & 0xff) | ((uint64_t) ((pixel) & 0xff0000) << 16))
+#define PLY_PIXEL_ODD_CHANNELS(pixel) \
+        ((((pixel) >> 8) & 0xff) | ((uint64_t) ((pixel) & 0xff000000) << 8))
+
+static inline uint32_t
+ply_pixels_pack_channels (uint64_t even,
+                          uint64_t odd)
+{
+        even >>= 2 * PLY_PIXEL_WEIGHT_BITS;
+        odd >>= 2 * PLY_PIXEL_WEIGHT_BITS;
+
+        return (uint32_t) (even & 0xff) |
+               (uint32_t) ((odd & 0xff) << 8) |
+               (uint32_t) (((even >> 32) & 0xff) << 16) |
+               (uint32_t) (((odd >> 32) & 0xff) << 24);
+}
+
+static inline uint32_t
+ply_pixels_blend_bilinear (uint32_t top_left,
+                           uint32_t top_right,
+                           uint32_t bottom_left,
+                           uint32_t bottom_right,
+                           uint32_t weight_x,
+                           uint32_t weight_y)
+{
+        uint64_t top, bottom, even, odd;
+
+        top = PLY_PIXEL_EVEN_CHANNELS (top_left) * (PLY_PIXEL_WEIGHT_ONE - weight_x) +
+              PLY_PIXEL_EVEN_CHANNELS (top_right) * weight_x;
+        bottom = PLY_PIXEL_EVEN_CHANNELS (bottom_left) * (PLY_PIXEL_WEIGHT_ONE - weight_x) +
+                 PLY_PIXEL_EVEN_CHANNELS (bottom_right) * weight_x;
+        even = top * (PLY_PIXEL_WEIGHT_ONE - weight_y) + bottom * weight_y;
+
+        top = PLY_PIXEL_ODD_CHANNELS (top_left) * (PLY_PIXEL_WEIGHT_ONE - weight_x) +
+              PLY_PIXEL_ODD_CHANNELS (top_right) * weight_x;
+        bottom = PLY_PIXEL_ODD_CHANNELS (bottom_left) * (PLY_PIXEL_WEIGHT_ONE - weight_x) +
+                 PLY_PIXEL_ODD_CHANNELS (bottom_right) * weight_x;
+        odd = top * (PLY_PIXEL_WEIGHT_ONE - weight_y) + bottom * weight_y;
+
+        return ply_pixels_pack_channels (even, odd);
+}
+
 static inline uint32_t
 ply_pixels_interpolate (uint32_t *bytes,
                         int       width,
@@ -653,47 +703,32 @@ ply_pixels_interpolate (uint32_t *bytes,
                         double    x,
                         double    y)
 {
-        int ix;
-        int iy;
-        int i;
-        int offset_x;
-        int offset_y;
-        uint32_t pixels[2][2];
-        uint32_t reply = 0;
-
-        for (offset_y = 0; offset_y < 2; offset_y++) {
-                for (offset_x = 0; offset_x < 2; offset_x++) {
-                        ix = x + offset_x;
-                        iy = y + offset_y;
-
-                        if (ix >= width)
-                                ix = width - 1;
-
-                        if (iy >= height)
-                                iy = height - 1;
-
-                        if (ix < 0 || iy < 0)
-                                pixels[offset_y][offset_x] = 0x00000000;
-                        else
-                                pixels[offset_y][offset_x] = bytes[ix + iy * width];
-                }
-        }
-        if (!pixels[0][0] && !pixels[0][1] && !pixels[1][0] && !pixels[1][1]) return 0;
+        int ix, iy;
+        int next_ix, next_iy;
+        uint32_t weight_x, weight_y;
+
+        if (x <= -1.0 || y <= -1.0)
+                return 0;
+
+        /* Within a pixel of the top or left edge, sample the edge */
+        x = MAX (x, 0.0);
+        y = MAX (y, 0.0);
 
         ix = x;
         iy = y;
-        x -= ix;
-        y -= iy;
-        for (i = 0; i < 4; i++) {
-                uint32_t value = 0;
-                uint32_t mask = UINT32_C (0xff) << (i * 8);
-                value += ((pixels[0][0]) & mask) * (1 - x) * (1 - y);
-                value += ((pixels[0][1]) & mask) * x * (1 - y);
-                value += ((pixels[1][0]) & mask) * (1 - x) * y;
-                value += ((pixels[1][1]) & mask) * x * y;
-                reply |= value & mask;
-        }
-        return reply;
+        weight_x = (x - ix) * PLY_PIXEL_WEIGHT_ONE;
+        weight_y = (y - iy) * PLY_PIXEL_WEIGHT_ONE;
+
+        ix = MIN (ix, width - 1);
+        iy = MIN (iy, height - 1);
+        next_ix = MIN (ix + 1, width - 1);
+        next_iy = MIN (iy + 1, height - 1);
+
+        return ply_pixels_blend_bilinear (bytes[ix + iy * width],
+                                          bytes[next_ix + iy * width],
+                                          bytes[ix + next_iy * width],
+                                          bytes[next_ix + next_iy * width],
+                                          weight_x, weight_y);
 }
 
 void
@@ -962,36 +997,204 @@ ply_pixel_buffer_interpolate (ply_pixel_buffer_t *buffer,
         return ply_pixels_interpolate (bytes, width, height, x, y);
 }
 
+typedef struct
+{
+        int      offset;
+        int      next_offset;
+        uint32_t weight;
+} ply_pixel_buffer_sample_t;
+
+static ply_pixel_buffer_sample_t *
+ply_pixel_buffer_compute_samples (long old_size,
+                                  long size)
+{
+        ply_pixel_buffer_sample_t *samples;
+        double scale;
+        double position;
+        long i;
+
+        samples = calloc (size, sizeof(ply_pixel_buffer_sample_t));
+        scale = ((double) old_size - 1) / MAX (size - 1, 1);
+
+        for (i = 0; i < size; i++) {
+                position = i * scale;
+                samples[i].offset = position;
+                samples[i].weight = (position - samples[i].offset) * PLY_PIXEL_WEIGHT_ONE;
+                samples[i].offset = MIN (samples[i].offset, old_size - 1);
+                samples[i].next_offset = MIN (samples[i].offset + 1, old_size - 1);
+        }
+
+        return samples;
+}
+
+/* Blends horizontally within one source row, leaving the channels
+ * spread out and unshifted for the vertical pass
+ */
+static void
+ply_pixel_buffer_interpolate_row (const uint32_t                  *row,
+                                  const ply_pixel_buffer_sample_t *columns,
+                                  long                             width,
+                                  uint64_t                        *even,
+                                  uint64_t                        *odd)
+{
+        long x;
+
+        for (x = 0; x < width; x++) {
+                uint32_t left = row[columns[x].offset];
+                uint32_t right = row[columns[x].next_offset];
+                uint32_t weight = columns[x].weight;
+
+                even[x] = PLY_PIXEL_EVEN_CHANNELS (left) * (PLY_PIXEL_WEIGHT_ONE - weight) +
+                          PLY_PIXEL_EVEN_CHANNELS (right) * weight;
+                odd[x] = PLY_PIXEL_ODD_CHANNELS (left) * (PLY_PIXEL_WEIGHT_ONE - weight) +
+                         PLY_PIXEL_ODD_CHANNELS (right) * weight;
+        }
+}
+
 ply_pixel_buffer_t *
 ply_pixel_buffer_resize (ply_pixel_buffer_t *old_buffer,
                          long                width,
                          long                height)
 {
         ply_pixel_buffer_t *buffer;
-        int x, y;
-        double old_x, old_y;
+        ply_pixel_buffer_sample_t *columns, *rows;
+        uint64_t *row_data, *even[2], *odd[2];
+        int cached_rows[2] = { -1, -1 };
+        uint32_t *bytes, *old_bytes;
         int old_width, old_height;
-        double scale_x, scale_y;
-        uint32_t *bytes;
+        long x, y;
 
         buffer = ply_pixel_buffer_new (width, height);
 
+        if (width <= 0 || height <= 0)
+                return buffer;
+
         bytes = ply_pixel_buffer_get_argb32_data (buffer);
+        old_bytes = ply_pixel_buffer_get_argb32_data (old_buffer);
+
+        old_width = old_buffer->area.width;
+        old_height = old_buffer->area.height;
+
+        columns = ply_pixel_buffer_compute_samples (old_width, width);
+        rows = ply_pixel_buffer_compute_samples (old_height, height);
+
+        row_data = malloc (4 * width * sizeof(uint64_t));
+        even[0] = row_data;
+        even[1] = row_data + width;
+        odd[0] = row_data + 2 * width;
+        odd[1] = row_data + 3 * width;
+
+        /* Each source row is blended horizontally once and kept while
+         * output rows still sample it
+         */
+        for (y = 0; y < height; y++) {
+                uint32_t weight = rows[y].weight;
+                uint32_t *output = bytes + y * width;
+
+                if (cached_rows[0] != rows[y].offset) {
+                        if (cached_rows[1] == rows[y].offset) {
+                                uint64_t *temp;
+
+                                temp = even[0];
+                                even[0] = even[1];
+                                even[1] = temp;
+                                temp = odd[0];
+                                odd[0] = odd[1];
+                                odd[1] = temp;
+                                cached_rows[1] = cached_rows[0];
+                        } else {
+                                ply_pixel_buffer_interpolate_row (old_bytes + rows[y].offset * old_width,
+                                                                  columns, width, even[0], odd[0]);
+                        }
+                        cached_rows[0] = rows[y].offset;
+                }
+
+                if (cached_rows[1] != rows[y].next_offset) {
+                        ply_pixel_buffer_interpolate_row (old_bytes + rows[y].next_offset * old_width,
+                                                          columns, width, even[1], odd[1]);
+                        cached_rows[1] = rows[y].next_offset;
+                }
+
+                for (x = 0; x < width; x++) {
+                        output[x] = ply_pixels_pack_channels (even[0][x] * (PLY_PIXEL_WEIGHT_ONE - weight) +
+                                                              even[1][x] * weight,
+                                                              odd[0][x] * (PLY_PIXEL_WEIGHT_ONE - weight) +
+                                                              odd[1][x] * weight);
+                }
+        }
+
+        free (row_data);
+        free (columns);
+        free (rows);
+
+        return buffer;
+}
+
+ply_pixel_buffer_t *
+ply_pixel_buffer_resize_area (ply_pixel_buffer_t *old_buffer,
+                              long                width,
+                              long                height)
+{
+        ply_pixel_buffer_t *buffer;
+        uint32_t *bytes, *old_bytes;
+        uint32_t *sums;
+        long old_width, old_height;
+        long x, y, old_x, old_y;
 
         old_width = old_buffer->area.width;
         old_height = old_buffer->area.height;
 
-        scale_x = ((double) old_width - 1) / MAX (width - 1, 1);
-        scale_y = ((double) old_height - 1) / MAX (height - 1, 1);
+        /* Averaging only helps when every output pixel covers several
+         * source pixels
+         */
+        if (width <= 0 || height <= 0 || width > old_width || height > old_height)
+                return ply_pixel_buffer_resize (old_buffer, width, height);
+
+        buffer = ply_pixel_buffer_new (width, height);
+        bytes = ply_pixel_buffer_get_argb32_data (buffer);
+        old_bytes = ply_pixel_buffer_get_argb32_data (old_buffer);
+        sums = malloc (4 * width * sizeof(uint32_t));
 
         for (y = 0; y < height; y++) {
-                old_y = y * scale_y;
+                long first_row = y * old_height / height;
+                long last_row = (y + 1) * old_height / height;
+
+                memset (sums, 0, 4 * width * sizeof(uint32_t));
+
+                for (old_y = first_row; old_y < last_row; old_y++) {
+                        uint32_t *row = old_bytes + old_y * old_width;
+
+                        for (x = 0; x < width; x++) {
+                                long first_column = x * old_width / width;
+                                long last_column = (x + 1) * old_width / width;
+
+                                for (old_x = first_column; old_x < last_column; old_x++) {
+                                        sums[4 * x] += row[old_x] & 0xff;
+                                        sums[4 * x + 1] += (row[old_x] >> 8) & 0xff;
+                                        sums[4 * x + 2] += (row[old_x] >> 16) & 0xff;
+                                        sums[4 * x + 3] += row[old_x] >> 24;
+                                }
+                        }
+                }
+
                 for (x = 0; x < width; x++) {
-                        old_x = x * scale_x;
-                        bytes[x + y * width] =
-                                ply_pixel_buffer_interpolate (old_buffer, old_x, old_y);
+                        uint32_t count;
+                        uint32_t pixel = 0;
+                        int i;
+
+                        count = (last_row - first_row) *
+                                ((x + 1) * old_width / width - x * old_width / width);
+
+                        for (i = 0; i < 4; i++) {
+                                pixel |= ((sums[4 * x + i] + count / 2) / count) << (i * 8);
+                        }
+
+                        bytes[x + y * width] = pixel;
                 }
         }
+
+        free (sums);
+
         return buffer;
 }
 
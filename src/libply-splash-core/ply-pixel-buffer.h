@@ -150,6 +150,13 @@ ply_pixel_buffer_t *ply_pixel_buffer_resize (ply_pixel_buffer_t *old_buffer,
                                              long                width,
                                              long                height);
 
+/* Averages every source pixel covered by each destination pixel, which
+ * looks better than ply_pixel_buffer_resize for large downscales
+ */
+ply_pixel_buffer_t *ply_pixel_buffer_resize_area (ply_pixel_buffer_t *old_buffer,
+                                                  long                width,
+                                                  long                height);
+
 ply_pixel_buffer_t *ply_pixel_buffer_rotate (ply_pixel_buffer_t *old_buffer,
                                              long                center_x,
                                              long                center_y,
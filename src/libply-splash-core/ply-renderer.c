@@ -44,20 +44,24 @@
 
 struct _ply_renderer
 {
-        ply_event_loop_t                      *loop;
-        ply_module_handle_t                   *module_handle;
-        const ply_renderer_plugin_interface_t *plugin_interface;
-        ply_renderer_backend_t                *backend;
-
-        ply_renderer_type_t                    type;
-        char                                  *plugin_directory;
-        char                                  *device_name;
-        ply_terminal_t                        *terminal;
-        ply_terminal_t                        *local_console_terminal;
-
-        uint32_t                               input_source_is_open : 1;
-        uint32_t                               is_mapped : 1;
-        uint32_t                               is_active : 1;
+        ply_event_loop_t                         *loop;
+        ply_module_handle_t                      *module_handle;
+        const ply_renderer_plugin_interface_t    *plugin_interface;
+        ply_renderer_backend_t                   *backend;
+
+        ply_renderer_type_t                       type;
+        char                                     *plugin_directory;
+        char                                     *device_name;
+        ply_terminal_t                           *terminal;
+        ply_terminal_t                           *local_console_terminal;
+
+        ply_renderer_device_is_managed_handler_t  device_is_managed_handler;
+        void                                     *device_is_managed_handler_user_data;
+
+        uint32_t                                  input_source_is_open : 1;
+        uint32_t                                  is_mapped : 1;
+        uint32_t                                  is_active : 1;
+        uint32_t                                  is_already_managed : 1;
 };
 
 typedef const ply_renderer_plugin_interface_t *
@@ -272,6 +276,16 @@ ply_renderer_open_plugin (ply_renderer_t *renderer,
         if (!ply_renderer_load_plugin (renderer, plugin_path))
                 return false;
 
+        if (renderer->device_is_managed_handler != NULL &&
+            renderer->device_is_managed_handler (renderer->device_is_managed_handler_user_data,
+                                                 renderer->device_name)) {
+                ply_trace ("device %s is already managed, not opening it",
+                           renderer->device_name);
+                renderer->is_already_managed = true;
+                ply_renderer_unload_plugin (renderer);
+                return false;
+        }
+
         if (!ply_renderer_open_device (renderer)) {
                 ply_trace ("could not open rendering device for plugin %s",
                            plugin_path);
@@ -307,11 +321,18 @@ ply_renderer_open (ply_renderer_t *renderer,
                 { PLY_RENDERER_TYPE_DRM,          "renderers/drm.so"          },
                 { PLY_RENDERER_TYPE_SIMPLEDRM,    "renderers/drm.so"          },
                 { PLY_RENDERER_TYPE_FRAME_BUFFER, "renderers/frame-buffer.so" },
+                { PLY_RENDERER_TYPE_HEADLESS,     "renderers/headless.so"     },
                 { PLY_RENDERER_TYPE_NONE,         NULL                        }
         };
 
         renderer->is_active = false;
+        renderer->is_already_managed = false;
         for (i = 0; known_plugins[i].type != PLY_RENDERER_TYPE_NONE; i++) {
+                /* The headless renderer always opens, so it has to be asked for */
+                if (renderer->type == PLY_RENDERER_TYPE_AUTO &&
+                    known_plugins[i].type == PLY_RENDERER_TYPE_HEADLESS)
+                        continue;
+
                 if (renderer->type == known_plugins[i].type ||
                     renderer->type == PLY_RENDERER_TYPE_AUTO) {
                         const char *separator;
@@ -335,6 +356,9 @@ ply_renderer_open (ply_renderer_t *renderer,
                         }
 
                         free (plugin_path);
+
+                        if (renderer->is_already_managed)
+                                goto out;
                 }
         }
 
@@ -351,6 +375,21 @@ ply_renderer_close (ply_renderer_t *renderer)
         renderer->is_active = false;
 }
 
+void
+ply_renderer_set_device_is_managed_handler (ply_renderer_t                          *renderer,
+                                            ply_renderer_device_is_managed_handler_t handler,
+                                            void                                    *user_data)
+{
+        renderer->device_is_managed_handler = handler;
+        renderer->device_is_managed_handler_user_data = user_data;
+}
+
+bool
+ply_renderer_is_already_managed (ply_renderer_t *renderer)
+{
+        return renderer->is_already_managed;
+}
+
 bool
 ply_renderer_handle_change_event (ply_renderer_t *renderer)
 {
@@ -43,13 +43,17 @@ typedef enum
         PLY_RENDERER_TYPE_DRM,
         PLY_RENDERER_TYPE_SIMPLEDRM,
         PLY_RENDERER_TYPE_FRAME_BUFFER,
-        PLY_RENDERER_TYPE_X11
+        PLY_RENDERER_TYPE_X11,
+        PLY_RENDERER_TYPE_HEADLESS
 } ply_renderer_type_t;
 
 typedef void (*ply_renderer_input_source_handler_t) (void                        *user_data,
                                                      ply_buffer_t                *key_buffer,
                                                      ply_renderer_input_source_t *input_source);
 
+typedef bool (*ply_renderer_device_is_managed_handler_t) (void       *user_data,
+                                                          const char *device_name);
+
 #ifndef PLY_HIDE_FUNCTION_DECLARATIONS
 ply_renderer_t *ply_renderer_new (ply_renderer_type_t renderer_type,
                                   const char         *device_name,
@@ -59,6 +63,14 @@ void ply_renderer_free (ply_renderer_t *renderer);
 bool ply_renderer_open (ply_renderer_t *renderer,
                         bool            force);
 void ply_renderer_close (ply_renderer_t *renderer);
+/* Asked once a plugin has said which device it would drive, before the
+ * device gets opened. Returning true makes ply_renderer_open () give up,
+ * and ply_renderer_is_already_managed () return true.
+ */
+void ply_renderer_set_device_is_managed_handler (ply_renderer_t                          *renderer,
+                                                 ply_renderer_device_is_managed_handler_t handler,
+                                                 void                                    *user_data);
+bool ply_renderer_is_already_managed (ply_renderer_t *renderer);
 /* Returns true when the heads have changed as a result of the change event */
 bool ply_renderer_handle_change_event (ply_renderer_t *renderer);
 void ply_renderer_activate (ply_renderer_t *renderer);
@@ -59,6 +59,34 @@
 #define PLY_TERMINAL_REOPEN_INTERVAL 0.05
 #endif
 
+#ifndef MOVE_CURSOR_SEQUENCE
+#define MOVE_CURSOR_SEQUENCE "\033[%d;%df"
+#endif
+
+#ifndef COLOR_SEQUENCE_FORMAT
+#define COLOR_SEQUENCE_FORMAT "\033[%dm"
+#endif
+
+#ifndef FOREGROUND_COLOR_BASE
+#define FOREGROUND_COLOR_BASE 30
+#endif
+
+#ifndef BACKGROUND_COLOR_BASE
+#define BACKGROUND_COLOR_BASE 40
+#endif
+
+/* Formatted output shorter than this skips the heap */
+#ifndef PLY_TERMINAL_FORMAT_BUFFER_SIZE
+#define PLY_TERMINAL_FORMAT_BUFFER_SIZE 256
+#endif
+
+/* How much output may wait for a slow terminal, such as a serial
+ * console, before older output gets thrown away
+ */
+#ifndef PLY_TERMINAL_MAX_PENDING_OUTPUT_SIZE
+#define PLY_TERMINAL_MAX_PENDING_OUTPUT_SIZE (64 * 1024)
+#endif
+
 typedef struct
 {
         ply_terminal_input_handler_t handler;
@@ -71,6 +99,18 @@ typedef struct
         void                                    *user_data;
 } ply_terminal_active_vt_changed_closure_t;
 
+/* Output the terminal couldn't take yet.  A frame is output that was
+ * held, which redraws the screen and so goes stale once a newer frame
+ * is queued behind it.
+ */
+typedef struct
+{
+        char    *bytes;
+        size_t   size;
+        size_t   offset;
+        uint32_t is_frame : 1;
+} ply_terminal_pending_output_t;
+
 struct _ply_terminal
 {
         ply_event_loop_t    *loop;
@@ -91,6 +131,15 @@ struct _ply_terminal
         ply_terminal_color_t foreground_color;
         ply_terminal_color_t background_color;
 
+        /* Output is collected here while held and written in one go */
+        ply_buffer_t        *output_buffer;
+        int                  output_hold_count;
+        ply_list_t          *pending_output;
+        size_t               pending_output_size;
+        ply_fd_watch_t      *output_watch;
+        int                  cursor_column;
+        int                  cursor_row;
+
         uint8_t              original_color_palette[TEXT_PALETTE_SIZE];
         uint8_t              color_palette[TEXT_PALETTE_SIZE];
 
@@ -106,6 +155,9 @@ struct _ply_terminal
         uint32_t             is_disabled : 1;
         uint32_t             is_watching_for_vt_changes : 1;
         uint32_t             should_ignore_mode_changes : 1;
+        uint32_t             has_known_foreground_color : 1;
+        uint32_t             has_known_background_color : 1;
+        uint32_t             has_known_cursor_position : 1;
 };
 
 typedef enum
@@ -130,6 +182,8 @@ ply_terminal_new (const char *device_name,
         terminal->loop = ply_event_loop_get_default ();
         terminal->vt_change_closures = ply_list_new ();
         terminal->input_closures = ply_list_new ();
+        terminal->output_buffer = ply_buffer_new ();
+        terminal->pending_output = ply_list_new ();
 
         if (strncmp (device_name, "/dev/", strlen ("/dev/")) == 0)
                 terminal->name = strdup (device_name);
@@ -345,27 +399,445 @@ ply_terminal_set_disabled_input (ply_terminal_t *terminal)
         return true;
 }
 
+/* Anything else writing to the tty between flushes can move the cursor
+ * or change colors, so what was sent is only trusted within one batch
+ */
+static void
+ply_terminal_forget_output_state (ply_terminal_t *terminal)
+{
+        terminal->has_known_foreground_color = false;
+        terminal->has_known_background_color = false;
+        terminal->has_known_cursor_position = false;
+}
+
+static void
+ply_terminal_drop_pending_output_node (ply_terminal_t  *terminal,
+                                       ply_list_node_t *node)
+{
+        ply_terminal_pending_output_t *output = ply_list_node_get_data (node);
+
+        terminal->pending_output_size -= output->size - output->offset;
+        ply_list_remove_node (terminal->pending_output, node);
+        free (output->bytes);
+        free (output);
+}
+
+static void
+ply_terminal_drop_pending_output (ply_terminal_t *terminal)
+{
+        ply_list_node_t *node;
+
+        while ((node = ply_list_get_first_node (terminal->pending_output)) != NULL) {
+                ply_terminal_drop_pending_output_node (terminal, node);
+        }
+}
+
+static void
+ply_terminal_stop_watching_for_writability (ply_terminal_t *terminal)
+{
+        if (terminal->output_watch == NULL)
+                return;
+
+        if (terminal->loop != NULL)
+                ply_event_loop_stop_watching_fd (terminal->loop, terminal->output_watch);
+
+        terminal->output_watch = NULL;
+}
+
+/* Returns how much of the bytes the terminal took, stopping short
+ * instead of waiting when it's busy
+ */
+static size_t
+ply_terminal_write_bytes (ply_terminal_t *terminal,
+                          const char     *bytes,
+                          size_t          size)
+{
+        size_t bytes_written = 0;
+
+        while (bytes_written < size) {
+                ssize_t result;
+
+                result = write (terminal->fd, bytes + bytes_written, size - bytes_written);
+
+                if (result < 0) {
+                        if (errno == EINTR)
+                                continue;
+
+                        /* Give up on output that can never be written */
+                        if (errno != EAGAIN && errno != EWOULDBLOCK)
+                                return size;
+
+                        break;
+                }
+
+                bytes_written += result;
+        }
+
+        return bytes_written;
+}
+
+static void
+ply_terminal_write_pending_output (ply_terminal_t *terminal)
+{
+        ply_list_node_t *node;
+
+        while ((node = ply_list_get_first_node (terminal->pending_output)) != NULL) {
+                ply_terminal_pending_output_t *output = ply_list_node_get_data (node);
+                size_t bytes_written;
+
+                bytes_written = ply_terminal_write_bytes (terminal,
+                                                          output->bytes + output->offset,
+                                                          output->size - output->offset);
+                output->offset += bytes_written;
+                terminal->pending_output_size -= bytes_written;
+
+                if (output->offset < output->size)
+                        break;
+
+                ply_terminal_drop_pending_output_node (terminal, node);
+        }
+}
+
+static bool
+ply_terminal_drop_stale_output (ply_terminal_t *terminal)
+{
+        ply_list_node_t *node;
+        ply_list_node_t *stale_node = NULL;
+
+        /* Unstarted frames that a newer frame will paint over go first, then
+         * anything unstarted except the newest output
+         */
+        ply_list_foreach (terminal->pending_output, node) {
+                ply_terminal_pending_output_t *output = ply_list_node_get_data (node);
+
+                if (!output->is_frame)
+                        continue;
+
+                if (stale_node != NULL) {
+                        ply_terminal_drop_pending_output_node (terminal, stale_node);
+                        return true;
+                }
+
+                if (output->offset == 0)
+                        stale_node = node;
+        }
+
+        ply_list_foreach (terminal->pending_output, node) {
+                ply_terminal_pending_output_t *output = ply_list_node_get_data (node);
+
+                if (node == ply_list_get_last_node (terminal->pending_output))
+                        break;
+
+                if (output->offset == 0) {
+                        ply_terminal_drop_pending_output_node (terminal, node);
+                        return true;
+                }
+        }
+
+        return false;
+}
+
+static void
+ply_terminal_trim_pending_output (ply_terminal_t *terminal)
+{
+        ply_terminal_pending_output_t *newest_output;
+        ply_list_node_t *node;
+        size_t excess_size;
+
+        if (terminal->pending_output_size <= PLY_TERMINAL_MAX_PENDING_OUTPUT_SIZE)
+                return;
+
+        ply_trace ("terminal %s can't keep up with %zu bytes of output, dropping old output",
+                   terminal->name, terminal->pending_output_size);
+
+        while (terminal->pending_output_size > PLY_TERMINAL_MAX_PENDING_OUTPUT_SIZE) {
+                if (!ply_terminal_drop_stale_output (terminal))
+                        break;
+        }
+
+        if (terminal->pending_output_size <= PLY_TERMINAL_MAX_PENDING_OUTPUT_SIZE)
+                return;
+
+        node = ply_list_get_last_node (terminal->pending_output);
+        newest_output = ply_list_node_get_data (node);
+
+        if (newest_output->offset != 0)
+                return;
+
+        /* A partial frame would be garbage, but for plain text the most
+         * recent lines are what matter
+         */
+        if (newest_output->is_frame) {
+                ply_terminal_drop_pending_output_node (terminal, node);
+                return;
+        }
+
+        excess_size = MIN (terminal->pending_output_size - PLY_TERMINAL_MAX_PENDING_OUTPUT_SIZE,
+                           newest_output->size);
+        newest_output->offset = excess_size;
+        terminal->pending_output_size -= excess_size;
+}
+
+static void
+on_tty_writable (ply_terminal_t *terminal)
+{
+        ply_terminal_write_pending_output (terminal);
+
+        if (ply_list_get_length (terminal->pending_output) == 0)
+                ply_terminal_stop_watching_for_writability (terminal);
+}
+
+static void
+on_tty_output_disconnected (ply_terminal_t *terminal)
+{
+        terminal->output_watch = NULL;
+        ply_terminal_drop_pending_output (terminal);
+}
+
+static void
+ply_terminal_watch_for_writability (ply_terminal_t *terminal)
+{
+        if (terminal->output_watch != NULL)
+                return;
+
+        if (terminal->loop == NULL) {
+                ply_terminal_drop_pending_output (terminal);
+                return;
+        }
+
+        terminal->output_watch = ply_event_loop_watch_fd (terminal->loop, terminal->fd,
+                                                          PLY_EVENT_LOOP_FD_STATUS_CAN_TAKE_DATA,
+                                                          (ply_event_handler_t) on_tty_writable,
+                                                          (ply_event_handler_t) on_tty_output_disconnected,
+                                                          terminal);
+}
+
+static void
+ply_terminal_flush_output (ply_terminal_t *terminal,
+                           bool            is_frame)
+{
+        ply_terminal_pending_output_t *output;
+        const char *bytes;
+        size_t size, bytes_written = 0;
+
+        size = ply_buffer_get_size (terminal->output_buffer);
+
+        if (size == 0)
+                return;
+
+        if (terminal->fd < 0) {
+                ply_buffer_clear (terminal->output_buffer);
+                return;
+        }
+
+        ply_terminal_set_mode (terminal, PLY_TERMINAL_MODE_TEXT);
+
+        bytes = ply_buffer_get_bytes (terminal->output_buffer);
+
+        /* Output can't jump ahead of what's already waiting */
+        if (ply_list_get_length (terminal->pending_output) == 0)
+                bytes_written = ply_terminal_write_bytes (terminal, bytes, size);
+
+        if (bytes_written < size) {
+                /* Output that got partly written can't be dropped anymore,
+                 * which the offset tracks
+                 */
+                output = calloc (1, sizeof(ply_terminal_pending_output_t));
+                output->size = size;
+                output->offset = bytes_written;
+                output->bytes = malloc (size);
+                memcpy (output->bytes, bytes, size);
+                output->is_frame = is_frame;
+
+                ply_list_append_data (terminal->pending_output, output);
+                terminal->pending_output_size += size - bytes_written;
+
+                ply_terminal_trim_pending_output (terminal);
+                ply_terminal_watch_for_writability (terminal);
+        }
+
+        ply_buffer_clear (terminal->output_buffer);
+}
+
+static void
+ply_terminal_finish_output (ply_terminal_t *terminal,
+                            bool            is_frame)
+{
+        if (terminal->output_hold_count > 0)
+                return;
+
+        ply_terminal_flush_output (terminal, is_frame);
+        ply_terminal_forget_output_state (terminal);
+}
+
+static void
+ply_terminal_append_output (ply_terminal_t *terminal,
+                            const char     *format,
+                            va_list         args)
+{
+        char format_buffer[PLY_TERMINAL_FORMAT_BUFFER_SIZE];
+        va_list args_copy;
+        char *string;
+        int size;
+
+        va_copy (args_copy, args);
+        size = vsnprintf (format_buffer, sizeof(format_buffer), format, args_copy);
+        va_end (args_copy);
+
+        if (size < 0)
+                return;
+
+        if ((size_t) size < sizeof(format_buffer)) {
+                ply_buffer_append_bytes (terminal->output_buffer, format_buffer, size);
+                return;
+        }
+
+        string = NULL;
+        size = vasprintf (&string, format, args);
+
+        if (size < 0)
+                return;
+
+        ply_buffer_append_bytes (terminal->output_buffer, string, size);
+        free (string);
+}
+
 void
 ply_terminal_write (ply_terminal_t *terminal,
                     const char     *format,
                     ...)
 {
         va_list args;
-        char *string;
-        int size;
 
         assert (terminal != NULL);
         assert (format != NULL);
 
-        ply_terminal_set_mode (terminal, PLY_TERMINAL_MODE_TEXT);
+        va_start (args, format);
+        ply_terminal_append_output (terminal, format, args);
+        va_end (args);
+
+        /* The output may carry its own escape sequences */
+        ply_terminal_forget_output_state (terminal);
+        ply_terminal_finish_output (terminal, false);
+}
+
+void
+ply_terminal_write_data (ply_terminal_t *terminal,
+                         const char     *data,
+                         size_t          size)
+{
+        assert (terminal != NULL);
+
+        if (size == 0)
+                return;
+
+        ply_buffer_append_bytes (terminal->output_buffer, data, size);
+
+        ply_terminal_forget_output_state (terminal);
+        ply_terminal_finish_output (terminal, false);
+}
+
+void
+ply_terminal_vwrite_text (ply_terminal_t *terminal,
+                          const char     *format,
+                          va_list         args)
+{
+        assert (terminal != NULL);
+        assert (format != NULL);
+
+        ply_terminal_append_output (terminal, format, args);
+
+        terminal->has_known_cursor_position = false;
+        ply_terminal_finish_output (terminal, false);
+}
+
+void
+ply_terminal_write_text (ply_terminal_t *terminal,
+                         const char     *format,
+                         ...)
+{
+        va_list args;
 
-        string = NULL;
         va_start (args, format);
-        size = vasprintf (&string, format, args);
+        ply_terminal_vwrite_text (terminal, format, args);
         va_end (args);
+}
 
-        write (terminal->fd, string, size);
-        free (string);
+void
+ply_terminal_set_cursor_position (ply_terminal_t *terminal,
+                                  int             column,
+                                  int             row)
+{
+        assert (terminal != NULL);
+
+        if (terminal->has_known_cursor_position &&
+            terminal->cursor_column == column &&
+            terminal->cursor_row == row)
+                return;
+
+        ply_buffer_append (terminal->output_buffer, MOVE_CURSOR_SEQUENCE, row, column);
+
+        terminal->cursor_column = column;
+        terminal->cursor_row = row;
+        terminal->has_known_cursor_position = true;
+        ply_terminal_finish_output (terminal, false);
+}
+
+void
+ply_terminal_set_foreground_color (ply_terminal_t      *terminal,
+                                   ply_terminal_color_t color)
+{
+        assert (terminal != NULL);
+
+        if (terminal->has_known_foreground_color && terminal->foreground_color == color)
+                return;
+
+        ply_buffer_append (terminal->output_buffer, COLOR_SEQUENCE_FORMAT,
+                           FOREGROUND_COLOR_BASE + color);
+
+        terminal->foreground_color = color;
+        terminal->has_known_foreground_color = true;
+        ply_terminal_finish_output (terminal, false);
+}
+
+void
+ply_terminal_set_background_color (ply_terminal_t      *terminal,
+                                   ply_terminal_color_t color)
+{
+        assert (terminal != NULL);
+
+        if (terminal->has_known_background_color && terminal->background_color == color)
+                return;
+
+        ply_buffer_append (terminal->output_buffer, COLOR_SEQUENCE_FORMAT,
+                           BACKGROUND_COLOR_BASE + color);
+
+        terminal->background_color = color;
+        terminal->has_known_background_color = true;
+        ply_terminal_finish_output (terminal, false);
+}
+
+void
+ply_terminal_hold_output (ply_terminal_t *terminal)
+{
+        assert (terminal != NULL);
+
+        if (terminal->output_hold_count == 0)
+                ply_terminal_forget_output_state (terminal);
+
+        terminal->output_hold_count++;
+}
+
+void
+ply_terminal_release_output (ply_terminal_t *terminal)
+{
+        assert (terminal != NULL);
+
+        if (terminal->output_hold_count == 0)
+                return;
+
+        terminal->output_hold_count--;
+        ply_terminal_finish_output (terminal, true);
 }
 
 static void
@@ -618,8 +1090,9 @@ ply_terminal_open_device (ply_terminal_t *terminal)
                 return PLY_TERMINAL_OPEN_RESULT_FAILURE;
         }
 
-        ply_set_fd_as_blocking (terminal->fd);
-
+        /* Output stays non-blocking so a slow serial console can't stall
+         * the daemon; it gets queued instead
+         */
         terminal->fd_watch = ply_event_loop_watch_fd (terminal->loop, terminal->fd,
                                                       PLY_EVENT_LOOP_FD_STATUS_HAS_DATA,
                                                       (ply_event_handler_t) on_tty_input,
@@ -714,6 +1187,13 @@ ply_terminal_close (ply_terminal_t *terminal)
 
         terminal->is_open = false;
 
+        /* Whatever the terminal can't take right away is lost */
+        ply_terminal_flush_output (terminal, false);
+        ply_terminal_stop_watching_for_writability (terminal);
+        ply_terminal_write_pending_output (terminal);
+        ply_terminal_drop_pending_output (terminal);
+        ply_terminal_forget_output_state (terminal);
+
         ply_terminal_stop_watching_for_vt_changes (terminal);
 
         ply_trace ("restoring color palette");
@@ -892,6 +1372,9 @@ ply_terminal_free (ply_terminal_t *terminal)
 
         free_vt_change_closures (terminal);
         free_input_closures (terminal);
+        ply_buffer_free (terminal->output_buffer);
+        ply_terminal_drop_pending_output (terminal);
+        ply_list_free (terminal->pending_output);
         free (terminal->name);
         free (terminal);
 }
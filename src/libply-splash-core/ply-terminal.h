@@ -77,6 +77,35 @@ __attribute__((__format__ (__printf__, 2, 3)))
 void ply_terminal_write (ply_terminal_t *terminal,
                          const char     *format,
                          ...);
+
+/* Like ply_terminal_write, but passes the bytes through unformatted */
+void ply_terminal_write_data (ply_terminal_t *terminal,
+                              const char     *data,
+                              size_t          size);
+
+/* Like ply_terminal_write, but for output that leaves colors alone */
+__attribute__((__format__ (__printf__, 2, 3)))
+void ply_terminal_write_text (ply_terminal_t *terminal,
+                              const char     *format,
+                              ...);
+__attribute__((__format__ (__printf__, 2, 0)))
+void ply_terminal_vwrite_text (ply_terminal_t *terminal,
+                               const char     *format,
+                               va_list         args);
+void ply_terminal_set_cursor_position (ply_terminal_t *terminal,
+                                       int             column,
+                                       int             row);
+void ply_terminal_set_foreground_color (ply_terminal_t      *terminal,
+                                        ply_terminal_color_t color);
+void ply_terminal_set_background_color (ply_terminal_t      *terminal,
+                                        ply_terminal_color_t color);
+
+/* While held, output is collected and written with a single syscall once
+ * every hold is released, and repeated cursor moves and color changes are
+ * dropped
+ */
+void ply_terminal_hold_output (ply_terminal_t *terminal);
+void ply_terminal_release_output (ply_terminal_t *terminal);
 int ply_terminal_get_number_of_columns (ply_terminal_t *terminal);
 int ply_terminal_get_number_of_rows (ply_terminal_t *terminal);
 
@@ -53,10 +53,6 @@
 #define BACKSPACE "\b\033[0K"
 #endif
 
-#ifndef MOVE_CURSOR_SEQUENCE
-#define MOVE_CURSOR_SEQUENCE "\033[%d;%df"
-#endif
-
 #ifndef HIDE_CURSOR_SEQUENCE
 #define HIDE_CURSOR_SEQUENCE "\033[?25l"
 #endif
@@ -65,10 +61,6 @@
 #define SHOW_CURSOR_SEQUENCE "\033[?25h"
 #endif
 
-#ifndef COLOR_SEQUENCE_FORMAT
-#define COLOR_SEQUENCE_FORMAT "\033[%dm"
-#endif
-
 #ifndef PAUSE_SEQUENCE
 #define PAUSE_SEQUENCE "\023"
 #endif
@@ -77,14 +69,6 @@
 #define UNPAUSE_SEQUENCE "\021"
 #endif
 
-#ifndef FOREGROUND_COLOR_BASE
-#define FOREGROUND_COLOR_BASE 30
-#endif
-
-#ifndef BACKGROUND_COLOR_BASE
-#define BACKGROUND_COLOR_BASE 40
-#endif
-
 #ifndef TEXT_PALETTE_SIZE
 #define TEXT_PALETTE_SIZE 48
 #endif
@@ -141,9 +125,7 @@ ply_text_display_set_cursor_position (ply_text_display_t *display,
         column = CLAMP (column, 0, number_of_columns - 1);
         row = CLAMP (row, 0, number_of_rows - 1);
 
-        ply_terminal_write (display->terminal,
-                            MOVE_CURSOR_SEQUENCE,
-                            row, column);
+        ply_terminal_set_cursor_position (display->terminal, column, row);
 }
 
 void
@@ -152,8 +134,8 @@ ply_text_display_clear_screen (ply_text_display_t *display)
         if (ply_is_tracing_to_terminal ())
                 return;
 
-        ply_terminal_write (display->terminal,
-                            CLEAR_SCREEN_SEQUENCE);
+        ply_terminal_write_text (display->terminal,
+                                 CLEAR_SCREEN_SEQUENCE);
 
         ply_text_display_set_cursor_position (display, 0, 0);
 }
@@ -161,24 +143,22 @@ ply_text_display_clear_screen (ply_text_display_t *display)
 void
 ply_text_display_clear_line (ply_text_display_t *display)
 {
-        ply_terminal_write (display->terminal,
-                            CLEAR_LINE_SEQUENCE);
+        ply_terminal_write_text (display->terminal,
+                                 CLEAR_LINE_SEQUENCE);
 }
 
 void
 ply_text_display_remove_character (ply_text_display_t *display)
 {
-        ply_terminal_write (display->terminal,
-                            BACKSPACE);
+        ply_terminal_write_text (display->terminal,
+                                 BACKSPACE);
 }
 
 void
 ply_text_display_set_background_color (ply_text_display_t  *display,
                                        ply_terminal_color_t color)
 {
-        ply_terminal_write (display->terminal,
-                            COLOR_SEQUENCE_FORMAT,
-                            BACKGROUND_COLOR_BASE + color);
+        ply_terminal_set_background_color (display->terminal, color);
 
         display->background_color = color;
 }
@@ -187,9 +167,7 @@ void
 ply_text_display_set_foreground_color (ply_text_display_t  *display,
                                        ply_terminal_color_t color)
 {
-        ply_terminal_write (display->terminal,
-                            COLOR_SEQUENCE_FORMAT,
-                            FOREGROUND_COLOR_BASE + color);
+        ply_terminal_set_foreground_color (display->terminal, color);
 
         display->foreground_color = color;
 }
@@ -213,17 +191,21 @@ ply_text_display_draw_area (ply_text_display_t *display,
                             int                 width,
                             int                 height)
 {
-        if (display->draw_handler != NULL)
-                display->draw_handler (display->draw_handler_user_data,
-                                       display->terminal,
-                                       x, y, width, height);
+        if (display->draw_handler == NULL)
+                return;
+
+        ply_terminal_hold_output (display->terminal);
+        display->draw_handler (display->draw_handler_user_data,
+                               display->terminal,
+                               x, y, width, height);
+        ply_terminal_release_output (display->terminal);
 }
 
 void
 ply_text_display_hide_cursor (ply_text_display_t *display)
 {
-        ply_terminal_write (display->terminal,
-                            HIDE_CURSOR_SEQUENCE);
+        ply_terminal_write_text (display->terminal,
+                                 HIDE_CURSOR_SEQUENCE);
 }
 
 void
@@ -231,30 +213,21 @@ ply_text_display_write (ply_text_display_t *display,
                         const char         *format,
                         ...)
 {
-        int fd;
-
         va_list args;
-        char *string;
 
         assert (display != NULL);
         assert (format != NULL);
 
-        fd = ply_terminal_get_fd (display->terminal);
-
-        string = NULL;
         va_start (args, format);
-        vasprintf (&string, format, args);
+        ply_terminal_vwrite_text (display->terminal, format, args);
         va_end (args);
-
-        write (fd, string, strlen (string));
-        free (string);
 }
 
 void
 ply_text_display_show_cursor (ply_text_display_t *display)
 {
-        ply_terminal_write (display->terminal,
-                            SHOW_CURSOR_SEQUENCE);
+        ply_terminal_write_text (display->terminal,
+                                 SHOW_CURSOR_SEQUENCE);
 }
 
 bool
@@ -300,15 +273,29 @@ ply_text_display_set_draw_handler (ply_text_display_t             *display,
 void
 ply_text_display_pause_updates (ply_text_display_t *display)
 {
-        ply_terminal_write (display->terminal,
-                            PAUSE_SEQUENCE);
+        ply_terminal_write_text (display->terminal,
+                                 PAUSE_SEQUENCE);
+        ply_terminal_hold_output (display->terminal);
 }
 
 void
 ply_text_display_unpause_updates (ply_text_display_t *display)
 {
-        ply_terminal_write (display->terminal,
-                            UNPAUSE_SEQUENCE);
+        ply_terminal_write_text (display->terminal,
+                                 UNPAUSE_SEQUENCE);
+        ply_terminal_release_output (display->terminal);
+}
+
+void
+ply_text_display_hold_output (ply_text_display_t *display)
+{
+        ply_terminal_hold_output (display->terminal);
+}
+
+void
+ply_text_display_release_output (ply_text_display_t *display)
+{
+        ply_terminal_release_output (display->terminal);
 }
 
 void
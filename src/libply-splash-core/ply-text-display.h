@@ -82,6 +82,8 @@ void ply_text_display_set_draw_handler (ply_text_display_t             *display,
                                         void                           *user_data);
 void ply_text_display_pause_updates (ply_text_display_t *display);
 void ply_text_display_unpause_updates (ply_text_display_t *display);
+void ply_text_display_hold_output (ply_text_display_t *display);
+void ply_text_display_release_output (ply_text_display_t *display);
 
 #endif
 
@@ -181,6 +181,8 @@ ply_text_progress_bar_draw (ply_text_progress_bar_t *progress_bar)
 
         width = progress_bar->number_of_columns - 2 - strlen (os_string);
 
+        ply_text_display_hold_output (progress_bar->display);
+
         ply_text_display_set_cursor_position (progress_bar->display,
                                               progress_bar->column,
                                               progress_bar->row);
@@ -231,6 +233,8 @@ ply_text_progress_bar_draw (ply_text_progress_bar_t *progress_bar)
                 ply_text_display_set_foreground_color (progress_bar->display,
                                                        PLY_TERMINAL_COLOR_DEFAULT);
         }
+
+        ply_text_display_release_output (progress_bar->display);
 }
 
 void
@@ -73,6 +73,8 @@ ply_text_step_bar_draw (ply_text_step_bar_t *step_bar)
         if (step_bar->is_hidden)
                 return;
 
+        ply_text_display_hold_output (step_bar->display);
+
         ply_text_display_set_background_color (step_bar->display,
                                                PLY_TERMINAL_COLOR_BLACK);
 
@@ -96,6 +98,8 @@ ply_text_step_bar_draw (ply_text_step_bar_t *step_bar)
 
         ply_text_display_set_foreground_color (step_bar->display,
                                                PLY_TERMINAL_COLOR_DEFAULT);
+
+        ply_text_display_release_output (step_bar->display);
 }
 
 void
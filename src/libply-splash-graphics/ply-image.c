@@ -159,6 +159,7 @@ ply_image_load_png (ply_image_t *image,
         struct png_load_state *state;
         png_uint_32 width, height, row;
         int bits_per_pixel, color_type, interlace_method;
+        bool has_alpha;
         uint32_t *bytes;
 
         assert (image != NULL);
@@ -192,8 +193,12 @@ ply_image_load_png (ply_image_t *image,
         if ((color_type == PNG_COLOR_TYPE_GRAY) && (bits_per_pixel < 8))
                 png_set_expand_gray_1_2_4_to_8 (png);
 
-        if (png_get_valid (png, info, PNG_INFO_tRNS))
+        has_alpha = (color_type & PNG_COLOR_MASK_ALPHA) != 0;
+
+        if (png_get_valid (png, info, PNG_INFO_tRNS)) {
                 png_set_tRNS_to_alpha (png);
+                has_alpha = true;
+        }
 
         if (bits_per_pixel == 16)
                 png_set_strip_16 (png);
@@ -233,6 +238,10 @@ ply_image_load_png (ply_image_t *image,
         png_read_end (png, info);
         png_destroy_read_struct (&png, &info, NULL);
 
+        /* Lets compositors skip whatever is underneath */
+        if (!has_alpha)
+                ply_pixel_buffer_set_opaque (state->buffer, true);
+
         image->buffer = state->buffer;
         free (state);
         return true;
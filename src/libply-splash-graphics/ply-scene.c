@@ -0,0 +1,503 @@
+/* ply-scene.c - retained mode layer compositor
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+#include "ply-scene.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ply-list.h"
+#include "ply-logger.h"
+#include "ply-pixel-buffer.h"
+#include "ply-pixel-display.h"
+#include "ply-rectangle.h"
+#include "ply-region.h"
+#include "ply-utils.h"
+
+struct _ply_scene_layer
+{
+        ply_scene_t                   *scene;
+
+        ply_pixel_buffer_t            *buffer;
+        ply_scene_layer_draw_handler_t draw_handler;
+        void                          *draw_handler_user_data;
+
+        ply_rectangle_t                area;
+        int                            z;
+        double                         opacity;
+
+        uint32_t                       is_hidden : 1;
+        uint32_t                       is_opaque : 1;
+};
+
+struct _ply_scene
+{
+        ply_pixel_display_t *display;
+
+        /* sorted by z, bottom-most layer first */
+        ply_list_t          *layers;
+        ply_region_t        *damage;
+
+        /* where translucent draw handler layers get drawn before being
+         * blended in, the size of the buffer being drawn to
+         */
+        ply_pixel_buffer_t  *scratch_buffer;
+};
+
+ply_scene_t *
+ply_scene_new (ply_pixel_display_t *display)
+{
+        ply_scene_t *scene;
+
+        scene = calloc (1, sizeof(ply_scene_t));
+        scene->display = display;
+        scene->layers = ply_list_new ();
+        scene->damage = ply_region_new ();
+
+        return scene;
+}
+
+void
+ply_scene_free (ply_scene_t *scene)
+{
+        ply_list_node_t *node;
+
+        if (scene == NULL)
+                return;
+
+        ply_list_foreach (scene->layers, node) {
+                free (ply_list_node_get_data (node));
+        }
+
+        ply_list_free (scene->layers);
+        ply_region_free (scene->damage);
+        ply_pixel_buffer_free (scene->scratch_buffer);
+        free (scene);
+}
+
+static void
+ply_scene_insert_layer (ply_scene_t       *scene,
+                        ply_scene_layer_t *layer)
+{
+        ply_list_node_t *node;
+        ply_list_node_t *node_before = NULL;
+
+        /* Layers with the same z stack in the order they were added */
+        ply_list_foreach (scene->layers, node) {
+                ply_scene_layer_t *other_layer = ply_list_node_get_data (node);
+
+                if (other_layer->z > layer->z)
+                        break;
+
+                node_before = node;
+        }
+
+        ply_list_insert_data (scene->layers, layer, node_before);
+}
+
+ply_scene_layer_t *
+ply_scene_add_layer (ply_scene_t *scene,
+                     int          z)
+{
+        ply_scene_layer_t *layer;
+
+        assert (scene != NULL);
+
+        layer = calloc (1, sizeof(ply_scene_layer_t));
+        layer->scene = scene;
+        layer->z = z;
+        layer->opacity = 1.0;
+
+        ply_scene_insert_layer (scene, layer);
+
+        return layer;
+}
+
+void
+ply_scene_remove_layer (ply_scene_t       *scene,
+                        ply_scene_layer_t *layer)
+{
+        if (layer == NULL)
+                return;
+
+        ply_scene_layer_damage (layer);
+        ply_list_remove_data (scene->layers, layer);
+        free (layer);
+}
+
+void
+ply_scene_damage_area (ply_scene_t     *scene,
+                       ply_rectangle_t *area)
+{
+        if (ply_rectangle_is_empty (area))
+                return;
+
+        ply_region_add_rectangle (scene->damage, area);
+}
+
+ply_region_t *
+ply_scene_get_damage (ply_scene_t *scene)
+{
+        return scene->damage;
+}
+
+void
+ply_scene_layer_damage (ply_scene_layer_t *layer)
+{
+        if (layer->is_hidden)
+                return;
+
+        ply_scene_damage_area (layer->scene, &layer->area);
+}
+
+void
+ply_scene_layer_set_buffer (ply_scene_layer_t  *layer,
+                            ply_pixel_buffer_t *buffer)
+{
+        ply_scene_layer_damage (layer);
+
+        layer->buffer = buffer;
+        layer->draw_handler = NULL;
+        layer->draw_handler_user_data = NULL;
+
+        if (buffer != NULL) {
+                layer->area.width = ply_pixel_buffer_get_width (buffer);
+                layer->area.height = ply_pixel_buffer_get_height (buffer);
+                layer->is_opaque = ply_pixel_buffer_is_opaque (buffer);
+        } else {
+                layer->area.width = 0;
+                layer->area.height = 0;
+                layer->is_opaque = false;
+        }
+
+        ply_scene_layer_damage (layer);
+}
+
+void
+ply_scene_layer_set_draw_handler (ply_scene_layer_t             *layer,
+                                  ply_scene_layer_draw_handler_t draw_handler,
+                                  void                          *user_data,
+                                  unsigned long                  width,
+                                  unsigned long                  height)
+{
+        ply_scene_layer_damage (layer);
+
+        layer->buffer = NULL;
+        layer->draw_handler = draw_handler;
+        layer->draw_handler_user_data = user_data;
+        layer->area.width = width;
+        layer->area.height = height;
+        layer->is_opaque = false;
+
+        ply_scene_layer_damage (layer);
+}
+
+void
+ply_scene_layer_set_position (ply_scene_layer_t *layer,
+                              long               x,
+                              long               y)
+{
+        if (layer->area.x == x && layer->area.y == y)
+                return;
+
+        ply_scene_layer_damage (layer);
+        layer->area.x = x;
+        layer->area.y = y;
+        ply_scene_layer_damage (layer);
+}
+
+void
+ply_scene_layer_set_z (ply_scene_layer_t *layer,
+                       int                z)
+{
+        if (layer->z == z)
+                return;
+
+        ply_list_remove_data (layer->scene->layers, layer);
+        layer->z = z;
+        ply_scene_insert_layer (layer->scene, layer);
+
+        ply_scene_layer_damage (layer);
+}
+
+void
+ply_scene_layer_set_opacity (ply_scene_layer_t *layer,
+                             double             opacity)
+{
+        opacity = CLAMP (opacity, 0.0, 1.0);
+
+        if (layer->opacity == opacity)
+                return;
+
+        layer->opacity = opacity;
+        ply_scene_layer_damage (layer);
+}
+
+void
+ply_scene_layer_set_opaque (ply_scene_layer_t *layer,
+                            bool               is_opaque)
+{
+        layer->is_opaque = is_opaque;
+}
+
+void
+ply_scene_layer_show (ply_scene_layer_t *layer)
+{
+        if (!layer->is_hidden)
+                return;
+
+        layer->is_hidden = false;
+        ply_scene_layer_damage (layer);
+}
+
+void
+ply_scene_layer_hide (ply_scene_layer_t *layer)
+{
+        if (layer->is_hidden)
+                return;
+
+        ply_scene_layer_damage (layer);
+        layer->is_hidden = true;
+}
+
+void
+ply_scene_layer_get_area (ply_scene_layer_t *layer,
+                          ply_rectangle_t   *area)
+{
+        *area = layer->area;
+}
+
+static bool
+ply_scene_layer_is_drawable (ply_scene_layer_t *layer)
+{
+        if (layer->is_hidden || layer->opacity <= 0.0)
+                return false;
+
+        if (layer->buffer == NULL && layer->draw_handler == NULL)
+                return false;
+
+        return !ply_rectangle_is_empty (&layer->area);
+}
+
+static bool
+ply_scene_layer_covers (ply_scene_layer_t *layer,
+                        ply_rectangle_t   *area)
+{
+        if (!layer->is_opaque || layer->opacity < 1.0)
+                return false;
+
+        if (!ply_scene_layer_is_drawable (layer))
+                return false;
+
+        return area->x >= layer->area.x &&
+               area->y >= layer->area.y &&
+               area->x + (long) area->width <= layer->area.x + (long) layer->area.width &&
+               area->y + (long) area->height <= layer->area.y + (long) layer->area.height;
+}
+
+static bool
+ply_scene_layer_is_occluded (ply_scene_t     *scene,
+                             ply_list_node_t *node,
+                             ply_rectangle_t *area)
+{
+        for (node = ply_list_get_next_node (scene->layers, node);
+             node != NULL;
+             node = ply_list_get_next_node (scene->layers, node)) {
+                if (ply_scene_layer_covers (ply_list_node_get_data (node), area))
+                        return true;
+        }
+
+        return false;
+}
+
+static ply_pixel_buffer_t *
+ply_scene_get_scratch_buffer (ply_scene_t        *scene,
+                              ply_pixel_buffer_t *buffer)
+{
+        unsigned long width, height;
+        int scale;
+
+        width = ply_pixel_buffer_get_width (buffer);
+        height = ply_pixel_buffer_get_height (buffer);
+        scale = ply_pixel_buffer_get_device_scale (buffer);
+
+        if (scene->scratch_buffer != NULL &&
+            ply_pixel_buffer_get_width (scene->scratch_buffer) == width &&
+            ply_pixel_buffer_get_height (scene->scratch_buffer) == height &&
+            ply_pixel_buffer_get_device_scale (scene->scratch_buffer) == scale)
+                return scene->scratch_buffer;
+
+        ply_pixel_buffer_free (scene->scratch_buffer);
+        scene->scratch_buffer = ply_pixel_buffer_new (width * scale, height * scale);
+        ply_pixel_buffer_set_device_scale (scene->scratch_buffer, scale);
+
+        return scene->scratch_buffer;
+}
+
+static void
+ply_scene_clear_scratch_area (ply_pixel_buffer_t *scratch_buffer,
+                              ply_rectangle_t    *area)
+{
+        ply_rectangle_t size, cleared_area;
+        uint32_t *bytes;
+        unsigned long row, row_width;
+        int scale;
+
+        size.x = 0;
+        size.y = 0;
+        size.width = ply_pixel_buffer_get_width (scratch_buffer);
+        size.height = ply_pixel_buffer_get_height (scratch_buffer);
+        ply_rectangle_intersect (area, &size, &cleared_area);
+
+        if (ply_rectangle_is_empty (&cleared_area))
+                return;
+
+        scale = ply_pixel_buffer_get_device_scale (scratch_buffer);
+        bytes = ply_pixel_buffer_get_argb32_data (scratch_buffer);
+        row_width = size.width * scale;
+
+        for (row = cleared_area.y * scale; row < (cleared_area.y + cleared_area.height) * scale; row++) {
+                memset (bytes + row * row_width + cleared_area.x * scale, 0,
+                        cleared_area.width * scale * sizeof(uint32_t));
+        }
+}
+
+static void
+ply_scene_layer_draw_area (ply_scene_layer_t  *layer,
+                           ply_pixel_buffer_t *buffer,
+                           ply_rectangle_t    *area)
+{
+        ply_pixel_buffer_t *scratch_buffer;
+
+        if (layer->buffer != NULL) {
+                ply_pixel_buffer_fill_with_buffer_at_opacity (buffer,
+                                                              layer->buffer,
+                                                              layer->area.x,
+                                                              layer->area.y,
+                                                              layer->opacity);
+                return;
+        }
+
+        if (layer->opacity >= 1.0) {
+                layer->draw_handler (layer->draw_handler_user_data,
+                                     buffer,
+                                     area->x, area->y,
+                                     area->width, area->height);
+                return;
+        }
+
+        /* Draw handlers can only paint straight into a buffer, so a
+         * translucent one paints into a cleared scratch area that then
+         * gets blended in at the layer's opacity
+         */
+        scratch_buffer = ply_scene_get_scratch_buffer (layer->scene, buffer);
+        ply_scene_clear_scratch_area (scratch_buffer, area);
+
+        ply_pixel_buffer_push_clip_area (scratch_buffer, area);
+        layer->draw_handler (layer->draw_handler_user_data,
+                             scratch_buffer,
+                             area->x, area->y,
+                             area->width, area->height);
+        ply_pixel_buffer_pop_clip_area (scratch_buffer);
+        ply_region_clear (ply_pixel_buffer_get_updated_areas (scratch_buffer));
+
+        ply_pixel_buffer_push_clip_area (buffer, area);
+        ply_pixel_buffer_fill_with_buffer_at_opacity (buffer, scratch_buffer, 0, 0, layer->opacity);
+        ply_pixel_buffer_pop_clip_area (buffer);
+}
+
+void
+ply_scene_draw_area (ply_scene_t        *scene,
+                     ply_pixel_buffer_t *buffer,
+                     long                x,
+                     long                y,
+                     unsigned long       width,
+                     unsigned long       height)
+{
+        ply_list_node_t *node;
+        ply_rectangle_t area;
+
+        assert (scene != NULL);
+        assert (buffer != NULL);
+
+        area.x = x;
+        area.y = y;
+        area.width = width;
+        area.height = height;
+
+        if (ply_rectangle_is_empty (&area))
+                return;
+
+        ply_pixel_buffer_push_clip_area (buffer, &area);
+
+        ply_list_foreach (scene->layers, node) {
+                ply_scene_layer_t *layer = ply_list_node_get_data (node);
+                ply_rectangle_t layer_area;
+
+                if (!ply_scene_layer_is_drawable (layer))
+                        continue;
+
+                ply_rectangle_intersect (&layer->area, &area, &layer_area);
+
+                if (ply_rectangle_is_empty (&layer_area))
+                        continue;
+
+                /* Skip layers that an opaque layer above hides completely
+                 * within the area being drawn
+                 */
+                if (ply_scene_layer_is_occluded (scene, node, &layer_area))
+                        continue;
+
+                ply_scene_layer_draw_area (layer, buffer, &layer_area);
+        }
+
+        ply_pixel_buffer_pop_clip_area (buffer);
+}
+
+void
+ply_scene_update (ply_scene_t *scene)
+{
+        ply_rectangle_t *rectangles;
+        size_t number_of_rectangles, i;
+
+        assert (scene != NULL);
+
+        if (ply_region_is_empty (scene->damage))
+                return;
+
+        if (scene->display == NULL) {
+                ply_region_clear (scene->damage);
+                return;
+        }
+
+        rectangles = ply_region_get_rectangles (scene->damage, &number_of_rectangles);
+
+        ply_pixel_display_pause_updates (scene->display);
+        for (i = 0; i < number_of_rectangles; i++) {
+                ply_pixel_display_draw_area (scene->display,
+                                             rectangles[i].x, rectangles[i].y,
+                                             rectangles[i].width, rectangles[i].height);
+        }
+        ply_pixel_display_unpause_updates (scene->display);
+
+        ply_region_clear (scene->damage);
+}
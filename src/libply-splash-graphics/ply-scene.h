@@ -0,0 +1,84 @@
+/* ply-scene.h - retained mode layer compositor
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+#ifndef PLY_SCENE_H
+#define PLY_SCENE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ply-pixel-buffer.h"
+#include "ply-pixel-display.h"
+#include "ply-region.h"
+
+typedef struct _ply_scene ply_scene_t;
+typedef struct _ply_scene_layer ply_scene_layer_t;
+
+typedef void (*ply_scene_layer_draw_handler_t) (void               *user_data,
+                                                ply_pixel_buffer_t *buffer,
+                                                long                x,
+                                                long                y,
+                                                unsigned long       width,
+                                                unsigned long       height);
+
+#ifndef PLY_HIDE_FUNCTION_DECLARATIONS
+ply_scene_t *ply_scene_new (ply_pixel_display_t *display);
+void ply_scene_free (ply_scene_t *scene);
+
+ply_scene_layer_t *ply_scene_add_layer (ply_scene_t *scene,
+                                        int          z);
+void ply_scene_remove_layer (ply_scene_t       *scene,
+                             ply_scene_layer_t *layer);
+
+void ply_scene_layer_set_buffer (ply_scene_layer_t  *layer,
+                                 ply_pixel_buffer_t *buffer);
+void ply_scene_layer_set_draw_handler (ply_scene_layer_t             *layer,
+                                       ply_scene_layer_draw_handler_t draw_handler,
+                                       void                          *user_data,
+                                       unsigned long                  width,
+                                       unsigned long                  height);
+void ply_scene_layer_set_position (ply_scene_layer_t *layer,
+                                   long               x,
+                                   long               y);
+void ply_scene_layer_set_z (ply_scene_layer_t *layer,
+                            int                z);
+void ply_scene_layer_set_opacity (ply_scene_layer_t *layer,
+                                  double             opacity);
+void ply_scene_layer_set_opaque (ply_scene_layer_t *layer,
+                                 bool               is_opaque);
+void ply_scene_layer_show (ply_scene_layer_t *layer);
+void ply_scene_layer_hide (ply_scene_layer_t *layer);
+void ply_scene_layer_damage (ply_scene_layer_t *layer);
+void ply_scene_layer_get_area (ply_scene_layer_t *layer,
+                               ply_rectangle_t   *area);
+
+void ply_scene_damage_area (ply_scene_t     *scene,
+                            ply_rectangle_t *area);
+ply_region_t *ply_scene_get_damage (ply_scene_t *scene);
+
+void ply_scene_draw_area (ply_scene_t        *scene,
+                          ply_pixel_buffer_t *buffer,
+                          long                x,
+                          long                y,
+                          unsigned long       width,
+                          unsigned long       height);
+void ply_scene_update (ply_scene_t *scene);
+#endif
+
+#endif /* PLY_SCENE_H */
@@ -50,10 +50,21 @@ struct _ply_hashtable
         ply_hashtable_hash_func_t    *hash_func;
 };
 
+/* Pointers are aligned and small integers are close together, so mix
+ * every bit into the low ones the table index is taken from
+ */
 unsigned int
 ply_hashtable_direct_hash (void *element)
 {
-        return (unsigned int) (intptr_t) element;
+        uint64_t hash = (uint64_t) (uintptr_t) element;
+
+        hash ^= hash >> 33;
+        hash *= UINT64_C (0xff51afd7ed558ccd);
+        hash ^= hash >> 33;
+        hash *= UINT64_C (0xc4ceb9fe1a85ec53);
+        hash ^= hash >> 33;
+
+        return (unsigned int) hash;
 }
 
 int
@@ -66,13 +77,23 @@ ply_hashtable_direct_compare (void *elementa,
 unsigned int
 ply_hashtable_string_hash (void *element)
 {
-        char *strptr;
-        unsigned int hash = 0;
-
-        for (strptr = element; *strptr; strptr++) {
-                hash ^= *strptr;
-                hash ^= hash << 1;
+        const unsigned char *byte;
+        uint32_t hash = UINT32_C (2166136261);
+
+        /* FNV-1a, with a final mix so keys like "1" and "2" that differ
+         * only in their last byte still spread over the low bits
+         */
+        for (byte = element; *byte != '\0'; byte++) {
+                hash ^= *byte;
+                hash *= UINT32_C (16777619);
         }
+
+        hash ^= hash >> 16;
+        hash *= UINT32_C (0x85ebca6b);
+        hash ^= hash >> 13;
+        hash *= UINT32_C (0xc2b2ae35);
+        hash ^= hash >> 16;
+
         return hash;
 }
 
@@ -178,8 +199,21 @@ ply_hashtable_resize (ply_hashtable_t *hashtable)
 static inline void
 ply_hashtable_resize_check (ply_hashtable_t *hashtable)
 {
-        if (hashtable->total_node_count < (hashtable->dirty_node_count * 2))
+        /* Removed nodes still count against occupancy since lookups have to
+         * probe past them, so this also rehashes away piled up tombstones
+         */
+        if (hashtable->total_node_count < (hashtable->dirty_node_count * 2)) {
                 ply_hashtable_resize (hashtable); /* hash tables work best below 50% occupancy */
+                return;
+        }
+
+        /* Shrink once most entries are gone, so foreach and the bitmaps
+         * don't keep walking a table sized for the old peak. This isn't
+         * done on removal since foreach callbacks remove entries.
+         */
+        if (hashtable->total_node_count > 64 &&
+            hashtable->total_node_count > (hashtable->live_node_count + 1) * 32)
+                ply_hashtable_resize (hashtable);
 }
 
 void
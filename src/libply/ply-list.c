@@ -25,15 +25,24 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
+/* Removed nodes are kept around, linked through next, to be reused by
+ * later insertions instead of going back to malloc each time
+ */
+#define PLY_LIST_MAX_FREE_NODES 256
+
 struct _ply_list
 {
         ply_list_node_t *first_node;
         ply_list_node_t *last_node;
 
         int              number_of_nodes;
+
+        ply_list_node_t *free_nodes;
+        int              number_of_free_nodes;
 };
 
 struct _ply_list_node
@@ -57,19 +66,22 @@ ply_list_new (void)
         return list;
 }
 
-void
-ply_list_free (ply_list_t *list)
-{
-        ply_list_remove_all_nodes (list);
-        free (list);
-}
-
 static ply_list_node_t *
-ply_list_node_new (void *data)
+ply_list_node_new (ply_list_t *list,
+                   void       *data)
 {
         ply_list_node_t *node;
 
-        node = calloc (1, sizeof(ply_list_node_t));
+        if (list->free_nodes != NULL) {
+                node = list->free_nodes;
+                list->free_nodes = node->next;
+                list->number_of_free_nodes--;
+
+                node->next = NULL;
+        } else {
+                node = calloc (1, sizeof(ply_list_node_t));
+        }
+
         node->data = data;
 
         return node;
@@ -86,6 +98,44 @@ ply_list_node_free (ply_list_node_t *node)
         free (node);
 }
 
+static void
+ply_list_recycle_node (ply_list_t      *list,
+                       ply_list_node_t *node)
+{
+        if (list->number_of_free_nodes >= PLY_LIST_MAX_FREE_NODES) {
+                ply_list_node_free (node);
+                return;
+        }
+
+        node->data = NULL;
+        node->next = list->free_nodes;
+        list->free_nodes = node;
+        list->number_of_free_nodes++;
+}
+
+void
+ply_list_free (ply_list_t *list)
+{
+        ply_list_node_t *node;
+
+        if (list == NULL)
+                return;
+
+        ply_list_remove_all_nodes (list);
+
+        node = list->free_nodes;
+        while (node != NULL) {
+                ply_list_node_t *next_node;
+
+                next_node = node->next;
+                node->next = NULL;
+                ply_list_node_free (node);
+                node = next_node;
+        }
+
+        free (list);
+}
+
 int
 ply_list_get_length (ply_list_t *list)
 {
@@ -148,7 +198,7 @@ ply_list_insert_data (ply_list_t      *list,
 {
         ply_list_node_t *node;
 
-        node = ply_list_node_new (data);
+        node = ply_list_node_new (list, data);
 
         ply_list_insert_node (list, node_before, node);
 
@@ -214,15 +264,17 @@ ply_list_unlink_node (ply_list_t      *list,
         node->next = NULL;
 
         list->number_of_nodes--;
-        assert (ply_list_find_node (list, node->data) != node);
 }
 
 void
 ply_list_remove_node (ply_list_t      *list,
                       ply_list_node_t *node)
 {
+        if (node == NULL)
+                return;
+
         ply_list_unlink_node (list, node);
-        ply_list_node_free (node);
+        ply_list_recycle_node (list, node);
 }
 
 void
@@ -278,79 +330,135 @@ ply_list_get_next_node (ply_list_t      *list,
         return node->next;
 }
 
-static void
-ply_list_sort_swap (void **element_a,
-                    void **element_b)
+ply_list_node_t *
+ply_list_get_previous_node (ply_list_t      *list,
+                            ply_list_node_t *node)
 {
-        void *temp;
-
-        temp = *element_a;
-        *element_a = *element_b;
-        *element_b = temp;
+        return node->previous;
 }
 
-static void
-ply_list_sort_body (ply_list_node_t         *node_start,
-                    ply_list_node_t         *node_end,
+static bool
+ply_list_is_sorted (ply_list_t              *list,
                     ply_list_compare_func_t *compare)
 {
-        if (node_start == node_end) return;
-        ply_list_node_t *cur_node = node_start;
-        ply_list_node_t *top_node = node_end;
-        ply_list_node_t *next_node = cur_node->next;
-        while (cur_node != top_node) {
-                int diff = compare (cur_node->data, next_node->data);
-                if (diff > 0) {
-                        ply_list_sort_swap (&next_node->data,
-                                            &cur_node->data);
-                        cur_node = next_node;
-                        next_node = cur_node->next;
+        ply_list_node_t *node;
+
+        for (node = list->first_node; node != NULL && node->next != NULL; node = node->next) {
+                if (compare (node->data, node->next->data) > 0)
+                        return false;
+        }
+
+        return true;
+}
+
+/* Merges the sorted runs starting at run_a and run_b, which are
+ * terminated by a NULL next pointer, taking from run_a on ties
+ */
+static ply_list_node_t *
+ply_list_merge_runs (ply_list_node_t         *run_a,
+                     ply_list_node_t         *run_b,
+                     ply_list_compare_func_t *compare,
+                     ply_list_node_t        **last_node)
+{
+        ply_list_node_t head = { NULL };
+        ply_list_node_t *tail = &head;
+
+        while (run_a != NULL && run_b != NULL) {
+                if (compare (run_a->data, run_b->data) <= 0) {
+                        tail->next = run_a;
+                        run_a = run_a->next;
                 } else {
-                        ply_list_sort_swap (&next_node->data,
-                                            &top_node->data);
-                        top_node = top_node->previous;
+                        tail->next = run_b;
+                        run_b = run_b->next;
                 }
+                tail = tail->next;
+        }
+
+        tail->next = run_a != NULL ? run_a : run_b;
+        while (tail->next != NULL) {
+                tail = tail->next;
         }
 
-        if (cur_node != node_end)
-                ply_list_sort_body (cur_node->next,
-                                    node_end,
-                                    compare);
-        if (cur_node != node_start)
-                ply_list_sort_body (node_start,
-                                    cur_node->previous,
-                                    compare);
+        *last_node = tail;
+        return head.next;
+}
+
+static ply_list_node_t *
+ply_list_split_run (ply_list_node_t *node,
+                    int              length)
+{
+        ply_list_node_t *rest;
+
+        while (--length > 0 && node != NULL) {
+                node = node->next;
+        }
+
+        if (node == NULL)
+                return NULL;
+
+        rest = node->next;
+        node->next = NULL;
+
+        return rest;
+}
+
+/* Bottom-up merge sort that relinks the nodes, so it's stable, needs no
+ * recursion and leaves each node holding the same data
+ */
+static void
+ply_list_merge_sort (ply_list_t              *list,
+                     ply_list_compare_func_t *compare)
+{
+        ply_list_node_t head = { NULL };
+        ply_list_node_t *node, *previous_node;
+        int run_length;
+
+        if (list->number_of_nodes < 2)
+                return;
+
+        if (ply_list_is_sorted (list, compare))
+                return;
+
+        head.next = list->first_node;
+
+        for (run_length = 1; run_length < list->number_of_nodes; run_length *= 2) {
+                ply_list_node_t *tail = &head;
+                ply_list_node_t *remaining = head.next;
+
+                while (remaining != NULL) {
+                        ply_list_node_t *run_a, *run_b, *last_node;
+
+                        run_a = remaining;
+                        run_b = ply_list_split_run (run_a, run_length);
+                        remaining = ply_list_split_run (run_b, run_length);
+
+                        tail->next = ply_list_merge_runs (run_a, run_b, compare, &last_node);
+                        tail = last_node;
+                }
+        }
+
+        previous_node = NULL;
+        for (node = head.next; node != NULL; node = node->next) {
+                node->previous = previous_node;
+                previous_node = node;
+        }
+
+        list->first_node = head.next;
+        list->last_node = previous_node;
 }
 
 void
 ply_list_sort (ply_list_t              *list,
                ply_list_compare_func_t *compare)
 {
-        ply_list_sort_body (ply_list_get_first_node (list),
-                            ply_list_get_last_node (list),
-                            compare);
+        ply_list_merge_sort (list, compare);
 }
 
 void
 ply_list_sort_stable (ply_list_t              *list,
                       ply_list_compare_func_t *compare)
 {
-        ply_list_node_t *top_node;
-        ply_list_node_t *cur_node;
-
-        top_node = ply_list_get_first_node (list);
-        if (top_node == NULL) return;
-        top_node = top_node->next;
-
-        while (top_node) {
-                cur_node = top_node->previous;
-                while (cur_node && compare (cur_node->data, cur_node->next->data) > 0) {
-                        ply_list_sort_swap (&cur_node->data,
-                                            &cur_node->next->data);
-                        cur_node = cur_node->previous;
-                }
-                top_node = top_node->next;
-        }
+        ply_list_merge_sort (list, compare);
 }
 
 void *
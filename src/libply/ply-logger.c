@@ -36,6 +36,7 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "ply-event-loop.h"
 #include "ply-utils.h"
 #include "ply-list.h"
 
@@ -51,6 +52,17 @@
 #define PLY_LOGGER_MAX_BUFFER_CAPACITY (8 * 4096)
 #endif
 
+/* With the deferred flush policy, output is written once this much has
+ * built up, or once the oldest of it has waited this long
+ */
+#ifndef PLY_LOGGER_FLUSH_THRESHOLD
+#define PLY_LOGGER_FLUSH_THRESHOLD (PLY_LOGGER_MAX_BUFFER_CAPACITY / 2)
+#endif
+
+#ifndef PLY_LOGGER_FLUSH_DELAY
+#define PLY_LOGGER_FLUSH_DELAY 0.5
+#endif
+
 typedef struct
 {
         ply_logger_filter_handler_t handler;
@@ -63,15 +75,20 @@ struct _ply_logger
         bool                      output_fd_is_terminal;
         char                     *filename;
 
+        /* fixed size ring, buffer_size bytes starting at buffer_start */
         char                     *buffer;
+        size_t                    buffer_start;
         size_t                    buffer_size;
-        size_t                    buffer_capacity;
 
         ply_logger_flush_policy_t flush_policy;
         ply_list_t               *filters;
 
+        ply_event_loop_t         *loop;
+        double                    flush_deadline;
+
         uint32_t                  is_enabled : 1;
         uint32_t                  tracing_is_enabled : 1;
+        uint32_t                  flush_is_scheduled : 1;
 };
 
 static bool ply_text_is_loggable (const char *string,
@@ -151,29 +168,21 @@ ply_logger_flush_buffer (ply_logger_t *logger)
 {
         assert (logger != NULL);
 
-        if (logger->buffer_size == 0)
-                return true;
+        while (logger->buffer_size > 0) {
+                size_t size;
 
-        if (!ply_logger_write (logger, logger->buffer, logger->buffer_size, true))
-                return false;
-
-        memset (logger->buffer, '\0', logger->buffer_size);
-        logger->buffer_size = 0;
+                size = MIN (logger->buffer_size,
+                            PLY_LOGGER_MAX_BUFFER_CAPACITY - logger->buffer_start);
 
-        return true;
-}
-
-static bool
-ply_logger_increase_buffer_size (ply_logger_t *logger)
-{
-        assert (logger != NULL);
+                if (!ply_logger_write (logger, logger->buffer + logger->buffer_start, size, true))
+                        return false;
 
-        if ((logger->buffer_capacity * 2) > PLY_LOGGER_MAX_BUFFER_CAPACITY)
-                return false;
+                logger->buffer_start = (logger->buffer_start + size) % PLY_LOGGER_MAX_BUFFER_CAPACITY;
+                logger->buffer_size -= size;
+        }
 
-        logger->buffer_capacity *= 2;
+        logger->buffer_start = 0;
 
-        logger->buffer = realloc (logger->buffer, logger->buffer_capacity);
         return true;
 }
 
@@ -185,13 +194,8 @@ ply_logger_decapitate_buffer (ply_logger_t *logger,
 
         bytes_in_head = MIN (logger->buffer_size, bytes_in_head);
 
-        if (bytes_in_head == logger->buffer_size) {
-                logger->buffer_size = 0;
-        } else {
-                memmove (logger->buffer, logger->buffer + bytes_in_head,
-                         logger->buffer_size - bytes_in_head);
-                logger->buffer_size -= bytes_in_head;
-        }
+        logger->buffer_start = (logger->buffer_start + bytes_in_head) % PLY_LOGGER_MAX_BUFFER_CAPACITY;
+        logger->buffer_size -= bytes_in_head;
 }
 
 static bool
@@ -199,28 +203,128 @@ ply_logger_buffer (ply_logger_t *logger,
                    const char   *string,
                    size_t        length)
 {
-        assert (logger != NULL);
+        size_t end, size;
 
-        if ((logger->buffer_size + length) >= logger->buffer_capacity) {
-                if (!ply_logger_increase_buffer_size (logger)) {
-                        ply_logger_decapitate_buffer (logger, length);
+        assert (logger != NULL);
 
-                        if ((logger->buffer_size + length) >= logger->buffer_capacity)
-                                if (!ply_logger_increase_buffer_size (logger))
-                                        return false;
-                }
+        /* Only the end of something too big to ever fit is kept */
+        if (length > PLY_LOGGER_MAX_BUFFER_CAPACITY) {
+                string += length - PLY_LOGGER_MAX_BUFFER_CAPACITY;
+                length = PLY_LOGGER_MAX_BUFFER_CAPACITY;
         }
 
-        assert (logger->buffer_size + length < logger->buffer_capacity);
+        /* When full, make room by dropping as much of the oldest output
+         * as is being added
+         */
+        if (logger->buffer_size + length > PLY_LOGGER_MAX_BUFFER_CAPACITY)
+                ply_logger_decapitate_buffer (logger, length);
+
+        end = (logger->buffer_start + logger->buffer_size) % PLY_LOGGER_MAX_BUFFER_CAPACITY;
+        size = MIN (length, PLY_LOGGER_MAX_BUFFER_CAPACITY - end);
 
-        memcpy (logger->buffer + logger->buffer_size,
-                string, length);
+        memcpy (logger->buffer + end, string, size);
+        memcpy (logger->buffer, string + size, length - size);
 
         logger->buffer_size += length;
 
         return true;
 }
 
+static void
+ply_logger_on_flush_timeout (ply_logger_t     *logger,
+                             ply_event_loop_t *loop)
+{
+        logger->flush_is_scheduled = false;
+        ply_logger_flush (logger);
+}
+
+static void
+ply_logger_cancel_scheduled_flush (ply_logger_t *logger)
+{
+        if (!logger->flush_is_scheduled)
+                return;
+
+        if (logger->loop != NULL)
+                ply_event_loop_stop_watching_for_timeout (logger->loop,
+                                                          (ply_event_loop_timeout_handler_t)
+                                                          ply_logger_on_flush_timeout,
+                                                          logger);
+        logger->flush_is_scheduled = false;
+}
+
+static void
+ply_logger_schedule_flush (ply_logger_t *logger)
+{
+        double now;
+
+        /* Until there is somewhere to write to, flushing can't do
+         * anything, so don't keep waking up to try
+         */
+        if (logger->output_fd < 0 || logger->buffer_size == 0)
+                return;
+
+        if (logger->buffer_size >= PLY_LOGGER_FLUSH_THRESHOLD) {
+                ply_logger_flush (logger);
+                return;
+        }
+
+        if (logger->flush_is_scheduled)
+                return;
+
+        if (logger->loop != NULL) {
+                ply_event_loop_watch_for_timeout (logger->loop,
+                                                  PLY_LOGGER_FLUSH_DELAY,
+                                                  (ply_event_loop_timeout_handler_t)
+                                                  ply_logger_on_flush_timeout,
+                                                  logger);
+                logger->flush_is_scheduled = true;
+                return;
+        }
+
+        /* Without an event loop the deadline can only be checked as more
+         * output comes in
+         */
+        now = ply_get_timestamp ();
+
+        if (logger->flush_deadline == 0.0)
+                logger->flush_deadline = now + PLY_LOGGER_FLUSH_DELAY;
+        else if (now >= logger->flush_deadline)
+                ply_logger_flush (logger);
+}
+
+static void
+ply_logger_detach_from_event_loop (ply_logger_t *logger)
+{
+        logger->flush_is_scheduled = false;
+        logger->loop = NULL;
+}
+
+void
+ply_logger_attach_to_event_loop (ply_logger_t     *logger,
+                                 ply_event_loop_t *loop)
+{
+        assert (logger != NULL);
+
+        if (logger->loop == loop)
+                return;
+
+        if (logger->loop != NULL) {
+                ply_logger_cancel_scheduled_flush (logger);
+                ply_event_loop_stop_watching_for_exit (logger->loop,
+                                                       (ply_event_loop_exit_handler_t)
+                                                       ply_logger_detach_from_event_loop,
+                                                       logger);
+        }
+
+        logger->loop = loop;
+
+        if (loop != NULL)
+                ply_event_loop_watch_for_exit (loop,
+                                               (ply_event_loop_exit_handler_t)
+                                               ply_logger_detach_from_event_loop,
+                                               logger);
+}
+
 ply_logger_t *
 ply_logger_new (void)
 {
@@ -234,8 +338,8 @@ ply_logger_new (void)
         logger->is_enabled = true;
         logger->tracing_is_enabled = false;
 
-        logger->buffer_capacity = 4096;
-        logger->buffer = calloc (1, logger->buffer_capacity);
+        logger->buffer = malloc (PLY_LOGGER_MAX_BUFFER_CAPACITY);
+        logger->buffer_start = 0;
         logger->buffer_size = 0;
 
         logger->filters = ply_list_new ();
@@ -303,6 +407,7 @@ ply_logger_free (ply_logger_t *logger)
                 close (logger->output_fd);
         }
 
+        ply_logger_attach_to_event_loop (logger, NULL);
         ply_logger_free_filters (logger);
 
         free (logger->filename);
@@ -363,6 +468,9 @@ ply_logger_set_output_fd (ply_logger_t *logger,
 {
         assert (logger != NULL);
 
+        if (fd < 0)
+                ply_logger_cancel_scheduled_flush (logger);
+
         logger->output_fd = fd;
         logger->output_fd_is_terminal = isatty (fd);
 }
@@ -386,6 +494,8 @@ ply_logger_flush (ply_logger_t *logger)
         if (logger->output_fd < 0)
                 return false;
 
+        logger->flush_deadline = 0.0;
+
         if (!ply_logger_flush_buffer (logger))
                 return false;
 
@@ -544,11 +654,16 @@ ply_logger_inject_bytes (ply_logger_t *logger,
                 free (filtered_bytes);
         }
 
-        assert ((logger->flush_policy == PLY_LOGGER_FLUSH_POLICY_WHEN_ASKED)
-                || (logger->flush_policy == PLY_LOGGER_FLUSH_POLICY_EVERY_TIME));
-
-        if (logger->flush_policy == PLY_LOGGER_FLUSH_POLICY_EVERY_TIME)
+        switch (logger->flush_policy) {
+        case PLY_LOGGER_FLUSH_POLICY_WHEN_ASKED:
+                break;
+        case PLY_LOGGER_FLUSH_POLICY_EVERY_TIME:
                 ply_logger_flush (logger);
+                break;
+        case PLY_LOGGER_FLUSH_POLICY_DEFERRED:
+                ply_logger_schedule_flush (logger);
+                break;
+        }
 }
 
 void
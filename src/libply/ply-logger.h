@@ -29,12 +29,16 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "ply-event-loop.h"
+
 typedef struct _ply_logger ply_logger_t;
 
 typedef enum
 {
         PLY_LOGGER_FLUSH_POLICY_WHEN_ASKED = 0,
-        PLY_LOGGER_FLUSH_POLICY_EVERY_TIME
+        PLY_LOGGER_FLUSH_POLICY_EVERY_TIME,
+        /* once enough output builds up, or shortly after it comes in */
+        PLY_LOGGER_FLUSH_POLICY_DEFERRED
 } ply_logger_flush_policy_t;
 
 typedef void (*ply_logger_filter_handler_t) (void         *user_data,
@@ -57,6 +61,8 @@ bool ply_logger_flush (ply_logger_t *logger);
 void ply_logger_set_flush_policy (ply_logger_t             *logger,
                                   ply_logger_flush_policy_t policy);
 ply_logger_flush_policy_t ply_logger_get_flush_policy (ply_logger_t *logger);
+void ply_logger_attach_to_event_loop (ply_logger_t     *logger,
+                                      ply_event_loop_t *loop);
 void ply_logger_toggle_logging (ply_logger_t *logger);
 bool ply_logger_is_logging (ply_logger_t *logger);
 void ply_logger_inject_bytes (ply_logger_t *logger,
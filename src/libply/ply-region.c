@@ -26,14 +26,49 @@
 #include "ply-region.h"
 
 #include <assert.h>
+#include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "ply-list.h"
 #include "ply-rectangle.h"
 
+typedef enum
+{
+        PLY_REGION_OPERATION_UNION,
+        PLY_REGION_OPERATION_INTERSECT,
+        PLY_REGION_OPERATION_SUBTRACT,
+} ply_region_operation_t;
+
+#define PLY_REGION_NO_BAND SIZE_MAX
+
 struct _ply_region
 {
-        ply_list_t *rectangle_list;
+        /* The region is split into horizontal bands. Rectangles in a band
+         * share the same y and height and are sorted by x, with gaps between
+         * them. Bands are sorted by y and don't overlap, and touching bands
+         * with the same columns get merged into one.
+         */
+        ply_rectangle_t *rectangles;
+        size_t           number_of_rectangles;
+        size_t           capacity;
+
+        /* where operations build their result before it's swapped in */
+        ply_rectangle_t *scratch;
+        size_t           scratch_capacity;
+
+        /* Added rectangles are collected here and merged into the bands
+         * all at once, the next time the region is looked at
+         */
+        ply_rectangle_t *pending;
+        size_t           number_of_pending_rectangles;
+        size_t           pending_capacity;
+
+        ply_rectangle_t  extents;
+
+        ply_list_t      *rectangle_list;
+        uint32_t         rectangle_list_is_stale : 1;
 };
 
 ply_region_t *
@@ -51,22 +86,15 @@ ply_region_new (void)
 void
 ply_region_clear (ply_region_t *region)
 {
-        ply_list_node_t *node;
-
-        node = ply_list_get_first_node (region->rectangle_list);
-        while (node != NULL) {
-                ply_list_node_t *next_node;
-                ply_rectangle_t *rectangle;
-
-                rectangle = (ply_rectangle_t *) ply_list_node_get_data (node);
-
-                next_node = ply_list_get_next_node (region->rectangle_list, node);
-
-                free (rectangle);
-                ply_list_remove_node (region->rectangle_list, node);
+        assert (region != NULL);
 
-                node = next_node;
-        }
+        region->number_of_rectangles = 0;
+        region->number_of_pending_rectangles = 0;
+        region->extents.x = 0;
+        region->extents.y = 0;
+        region->extents.width = 0;
+        region->extents.height = 0;
+        region->rectangle_list_is_stale = true;
 }
 
 bool
@@ -74,396 +102,605 @@ ply_region_is_empty (ply_region_t *region)
 {
         assert (region != NULL);
 
-        return ply_list_get_first_node (region->rectangle_list) == NULL;
+        return region->number_of_rectangles == 0 &&
+               region->number_of_pending_rectangles == 0;
 }
 
 void
 ply_region_free (ply_region_t *region)
 {
-        ply_region_clear (region);
+        if (region == NULL)
+                return;
+
         ply_list_free (region->rectangle_list);
+        free (region->rectangles);
+        free (region->scratch);
+        free (region->pending);
         free (region);
 }
 
 static ply_rectangle_t *
-copy_rectangle (ply_rectangle_t *rectangle)
+reserve_rectangles (ply_rectangle_t **rectangles,
+                    size_t           *capacity,
+                    size_t            number_of_rectangles)
 {
-        ply_rectangle_t *new_rectangle;
+        if (number_of_rectangles <= *capacity)
+                return *rectangles;
 
-        new_rectangle = malloc (sizeof(*rectangle));
-        *new_rectangle = *rectangle;
+        *capacity = MAX (*capacity * 2, MAX (number_of_rectangles, 16));
+        *rectangles = realloc (*rectangles, *capacity * sizeof(ply_rectangle_t));
 
-        return new_rectangle;
+        return *rectangles;
 }
 
 static void
-merge_rectangle_with_sub_list (ply_region_t    *region,
-                               ply_rectangle_t *new_area,
-                               ply_list_node_t *node)
+ply_region_append_to_scratch (ply_region_t *region,
+                              size_t       *number_of_rectangles,
+                              long          x,
+                              long          y,
+                              unsigned long width,
+                              unsigned long height)
 {
-        if (ply_rectangle_is_empty (new_area)) {
-                free (new_area);
-                return;
-        }
+        ply_rectangle_t *rectangle;
 
-        while (node != NULL) {
-                ply_list_node_t *next_node;
-                ply_rectangle_t *old_area;
-                ply_rectangle_overlap_t overlap;
+        reserve_rectangles (&region->scratch, &region->scratch_capacity, *number_of_rectangles + 1);
 
-                old_area = (ply_rectangle_t *) ply_list_node_get_data (node);
+        rectangle = &region->scratch[*number_of_rectangles];
+        rectangle->x = x;
+        rectangle->y = y;
+        rectangle->width = width;
+        rectangle->height = height;
 
-                next_node = ply_list_get_next_node (region->rectangle_list, node);
+        (*number_of_rectangles)++;
+}
 
-                if (ply_rectangle_is_empty (new_area))
-                        overlap = PLY_RECTANGLE_OVERLAP_NO_EDGES;
-                else if (ply_rectangle_is_empty (old_area))
-                        overlap = PLY_RECTANGLE_OVERLAP_ALL_EDGES;
-                else
-                        overlap = ply_rectangle_find_overlap (old_area, new_area);
+static size_t
+get_band_end (const ply_rectangle_t *rectangles,
+              size_t                 number_of_rectangles,
+              size_t                 band_start)
+{
+        size_t i;
 
-                switch (overlap) {
-                /* NNNN      The new rectangle and node rectangle don't touch,
-                 * NNNN OOOO so let's move on to the next one.
-                 *      OOOO
-                 */
-                case PLY_RECTANGLE_OVERLAP_NONE:
+        for (i = band_start + 1; i < number_of_rectangles; i++) {
+                if (rectangles[i].y != rectangles[band_start].y)
                         break;
+        }
 
-                /* NNNNN   We need to split the new rectangle into
-                 * NNOOOOO two rectangles:  The top row of Ns and
-                 * NNOOOOO the left side of Ns.
-                 *   OOOOO
-                 */
-                case PLY_RECTANGLE_OVERLAP_TOP_AND_LEFT_EDGES:
-                {
-                        ply_rectangle_t *rectangle;
+        return i;
+}
 
-                        rectangle = copy_rectangle (new_area);
-                        rectangle->y = old_area->y;
-                        rectangle->width = old_area->x - new_area->x;
-                        rectangle->height = (new_area->y + new_area->height) - old_area->y;
+static bool
+operation_keeps_area (ply_region_operation_t operation,
+                      bool                   is_in_a,
+                      bool                   is_in_b)
+{
+        switch (operation) {
+        case PLY_REGION_OPERATION_UNION:
+                return is_in_a || is_in_b;
+        case PLY_REGION_OPERATION_INTERSECT:
+                return is_in_a && is_in_b;
+        case PLY_REGION_OPERATION_SUBTRACT:
+                return is_in_a && !is_in_b;
+        }
 
-                        merge_rectangle_with_sub_list (region, rectangle, next_node);
+        return false;
+}
 
-                        new_area->height = old_area->y - new_area->y;
-                }
-                break;
-
-                /*   NNNNN We need to split the new rectangle into
-                 * OOOOONN two rectangles:  The top row of Ns and
-                 * OOOOONN the right side of Ns.
-                 * OOOOO
-                 */
-                case PLY_RECTANGLE_OVERLAP_TOP_AND_RIGHT_EDGES:
-                {
-                        ply_rectangle_t *rectangle;
-
-                        rectangle = copy_rectangle (new_area);
-                        rectangle->x = old_area->x + old_area->width;
-                        rectangle->y = old_area->y;
-                        rectangle->width = (new_area->x + new_area->width) - (old_area->x + old_area->width);
-                        rectangle->height = (new_area->y + new_area->height) - old_area->y;
-
-                        merge_rectangle_with_sub_list (region, rectangle, next_node);
-
-                        new_area->height = old_area->y - new_area->y;
-                }
-                break;
-
-                /* NNNNNNN We need to trim out the part of
-                 * NOOOOON old rectangle that overlaps the new
-                 * NOOOOON rectangle by shrinking and moving it
-                 *  OOOOO  and then we need to add the new rectangle.
-                 */
-                case PLY_RECTANGLE_OVERLAP_TOP_AND_SIDE_EDGES:
-                {
-                        old_area->height = (old_area->y + old_area->height)
-                                           - (new_area->y + new_area->height);
-                        old_area->y = new_area->y + new_area->height;
-                }
-                break;
-
-                /*   NNN  We only care about the top row of Ns,
-                 *  ONNNO everything below that is already handled by
-                 *  ONNNO the old rectangle.
-                 *  OOOOO
-                 */
-                case PLY_RECTANGLE_OVERLAP_TOP_EDGE:
-                        new_area->height = old_area->y - new_area->y;
-                        break;
+static bool
+bands_have_same_columns (const ply_rectangle_t *band_a,
+                         const ply_rectangle_t *band_b,
+                         size_t                 number_of_rectangles)
+{
+        size_t i;
+
+        for (i = 0; i < number_of_rectangles; i++) {
+                if (band_a[i].x != band_b[i].x || band_a[i].width != band_b[i].width)
+                        return false;
+        }
+
+        return true;
+}
+
+static void
+ply_region_finish_band (ply_region_t *region,
+                        size_t       *number_of_rectangles,
+                        size_t       *previous_band,
+                        size_t        band_start)
+{
+        ply_rectangle_t *previous, *band;
+        size_t band_size, i;
 
-                /*   OOOOO We need to split the new rectangle into
-                 * NNOOOOO two rectangles:  The left side of Ns and
-                 * NNOOOOO the bottom row of Ns.
-                 * NNOOOOO
-                 * NNNNN
-                 */
-                case PLY_RECTANGLE_OVERLAP_BOTTOM_AND_LEFT_EDGES:
-                {
-                        ply_rectangle_t *rectangle;
+        band_size = *number_of_rectangles - band_start;
 
-                        rectangle = copy_rectangle (new_area);
+        if (band_size == 0)
+                return;
 
-                        rectangle->width = old_area->x - new_area->x;
-                        rectangle->height = (old_area->y + old_area->height) - new_area->y;
+        /* Grow the band above instead, if this one just continues it */
+        if (*previous_band != PLY_REGION_NO_BAND) {
+                previous = &region->scratch[*previous_band];
+                band = &region->scratch[band_start];
 
-                        merge_rectangle_with_sub_list (region, rectangle, next_node);
+                if (previous->y + (long) previous->height == band->y &&
+                    band_start - *previous_band == band_size &&
+                    bands_have_same_columns (previous, band, band_size)) {
+                        for (i = 0; i < band_size; i++) {
+                                previous[i].height += band->height;
+                        }
 
-                        new_area->height = (new_area->y + new_area->height) - (old_area->y + old_area->height);
-                        new_area->y = old_area->y + old_area->height;
+                        *number_of_rectangles = band_start;
+                        return;
                 }
-                break;
+        }
+
+        *previous_band = band_start;
+}
 
-                /*   OOOOO   We need to split the new rectangle into
-                 *   OOOOONN two rectangles:  The right side of Ns and
-                 *   OOOOONN the bottom row of Ns.
-                 *   OOOOONN
-                 *     NNNNN
-                 */
-                case PLY_RECTANGLE_OVERLAP_BOTTOM_AND_RIGHT_EDGES:
-                {
-                        ply_rectangle_t *rectangle;
+/* Combines the rows of a and b between top and bottom by walking their
+ * edges left to right, and appends the result as a new band
+ */
+static void
+ply_region_append_band (ply_region_t          *region,
+                        size_t                *number_of_rectangles,
+                        size_t                *previous_band,
+                        long                   top,
+                        long                   bottom,
+                        const ply_rectangle_t *a,
+                        size_t                 number_of_a_rectangles,
+                        const ply_rectangle_t *b,
+                        size_t                 number_of_b_rectangles,
+                        ply_region_operation_t operation)
+{
+        size_t band_start;
+        size_t i = 0, j = 0;
+        bool is_in_a = false, is_in_b = false;
+        long span_start = 0;
 
-                        rectangle = copy_rectangle (new_area);
+        band_start = *number_of_rectangles;
 
-                        rectangle->x = old_area->x + old_area->width;
-                        rectangle->width = (new_area->x + new_area->width) - (old_area->x + old_area->width);
-                        rectangle->height = (old_area->y + old_area->height) - new_area->y;
+        while (i < number_of_a_rectangles || j < number_of_b_rectangles) {
+                long next_a_edge = LONG_MAX, next_b_edge = LONG_MAX, x;
+                bool was_kept, is_kept;
 
-                        merge_rectangle_with_sub_list (region, rectangle, next_node);
+                if (i < number_of_a_rectangles)
+                        next_a_edge = is_in_a ? a[i].x + (long) a[i].width : a[i].x;
 
-                        new_area->height = (new_area->y + new_area->height) - (old_area->y + old_area->height);
-                        new_area->y = old_area->y + old_area->height;
-                }
-                break;
-
-                /*  OOOOO  We need to trim out the part of
-                 * NOOOOON old rectangle that overlaps the new
-                 * NOOOOON rectangle by shrinking it
-                 * NNNNNNN and then we need to add the new rectangle.
-                 */
-                case PLY_RECTANGLE_OVERLAP_BOTTOM_AND_SIDE_EDGES:
-                {
-                        old_area->height = new_area->y - old_area->y;
-                }
-                break;
-
-                /*  OOOOO We only care about the bottom row of Ns,
-                 *  ONNNO everything above that is already handled by
-                 *  ONNNO the old rectangle.
-                 *   NNN
-                 */
-                case PLY_RECTANGLE_OVERLAP_BOTTOM_EDGE:
-                {
-                        new_area->height = (new_area->y + new_area->height) - (old_area->y + old_area->height);
-                        new_area->y = old_area->y + old_area->height;
+                if (j < number_of_b_rectangles)
+                        next_b_edge = is_in_b ? b[j].x + (long) b[j].width : b[j].x;
+
+                x = MIN (next_a_edge, next_b_edge);
+                was_kept = operation_keeps_area (operation, is_in_a, is_in_b);
+
+                if (next_a_edge == x) {
+                        is_in_a = !is_in_a;
+                        if (!is_in_a)
+                                i++;
                 }
-                break;
-
-                /*  NNNN   We need to trim out the part of
-                 *  NNNNO  old rectangle that overlaps the new
-                 *  NNNNO  rectangle by shrinking it and moving it
-                 *  NNNN   and then we need to add the new rectangle.
-                 */
-                case PLY_RECTANGLE_OVERLAP_TOP_LEFT_AND_BOTTOM_EDGES:
-                {
-                        old_area->width = (old_area->x + old_area->width)
-                                          - (new_area->x + new_area->width);
-                        old_area->x = new_area->x + new_area->width;
+
+                if (next_b_edge == x) {
+                        is_in_b = !is_in_b;
+                        if (!is_in_b)
+                                j++;
                 }
-                break;
-
-                /*  NNNN  We need to trim out the part of
-                 * ONNNN  old rectangle that overlaps the new
-                 * ONNNN  rectangle by shrinking it and then we
-                 *  NNNN  need to add the new rectangle.
-                 */
-                case PLY_RECTANGLE_OVERLAP_TOP_RIGHT_AND_BOTTOM_EDGES:
-                        old_area->width = new_area->x - old_area->x;
+
+                is_kept = operation_keeps_area (operation, is_in_a, is_in_b);
+
+                if (!was_kept && is_kept)
+                        span_start = x;
+                else if (was_kept && !is_kept)
+                        ply_region_append_to_scratch (region, number_of_rectangles,
+                                                      span_start, top,
+                                                      x - span_start, bottom - top);
+        }
+
+        ply_region_finish_band (region, number_of_rectangles, previous_band, band_start);
+}
+
+static void
+ply_region_update_extents (ply_region_t *region)
+{
+        ply_rectangle_t *first, *last;
+        long left, right;
+        size_t i;
+
+        if (region->number_of_rectangles == 0) {
+                region->extents.x = 0;
+                region->extents.y = 0;
+                region->extents.width = 0;
+                region->extents.height = 0;
+                return;
+        }
+
+        first = &region->rectangles[0];
+        last = &region->rectangles[region->number_of_rectangles - 1];
+
+        left = first->x;
+        right = first->x + (long) first->width;
+        for (i = 1; i < region->number_of_rectangles; i++) {
+                ply_rectangle_t *rectangle = &region->rectangles[i];
+
+                left = MIN (left, rectangle->x);
+                right = MAX (right, rectangle->x + (long) rectangle->width);
+        }
+
+        region->extents.x = left;
+        region->extents.y = first->y;
+        region->extents.width = right - left;
+        region->extents.height = (last->y + (long) last->height) - first->y;
+}
+
+static void
+ply_region_take_scratch (ply_region_t *region,
+                         size_t        number_of_rectangles)
+{
+        ply_rectangle_t *rectangles;
+        size_t capacity;
+
+        rectangles = region->rectangles;
+        capacity = region->capacity;
+
+        region->rectangles = region->scratch;
+        region->capacity = region->scratch_capacity;
+        region->number_of_rectangles = number_of_rectangles;
+
+        region->scratch = rectangles;
+        region->scratch_capacity = capacity;
+
+        region->rectangle_list_is_stale = true;
+        ply_region_update_extents (region);
+}
+
+static void
+ply_region_combine (ply_region_t          *region,
+                    const ply_rectangle_t *b,
+                    size_t                 number_of_b_rectangles,
+                    ply_region_operation_t operation)
+{
+        const ply_rectangle_t *a = region->rectangles;
+        size_t number_of_a_rectangles = region->number_of_rectangles;
+        size_t a_start = 0, b_start = 0;
+        size_t number_of_rectangles = 0;
+        size_t previous_band = PLY_REGION_NO_BAND;
+        long y = LONG_MIN;
+
+        while (a_start < number_of_a_rectangles || b_start < number_of_b_rectangles) {
+                long a_top = LONG_MAX, a_bottom = LONG_MAX;
+                long b_top = LONG_MAX, b_bottom = LONG_MAX;
+                size_t a_end = a_start, b_end = b_start;
+                bool a_is_active, b_is_active;
+                long top, bottom;
+
+                if (a_start >= number_of_a_rectangles &&
+                    operation != PLY_REGION_OPERATION_UNION)
                         break;
 
-                /* NNNNNNN The old rectangle is completely inside the new rectangle
-                 * NOOOOON so replace the old rectangle with the new rectangle.
-                 * NOOOOON
-                 * NNNNNNN
-                 */
-                case PLY_RECTANGLE_OVERLAP_ALL_EDGES:
-                        merge_rectangle_with_sub_list (region, new_area, next_node);
-                        free (old_area);
-                        ply_list_remove_node (region->rectangle_list, node);
-                        return;
+                if (b_start >= number_of_b_rectangles &&
+                    operation == PLY_REGION_OPERATION_INTERSECT)
+                        break;
 
-                /*  NNN  We need to split the new rectangle into
-                 * ONNNO two rectangles: the top and bottom row of Ns
-                 * ONNNO
-                 *  NNN
-                 */
-                case PLY_RECTANGLE_OVERLAP_TOP_AND_BOTTOM_EDGES:
-                {
-                        ply_rectangle_t *rectangle;
-
-                        rectangle = copy_rectangle (new_area);
-                        rectangle->y = old_area->y + old_area->height;
-                        rectangle->width = new_area->width;
-                        rectangle->height = (new_area->y + new_area->height) - (old_area->y + old_area->height);
-                        merge_rectangle_with_sub_list (region, rectangle, next_node);
-
-                        new_area->height = old_area->y - new_area->y;
+                if (a_start < number_of_a_rectangles) {
+                        a_end = get_band_end (a, number_of_a_rectangles, a_start);
+                        a_top = a[a_start].y;
+                        a_bottom = a_top + (long) a[a_start].height;
                 }
-                break;
-
-                /*  OOOOO We only care about the side row of Ns,
-                 * NNNNOO everything rigth of that is already handled by
-                 * NNNNOO the old rectangle.
-                 *  OOOOO
-                 */
-                case PLY_RECTANGLE_OVERLAP_LEFT_EDGE:
-                        new_area->width = old_area->x - new_area->x;
-                        break;
 
-                /* OOOOO  We only care about the side row of Ns,
-                 * NNNNNN everything left of that is already handled by
-                 * NNNNNN the old rectangle.
-                 * OOOOO
-                 */
-                case PLY_RECTANGLE_OVERLAP_RIGHT_EDGE:
-                {
-                        long temp = new_area->x;
-                        new_area->x = old_area->x + old_area->width;
-                        new_area->width = (temp + new_area->width) - (old_area->x + old_area->width);
+                if (b_start < number_of_b_rectangles) {
+                        b_end = get_band_end (b, number_of_b_rectangles, b_start);
+                        b_top = b[b_start].y;
+                        b_bottom = b_top + (long) b[b_start].height;
                 }
-                break;
 
-                /*  OOOOO  We need to split the new rectangle into
-                 * NNNNNNN two rectangles: the side columns of Ns
-                 * NNNNNNN
-                 *  OOOOO
-                 */
-                case PLY_RECTANGLE_OVERLAP_SIDE_EDGES:
-                {
-                        ply_rectangle_t *rectangle;
+                top = MAX (y, MIN (a_top, b_top));
+                a_is_active = a_top <= top;
+                b_is_active = b_top <= top;
+                bottom = MIN (a_is_active ? a_bottom : a_top,
+                              b_is_active ? b_bottom : b_top);
 
-                        rectangle = copy_rectangle (new_area);
+                ply_region_append_band (region, &number_of_rectangles, &previous_band,
+                                        top, bottom,
+                                        a + a_start, a_is_active ? a_end - a_start : 0,
+                                        b + b_start, b_is_active ? b_end - b_start : 0,
+                                        operation);
 
-                        rectangle->x = old_area->x + old_area->width;
-                        rectangle->width = (new_area->x + new_area->width) - (old_area->x + old_area->width);
+                y = bottom;
 
-                        merge_rectangle_with_sub_list (region, rectangle, next_node);
+                if (a_is_active && y >= a_bottom)
+                        a_start = a_end;
 
-                        new_area->width = old_area->x - new_area->x;
-                }
-                break;
-
-                /* OOOOOOO The new rectangle is completely inside an old rectangle
-                 * ONNNNNO so return early without adding the new rectangle.
-                 * ONNNNNO
-                 * OOOOOOO
-                 */
-                case PLY_RECTANGLE_OVERLAP_NO_EDGES:
-                        free (new_area);
-                        return;
+                if (b_is_active && y >= b_bottom)
+                        b_start = b_end;
+        }
 
-                /*  NNNNN We expand the old rectangle up and throw away the new.
-                 *  NNNNN We must merge it because the new region may have overlapped
-                 *  NNNNN something further down the list.
-                 *  OOOOO
-                 */
-                case PLY_RECTANGLE_OVERLAP_EXACT_TOP_EDGE:
-                {
-                        old_area->height = (old_area->y + old_area->height) - new_area->y;
-                        old_area->y = new_area->y;
-                        free (new_area);
-                        merge_rectangle_with_sub_list (region, old_area, next_node);
-                        ply_list_remove_node (region->rectangle_list, node);
-                }
-                        return;
+        ply_region_take_scratch (region, number_of_rectangles);
+}
 
-                /*  OOOOO We expand the old rectangle down and throw away the new.
-                 *  NNNNN We must merge it because the new region may have overlapped
-                 *  NNNNN something further down the list.
-                 *  NNNNN
-                 */
-                case PLY_RECTANGLE_OVERLAP_EXACT_BOTTOM_EDGE:
-                {
-                        old_area->height = (new_area->y + new_area->height) - old_area->y;
-                        free (new_area);
-                        merge_rectangle_with_sub_list (region, old_area, next_node);
-                        ply_list_remove_node (region->rectangle_list, node);
-                }
-                        return;
+static int
+compare_rectangle_tops (const void *element_a,
+                        const void *element_b)
+{
+        const ply_rectangle_t *rectangle_a = element_a;
+        const ply_rectangle_t *rectangle_b = element_b;
+
+        return (rectangle_a->y > rectangle_b->y) - (rectangle_a->y < rectangle_b->y);
+}
+
+static int
+compare_edges (const void *element_a,
+               const void *element_b)
+{
+        long edge_a = *(const long *) element_a;
+        long edge_b = *(const long *) element_b;
 
-                /*  NNNNNO We expand the old rectangle left and throw away the new.
-                 *  NNNNNO We must merge it because the new region may have overlapped
-                 *  NNNNNO something further down the list.
-                 */
-                case PLY_RECTANGLE_OVERLAP_EXACT_LEFT_EDGE:
-                {
-                        old_area->width = (old_area->x + old_area->width) - new_area->x;
-                        old_area->x = new_area->x;
-                        free (new_area);
-                        merge_rectangle_with_sub_list (region, old_area, next_node);
-                        ply_list_remove_node (region->rectangle_list, node);
+        return (edge_a > edge_b) - (edge_a < edge_b);
+}
+
+/* Rebuilds the bands from the existing rectangles and the pending ones in
+ * a single sweep from top to bottom, keeping the rectangles that cross
+ * each row sorted by x
+ */
+static void
+ply_region_merge_pending_rectangles (ply_region_t *region)
+{
+        ply_rectangle_t *inputs, **active;
+        size_t number_of_inputs, number_of_edges, number_of_active_rectangles;
+        size_t number_of_rectangles = 0, previous_band = PLY_REGION_NO_BAND;
+        size_t next_input = 0, i, j;
+        long *edges;
+
+        if (region->number_of_pending_rectangles == 0)
+                return;
+
+        number_of_inputs = region->number_of_pending_rectangles + region->number_of_rectangles;
+        inputs = reserve_rectangles (&region->pending, &region->pending_capacity, number_of_inputs);
+        if (region->number_of_rectangles > 0)
+                memcpy (inputs + region->number_of_pending_rectangles,
+                        region->rectangles,
+                        region->number_of_rectangles * sizeof(ply_rectangle_t));
+
+        qsort (inputs, number_of_inputs, sizeof(ply_rectangle_t), compare_rectangle_tops);
+
+        edges = malloc (2 * number_of_inputs * sizeof(long));
+        active = malloc (number_of_inputs * sizeof(ply_rectangle_t *));
+
+        for (i = 0; i < number_of_inputs; i++) {
+                edges[2 * i] = inputs[i].y;
+                edges[2 * i + 1] = inputs[i].y + (long) inputs[i].height;
+        }
+        qsort (edges, 2 * number_of_inputs, sizeof(long), compare_edges);
+
+        number_of_edges = 0;
+        for (i = 0; i < 2 * number_of_inputs; i++) {
+                if (number_of_edges == 0 || edges[number_of_edges - 1] != edges[i])
+                        edges[number_of_edges++] = edges[i];
+        }
+
+        number_of_active_rectangles = 0;
+        for (i = 0; i + 1 < number_of_edges; i++) {
+                long top = edges[i], bottom = edges[i + 1];
+                long span_start = 0, span_end = 0;
+                size_t band_start;
+
+                for (j = 0; j < number_of_active_rectangles;) {
+                        if (active[j]->y + (long) active[j]->height <= top) {
+                                memmove (&active[j], &active[j + 1],
+                                         (number_of_active_rectangles - j - 1) * sizeof(ply_rectangle_t *));
+                                number_of_active_rectangles--;
+                        } else {
+                                j++;
+                        }
                 }
-                        return;
 
-                /*  ONNNNN We expand the old rectangle right and throw away the new.
-                 *  ONNNNN We must merge it because the new region may have overlapped
-                 *  ONNNNN something further down the list.
-                 */
-                case PLY_RECTANGLE_OVERLAP_EXACT_RIGHT_EDGE:
-                {
-                        old_area->width = (new_area->x + new_area->width) - old_area->x;
-                        free (new_area);
-                        merge_rectangle_with_sub_list (region, old_area, next_node);
-                        ply_list_remove_node (region->rectangle_list, node);
+                for (; next_input < number_of_inputs && inputs[next_input].y <= top; next_input++) {
+                        ply_rectangle_t *input = &inputs[next_input];
+
+                        for (j = number_of_active_rectangles; j > 0 && active[j - 1]->x > input->x; j--) {
+                                active[j] = active[j - 1];
+                        }
+                        active[j] = input;
+                        number_of_active_rectangles++;
                 }
-                        return;
+
+                band_start = number_of_rectangles;
+                for (j = 0; j < number_of_active_rectangles; j++) {
+                        long left = active[j]->x, right = active[j]->x + (long) active[j]->width;
+
+                        if (j > 0 && left <= span_end) {
+                                span_end = MAX (span_end, right);
+                                continue;
+                        }
+
+                        if (j > 0)
+                                ply_region_append_to_scratch (region, &number_of_rectangles,
+                                                              span_start, top,
+                                                              span_end - span_start, bottom - top);
+                        span_start = left;
+                        span_end = right;
                 }
 
-                node = ply_list_get_next_node (region->rectangle_list, node);
+                if (number_of_active_rectangles > 0)
+                        ply_region_append_to_scratch (region, &number_of_rectangles,
+                                                      span_start, top,
+                                                      span_end - span_start, bottom - top);
+
+                ply_region_finish_band (region, &number_of_rectangles, &previous_band, band_start);
         }
 
-        ply_list_append_data (region->rectangle_list, new_area);
+        free (active);
+        free (edges);
+
+        region->number_of_pending_rectangles = 0;
+        ply_region_take_scratch (region, number_of_rectangles);
 }
 
 void
 ply_region_add_rectangle (ply_region_t    *region,
                           ply_rectangle_t *rectangle)
 {
-        ply_list_node_t *first_node;
-        ply_rectangle_t *rectangle_copy;
+        assert (region != NULL);
+        assert (rectangle != NULL);
 
+        if (ply_rectangle_is_empty (rectangle))
+                return;
+
+        reserve_rectangles (&region->pending, &region->pending_capacity,
+                            region->number_of_pending_rectangles + 1);
+        region->pending[region->number_of_pending_rectangles] = *rectangle;
+        region->number_of_pending_rectangles++;
+}
+
+void
+ply_region_intersect_rectangle (ply_region_t    *region,
+                                ply_rectangle_t *rectangle)
+{
         assert (region != NULL);
         assert (rectangle != NULL);
 
-        first_node = ply_list_get_first_node (region->rectangle_list);
+        if (ply_rectangle_is_empty (rectangle)) {
+                ply_region_clear (region);
+                return;
+        }
 
-        rectangle_copy = copy_rectangle (rectangle);
-        merge_rectangle_with_sub_list (region,
-                                       rectangle_copy,
-                                       first_node);
+        ply_region_merge_pending_rectangles (region);
+        ply_region_combine (region, rectangle, 1, PLY_REGION_OPERATION_INTERSECT);
 }
 
-ply_list_t *
-ply_region_get_rectangle_list (ply_region_t *region)
+void
+ply_region_subtract_rectangle (ply_region_t    *region,
+                               ply_rectangle_t *rectangle)
 {
-        return region->rectangle_list;
+        assert (region != NULL);
+        assert (rectangle != NULL);
+
+        if (ply_rectangle_is_empty (rectangle))
+                return;
+
+        ply_region_merge_pending_rectangles (region);
+        ply_region_combine (region, rectangle, 1, PLY_REGION_OPERATION_SUBTRACT);
 }
 
-static int
-rectangle_compare_y (void *element_a,
-                     void *element_b)
+void
+ply_region_union (ply_region_t *region,
+                  ply_region_t *other_region)
+{
+        size_t i;
+
+        assert (region != NULL);
+        assert (other_region != NULL);
+
+        ply_region_merge_pending_rectangles (other_region);
+
+        for (i = 0; i < other_region->number_of_rectangles; i++) {
+                ply_region_add_rectangle (region, &other_region->rectangles[i]);
+        }
+}
+
+void
+ply_region_intersect (ply_region_t *region,
+                      ply_region_t *other_region)
+{
+        assert (region != NULL);
+        assert (other_region != NULL);
+
+        ply_region_merge_pending_rectangles (region);
+        ply_region_merge_pending_rectangles (other_region);
+        ply_region_combine (region,
+                            other_region->rectangles,
+                            other_region->number_of_rectangles,
+                            PLY_REGION_OPERATION_INTERSECT);
+}
+
+void
+ply_region_subtract (ply_region_t *region,
+                     ply_region_t *other_region)
+{
+        assert (region != NULL);
+        assert (other_region != NULL);
+
+        ply_region_merge_pending_rectangles (region);
+        ply_region_merge_pending_rectangles (other_region);
+        ply_region_combine (region,
+                            other_region->rectangles,
+                            other_region->number_of_rectangles,
+                            PLY_REGION_OPERATION_SUBTRACT);
+}
+
+void
+ply_region_get_bounding_box (ply_region_t    *region,
+                             ply_rectangle_t *bounding_box)
+{
+        assert (region != NULL);
+        assert (bounding_box != NULL);
+
+        ply_region_merge_pending_rectangles (region);
+        *bounding_box = region->extents;
+}
+
+void
+ply_region_simplify (ply_region_t *region,
+                     size_t        max_number_of_rectangles)
 {
-        ply_rectangle_t *rectangle_a = element_a;
-        ply_rectangle_t *rectangle_b = element_b;
+        unsigned long covered_area = 0;
+        size_t i;
+
+        assert (region != NULL);
+
+        ply_region_merge_pending_rectangles (region);
+
+        if (region->number_of_rectangles <= MAX (max_number_of_rectangles, 1))
+                return;
+
+        for (i = 0; i < region->number_of_rectangles; i++) {
+                covered_area += region->rectangles[i].width * region->rectangles[i].height;
+        }
+
+        /* Don't blow a few far apart areas up into most of the screen */
+        if (covered_area < region->extents.width * region->extents.height / 2)
+                return;
 
-        return rectangle_a->y - rectangle_b->y;
+        region->rectangles[0] = region->extents;
+        region->number_of_rectangles = 1;
+        region->rectangle_list_is_stale = true;
+}
+
+ply_rectangle_t *
+ply_region_get_rectangles (ply_region_t *region,
+                           size_t       *number_of_rectangles)
+{
+        assert (region != NULL);
+        assert (number_of_rectangles != NULL);
+
+        ply_region_merge_pending_rectangles (region);
+
+        *number_of_rectangles = region->number_of_rectangles;
+
+        return region->rectangles;
 }
 
 ply_list_t *
-ply_region_get_sorted_rectangle_list (ply_region_t *region)
+ply_region_get_rectangle_list (ply_region_t *region)
 {
-        ply_list_sort (region->rectangle_list, &rectangle_compare_y);
+        size_t i;
+
+        assert (region != NULL);
+
+        ply_region_merge_pending_rectangles (region);
+
+        if (!region->rectangle_list_is_stale)
+                return region->rectangle_list;
+
+        ply_list_remove_all_nodes (region->rectangle_list);
+
+        for (i = 0; i < region->number_of_rectangles; i++) {
+                ply_list_append_data (region->rectangle_list, &region->rectangles[i]);
+        }
+
+        region->rectangle_list_is_stale = false;
+
         return region->rectangle_list;
 }
+
+ply_list_t *
+ply_region_get_sorted_rectangle_list (ply_region_t *region)
+{
+        /* bands are already in order from top to bottom */
+        return ply_region_get_rectangle_list (region);
+}
@@ -23,6 +23,7 @@
 #define PLY_REGION_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "ply-list.h"
@@ -36,9 +37,33 @@ ply_region_t *ply_region_new (void);
 void ply_region_free (ply_region_t *region);
 void ply_region_add_rectangle (ply_region_t    *region,
                                ply_rectangle_t *rectangle);
+void ply_region_intersect_rectangle (ply_region_t    *region,
+                                     ply_rectangle_t *rectangle);
+void ply_region_subtract_rectangle (ply_region_t    *region,
+                                    ply_rectangle_t *rectangle);
+void ply_region_union (ply_region_t *region,
+                       ply_region_t *other_region);
+void ply_region_intersect (ply_region_t *region,
+                           ply_region_t *other_region);
+void ply_region_subtract (ply_region_t *region,
+                          ply_region_t *other_region);
 void ply_region_clear (ply_region_t *region);
+
+/* Rectangles come back sorted top to bottom, then left to right, and stay
+ * valid until the region is next changed
+ */
+ply_rectangle_t *ply_region_get_rectangles (ply_region_t *region,
+                                            size_t       *number_of_rectangles);
 ply_list_t *ply_region_get_rectangle_list (ply_region_t *region);
 ply_list_t *ply_region_get_sorted_rectangle_list (ply_region_t *region);
+void ply_region_get_bounding_box (ply_region_t    *region,
+                                  ply_rectangle_t *bounding_box);
+
+/* Replaces a region split into more than max_number_of_rectangles pieces
+ * with its bounding box, unless that would be mostly empty
+ */
+void ply_region_simplify (ply_region_t *region,
+                          size_t        max_number_of_rectangles);
 
 bool ply_region_is_empty (ply_region_t *region);
 
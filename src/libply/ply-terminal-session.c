@@ -72,6 +72,8 @@ ply_terminal_session_new (const char *const *argv)
         session->pseudoterminal_master_fd = -1;
         session->argv = argv == NULL ? NULL : ply_copy_string_array (argv);
         session->logger = ply_logger_new ();
+        ply_logger_set_flush_policy (session->logger,
+                                     PLY_LOGGER_FLUSH_POLICY_DEFERRED);
         session->is_running = false;
         session->console_is_redirected = false;
 
@@ -110,6 +112,7 @@ ply_terminal_session_attach_to_event_loop (ply_terminal_session_t *session,
         assert (session->loop == NULL);
 
         session->loop = loop;
+        ply_logger_attach_to_event_loop (session->logger, loop);
 
         ply_event_loop_watch_for_exit (loop, (ply_event_loop_exit_handler_t)
                                        ply_terminal_session_detach_from_event_loop,
@@ -313,8 +316,6 @@ ply_terminal_session_on_new_data (ply_terminal_session_t *session,
 
         if (bytes_read > 0)
                 ply_terminal_session_log_bytes (session, buffer, bytes_read);
-
-        ply_logger_flush (session->logger);
 }
 
 static void
@@ -390,8 +391,10 @@ ply_terminal_session_stop_logging (ply_terminal_session_t *session)
         assert (session->logger != NULL);
 
         ply_trace ("stopping logging of incoming console messages");
-        if (ply_logger_is_logging (session->logger))
+        if (ply_logger_is_logging (session->logger)) {
+                ply_logger_flush (session->logger);
                 ply_logger_toggle_logging (session->logger);
+        }
 
         if (session->loop != NULL &&
             session->fd_watch != NULL)
@@ -425,6 +428,7 @@ ply_terminal_session_close_log (ply_terminal_session_t *session)
         assert (session != NULL);
         assert (session->logger != NULL);
 
+        ply_logger_flush (session->logger);
         return ply_logger_close_file (session->logger);
 }
 
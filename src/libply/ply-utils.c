@@ -885,6 +885,168 @@ ply_utf8_string_get_byte_offset_from_character_offset (const char *string,
         return byte_offset;
 }
 
+/* Lays out one line of terminal output, returning how many rows it wraps
+ * to and where the given row starts.  Escape sequences take up no room.
+ */
+static int
+get_terminal_line_layout (const char *line,
+                          size_t      size,
+                          int         number_of_columns,
+                          int         row_to_find,
+                          size_t     *row_offset)
+{
+        int row = 0, column = 0;
+        size_t i = 0;
+
+        *row_offset = 0;
+
+        while (i < size) {
+                unsigned char byte = line[i];
+                ssize_t character_size;
+
+                if (byte == '\033') {
+                        i++;
+                        if (i < size && line[i] == '[') {
+                                i++;
+                                while (i < size && ((unsigned char) line[i] < 0x40 || (unsigned char) line[i] > 0x7e)) {
+                                        i++;
+                                }
+                        }
+                        i++;
+                        continue;
+                }
+
+                if (byte == '\r') {
+                        column = 0;
+                        i++;
+                        continue;
+                }
+
+                if (byte == '\t') {
+                        column = MIN ((column / 8 + 1) * 8, number_of_columns);
+                        i++;
+                        continue;
+                }
+
+                if (byte < ' ') {
+                        i++;
+                        continue;
+                }
+
+                if (column == number_of_columns) {
+                        row++;
+                        column = 0;
+
+                        if (row == row_to_find)
+                                *row_offset = i;
+                }
+
+                column++;
+
+                character_size = ply_utf8_character_get_size (line + i);
+                i += CLAMP (character_size, 1, (ssize_t) (size - i));
+        }
+
+        return row + 1;
+}
+
+size_t
+ply_utf8_string_get_offset_of_last_screenful (const char *string,
+                                              size_t      size,
+                                              int         number_of_columns,
+                                              int         number_of_rows)
+{
+        size_t line_end = size;
+        int rows_left = number_of_rows;
+
+        if (number_of_columns <= 0 || number_of_rows <= 0)
+                return 0;
+
+        /* Work back from the end a line at a time, so only the tail of
+         * the text ever gets looked at
+         */
+        while (true) {
+                size_t line_start = line_end;
+                size_t row_offset;
+                int line_rows;
+
+                while (line_start > 0 && string[line_start - 1] != '\n') {
+                        line_start--;
+                }
+
+                line_rows = get_terminal_line_layout (string + line_start,
+                                                      line_end - line_start,
+                                                      number_of_columns,
+                                                      -1, &row_offset);
+
+                if (line_rows >= rows_left) {
+                        get_terminal_line_layout (string + line_start,
+                                                  line_end - line_start,
+                                                  number_of_columns,
+                                                  line_rows - rows_left,
+                                                  &row_offset);
+                        return line_start + row_offset;
+                }
+
+                rows_left -= line_rows;
+
+                if (line_start == 0)
+                        return 0;
+
+                line_end = line_start - 1;
+        }
+}
+
+bool
+ply_utf8_string_find_last_sgr_sequence (const char *string,
+                                        size_t      offset,
+                                        size_t     *sequence_offset,
+                                        size_t     *sequence_size)
+{
+        size_t line_start = offset;
+        size_t i;
+        bool found = false;
+
+        while (line_start > 0 && string[line_start - 1] != '\n') {
+                line_start--;
+        }
+
+        /* Walk forward so that only whole sequences are matched, not bytes
+         * that happen to look like one in the middle of another
+         */
+        i = line_start;
+        while (i < offset) {
+                size_t start = i;
+
+                if (string[i] != '\033') {
+                        i++;
+                        continue;
+                }
+
+                i++;
+                if (i >= offset || string[i] != '[')
+                        continue;
+
+                i++;
+                while (i < offset && ((unsigned char) string[i] < 0x40 || (unsigned char) string[i] > 0x7e)) {
+                        i++;
+                }
+
+                if (i >= offset)
+                        break;
+
+                if (string[i] == 'm') {
+                        *sequence_offset = start;
+                        *sequence_size = i + 1 - start;
+                        found = true;
+                }
+
+                i++;
+        }
+
+        return found;
+}
+
 void
 ply_utf8_string_iterator_initialize (ply_utf8_string_iterator_t *iterator,
                                      const char                 *string,
@@ -147,6 +147,22 @@ int ply_utf8_string_get_length (const char *string,
 
 size_t ply_utf8_string_get_byte_offset_from_character_offset (const char *string,
                                                               size_t      character_offset);
+
+/* Returns where the part of the text that a terminal of the given size
+ * would still show after printing all of it begins
+ */
+size_t ply_utf8_string_get_offset_of_last_screenful (const char *string,
+                                                     size_t      size,
+                                                     int         number_of_columns,
+                                                     int         number_of_rows);
+/* Finds the last color/attribute escape sequence on the line that the
+ * given offset falls in, so text replayed from the middle of a line can
+ * keep its attributes
+ */
+bool ply_utf8_string_find_last_sgr_sequence (const char *string,
+                                             size_t      offset,
+                                             size_t     *sequence_offset,
+                                             size_t     *sequence_size);
 void ply_utf8_string_iterator_initialize (ply_utf8_string_iterator_t *iterator,
                                           const char                 *string,
                                           ssize_t                     starting_offset,
@@ -1731,10 +1731,9 @@ static void
 flush_head (ply_renderer_backend_t *backend,
             ply_renderer_head_t    *head)
 {
-        ply_rectangle_t *area_to_flush;
         ply_region_t *updated_region;
-        ply_list_t *areas_to_flush;
-        ply_list_node_t *node;
+        ply_rectangle_t *areas_to_flush;
+        size_t number_of_areas_to_flush, i;
         ply_pixel_buffer_t *pixel_buffer;
         char *map_address;
         bool dirty = false;
@@ -1767,7 +1766,7 @@ flush_head (ply_renderer_backend_t *backend,
         }
         pixel_buffer = head->pixel_buffer;
         updated_region = ply_pixel_buffer_get_updated_areas (pixel_buffer);
-        areas_to_flush = ply_region_get_sorted_rectangle_list (updated_region);
+        areas_to_flush = ply_region_get_rectangles (updated_region, &number_of_areas_to_flush);
 
         /* A hotplugged head may not be mapped yet, map it now. */
         if (!head->scan_out_buffer_id) {
@@ -1777,14 +1776,9 @@ flush_head (ply_renderer_backend_t *backend,
 
         map_address = begin_flush (backend, head->scan_out_buffer_id);
 
-        node = ply_list_get_first_node (areas_to_flush);
-        while (node != NULL) {
-                area_to_flush = (ply_rectangle_t *) ply_list_node_get_data (node);
-
-                ply_renderer_head_flush_area (head, area_to_flush, map_address);
+        for (i = 0; i < number_of_areas_to_flush; i++) {
+                ply_renderer_head_flush_area (head, &areas_to_flush[i], map_address);
                 dirty = true;
-
-                node = ply_list_get_next_node (areas_to_flush, node);
         }
 
         if (set_mode_on_redraws == PLY_SET_MODE_ON_REDRAWS_ENABLED) {
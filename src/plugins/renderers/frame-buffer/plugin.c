@@ -55,6 +55,8 @@
 #include "ply-renderer.h"
 #include "ply-renderer-plugin.h"
 
+#include "ply-frame-buffer-pixels-private.h"
+
 #ifndef PLY_FRAME_BUFFER_DEFAULT_FB_DEVICE_NAME
 #define PLY_FRAME_BUFFER_DEFAULT_FB_DEVICE_NAME "/dev/fb0"
 #endif
@@ -65,6 +67,9 @@ struct _ply_renderer_head
         ply_rectangle_t     area;
         char               *map_address;
         size_t              size;
+
+        /* one converted row, copied to the device in a single write */
+        char               *row_buffer;
 };
 
 struct _ply_renderer_input_source
@@ -101,9 +106,7 @@ struct _ply_renderer_backend
         uint32_t                    bits_for_blue;
         uint32_t                    bits_for_alpha;
 
-        int32_t                     dither_red;
-        int32_t                     dither_green;
-        int32_t                     dither_blue;
+        ply_frame_buffer_pixel_tables_t *pixel_tables;
 
         unsigned int                bytes_per_pixel;
         unsigned int                row_stride;
@@ -123,91 +126,29 @@ static bool using_input_device (ply_renderer_input_source_t *backend);
 static bool open_input_source (ply_renderer_backend_t      *backend,
                                ply_renderer_input_source_t *input_source);
 
-static inline uint_fast32_t
-argb32_pixel_value_to_device_pixel_value (ply_renderer_backend_t *backend,
-                                          uint32_t                pixel_value)
-{
-        uint8_t r, g, b, a;
-        int orig_r, orig_g, orig_b, orig_a;
-        uint8_t new_r, new_g, new_b;
-        int i;
-
-        orig_a = pixel_value >> 24;
-        a = orig_a >> (8 - backend->bits_for_alpha);
-
-        orig_r = ((pixel_value >> 16) & 0xff) - backend->dither_red;
-        r = CLAMP (orig_r, 0, 255) >> (8 - backend->bits_for_red);
-
-        orig_g = ((pixel_value >> 8) & 0xff) - backend->dither_green;
-        g = CLAMP (orig_g, 0, 255) >> (8 - backend->bits_for_green);
-
-        orig_b = (pixel_value & 0xff) - backend->dither_blue;
-        b = CLAMP (orig_b, 0, 255) >> (8 - backend->bits_for_blue);
-
-        new_r = r << (8 - backend->bits_for_red);
-        new_g = g << (8 - backend->bits_for_green);
-        new_b = b << (8 - backend->bits_for_blue);
-
-        for (i = backend->bits_for_red; i < 8; i <<= 1) {
-                new_r |= new_r >> i;
-        }
-
-        for (i = backend->bits_for_green; i < 8; i <<= 1) {
-                new_g |= new_g >> i;
-        }
-
-        for (i = backend->bits_for_blue; i < 8; i <<= 1) {
-                new_b |= new_b >> i;
-        }
-
-        backend->dither_red = new_r - orig_r;
-        backend->dither_green = new_g - orig_g;
-        backend->dither_blue = new_b - orig_b;
-
-        return (a << backend->alpha_bit_position)
-               | (r << backend->red_bit_position)
-               | (g << backend->green_bit_position)
-               | (b << backend->blue_bit_position);
-}
-
 static void
-flush_area_to_any_device (ply_renderer_backend_t *backend,
-                          ply_renderer_head_t    *head,
-                          ply_rectangle_t        *area_to_flush)
+flush_area_with_pixel_tables (ply_renderer_backend_t *backend,
+                              ply_renderer_head_t    *head,
+                              ply_rectangle_t        *area_to_flush)
 {
-        unsigned long row, column;
+        unsigned long row;
         uint32_t *shadow_buffer;
-        char *row_backend;
-        unsigned long x1, y1, x2, y2;
+        unsigned long x1, y1, y2;
 
         x1 = area_to_flush->x;
         y1 = area_to_flush->y;
-        x2 = x1 + area_to_flush->width;
         y2 = y1 + area_to_flush->height;
 
-        row_backend = malloc (backend->row_stride);
         shadow_buffer = ply_pixel_buffer_get_argb32_data (backend->head.pixel_buffer);
         for (row = y1; row < y2; row++) {
-                unsigned long offset;
-
-                for (column = x1; column < x2; column++) {
-                        uint32_t pixel_value;
-                        uint_fast32_t device_pixel_value;
-
-                        pixel_value = shadow_buffer[row * head->area.width + column];
-
-                        device_pixel_value = argb32_pixel_value_to_device_pixel_value (backend,
-                                                                                       pixel_value);
+                ply_frame_buffer_pixel_tables_convert_row (backend->pixel_tables,
+                                                           shadow_buffer + row * head->area.width + x1,
+                                                           x1, row, area_to_flush->width,
+                                                           head->row_buffer);
 
-                        memcpy (row_backend + column * backend->bytes_per_pixel,
-                                &device_pixel_value, backend->bytes_per_pixel);
-                }
-
-                offset = row * backend->row_stride + x1 * backend->bytes_per_pixel;
-                memcpy (head->map_address + offset, row_backend + x1 * backend->bytes_per_pixel,
-                        area_to_flush->width * backend->bytes_per_pixel);
+                memcpy (head->map_address + row * backend->row_stride + x1 * backend->bytes_per_pixel,
+                        head->row_buffer, area_to_flush->width * backend->bytes_per_pixel);
         }
-        free (row_backend);
 }
 
 static void
@@ -279,6 +220,7 @@ initialize_head (ply_renderer_backend_t *backend,
                    head->area.width, head->area.height);
         head->pixel_buffer = ply_pixel_buffer_new (head->area.width,
                                                    head->area.height);
+        head->row_buffer = malloc (head->area.width * backend->bytes_per_pixel);
         ply_pixel_buffer_fill_with_color (backend->head.pixel_buffer, NULL,
                                           0.0, 0.0, 0.0, 1.0);
         ply_list_append_data (backend->heads, head);
@@ -294,6 +236,9 @@ uninitialize_head (ply_renderer_backend_t *backend,
                 ply_pixel_buffer_free (head->pixel_buffer);
                 head->pixel_buffer = NULL;
 
+                free (head->row_buffer);
+                head->row_buffer = NULL;
+
                 ply_list_remove_data (backend->heads, head);
         }
 }
@@ -314,6 +259,7 @@ destroy_backend (ply_renderer_backend_t *backend)
         uninitialize_head (backend, &backend->head);
 
         ply_list_free (backend->heads);
+        ply_frame_buffer_pixel_tables_free (backend->pixel_tables);
 
         free (backend);
 }
@@ -398,6 +344,9 @@ close_device (ply_renderer_backend_t *backend)
         close (backend->device_fd);
         backend->device_fd = -1;
 
+        ply_frame_buffer_pixel_tables_free (backend->pixel_tables);
+        backend->pixel_tables = NULL;
+
         backend->bytes_per_pixel = 0;
         backend->head.area.x = 0;
         backend->head.area.y = 0;
@@ -507,9 +456,6 @@ query_device (ply_renderer_backend_t *backend,
 
         backend->bytes_per_pixel = variable_screen_info.bits_per_pixel >> 3;
         backend->row_stride = fixed_screen_info.line_length;
-        backend->dither_red = 0;
-        backend->dither_green = 0;
-        backend->dither_blue = 0;
 
         ply_trace ("%d bpp (%d, %d, %d, %d) with rowstride %d",
                    (int) backend->bytes_per_pixel * 8,
@@ -524,10 +470,25 @@ query_device (ply_renderer_backend_t *backend,
         if (backend->bytes_per_pixel == 4 &&
             backend->red_bit_position == 16 && backend->bits_for_red == 8 &&
             backend->green_bit_position == 8 && backend->bits_for_green == 8 &&
-            backend->blue_bit_position == 0 && backend->bits_for_blue == 8)
+            backend->blue_bit_position == 0 && backend->bits_for_blue == 8) {
                 backend->flush_area = flush_area_to_xrgb32_device;
-        else
-                backend->flush_area = flush_area_to_any_device;
+        } else {
+                ply_frame_buffer_pixel_format_t format = {
+                        .red_bit_position   = backend->red_bit_position,
+                        .green_bit_position = backend->green_bit_position,
+                        .blue_bit_position  = backend->blue_bit_position,
+                        .alpha_bit_position = backend->alpha_bit_position,
+                        .bits_for_red       = backend->bits_for_red,
+                        .bits_for_green     = backend->bits_for_green,
+                        .bits_for_blue      = backend->bits_for_blue,
+                        .bits_for_alpha     = backend->bits_for_alpha,
+                        .bytes_per_pixel    = backend->bytes_per_pixel,
+                };
+
+                backend->flush_area = flush_area_with_pixel_tables;
+                ply_frame_buffer_pixel_tables_free (backend->pixel_tables);
+                backend->pixel_tables = ply_frame_buffer_pixel_tables_new (&format);
+        }
 
         initialize_head (backend, &backend->head);
 
@@ -587,8 +548,8 @@ flush_head (ply_renderer_backend_t *backend,
             ply_renderer_head_t    *head)
 {
         ply_region_t *updated_region;
-        ply_list_t *areas_to_flush;
-        ply_list_node_t *node;
+        ply_rectangle_t *areas_to_flush;
+        size_t number_of_areas_to_flush, i;
         ply_pixel_buffer_t *pixel_buffer;
 
         assert (backend != NULL);
@@ -608,20 +569,10 @@ flush_head (ply_renderer_backend_t *backend,
         }
         pixel_buffer = head->pixel_buffer;
         updated_region = ply_pixel_buffer_get_updated_areas (pixel_buffer);
-        areas_to_flush = ply_region_get_sorted_rectangle_list (updated_region);
-
-        node = ply_list_get_first_node (areas_to_flush);
-        while (node != NULL) {
-                ply_list_node_t *next_node;
-                ply_rectangle_t *area_to_flush;
-
-                area_to_flush = (ply_rectangle_t *) ply_list_node_get_data (node);
-
-                next_node = ply_list_get_next_node (areas_to_flush, node);
-
-                backend->flush_area (backend, head, area_to_flush);
+        areas_to_flush = ply_region_get_rectangles (updated_region, &number_of_areas_to_flush);
 
-                node = next_node;
+        for (i = 0; i < number_of_areas_to_flush; i++) {
+                backend->flush_area (backend, head, &areas_to_flush[i]);
         }
 
         ply_region_clear (updated_region);
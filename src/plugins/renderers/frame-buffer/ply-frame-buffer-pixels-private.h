@@ -0,0 +1,48 @@
+/* ply-frame-buffer-pixels-private.h - internal argb32 to device pixel conversion
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ */
+
+#ifndef PLY_FRAME_BUFFER_PIXELS_PRIVATE_H
+#define PLY_FRAME_BUFFER_PIXELS_PRIVATE_H
+
+#include <stdint.h>
+
+#include "ply-private.h"
+
+typedef struct
+{
+        uint32_t     red_bit_position;
+        uint32_t     green_bit_position;
+        uint32_t     blue_bit_position;
+        uint32_t     alpha_bit_position;
+
+        uint32_t     bits_for_red;
+        uint32_t     bits_for_green;
+        uint32_t     bits_for_blue;
+        uint32_t     bits_for_alpha;
+
+        unsigned int bytes_per_pixel;
+} ply_frame_buffer_pixel_format_t;
+
+typedef struct _ply_frame_buffer_pixel_tables ply_frame_buffer_pixel_tables_t;
+
+PLY_PRIVATE ply_frame_buffer_pixel_tables_t *ply_frame_buffer_pixel_tables_new (const ply_frame_buffer_pixel_format_t *format);
+PLY_PRIVATE void ply_frame_buffer_pixel_tables_free (ply_frame_buffer_pixel_tables_t *tables);
+
+/* Converts width pixels starting at column x of row y, so the right
+ * dither cells get used, and writes them packed to output
+ */
+PLY_PRIVATE void ply_frame_buffer_pixel_tables_convert_row (ply_frame_buffer_pixel_tables_t *tables,
+                                                            const uint32_t                  *pixels,
+                                                            unsigned long                    x,
+                                                            unsigned long                    y,
+                                                            unsigned long                    width,
+                                                            char                            *output);
+
+#endif /* PLY_FRAME_BUFFER_PIXELS_PRIVATE_H */
@@ -0,0 +1,167 @@
+/* ply-frame-buffer-pixels.c - internal argb32 to device pixel conversion
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ */
+
+#include "ply-frame-buffer-pixels-private.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ply-utils.h"
+
+/* Device channel bits for every 8-bit channel value, one table per cell of
+ * the 4x4 ordered dither matrix
+ */
+#define DITHER_MATRIX_SIZE 4
+
+struct _ply_frame_buffer_pixel_tables
+{
+        uint32_t     red[DITHER_MATRIX_SIZE * DITHER_MATRIX_SIZE][256];
+        uint32_t     green[DITHER_MATRIX_SIZE * DITHER_MATRIX_SIZE][256];
+        uint32_t     blue[DITHER_MATRIX_SIZE * DITHER_MATRIX_SIZE][256];
+        uint32_t     alpha[256];
+
+        unsigned int bytes_per_pixel;
+};
+
+static const uint8_t dither_matrix[DITHER_MATRIX_SIZE * DITHER_MATRIX_SIZE] =
+{
+        0,  8,  2,  10,
+        12, 4,  14, 6,
+        3,  11, 1,  9,
+        15, 7,  13, 5,
+};
+
+static uint32_t
+channel_value_to_device_bits (uint32_t value,
+                              uint32_t bits,
+                              uint32_t threshold)
+{
+        uint32_t max_value;
+
+        if (bits == 0)
+                return 0;
+
+        if (bits >= 8) {
+                /* Wider channels get the value repeated into the low bits */
+                value <<= bits - 8;
+                return value | (value >> 8);
+        }
+
+        /* Nudge the value up by a fraction of one device step before
+         * truncating, so neighbouring pixels round different ways
+         */
+        max_value = (1 << bits) - 1;
+        value = (value + ((threshold << (8 - bits)) >> 4)) >> (8 - bits);
+
+        return MIN (value, max_value);
+}
+
+static void
+fill_channel_table (uint32_t table[DITHER_MATRIX_SIZE * DITHER_MATRIX_SIZE][256],
+                    uint32_t bits,
+                    uint32_t bit_position)
+{
+        int cell, value;
+
+        for (cell = 0; cell < DITHER_MATRIX_SIZE * DITHER_MATRIX_SIZE; cell++) {
+                for (value = 0; value < 256; value++) {
+                        table[cell][value] = channel_value_to_device_bits (value, bits,
+                                                                           dither_matrix[cell]) << bit_position;
+                }
+        }
+}
+
+ply_frame_buffer_pixel_tables_t *
+ply_frame_buffer_pixel_tables_new (const ply_frame_buffer_pixel_format_t *format)
+{
+        ply_frame_buffer_pixel_tables_t *tables;
+        int value;
+
+        tables = malloc (sizeof(ply_frame_buffer_pixel_tables_t));
+        tables->bytes_per_pixel = format->bytes_per_pixel;
+
+        fill_channel_table (tables->red, format->bits_for_red, format->red_bit_position);
+        fill_channel_table (tables->green, format->bits_for_green, format->green_bit_position);
+        fill_channel_table (tables->blue, format->bits_for_blue, format->blue_bit_position);
+
+        for (value = 0; value < 256; value++) {
+                tables->alpha[value] = channel_value_to_device_bits (value, format->bits_for_alpha, 0)
+                                       << format->alpha_bit_position;
+        }
+
+        return tables;
+}
+
+void
+ply_frame_buffer_pixel_tables_free (ply_frame_buffer_pixel_tables_t *tables)
+{
+        free (tables);
+}
+
+/* Inlined with a constant bytes_per_pixel, so each device depth gets its
+ * own loop with fixed size stores
+ */
+static inline void
+convert_row (ply_frame_buffer_pixel_tables_t *tables,
+             const uint32_t                  *pixels,
+             unsigned long                    x,
+             unsigned long                    y,
+             unsigned long                    width,
+             char                            *output,
+             unsigned int                     bytes_per_pixel)
+{
+        unsigned int dither_row = (y % DITHER_MATRIX_SIZE) * DITHER_MATRIX_SIZE;
+        unsigned long i;
+
+        for (i = 0; i < width; i++) {
+                unsigned int cell = dither_row + (x + i) % DITHER_MATRIX_SIZE;
+                uint32_t pixel_value = pixels[i];
+                uint32_t device_pixel_value;
+
+                device_pixel_value = tables->alpha[pixel_value >> 24] |
+                                     tables->red[cell][(pixel_value >> 16) & 0xff] |
+                                     tables->green[cell][(pixel_value >> 8) & 0xff] |
+                                     tables->blue[cell][pixel_value & 0xff];
+
+                if (bytes_per_pixel == 2) {
+                        uint16_t short_value = device_pixel_value;
+
+                        memcpy (output, &short_value, 2);
+                } else if (bytes_per_pixel == 4) {
+                        memcpy (output, &device_pixel_value, 4);
+                } else {
+                        output[0] = device_pixel_value;
+                        output[1] = device_pixel_value >> 8;
+                        output[2] = device_pixel_value >> 16;
+                }
+                output += bytes_per_pixel;
+        }
+}
+
+void
+ply_frame_buffer_pixel_tables_convert_row (ply_frame_buffer_pixel_tables_t *tables,
+                                           const uint32_t                  *pixels,
+                                           unsigned long                    x,
+                                           unsigned long                    y,
+                                           unsigned long                    width,
+                                           char                            *output)
+{
+        switch (tables->bytes_per_pixel) {
+        case 2:
+                convert_row (tables, pixels, x, y, width, output, 2);
+                break;
+        case 3:
+                convert_row (tables, pixels, x, y, width, output, 3);
+                break;
+        default:
+                convert_row (tables, pixels, x, y, width, output, 4);
+                break;
+        }
+}
@@ -0,0 +1,53 @@
+/* headless-renderer.h - statistics kept by the headless renderer plugin
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+#ifndef HEADLESS_RENDERER_H
+#define HEADLESS_RENDERER_H
+
+#include <stddef.h>
+
+#define PLY_RENDERER_HEADLESS_MAX_RECORDED_FLUSHES (1 << 16)
+
+typedef struct
+{
+        double        start_time;
+        double        duration;
+        unsigned long damaged_pixels;
+        unsigned int  number_of_areas;
+} ply_renderer_headless_flush_t;
+
+/* Every flush is counted, but only the first
+ * PLY_RENDERER_HEADLESS_MAX_RECORDED_FLUSHES are recorded individually
+ */
+typedef struct
+{
+        unsigned long                  number_of_flushes;
+        double                         total_flush_duration;
+        unsigned long long             total_damaged_pixels;
+
+        ply_renderer_headless_flush_t *flushes;
+        size_t                         number_of_recorded_flushes;
+} ply_renderer_headless_statistics_t;
+
+typedef const ply_renderer_headless_statistics_t *
+(*ply_renderer_headless_get_statistics_function_t) (void);
+
+const ply_renderer_headless_statistics_t *ply_renderer_headless_get_statistics (void);
+
+#endif /* HEADLESS_RENDERER_H */
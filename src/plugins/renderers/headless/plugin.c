@@ -0,0 +1,764 @@
+/* plugin.c - offscreen renderer plugin
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Renders into memory instead of a display, so splash plugins can be run
+ * and timed without any graphics hardware. Heads are described by the
+ * device name, for instance
+ *
+ *   headless:1920x1080,1280x800@2/90:rgb565
+ *
+ * gives a 1920x1080 head, and a 1280x800 head drawn at scale 2, rotated
+ * clockwise and flushed to 16 bits per pixel. Rotations are given in
+ * degrees clockwise and the formats are xrgb8888 and rgb565. A plain
+ * "headless" gives a single 1024x768 head.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ply-buffer.h"
+#include "ply-event-loop.h"
+#include "ply-input-device.h"
+#include "ply-list.h"
+#include "ply-logger.h"
+#include "ply-rectangle.h"
+#include "ply-region.h"
+#include "ply-terminal.h"
+#include "ply-utils.h"
+
+#include "ply-renderer.h"
+#include "ply-renderer-plugin.h"
+
+#include "headless-renderer.h"
+
+#define HEADLESS_DEVICE_NAME "headless"
+#define HEADLESS_DEFAULT_HEADS "1024x768"
+
+typedef enum
+{
+        HEADLESS_FORMAT_XRGB8888,
+        HEADLESS_FORMAT_RGB565,
+} headless_format_t;
+
+struct _ply_renderer_head
+{
+        ply_pixel_buffer_t         *pixel_buffer;
+        ply_rectangle_t             area;
+        ply_pixel_buffer_rotation_t rotation;
+        int                         scale;
+
+        headless_format_t           format;
+        unsigned int                bytes_per_pixel;
+        unsigned int                row_stride;
+
+        /* stands in for the scanout buffer a real device would have */
+        char                       *memory;
+};
+
+struct _ply_renderer_input_source
+{
+        ply_renderer_backend_t             *backend;
+        ply_fd_watch_t                     *terminal_input_watch;
+        ply_list_t                         *input_devices;
+
+        ply_buffer_t                       *key_buffer;
+
+        ply_renderer_input_source_handler_t handler;
+        void                               *user_data;
+};
+
+struct _ply_renderer_backend
+{
+        ply_event_loop_t           *loop;
+        ply_terminal_t             *terminal;
+
+        char                       *device_name;
+        char                       *head_descriptions;
+
+        ply_renderer_input_source_t input_source;
+        ply_list_t                 *heads;
+
+        uint32_t                    is_active : 1;
+        uint32_t                    input_source_is_open : 1;
+};
+
+ply_renderer_plugin_interface_t *ply_renderer_backend_get_interface (void);
+static bool open_input_source (ply_renderer_backend_t      *backend,
+                               ply_renderer_input_source_t *input_source);
+
+/* Shared by every backend the module creates, so a benchmark can get at it
+ * without going through the renderer
+ */
+static ply_renderer_headless_statistics_t statistics;
+
+const ply_renderer_headless_statistics_t *
+ply_renderer_headless_get_statistics (void)
+{
+        return &statistics;
+}
+
+static void
+reset_statistics (void)
+{
+        free (statistics.flushes);
+        memset (&statistics, 0, sizeof(statistics));
+}
+
+static void
+record_flush (double        start_time,
+              double        duration,
+              unsigned long damaged_pixels,
+              unsigned int  number_of_areas)
+{
+        ply_renderer_headless_flush_t *flush;
+
+        statistics.number_of_flushes++;
+        statistics.total_flush_duration += duration;
+        statistics.total_damaged_pixels += damaged_pixels;
+
+        if (statistics.number_of_recorded_flushes >= PLY_RENDERER_HEADLESS_MAX_RECORDED_FLUSHES)
+                return;
+
+        if (statistics.flushes == NULL)
+                statistics.flushes = calloc (PLY_RENDERER_HEADLESS_MAX_RECORDED_FLUSHES,
+                                             sizeof(ply_renderer_headless_flush_t));
+
+        flush = &statistics.flushes[statistics.number_of_recorded_flushes++];
+        flush->start_time = start_time;
+        flush->duration = duration;
+        flush->damaged_pixels = damaged_pixels;
+        flush->number_of_areas = number_of_areas;
+}
+
+static bool
+parse_rotation (unsigned long                degrees,
+                ply_pixel_buffer_rotation_t *rotation)
+{
+        switch (degrees) {
+        case 0:
+                *rotation = PLY_PIXEL_BUFFER_ROTATE_UPRIGHT;
+                return true;
+        case 90:
+                *rotation = PLY_PIXEL_BUFFER_ROTATE_CLOCKWISE;
+                return true;
+        case 180:
+                *rotation = PLY_PIXEL_BUFFER_ROTATE_UPSIDE_DOWN;
+                return true;
+        case 270:
+                *rotation = PLY_PIXEL_BUFFER_ROTATE_COUNTER_CLOCKWISE;
+                return true;
+        }
+
+        return false;
+}
+
+static bool
+parse_head_description (const char          *description,
+                        ply_renderer_head_t *head)
+{
+        unsigned long width, height, value;
+        char *end;
+
+        width = strtoul (description, &end, 10);
+        if (end == description || *end != 'x')
+                return false;
+
+        description = end + 1;
+        height = strtoul (description, &end, 10);
+        if (end == description)
+                return false;
+
+        if (width == 0 || height == 0 || width > 16384 || height > 16384)
+                return false;
+
+        head->area.width = width;
+        head->area.height = height;
+        head->rotation = PLY_PIXEL_BUFFER_ROTATE_UPRIGHT;
+        head->scale = 0;
+        head->format = HEADLESS_FORMAT_XRGB8888;
+
+        while (*end != '\0') {
+                description = end + 1;
+
+                switch (*end) {
+                case '@':
+                        value = strtoul (description, &end, 10);
+                        if (end == description || value == 0 || value > 4)
+                                return false;
+                        head->scale = value;
+                        break;
+                case '/':
+                        value = strtoul (description, &end, 10);
+                        if (end == description || !parse_rotation (value, &head->rotation))
+                                return false;
+                        break;
+                case ':':
+                        if (strcmp (description, "xrgb8888") == 0)
+                                head->format = HEADLESS_FORMAT_XRGB8888;
+                        else if (strcmp (description, "rgb565") == 0)
+                                head->format = HEADLESS_FORMAT_RGB565;
+                        else
+                                return false;
+                        end = (char *) description + strlen (description);
+                        break;
+                default:
+                        return false;
+                }
+        }
+
+        return true;
+}
+
+static void
+free_heads (ply_renderer_backend_t *backend)
+{
+        ply_list_node_t *node;
+
+        ply_list_foreach (backend->heads, node) {
+                ply_renderer_head_t *head = ply_list_node_get_data (node);
+
+                ply_pixel_buffer_free (head->pixel_buffer);
+                free (head->memory);
+                free (head);
+        }
+
+        ply_list_remove_all_nodes (backend->heads);
+}
+
+static bool
+create_heads (ply_renderer_backend_t *backend)
+{
+        char *descriptions, *description, *state = NULL;
+
+        descriptions = strdup (backend->head_descriptions);
+
+        for (description = strtok_r (descriptions, ",", &state);
+             description != NULL;
+             description = strtok_r (NULL, ",", &state)) {
+                ply_renderer_head_t *head;
+
+                head = calloc (1, sizeof(ply_renderer_head_t));
+
+                if (!parse_head_description (description, head)) {
+                        ply_trace ("could not parse head description '%s'", description);
+                        free (head);
+                        free (descriptions);
+                        free_heads (backend);
+                        return false;
+                }
+
+                if (head->scale == 0)
+                        head->scale = ply_get_device_scale (head->area.width, head->area.height, 0, 0);
+
+                head->bytes_per_pixel = head->format == HEADLESS_FORMAT_RGB565 ? 2 : 4;
+                head->row_stride = head->area.width * head->bytes_per_pixel;
+                head->memory = calloc (head->area.height, head->row_stride);
+
+                head->pixel_buffer = ply_pixel_buffer_new_with_device_rotation (head->area.width,
+                                                                                head->area.height,
+                                                                                head->rotation);
+                ply_pixel_buffer_set_device_scale (head->pixel_buffer, head->scale);
+                ply_pixel_buffer_fill_with_color (head->pixel_buffer, NULL, 0.0, 0.0, 0.0, 1.0);
+
+                ply_trace ("created %lux%lu head (rotation %d, scale %d, %d bytes per pixel)",
+                           head->area.width, head->area.height,
+                           head->rotation, head->scale, head->bytes_per_pixel);
+
+                ply_list_append_data (backend->heads, head);
+        }
+
+        free (descriptions);
+
+        return ply_list_get_length (backend->heads) > 0;
+}
+
+static ply_renderer_backend_t *
+create_backend (const char     *device_name,
+                ply_terminal_t *terminal,
+                ply_terminal_t *local_console_terminal)
+{
+        ply_renderer_backend_t *backend;
+        const char *head_descriptions;
+
+        if (device_name == NULL || strcmp (device_name, HEADLESS_DEVICE_NAME) == 0)
+                head_descriptions = HEADLESS_DEFAULT_HEADS;
+        else if (strncmp (device_name, HEADLESS_DEVICE_NAME ":", strlen (HEADLESS_DEVICE_NAME ":")) == 0)
+                head_descriptions = device_name + strlen (HEADLESS_DEVICE_NAME ":");
+        else
+                return NULL;
+
+        backend = calloc (1, sizeof(ply_renderer_backend_t));
+
+        backend->device_name = strdup (device_name != NULL ? device_name : HEADLESS_DEVICE_NAME);
+        backend->head_descriptions = strdup (head_descriptions);
+
+        ply_trace ("creating renderer backend for %s", backend->device_name);
+
+        backend->loop = ply_event_loop_get_default ();
+        backend->heads = ply_list_new ();
+        backend->input_source.key_buffer = ply_buffer_new ();
+        backend->input_source.input_devices = ply_list_new ();
+        backend->terminal = terminal;
+
+        reset_statistics ();
+
+        return backend;
+}
+
+static void
+destroy_backend (ply_renderer_backend_t *backend)
+{
+        ply_trace ("destroying renderer backend for %s", backend->device_name);
+
+        free_heads (backend);
+        ply_list_free (backend->heads);
+        ply_list_free (backend->input_source.input_devices);
+        ply_buffer_free (backend->input_source.key_buffer);
+        free (backend->head_descriptions);
+        free (backend->device_name);
+        free (backend);
+}
+
+static void
+flush_area (ply_renderer_head_t *head,
+            ply_rectangle_t     *area_to_flush)
+{
+        uint32_t *shadow_buffer;
+        unsigned long x, y;
+        char *row;
+
+        shadow_buffer = ply_pixel_buffer_get_argb32_data (head->pixel_buffer);
+
+        for (y = area_to_flush->y; y < area_to_flush->y + area_to_flush->height; y++) {
+                uint32_t *source = &shadow_buffer[y * head->area.width + area_to_flush->x];
+
+                row = head->memory + y * head->row_stride + area_to_flush->x * head->bytes_per_pixel;
+
+                if (head->format == HEADLESS_FORMAT_XRGB8888) {
+                        memcpy (row, source, area_to_flush->width * 4);
+                        continue;
+                }
+
+                for (x = 0; x < area_to_flush->width; x++) {
+                        uint32_t pixel = source[x];
+                        uint16_t device_pixel;
+
+                        device_pixel = ((pixel >> 8) & 0xf800) |
+                                       ((pixel >> 5) & 0x07e0) |
+                                       ((pixel >> 3) & 0x001f);
+                        memcpy (row + x * 2, &device_pixel, 2);
+                }
+        }
+}
+
+static void
+flush_head (ply_renderer_backend_t *backend,
+            ply_renderer_head_t    *head)
+{
+        ply_region_t *updated_region;
+        ply_rectangle_t *areas_to_flush;
+        size_t number_of_areas_to_flush, i;
+        unsigned long damaged_pixels = 0;
+        double start_time;
+
+        assert (backend != NULL);
+        assert (head != NULL);
+
+        if (!backend->is_active)
+                return;
+
+        updated_region = ply_pixel_buffer_get_updated_areas (head->pixel_buffer);
+        areas_to_flush = ply_region_get_rectangles (updated_region, &number_of_areas_to_flush);
+
+        if (number_of_areas_to_flush == 0)
+                return;
+
+        start_time = ply_get_timestamp ();
+
+        for (i = 0; i < number_of_areas_to_flush; i++) {
+                ply_rectangle_t area_to_flush;
+
+                ply_rectangle_intersect (&areas_to_flush[i], &head->area, &area_to_flush);
+
+                if (ply_rectangle_is_empty (&area_to_flush))
+                        continue;
+
+                flush_area (head, &area_to_flush);
+                damaged_pixels += area_to_flush.width * area_to_flush.height;
+        }
+
+        ply_region_clear (updated_region);
+
+        record_flush (start_time, ply_get_timestamp () - start_time,
+                      damaged_pixels, number_of_areas_to_flush);
+}
+
+static void
+redraw_heads (ply_renderer_backend_t *backend)
+{
+        ply_list_node_t *node;
+
+        ply_list_foreach (backend->heads, node) {
+                ply_renderer_head_t *head = ply_list_node_get_data (node);
+                ply_region_t *region;
+
+                region = ply_pixel_buffer_get_updated_areas (head->pixel_buffer);
+                ply_region_add_rectangle (region, &head->area);
+
+                flush_head (backend, head);
+        }
+}
+
+static void
+activate (ply_renderer_backend_t *backend)
+{
+        backend->is_active = true;
+        redraw_heads (backend);
+}
+
+static void
+deactivate (ply_renderer_backend_t *backend)
+{
+        backend->is_active = false;
+}
+
+static bool
+open_device (ply_renderer_backend_t *backend)
+{
+        return true;
+}
+
+static void
+close_device (ply_renderer_backend_t *backend)
+{
+        if (statistics.number_of_flushes > 0) {
+                ply_trace ("%lu flushes taking %.3fms and covering %llu pixels on average",
+                           statistics.number_of_flushes,
+                           1000.0 * statistics.total_flush_duration / statistics.number_of_flushes,
+                           statistics.total_damaged_pixels / statistics.number_of_flushes);
+        }
+
+        free_heads (backend);
+}
+
+static bool
+query_device (ply_renderer_backend_t *backend,
+              bool                    force)
+{
+        if (ply_list_get_length (backend->heads) > 0)
+                return true;
+
+        return create_heads (backend);
+}
+
+static bool
+map_to_device (ply_renderer_backend_t *backend)
+{
+        activate (backend);
+        return true;
+}
+
+static void
+unmap_from_device (ply_renderer_backend_t *backend)
+{
+        deactivate (backend);
+}
+
+static const char *
+get_device_name (ply_renderer_backend_t *backend)
+{
+        return backend->device_name;
+}
+
+static ply_list_t *
+get_heads (ply_renderer_backend_t *backend)
+{
+        return backend->heads;
+}
+
+static ply_pixel_buffer_t *
+get_buffer_for_head (ply_renderer_backend_t *backend,
+                     ply_renderer_head_t    *head)
+{
+        return head->pixel_buffer;
+}
+
+static bool
+get_panel_properties (ply_renderer_backend_t      *backend,
+                      int                         *width,
+                      int                         *height,
+                      ply_pixel_buffer_rotation_t *rotation,
+                      int                         *scale)
+{
+        ply_list_node_t *node;
+        ply_renderer_head_t *head;
+
+        node = ply_list_get_first_node (backend->heads);
+        if (node == NULL)
+                return false;
+
+        head = ply_list_node_get_data (node);
+        *width = head->area.width;
+        *height = head->area.height;
+        *rotation = head->rotation;
+        *scale = head->scale;
+        return true;
+}
+
+static bool
+has_input_source (ply_renderer_backend_t      *backend,
+                  ply_renderer_input_source_t *input_source)
+{
+        return input_source == &backend->input_source;
+}
+
+static ply_renderer_input_source_t *
+get_input_source (ply_renderer_backend_t *backend)
+{
+        return &backend->input_source;
+}
+
+static bool
+using_input_device (ply_renderer_input_source_t *input_source)
+{
+        return ply_list_get_length (input_source->input_devices) > 0;
+}
+
+static void
+on_terminal_key_event (ply_renderer_input_source_t *input_source)
+{
+        ply_renderer_backend_t *backend = input_source->backend;
+
+        if (using_input_device (input_source))
+                return;
+
+        ply_buffer_append_from_fd (input_source->key_buffer,
+                                   ply_terminal_get_fd (backend->terminal));
+
+        if (input_source->handler != NULL)
+                input_source->handler (input_source->user_data, input_source->key_buffer, input_source);
+}
+
+static ply_input_device_input_result_t
+on_input_device_key (ply_renderer_input_source_t *input_source,
+                     ply_input_device_t          *input_device,
+                     const char                  *text)
+{
+        ply_buffer_append_bytes (input_source->key_buffer, text, strlen (text));
+
+        if (input_source->handler == NULL)
+                return PLY_INPUT_RESULT_PROPAGATED;
+
+        input_source->handler (input_source->user_data, input_source->key_buffer, input_source);
+
+        return PLY_INPUT_RESULT_CONSUMED;
+}
+
+static void
+on_input_leds_changed (ply_renderer_input_source_t *input_source,
+                       ply_input_device_t          *input_device)
+{
+        ply_list_node_t *node;
+
+        ply_list_foreach (input_source->input_devices, node) {
+                ply_input_device_update_leds (ply_list_node_get_data (node));
+        }
+}
+
+static void
+on_input_source_disconnected (ply_renderer_input_source_t *input_source)
+{
+        ply_trace ("input source disconnected, reopening");
+        open_input_source (input_source->backend, input_source);
+}
+
+static void
+watch_input_device (ply_renderer_backend_t *backend,
+                    ply_input_device_t     *input_device)
+{
+        ply_input_device_watch_for_input (input_device,
+                                          (ply_input_device_input_handler_t) on_input_device_key,
+                                          (ply_input_device_leds_changed_handler_t) on_input_leds_changed,
+                                          &backend->input_source);
+}
+
+static bool
+open_input_source (ply_renderer_backend_t      *backend,
+                   ply_renderer_input_source_t *input_source)
+{
+        ply_list_node_t *node;
+
+        assert (backend != NULL);
+        assert (has_input_source (backend, input_source));
+
+        if (!backend->input_source_is_open) {
+                ply_list_foreach (input_source->input_devices, node) {
+                        watch_input_device (backend, ply_list_node_get_data (node));
+                }
+        }
+
+        if (backend->terminal != NULL && ply_terminal_get_fd (backend->terminal) >= 0) {
+                input_source->terminal_input_watch = ply_event_loop_watch_fd (backend->loop,
+                                                                              ply_terminal_get_fd (backend->terminal),
+                                                                              PLY_EVENT_LOOP_FD_STATUS_HAS_DATA,
+                                                                              (ply_event_handler_t) on_terminal_key_event,
+                                                                              (ply_event_handler_t)
+                                                                              on_input_source_disconnected, input_source);
+        }
+
+        input_source->backend = backend;
+        backend->input_source_is_open = true;
+
+        return true;
+}
+
+static void
+set_handler_for_input_source (ply_renderer_backend_t             *backend,
+                              ply_renderer_input_source_t        *input_source,
+                              ply_renderer_input_source_handler_t handler,
+                              void                               *user_data)
+{
+        assert (backend != NULL);
+        assert (has_input_source (backend, input_source));
+
+        input_source->handler = handler;
+        input_source->user_data = user_data;
+}
+
+static void
+close_input_source (ply_renderer_backend_t      *backend,
+                    ply_renderer_input_source_t *input_source)
+{
+        ply_list_node_t *node;
+
+        assert (backend != NULL);
+        assert (has_input_source (backend, input_source));
+
+        if (!backend->input_source_is_open)
+                return;
+
+        ply_list_foreach (input_source->input_devices, node) {
+                ply_input_device_stop_watching_for_input (ply_list_node_get_data (node),
+                                                          (ply_input_device_input_handler_t) on_input_device_key,
+                                                          (ply_input_device_leds_changed_handler_t) on_input_leds_changed,
+                                                          &backend->input_source);
+        }
+
+        if (input_source->terminal_input_watch != NULL) {
+                ply_event_loop_stop_watching_fd (backend->loop, input_source->terminal_input_watch);
+                input_source->terminal_input_watch = NULL;
+        }
+
+        input_source->backend = NULL;
+        backend->input_source_is_open = false;
+}
+
+static ply_input_device_t *
+get_any_input_device (ply_renderer_backend_t *backend)
+{
+        ply_list_node_t *node = ply_list_get_first_node (backend->input_source.input_devices);
+
+        if (node != NULL)
+                return ply_list_node_get_data (node);
+
+        return NULL;
+}
+
+static bool
+get_capslock_state (ply_renderer_backend_t *backend)
+{
+        ply_input_device_t *input_device = get_any_input_device (backend);
+
+        if (input_device != NULL)
+                return ply_input_device_get_capslock_state (input_device);
+
+        if (backend->terminal == NULL)
+                return false;
+
+        return ply_terminal_get_capslock_state (backend->terminal);
+}
+
+static const char *
+get_keymap (ply_renderer_backend_t *backend)
+{
+        ply_input_device_t *input_device = get_any_input_device (backend);
+
+        if (input_device != NULL)
+                return ply_input_device_get_keymap (input_device);
+
+        if (backend->terminal == NULL)
+                return NULL;
+
+        return ply_terminal_get_keymap (backend->terminal);
+}
+
+static void
+add_input_device (ply_renderer_backend_t *backend,
+                  ply_input_device_t     *input_device)
+{
+        ply_list_append_data (backend->input_source.input_devices, input_device);
+
+        if (backend->input_source_is_open)
+                watch_input_device (backend, input_device);
+}
+
+static void
+remove_input_device (ply_renderer_backend_t *backend,
+                     ply_input_device_t     *input_device)
+{
+        ply_list_remove_data (backend->input_source.input_devices, input_device);
+}
+
+ply_renderer_plugin_interface_t *
+ply_renderer_backend_get_interface (void)
+{
+        static ply_renderer_plugin_interface_t plugin_interface =
+        {
+                .create_backend               = create_backend,
+                .destroy_backend              = destroy_backend,
+                .open_device                  = open_device,
+                .close_device                 = close_device,
+                .query_device                 = query_device,
+                .map_to_device                = map_to_device,
+                .unmap_from_device            = unmap_from_device,
+                .activate                     = activate,
+                .deactivate                   = deactivate,
+                .flush_head                   = flush_head,
+                .get_heads                    = get_heads,
+                .get_buffer_for_head          = get_buffer_for_head,
+                .get_input_source             = get_input_source,
+                .open_input_source            = open_input_source,
+                .set_handler_for_input_source = set_handler_for_input_source,
+                .close_input_source           = close_input_source,
+                .get_device_name              = get_device_name,
+                .get_panel_properties         = get_panel_properties,
+                .get_capslock_state           = get_capslock_state,
+                .get_keymap                   = get_keymap,
+                .add_input_device             = add_input_device,
+                .remove_input_device          = remove_input_device,
+        };
+
+        return &plugin_interface;
+}
@@ -48,6 +48,8 @@
 #include <gtk/gtk.h>
 #include <gdk/gdkkeysyms.h>
 #include <gdk/gdkx.h>
+#include <X11/Xlib.h>
+#include <X11/extensions/XShm.h>
 
 #include "ply-buffer.h"
 #include "ply-event-loop.h"
@@ -60,6 +62,10 @@
 #include "ply-renderer.h"
 #include "ply-renderer-plugin.h"
 
+#define MAX_MAIN_CONTEXT_POLL_FDS 64
+#define MAX_MAIN_CONTEXT_ITERATIONS_PER_WAKEUP 32
+#define MIN_MAIN_CONTEXT_TIMEOUT 0.0001
+
 static const char *function_key_escape_sequence[] = {
         "\033[[A",  /* F1 */
         "\033[[B",  /* F2 */
@@ -83,7 +89,15 @@ struct _ply_renderer_head
         GtkWidget              *window;
         cairo_surface_t        *image;
         uint32_t                scale;
+
+        /* Set when flushes go straight to the window instead of through gtk */
+        Window                  xid;
+        GC                      gc;
+        XImage                 *ximage;
+        XShmSegmentInfo         shm_info;
+
         uint32_t                is_fullscreen : 1;
+        uint32_t                uses_shm : 1;
 };
 
 struct _ply_renderer_input_source
@@ -93,15 +107,30 @@ struct _ply_renderer_input_source
         void                               *user_data;
 };
 
+typedef enum
+{
+        PLY_X11_FLUSH_METHOD_XSHM = 0,
+        PLY_X11_FLUSH_METHOD_XPUTIMAGE,
+        PLY_X11_FLUSH_METHOD_GTK,
+} ply_x11_flush_method_t;
+
 struct _ply_renderer_backend
 {
         ply_event_loop_t           *loop;
+        Display                    *display;
+        ply_x11_flush_method_t      flush_method;
         ply_renderer_input_source_t input_source;
         ply_list_t                 *heads;
 
-        ply_fd_watch_t             *display_watch;
+        /* What the GLib main context last asked to be woken for */
+        GPollFD                     poll_fds[MAX_MAIN_CONTEXT_POLL_FDS];
+        ply_fd_watch_t             *poll_fd_watches[MAX_MAIN_CONTEXT_POLL_FDS];
+        int                         number_of_poll_fds;
 
         uint32_t                    is_active : 1;
+        uint32_t                    is_watching_main_context : 1;
+        uint32_t                    is_dispatching_main_context : 1;
+        uint32_t                    main_context_timeout_is_pending : 1;
 };
 
 ply_renderer_plugin_interface_t *ply_renderer_backend_get_interface (void);
@@ -119,6 +148,7 @@ create_backend (const char     *device_name,
                 ply_terminal_t *local_console_terminal)
 {
         ply_renderer_backend_t *backend;
+        const char *flush_method;
 
         gdk_set_allowed_backends ("x11");
 
@@ -128,9 +158,18 @@ create_backend (const char     *device_name,
         backend = calloc (1, sizeof(ply_renderer_backend_t));
 
         backend->loop = ply_event_loop_get_default ();
+        backend->display = GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
         backend->heads = ply_list_new ();
         backend->input_source.key_buffer = ply_buffer_new ();
 
+        flush_method = getenv ("PLY_X11_FLUSH_METHOD");
+        if (flush_method != NULL && strcmp (flush_method, "gtk") == 0)
+                backend->flush_method = PLY_X11_FLUSH_METHOD_GTK;
+        else if (flush_method != NULL && strcmp (flush_method, "xputimage") == 0)
+                backend->flush_method = PLY_X11_FLUSH_METHOD_XPUTIMAGE;
+        else
+                backend->flush_method = PLY_X11_FLUSH_METHOD_XSHM;
+
         return backend;
 }
 
@@ -156,46 +195,218 @@ destroy_backend (ply_renderer_backend_t *backend)
         free (backend);
 }
 
+static void watch_main_context (ply_renderer_backend_t *backend);
+
+static void
+dispatch_main_context (ply_renderer_backend_t *backend)
+{
+        GMainContext *context = g_main_context_default ();
+        int i;
+
+        /* Bounded so a busy X connection can't starve the rest of the loop */
+        backend->is_dispatching_main_context = true;
+        for (i = 0; i < MAX_MAIN_CONTEXT_ITERATIONS_PER_WAKEUP; i++) {
+                if (!g_main_context_iteration (context, FALSE))
+                        break;
+        }
+        backend->is_dispatching_main_context = false;
+
+        watch_main_context (backend);
+}
+
+static void
+on_main_context_fd_event (ply_renderer_backend_t *backend,
+                          int                     fd)
+{
+        dispatch_main_context (backend);
+}
+
 static void
-on_display_event (ply_renderer_backend_t *backend)
+on_main_context_fd_disconnected (ply_renderer_backend_t *backend,
+                                 int                     fd)
 {
-        while (gtk_events_pending ()) {
-                gtk_main_iteration ();
+        int i;
+
+        /* the event loop frees the watches of a hung up fd itself */
+        for (i = 0; i < backend->number_of_poll_fds; i++) {
+                if (backend->poll_fds[i].fd == fd)
+                        backend->poll_fd_watches[i] = NULL;
         }
 }
 
 static void
-on_timeout_event (ply_renderer_backend_t *backend,
-                  ply_event_loop_t       *loop)
+on_main_context_timeout (ply_renderer_backend_t *backend,
+                         ply_event_loop_t       *loop)
+{
+        backend->main_context_timeout_is_pending = false;
+        dispatch_main_context (backend);
+}
+
+static void
+stop_watching_main_context_fds (ply_renderer_backend_t *backend)
 {
-        on_display_event (backend);
+        int i;
 
-        ply_event_loop_watch_for_timeout (loop, 0.02,
-                                          (ply_event_loop_timeout_handler_t) on_timeout_event,
-                                          backend);
+        for (i = 0; i < backend->number_of_poll_fds; i++) {
+                if (backend->poll_fd_watches[i] != NULL)
+                        ply_event_loop_stop_watching_fd (backend->loop, backend->poll_fd_watches[i]);
+                backend->poll_fd_watches[i] = NULL;
+        }
+        backend->number_of_poll_fds = 0;
+}
+
+static void
+stop_watching_main_context (ply_renderer_backend_t *backend)
+{
+        stop_watching_main_context_fds (backend);
+
+        if (backend->main_context_timeout_is_pending) {
+                ply_event_loop_stop_watching_for_timeout (backend->loop,
+                                                          (ply_event_loop_timeout_handler_t) on_main_context_timeout,
+                                                          backend);
+                backend->main_context_timeout_is_pending = false;
+        }
+
+        backend->is_watching_main_context = false;
 }
 
 static bool
-open_device (ply_renderer_backend_t *backend)
+main_context_fds_changed (ply_renderer_backend_t *backend,
+                          GPollFD                *poll_fds,
+                          int                     number_of_poll_fds)
 {
-        Display *display;
-        int display_fd;
+        int i;
 
-        /* Force gtk+ to deal in device pixels */
-        gdk_x11_display_set_window_scale (gdk_display_get_default (), 1);
+        if (number_of_poll_fds != backend->number_of_poll_fds)
+                return true;
 
-        display = GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
-        display_fd = ConnectionNumber (display);
-        backend->display_watch = ply_event_loop_watch_fd (backend->loop,
-                                                          display_fd,
-                                                          PLY_EVENT_LOOP_FD_STATUS_HAS_DATA,
-                                                          (ply_event_handler_t) on_display_event,
-                                                          NULL,
+        for (i = 0; i < number_of_poll_fds; i++) {
+                if (poll_fds[i].fd != backend->poll_fds[i].fd ||
+                    poll_fds[i].events != backend->poll_fds[i].events)
+                        return true;
+        }
+
+        return false;
+}
+
+static ply_event_loop_fd_status_t
+get_fd_status_for_poll_events (gushort events)
+{
+        ply_event_loop_fd_status_t status = PLY_EVENT_LOOP_FD_STATUS_NONE;
+
+        if (events & G_IO_IN)
+                status |= PLY_EVENT_LOOP_FD_STATUS_HAS_DATA;
+        if (events & G_IO_PRI)
+                status |= PLY_EVENT_LOOP_FD_STATUS_HAS_CONTROL_DATA;
+        if (events & G_IO_OUT)
+                status |= PLY_EVENT_LOOP_FD_STATUS_CAN_TAKE_DATA;
+
+        return status;
+}
+
+/* Asks the GLib main context (where gdk reads the X connection) which
+ * fds and deadline it's waiting on, and has the event loop wake us for
+ * exactly those, instead of polling gtk on a timer.
+ */
+static void
+watch_main_context (ply_renderer_backend_t *backend)
+{
+        GMainContext *context = g_main_context_default ();
+        GPollFD poll_fds[MAX_MAIN_CONTEXT_POLL_FDS];
+        int number_of_poll_fds;
+        gint max_priority, timeout;
+        gboolean is_ready;
+        int i;
+
+        /* anything queued from inside a dispatch is picked up once it returns */
+        if (!backend->is_watching_main_context || backend->is_dispatching_main_context)
+                return;
+
+        if (!g_main_context_acquire (context))
+                return;
+
+        is_ready = g_main_context_prepare (context, &max_priority);
+        number_of_poll_fds = g_main_context_query (context, max_priority, &timeout,
+                                                   poll_fds, MAX_MAIN_CONTEXT_POLL_FDS);
+        g_main_context_release (context);
+
+        if (number_of_poll_fds > MAX_MAIN_CONTEXT_POLL_FDS) {
+                ply_trace ("main context wants %d fds, only watching %d",
+                           number_of_poll_fds, MAX_MAIN_CONTEXT_POLL_FDS);
+                number_of_poll_fds = MAX_MAIN_CONTEXT_POLL_FDS;
+        }
+
+        if (main_context_fds_changed (backend, poll_fds, number_of_poll_fds)) {
+                stop_watching_main_context_fds (backend);
+
+                for (i = 0; i < number_of_poll_fds; i++) {
+                        ply_event_loop_fd_status_t status;
+                        bool is_duplicate = false;
+                        int j;
+
+                        backend->poll_fds[i] = poll_fds[i];
+                        backend->poll_fd_watches[i] = NULL;
+
+                        /* One watch per fd, so stopping a watch from its own
+                         * handler can't pull another out from under the loop
+                         */
+                        status = PLY_EVENT_LOOP_FD_STATUS_NONE;
+                        for (j = 0; j < number_of_poll_fds; j++) {
+                                if (poll_fds[j].fd != poll_fds[i].fd)
+                                        continue;
+                                if (j < i)
+                                        is_duplicate = true;
+                                status |= get_fd_status_for_poll_events (poll_fds[j].events);
+                        }
+
+                        if (poll_fds[i].fd < 0 || is_duplicate || status == PLY_EVENT_LOOP_FD_STATUS_NONE)
+                                continue;
+
+                        backend->poll_fd_watches[i] =
+                                ply_event_loop_watch_fd (backend->loop,
+                                                         poll_fds[i].fd,
+                                                         status,
+                                                         (ply_event_handler_t) on_main_context_fd_event,
+                                                         (ply_event_handler_t) on_main_context_fd_disconnected,
+                                                         backend);
+                }
+                backend->number_of_poll_fds = number_of_poll_fds;
+        }
+
+        if (backend->main_context_timeout_is_pending) {
+                ply_event_loop_stop_watching_for_timeout (backend->loop,
+                                                          (ply_event_loop_timeout_handler_t) on_main_context_timeout,
                                                           backend);
+                backend->main_context_timeout_is_pending = false;
+        }
+
+        /* Sources that are already ready (e.g. X events xlib has queued
+         * but not handed out yet) get the soonest wakeup the event loop
+         * allows, since it won't take a timeout of zero.
+         */
+        if (is_ready)
+                timeout = 0;
+
+        if (timeout >= 0) {
+                ply_event_loop_watch_for_timeout (backend->loop,
+                                                  MAX (timeout / 1000.0, MIN_MAIN_CONTEXT_TIMEOUT),
+                                                  (ply_event_loop_timeout_handler_t) on_main_context_timeout,
+                                                  backend);
+                backend->main_context_timeout_is_pending = true;
+        }
+}
+
+static bool
+open_device (ply_renderer_backend_t *backend)
+{
+        /* Force gtk+ to deal in device pixels */
+        gdk_x11_display_set_window_scale (gdk_display_get_default (), 1);
 
-        ply_event_loop_watch_for_timeout (backend->loop, 0.02,
-                                          (ply_event_loop_timeout_handler_t) on_timeout_event,
-                                          backend);
+        /* gdk watches the X connection from the main context, so that
+         * covers X traffic as well as gtk's own timers and idles
+         */
+        backend->is_watching_main_context = true;
+        dispatch_main_context (backend);
 
         return true;
 }
@@ -209,12 +420,7 @@ get_device_name (ply_renderer_backend_t *backend)
 static void
 close_device (ply_renderer_backend_t *backend)
 {
-        ply_event_loop_stop_watching_for_timeout (backend->loop,
-                                                  (ply_event_loop_timeout_handler_t) on_display_event,
-                                                  backend);
-        ply_event_loop_stop_watching_fd (backend->loop, backend->display_watch);
-        backend->display_watch = NULL;
-        return;
+        stop_watching_main_context (backend);
 }
 
 static void
@@ -321,6 +527,152 @@ on_draw (GtkWidget *widget,
         return TRUE;
 }
 
+static int
+get_host_byte_order (void)
+{
+        const uint32_t value = 1;
+
+        return *(const uint8_t *) &value == 1 ? LSBFirst : MSBFirst;
+}
+
+static bool
+create_shm_image (ply_renderer_backend_t *backend,
+                  ply_renderer_head_t    *head,
+                  Visual                 *visual,
+                  int                     depth)
+{
+        int error;
+
+        if (!XShmQueryExtension (backend->display))
+                return false;
+
+        /* the server reads the segment as is, so it has to match us */
+        if (ImageByteOrder (backend->display) != get_host_byte_order ())
+                return false;
+
+        head->ximage = XShmCreateImage (backend->display, visual, depth, ZPixmap, NULL,
+                                        &head->shm_info,
+                                        head->area.width, head->area.height);
+        if (head->ximage == NULL)
+                return false;
+
+        if (head->ximage->bits_per_pixel != 32)
+                goto fail;
+
+        head->shm_info.shmid = shmget (IPC_PRIVATE,
+                                       head->ximage->bytes_per_line * head->ximage->height,
+                                       IPC_CREAT | 0600);
+        if (head->shm_info.shmid < 0)
+                goto fail;
+
+        head->shm_info.shmaddr = shmat (head->shm_info.shmid, NULL, 0);
+        if (head->shm_info.shmaddr == (char *) -1) {
+                shmctl (head->shm_info.shmid, IPC_RMID, NULL);
+                goto fail;
+        }
+        head->ximage->data = head->shm_info.shmaddr;
+        head->shm_info.readOnly = False;
+
+        /* Attaching fails asynchronously when the server can't see our
+         * memory, e.g. for a remote display
+         */
+        gdk_x11_display_error_trap_push (gdk_display_get_default ());
+        XShmAttach (backend->display, &head->shm_info);
+        XSync (backend->display, False);
+        error = gdk_x11_display_error_trap_pop (gdk_display_get_default ());
+
+        /* the segment goes away once both of us have detached */
+        shmctl (head->shm_info.shmid, IPC_RMID, NULL);
+
+        if (error != 0) {
+                ply_trace ("could not attach shared memory to X server: error %d", error);
+                shmdt (head->shm_info.shmaddr);
+                goto fail;
+        }
+
+        head->uses_shm = true;
+        return true;
+fail:
+        head->ximage->data = NULL;
+        XDestroyImage (head->ximage);
+        head->ximage = NULL;
+        return false;
+}
+
+static void
+create_image_for_head (ply_renderer_backend_t *backend,
+                       ply_renderer_head_t    *head)
+{
+        GdkWindow *window;
+        GdkVisual *visual;
+        Visual *xvisual;
+        int depth;
+
+        if (backend->flush_method == PLY_X11_FLUSH_METHOD_GTK)
+                return;
+
+        window = gtk_widget_get_window (head->window);
+        visual = gdk_window_get_visual (window);
+        xvisual = gdk_x11_visual_get_xvisual (visual);
+        depth = gdk_visual_get_depth (visual);
+
+        /* The shadow buffer is xrgb8888, so only a visual that takes it
+         * unconverted can skip gtk
+         */
+        if (depth != 24 ||
+            xvisual->red_mask != 0xff0000 ||
+            xvisual->green_mask != 0x00ff00 ||
+            xvisual->blue_mask != 0x0000ff) {
+                ply_trace ("window visual doesn't match the shadow buffer, flushing through gtk");
+                return;
+        }
+
+        head->xid = gdk_x11_window_get_xid (window);
+
+        if (backend->flush_method != PLY_X11_FLUSH_METHOD_XSHM ||
+            !create_shm_image (backend, head, xvisual, depth)) {
+                head->ximage = XCreateImage (backend->display, xvisual, depth, ZPixmap, 0,
+                                             (char *) ply_pixel_buffer_get_argb32_data (head->pixel_buffer),
+                                             head->area.width, head->area.height,
+                                             32, head->area.width * 4);
+                if (head->ximage == NULL) {
+                        ply_trace ("could not create X image, flushing through gtk");
+                        return;
+                }
+                head->ximage->byte_order = get_host_byte_order ();
+        }
+
+        head->gc = XCreateGC (backend->display, head->xid, 0, NULL);
+
+        ply_trace ("flushing %lux%lu head with %s",
+                   head->area.width, head->area.height,
+                   head->uses_shm ? "XShmPutImage" : "XPutImage");
+}
+
+static void
+destroy_image_for_head (ply_renderer_backend_t *backend,
+                        ply_renderer_head_t    *head)
+{
+        if (head->ximage == NULL)
+                return;
+
+        if (head->uses_shm) {
+                XShmDetach (backend->display, &head->shm_info);
+                XSync (backend->display, False);
+                shmdt (head->shm_info.shmaddr);
+                head->uses_shm = false;
+        }
+
+        /* the pixels belong to the shadow buffer or the segment, not xlib */
+        head->ximage->data = NULL;
+        XDestroyImage (head->ximage);
+        head->ximage = NULL;
+
+        XFreeGC (backend->display, head->gc);
+        head->gc = NULL;
+        head->xid = None;
+}
+
 static bool
 map_to_device (ply_renderer_backend_t *backend)
 {
@@ -372,12 +724,17 @@ map_to_device (ply_renderer_backend_t *backend)
                         g_signal_connect (head->window, "delete-event",
                                           G_CALLBACK (on_window_destroy),
                                           NULL);
+
+                        create_image_for_head (backend, head);
                 }
                 node = next_node;
         }
 
         backend->is_active = true;
 
+        /* gtk queues the new windows' work without waking anyone */
+        watch_main_context (backend);
+
         return true;
 }
 
@@ -396,6 +753,7 @@ unmap_from_device (ply_renderer_backend_t *backend)
                 head = (ply_renderer_head_t *) ply_list_node_get_data (node);
                 next_node = ply_list_get_next_node (backend->heads, node);
 
+                destroy_image_for_head (backend, head);
                 gtk_widget_destroy (head->window);
                 head->window = NULL;
                 ply_pixel_buffer_free (head->pixel_buffer);
@@ -405,6 +763,8 @@ unmap_from_device (ply_renderer_backend_t *backend)
 
                 node = next_node;
         }
+
+        watch_main_context (backend);
 }
 
 static void
@@ -419,14 +779,31 @@ deactivate (ply_renderer_backend_t *backend)
         backend->is_active = false;
 }
 
+static void
+copy_area_to_shm_image (ply_renderer_head_t *head,
+                        ply_rectangle_t     *area)
+{
+        uint32_t *shadow_buffer;
+        long y;
+
+        shadow_buffer = ply_pixel_buffer_get_argb32_data (head->pixel_buffer);
+
+        for (y = area->y; y < area->y + (long) area->height; y++) {
+                memcpy (head->ximage->data + y * head->ximage->bytes_per_line + area->x * 4,
+                        shadow_buffer + y * head->area.width + area->x,
+                        area->width * 4);
+        }
+}
+
 static void
 flush_head (ply_renderer_backend_t *backend,
             ply_renderer_head_t    *head)
 {
         ply_region_t *updated_region;
-        ply_list_t *areas_to_flush;
-        ply_list_node_t *node;
+        ply_rectangle_t *areas_to_flush;
+        size_t number_of_areas_to_flush, i;
         ply_pixel_buffer_t *pixel_buffer;
+        ply_rectangle_t head_area;
 
         assert (backend != NULL);
 
@@ -435,31 +812,62 @@ flush_head (ply_renderer_backend_t *backend,
 
         pixel_buffer = head->pixel_buffer;
         updated_region = ply_pixel_buffer_get_updated_areas (pixel_buffer);
-        areas_to_flush = ply_region_get_sorted_rectangle_list (updated_region);
-
-        node = ply_list_get_first_node (areas_to_flush);
-        while (node != NULL) {
-                ply_list_node_t *next_node;
-                ply_rectangle_t *area_to_flush;
+        areas_to_flush = ply_region_get_rectangles (updated_region, &number_of_areas_to_flush);
 
-                area_to_flush = (ply_rectangle_t *) ply_list_node_get_data (node);
-                next_node = ply_list_get_next_node (areas_to_flush, node);
+        head_area.x = 0;
+        head_area.y = 0;
+        head_area.width = head->area.width;
+        head_area.height = head->area.height;
 
-                cairo_surface_mark_dirty_rectangle (head->image,
-                                                    area_to_flush->x,
-                                                    area_to_flush->y,
-                                                    area_to_flush->width,
-                                                    area_to_flush->height);
+        for (i = 0; i < number_of_areas_to_flush; i++) {
+                ply_rectangle_t area_to_flush;
 
-                gtk_widget_queue_draw_area (head->window,
-                                            area_to_flush->x,
-                                            area_to_flush->y,
-                                            area_to_flush->width,
-                                            area_to_flush->height);
+                ply_rectangle_intersect (&areas_to_flush[i], &head_area, &area_to_flush);
+                if (ply_rectangle_is_empty (&area_to_flush))
+                        continue;
 
-                node = next_node;
+                /* keeps exposes, which still go through gtk, up to date */
+                cairo_surface_mark_dirty_rectangle (head->image,
+                                                    area_to_flush.x,
+                                                    area_to_flush.y,
+                                                    area_to_flush.width,
+                                                    area_to_flush.height);
+
+                if (head->ximage == NULL) {
+                        gtk_widget_queue_draw_area (head->window,
+                                                    area_to_flush.x,
+                                                    area_to_flush.y,
+                                                    area_to_flush.width,
+                                                    area_to_flush.height);
+                } else if (head->uses_shm) {
+                        copy_area_to_shm_image (head, &area_to_flush);
+                        XShmPutImage (backend->display, head->xid, head->gc, head->ximage,
+                                      area_to_flush.x, area_to_flush.y,
+                                      area_to_flush.x, area_to_flush.y,
+                                      area_to_flush.width, area_to_flush.height,
+                                      False);
+                } else {
+                        XPutImage (backend->display, head->xid, head->gc, head->ximage,
+                                   area_to_flush.x, area_to_flush.y,
+                                   area_to_flush.x, area_to_flush.y,
+                                   area_to_flush.width, area_to_flush.height);
+                }
         }
         ply_region_clear (updated_region);
+
+        if (number_of_areas_to_flush == 0)
+                return;
+
+        /* The server has to be done reading the segment before the next
+         * flush writes to it
+         */
+        if (head->uses_shm)
+                XSync (backend->display, False);
+        else if (head->ximage != NULL)
+                XFlush (backend->display);
+
+        /* gtk's redraws, and any events the sync read, don't wake anyone */
+        watch_main_context (backend);
 }
 
 static ply_list_t *
@@ -78,6 +78,19 @@ struct _ply_boot_splash_plugin
         ply_list_t                    *messages;
 
         ply_buffer_t                  *boot_buffer;
+
+        /* Where the last screenful of the boot buffer starts, kept
+         * around so views of the same size share the work. The buffer
+         * drops old output once it's full, so its size alone doesn't say
+         * whether the contents changed.
+         */
+        size_t                         boot_buffer_tail_offset;
+        int                            boot_buffer_tail_columns;
+        int                            boot_buffer_tail_rows;
+        size_t                         boot_buffer_tail_sgr_offset;
+        size_t                         boot_buffer_tail_sgr_size;
+
+        uint32_t                       boot_buffer_tail_is_valid : 1;
 };
 
 static view_t *
@@ -198,30 +211,92 @@ view_write (view_t     *view,
         ply_terminal_t *terminal;
 
         terminal = ply_text_display_get_terminal (view->display);
-        ply_terminal_write (terminal, "%.*s", (int) number_of_bytes, text);
+        ply_terminal_write_data (terminal, text, number_of_bytes);
 }
 
+static size_t
+get_boot_buffer_tail_offset (ply_boot_splash_plugin_t *plugin,
+                             view_t                   *view)
+{
+        const char *bytes;
+        size_t size;
+        int columns, rows;
+
+        columns = ply_text_display_get_number_of_columns (view->display);
+        rows = ply_text_display_get_number_of_rows (view->display);
+
+        if (columns <= 0 || rows <= 0) {
+                columns = 80;
+                rows = 24;
+        }
+
+        if (plugin->boot_buffer_tail_is_valid &&
+            columns == plugin->boot_buffer_tail_columns &&
+            rows == plugin->boot_buffer_tail_rows)
+                return plugin->boot_buffer_tail_offset;
+
+        size = ply_buffer_get_size (plugin->boot_buffer);
+        bytes = ply_buffer_get_bytes (plugin->boot_buffer);
+
+        plugin->boot_buffer_tail_offset = ply_utf8_string_get_offset_of_last_screenful (bytes, size, columns, rows);
+
+        /* If the cut lands part way through a line, the colors that line
+         * started with would be lost, so carry them over
+         */
+        if (!ply_utf8_string_find_last_sgr_sequence (bytes,
+                                                     plugin->boot_buffer_tail_offset,
+                                                     &plugin->boot_buffer_tail_sgr_offset,
+                                                     &plugin->boot_buffer_tail_sgr_size)) {
+                plugin->boot_buffer_tail_sgr_offset = 0;
+                plugin->boot_buffer_tail_sgr_size = 0;
+        }
+
+        plugin->boot_buffer_tail_columns = columns;
+        plugin->boot_buffer_tail_rows = rows;
+        plugin->boot_buffer_tail_is_valid = true;
+
+        return plugin->boot_buffer_tail_offset;
+}
+
+/* Anything that scrolled off before the splash started would just
+ * scroll off again, so only replay what fits on the screen
+ */
 static void
-view_write_boot_buffer (view_t *view)
+view_write_boot_buffer_tail (view_t *view)
 {
         ply_boot_splash_plugin_t *plugin;
-        ply_terminal_t *terminal;
+        const char *bytes;
+        size_t size, offset;
 
         plugin = view->plugin;
 
+        if (plugin->boot_buffer == NULL)
+                return;
+
+        size = ply_buffer_get_size (plugin->boot_buffer);
+        bytes = ply_buffer_get_bytes (plugin->boot_buffer);
+        offset = get_boot_buffer_tail_offset (plugin, view);
+
+        ply_text_display_hold_output (view->display);
+        if (plugin->boot_buffer_tail_sgr_size > 0)
+                view_write (view,
+                            bytes + plugin->boot_buffer_tail_sgr_offset,
+                            plugin->boot_buffer_tail_sgr_size);
+        view_write (view, bytes + offset, size - offset);
+        ply_text_display_release_output (view->display);
+}
+
+static void
+view_write_boot_buffer (view_t *view)
+{
+        ply_terminal_t *terminal;
+
         terminal = ply_text_display_get_terminal (view->display);
 
         ply_text_display_clear_screen (view->display);
         ply_terminal_activate_vt (terminal);
 
-        if (plugin->boot_buffer != NULL) {
-                size_t size;
-                const char *bytes;
-
-                size = ply_buffer_get_size (plugin->boot_buffer);
-                bytes = ply_buffer_get_bytes (plugin->boot_buffer);
-                view_write (view, bytes, size);
-        }
+        view_write_boot_buffer_tail (view);
 }
 
 static void
@@ -297,7 +372,7 @@ show_splash_screen (ply_boot_splash_plugin_t *plugin,
                     ply_buffer_t             *boot_buffer,
                     ply_boot_splash_mode_t    mode)
 {
-        size_t size;
+        ply_list_node_t *node;
 
         assert (plugin != NULL);
 
@@ -312,9 +387,11 @@ show_splash_screen (ply_boot_splash_plugin_t *plugin,
 
         if (boot_buffer) {
                 plugin->boot_buffer = boot_buffer;
+                plugin->boot_buffer_tail_is_valid = false;
 
-                size = ply_buffer_get_size (boot_buffer);
-                write_on_views (plugin, ply_buffer_get_bytes (boot_buffer), size);
+                ply_list_foreach (plugin->views, node) {
+                        view_write_boot_buffer_tail (ply_list_node_get_data (node));
+                }
         }
 
         return true;
@@ -336,6 +413,7 @@ on_boot_output (ply_boot_splash_plugin_t *plugin,
 {
         ply_trace ("writing '%s' to all views (%d bytes)",
                    output, (int) size);
+        plugin->boot_buffer_tail_is_valid = false;
         write_on_views (plugin, output, size);
 }
 
@@ -49,6 +49,7 @@
 #include "ply-key-file.h"
 #include "ply-pixel-buffer.h"
 #include "ply-pixel-display.h"
+#include "ply-scene.h"
 #include "ply-trigger.h"
 #include "ply-utils.h"
 #include "ply-console-viewer.h"
@@ -68,11 +69,12 @@ typedef enum
 
 typedef struct
 {
-        unsigned int x;
-        unsigned int y;
-        double       start_time;
-        double       speed;
-        double       opacity;
+        unsigned int       x;
+        unsigned int       y;
+        double             start_time;
+        double             speed;
+        double             opacity;
+        ply_scene_layer_t *layer;
 } star_t;
 
 typedef struct
@@ -84,7 +86,11 @@ typedef struct
         ply_label_t              *label;
         ply_label_t              *message_label;
         ply_rectangle_t           lock_area;
-        double                    logo_opacity;
+
+        ply_scene_t              *scene;
+        ply_pixel_buffer_t       *background_buffer;
+        ply_scene_layer_t        *background_layer;
+        ply_scene_layer_t        *logo_layer;
 
         ply_console_viewer_t     *console_viewer;
 } view_t;
@@ -338,6 +344,7 @@ view_new (ply_boot_splash_plugin_t *plugin,
 
         view->entry = ply_entry_new (plugin->image_dir);
         view->stars = ply_list_new ();
+        view->scene = ply_scene_new (display);
         view->label = ply_label_new ();
 
         view->message_label = ply_label_new ();
@@ -362,6 +369,9 @@ view_free (view_t *view)
         ply_label_free (view->message_label);
         free_stars (view);
 
+        ply_scene_free (view->scene);
+        ply_pixel_buffer_free (view->background_buffer);
+
         ply_console_viewer_free (view->console_viewer);
 
         ply_pixel_display_set_draw_handler (view->display, NULL, NULL);
@@ -372,10 +382,50 @@ view_free (view_t *view)
 static bool
 view_load (view_t *view)
 {
+        ply_boot_splash_plugin_t *plugin;
+        unsigned long screen_width, screen_height;
+        long logo_width, logo_height;
+        int screen_scale;
+
+        plugin = view->plugin;
+
         ply_trace ("loading entry");
         if (!ply_entry_load (view->entry))
                 return false;
 
+        screen_width = ply_pixel_display_get_width (view->display);
+        screen_height = ply_pixel_display_get_height (view->display);
+        screen_scale = ply_pixel_display_get_device_scale (view->display);
+
+        /* Render the gradient once, the scene copies it into damaged areas
+         * and skips it under opaque layers
+         */
+        if (view->background_buffer == NULL) {
+                view->background_buffer = ply_pixel_buffer_new (screen_width * screen_scale,
+                                                                 screen_height * screen_scale);
+                ply_pixel_buffer_set_device_scale (view->background_buffer, screen_scale);
+                ply_pixel_buffer_fill_with_gradient (view->background_buffer, NULL,
+                                                     PLYMOUTH_BACKGROUND_START_COLOR,
+                                                     PLYMOUTH_BACKGROUND_END_COLOR);
+                ply_pixel_buffer_set_opaque (view->background_buffer, true);
+
+                view->background_layer = ply_scene_add_layer (view->scene, 0);
+                ply_scene_layer_set_buffer (view->background_layer, view->background_buffer);
+        }
+
+        if (view->logo_layer == NULL) {
+                logo_width = ply_image_get_width (plugin->logo_image);
+                logo_height = ply_image_get_height (plugin->logo_image);
+
+                view->logo_layer = ply_scene_add_layer (view->scene, 2);
+                ply_scene_layer_set_buffer (view->logo_layer,
+                                            ply_image_get_buffer (plugin->logo_image));
+                ply_scene_layer_set_position (view->logo_layer,
+                                              (screen_width / 2) - (logo_width / 2),
+                                              (screen_height / 2) - (logo_height / 2));
+                ply_scene_layer_set_opacity (view->logo_layer, 0.0);
+        }
+
         return true;
 }
 
@@ -540,25 +590,9 @@ view_animate_at_time (view_t *view,
         ply_boot_splash_plugin_t *plugin;
         ply_list_node_t *node;
         double logo_opacity;
-        long logo_x, logo_y;
-        long logo_width, logo_height;
-        unsigned long screen_width, screen_height;
-        unsigned long star_width, star_height;
 
         plugin = view->plugin;
 
-        logo_width = ply_image_get_width (plugin->logo_image);
-        logo_height = ply_image_get_height (plugin->logo_image);
-
-        screen_width = ply_pixel_display_get_width (view->display);
-        screen_height = ply_pixel_display_get_height (view->display);
-
-        logo_x = (screen_width / 2) - (logo_width / 2);
-        logo_y = (screen_height / 2) - (logo_height / 2);
-
-        star_width = ply_image_get_width (plugin->star_image);
-        star_height = ply_image_get_height (plugin->star_image);
-
         node = ply_list_get_first_node (view->stars);
         while (node != NULL) {
                 ply_list_node_t *next_node;
@@ -570,9 +604,7 @@ view_animate_at_time (view_t *view,
                 star->opacity = .5 * sin (((plugin->now - star->start_time) / star->speed) * (2 * M_PI)) + .5;
                 star->opacity = CLAMP (star->opacity, 0, 1.0);
 
-                ply_pixel_display_draw_area (view->display,
-                                             star->x, star->y,
-                                             star_width, star_height);
+                ply_scene_layer_set_opacity (star->layer, star->opacity);
                 node = next_node;
         }
 
@@ -583,14 +615,11 @@ view_animate_at_time (view_t *view,
             plugin->mode == PLY_BOOT_SPLASH_MODE_REBOOT)
                 logo_opacity = 1.0;
 
-        if (fabs (logo_opacity - view->logo_opacity) <= DBL_MIN)
-                return;
-
-        view->logo_opacity = logo_opacity;
+        if (view->logo_layer != NULL)
+                ply_scene_layer_set_opacity (view->logo_layer, logo_opacity);
 
-        ply_pixel_display_draw_area (view->display,
-                                     logo_x, logo_y,
-                                     logo_width, logo_height);
+        /* Redraw only what the opacity changes above damaged */
+        ply_scene_update (view->scene);
 }
 
 static void
@@ -744,71 +773,17 @@ draw_background (view_t             *view,
 
         plugin = view->plugin;
 
-        ply_pixel_buffer_fill_with_gradient (pixel_buffer, &area,
-                                             PLYMOUTH_BACKGROUND_START_COLOR,
-                                             PLYMOUTH_BACKGROUND_END_COLOR);
+        if (view->background_buffer != NULL)
+                ply_pixel_buffer_fill_with_buffer (pixel_buffer, view->background_buffer, 0, 0);
+        else
+                ply_pixel_buffer_fill_with_gradient (pixel_buffer, &area,
+                                                     PLYMOUTH_BACKGROUND_START_COLOR,
+                                                     PLYMOUTH_BACKGROUND_END_COLOR);
 
         if (plugin->should_show_console_messages)
                 ply_pixel_buffer_fill_with_hex_color (pixel_buffer, &area, plugin->console_background_color);
 }
 
-static void
-draw_normal_view (view_t             *view,
-                  ply_pixel_buffer_t *pixel_buffer,
-                  int                 x,
-                  int                 y,
-                  int                 width,
-                  int                 height)
-{
-        ply_boot_splash_plugin_t *plugin;
-        ply_list_node_t *node;
-        ply_rectangle_t logo_area;
-        ply_rectangle_t star_area;
-        uint32_t *logo_data, *star_data;
-        unsigned long screen_width, screen_height;
-
-        plugin = view->plugin;
-
-        if (!plugin->is_animating)
-                return;
-
-        logo_area.width = ply_image_get_width (plugin->logo_image);
-        logo_area.height = ply_image_get_height (plugin->logo_image);
-        logo_data = ply_image_get_data (plugin->logo_image);
-
-        screen_width = ply_pixel_display_get_width (view->display);
-        screen_height = ply_pixel_display_get_height (view->display);
-
-        logo_area.x = (screen_width / 2) - (logo_area.width / 2);
-        logo_area.y = (screen_height / 2) - (logo_area.height / 2);
-
-        star_data = ply_image_get_data (plugin->star_image);
-        star_area.width = ply_image_get_width (plugin->star_image);
-        star_area.height = ply_image_get_height (plugin->star_image);
-
-        node = ply_list_get_first_node (view->stars);
-        while (node != NULL) {
-                ply_list_node_t *next_node;
-                star_t *star;
-
-                star = (star_t *) ply_list_node_get_data (node);
-                next_node = ply_list_get_next_node (view->stars, node);
-
-                star_area.x = star->x;
-                star_area.y = star->y;
-                ply_pixel_buffer_fill_with_argb32_data_at_opacity (pixel_buffer,
-                                                                   &star_area,
-                                                                   star_data,
-                                                                   star->opacity);
-                node = next_node;
-        }
-
-        ply_pixel_buffer_fill_with_argb32_data_at_opacity (pixel_buffer,
-                                                           &logo_area,
-                                                           logo_data,
-                                                           view->logo_opacity);
-}
-
 static void
 draw_prompt_view (view_t             *view,
                   ply_pixel_buffer_t *pixel_buffer,
@@ -847,12 +822,18 @@ on_draw (view_t             *view,
 
         plugin = view->plugin;
 
-        draw_background (view, pixel_buffer, x, y, width, height);
+        /* While animating, the scene composites the background, stars and
+         * logo layers in one pass
+         */
+        if (!plugin->should_show_console_messages &&
+            plugin->state == PLY_BOOT_SPLASH_DISPLAY_NORMAL &&
+            plugin->is_animating)
+                ply_scene_draw_area (view->scene, pixel_buffer, x, y, width, height);
+        else
+                draw_background (view, pixel_buffer, x, y, width, height);
 
         if (!plugin->should_show_console_messages) {
-                if (plugin->state == PLY_BOOT_SPLASH_DISPLAY_NORMAL)
-                        draw_normal_view (view, pixel_buffer, x, y, width, height);
-                else
+                if (plugin->state != PLY_BOOT_SPLASH_DISPLAY_NORMAL)
                         draw_prompt_view (view, pixel_buffer, x, y, width, height);
 
                 ply_label_draw_area (view->message_label,
@@ -1039,6 +1020,10 @@ view_add_star (view_t *view)
         } while (node != NULL);
 
         star = star_new (x, y, (double) ((ply_get_random_number (0, 50)) + 1));
+        star->layer = ply_scene_add_layer (view->scene, 1);
+        ply_scene_layer_set_buffer (star->layer, ply_image_get_buffer (plugin->star_image));
+        ply_scene_layer_set_position (star->layer, x, y);
+        ply_scene_layer_set_opacity (star->layer, 0.0);
         ply_list_append_data (view->stars, star);
 }
 
@@ -384,6 +384,14 @@ start_animation (ply_boot_splash_plugin_t *plugin)
 static void
 stop_script_animation (ply_boot_splash_plugin_t *plugin)
 {
+        script_obj_pool_statistics_t objects, variables;
+
+        script_obj_get_pool_statistics (&objects, &variables);
+        ply_trace ("script objects: %zu live, %zu pooled, %zu slabs allocated; "
+                   "variables: %zu live, %zu pooled, %zu slabs allocated",
+                   objects.live, objects.pooled, objects.allocations,
+                   variables.live, variables.pooled, variables.allocations);
+
         script_lib_plymouth_on_quit (plugin->script_state,
                                      plugin->script_plymouth_lib);
         script_lib_sprite_refresh (plugin->script_sprite_lib);
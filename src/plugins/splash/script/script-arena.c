@@ -0,0 +1,188 @@
+/* script-arena.c - bulk allocation for parsed scripts
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+#include <stdalign.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ply-hashtable.h"
+#include "ply-utils.h"
+
+#include "script-arena.h"
+
+#define SCRIPT_ARENA_MIN_BLOCK_SIZE 4096
+#define SCRIPT_ARENA_ALIGNMENT alignof (max_align_t)
+
+typedef struct _script_arena_block
+{
+        struct _script_arena_block *next;
+        size_t                      size;
+        size_t                      used;
+        alignas (max_align_t) char  data[];
+} script_arena_block_t;
+
+typedef struct _script_arena_cleanup
+{
+        struct _script_arena_cleanup  *next;
+        script_arena_cleanup_handler_t handler;
+        void                          *user_data;
+} script_arena_cleanup_t;
+
+struct _script_arena
+{
+        script_arena_block_t   *blocks;
+        script_arena_cleanup_t *cleanups;
+        ply_hashtable_t        *strings;
+
+        void                  **pending_pointers;
+        size_t                  number_of_pending_pointers;
+        size_t                  pending_pointers_size;
+};
+
+script_arena_t *
+script_arena_new (void)
+{
+        script_arena_t *arena = calloc (1, sizeof(script_arena_t));
+
+        arena->strings = ply_hashtable_new (ply_hashtable_string_hash,
+                                            ply_hashtable_string_compare);
+        return arena;
+}
+
+void
+script_arena_free (script_arena_t *arena)
+{
+        script_arena_block_t *block, *next_block;
+        script_arena_cleanup_t *cleanup;
+
+        if (arena == NULL)
+                return;
+
+        for (cleanup = arena->cleanups; cleanup != NULL; cleanup = cleanup->next) {
+                cleanup->handler (cleanup->user_data);
+        }
+
+        for (block = arena->blocks; block != NULL; block = next_block) {
+                next_block = block->next;
+                free (block);
+        }
+
+        ply_hashtable_free (arena->strings);
+        free (arena->pending_pointers);
+        free (arena);
+}
+
+void *
+script_arena_alloc (script_arena_t *arena,
+                    size_t          size)
+{
+        script_arena_block_t *block = arena->blocks;
+        void *memory;
+
+        size = (size + SCRIPT_ARENA_ALIGNMENT - 1) & ~(SCRIPT_ARENA_ALIGNMENT - 1);
+
+        if (block == NULL || block->size - block->used < size) {
+                size_t block_size = SCRIPT_ARENA_MIN_BLOCK_SIZE;
+
+                /* Grow with the script so big themes need few blocks */
+                if (block != NULL)
+                        block_size = block->size * 2;
+                block_size = MAX (block_size, size);
+
+                block = malloc (sizeof(script_arena_block_t) + block_size);
+                block->size = block_size;
+                block->used = 0;
+                block->next = arena->blocks;
+                arena->blocks = block;
+        }
+
+        memory = block->data + block->used;
+        block->used += size;
+
+        return memory;
+}
+
+void
+script_arena_add_cleanup (script_arena_t                *arena,
+                          script_arena_cleanup_handler_t handler,
+                          void                          *user_data)
+{
+        script_arena_cleanup_t *cleanup;
+
+        cleanup = script_arena_alloc (arena, sizeof(script_arena_cleanup_t));
+        cleanup->handler = handler;
+        cleanup->user_data = user_data;
+        cleanup->next = arena->cleanups;
+        arena->cleanups = cleanup;
+}
+
+char *
+script_arena_intern_string (script_arena_t *arena,
+                            const char     *string)
+{
+        char *interned_string;
+        size_t length;
+
+        interned_string = ply_hashtable_lookup (arena->strings, (void *) string);
+        if (interned_string != NULL)
+                return interned_string;
+
+        length = strlen (string);
+        interned_string = script_arena_alloc (arena, length + 1);
+        memcpy (interned_string, string, length + 1);
+        ply_hashtable_insert (arena->strings, interned_string, interned_string);
+
+        return interned_string;
+}
+
+size_t
+script_arena_start_array (script_arena_t *arena)
+{
+        return arena->number_of_pending_pointers;
+}
+
+void
+script_arena_append_to_array (script_arena_t *arena,
+                              void           *pointer)
+{
+        if (arena->number_of_pending_pointers == arena->pending_pointers_size) {
+                arena->pending_pointers_size = MAX (arena->pending_pointers_size * 2, 32);
+                arena->pending_pointers = realloc (arena->pending_pointers,
+                                                   arena->pending_pointers_size * sizeof(void *));
+        }
+
+        arena->pending_pointers[arena->number_of_pending_pointers++] = pointer;
+}
+
+void **
+script_arena_finish_array (script_arena_t *arena,
+                           size_t          start)
+{
+        size_t number_of_pointers = arena->number_of_pending_pointers - start;
+        void **array;
+
+        array = script_arena_alloc (arena, (number_of_pointers + 1) * sizeof(void *));
+        if (number_of_pointers > 0)
+                memcpy (array, arena->pending_pointers + start, number_of_pointers * sizeof(void *));
+        array[number_of_pointers] = NULL;
+
+        arena->number_of_pending_pointers = start;
+
+        return array;
+}
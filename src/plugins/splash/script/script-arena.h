@@ -0,0 +1,54 @@
+/* script-arena.h - bulk allocation for parsed scripts
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+#ifndef SCRIPT_ARENA_H
+#define SCRIPT_ARENA_H
+
+#include <stddef.h>
+
+/* Everything allocated from an arena lives until the arena is freed */
+typedef struct _script_arena script_arena_t;
+
+script_arena_t *script_arena_new (void);
+void script_arena_free (script_arena_t *arena);
+void *script_arena_alloc (script_arena_t *arena,
+                          size_t          size);
+
+/* Runs when the arena is freed, newest first, for anything the arena
+ * holds that wasn't allocated from it.
+ */
+typedef void (*script_arena_cleanup_handler_t) (void *user_data);
+void script_arena_add_cleanup (script_arena_t                *arena,
+                               script_arena_cleanup_handler_t handler,
+                               void                          *user_data);
+
+/* Returns the arena's single copy of the string */
+char *script_arena_intern_string (script_arena_t *arena,
+                                  const char     *string);
+
+/* Builds a NULL terminated pointer array in the arena. Arrays may be
+ * nested, as long as each is finished before its parent.
+ */
+size_t script_arena_start_array (script_arena_t *arena);
+void script_arena_append_to_array (script_arena_t *arena,
+                                   void           *pointer);
+void **script_arena_finish_array (script_arena_t *arena,
+                                  size_t          start);
+
+#endif /* SCRIPT_ARENA_H */
@@ -43,26 +43,24 @@
 
 static script_obj_t *script_evaluate (script_state_t *state,
                                       script_exp_t   *exp);
-static script_return_t script_execute_function_with_parlist (script_state_t    *state,
-                                                             script_function_t *function,
-                                                             script_obj_t      *this,
-                                                             ply_list_t        *parameter_data);
+static script_return_t script_execute_function_with_arguments (script_state_t    *state,
+                                                               script_function_t *function,
+                                                               script_obj_t      *this,
+                                                               script_obj_t     **arguments,
+                                                               int                number_of_arguments);
 
+/* Calls with more arguments than this allocate their argument array */
+#define SCRIPT_EXECUTE_STACK_ARGUMENTS 8
 
-static void script_execute_error (void       *element,
-                                  const char *message)
+
+static void script_execute_error (script_exp_t *exp,
+                                  const char   *message)
 {
-        script_debug_location_t *location = script_debug_lookup_element (element);
-
-        if (location) {
-                ply_error ("Execution error \"%s\" L:%d C:%d : %s\n",
-                           location->name,
-                           location->line_index,
-                           location->column_index,
-                           message);
-        } else {
-                ply_error ("Execution error: %s\n", message);
-        }
+        ply_error ("Execution error \"%s\" L:%d C:%d : %s\n",
+                   exp->location.name,
+                   exp->location.line_index,
+                   exp->location.column_index,
+                   message);
 }
 
 
@@ -80,6 +78,64 @@ static script_obj_t *script_evaluate_apply_function (script_state_t *state,
         return obj;
 }
 
+/* A number nothing else can see, so its value can be overwritten */
+static bool script_obj_is_temporary_number (script_obj_t *obj)
+{
+        return obj->type == SCRIPT_OBJ_TYPE_NUMBER && obj->refcount == 1 && !obj->immutable;
+}
+
+static script_obj_t *script_evaluate_arithmetic (script_state_t *state,
+                                                 script_exp_t   *exp,
+                                                 script_obj_t *(*function)(script_obj_t *,
+                                                                           script_obj_t *))
+{
+        script_obj_t *script_obj_a = script_evaluate (state, exp->data.dual.sub_a);
+        script_obj_t *script_obj_b = script_evaluate (state, exp->data.dual.sub_b);
+        script_obj_t *obj;
+
+        /* Chained arithmetic reuses the intermediate results */
+        if (script_obj_is_number (script_obj_a) && script_obj_is_number (script_obj_b)) {
+                if (script_obj_is_temporary_number (script_obj_a))
+                        obj = script_obj_a;
+                else if (script_obj_is_temporary_number (script_obj_b))
+                        obj = script_obj_b;
+                else
+                        obj = NULL;
+
+                if (obj) {
+                        script_number_t number_a = script_obj_as_number (script_obj_a);
+                        script_number_t number_b = script_obj_as_number (script_obj_b);
+
+                        switch (exp->type) {
+                        case SCRIPT_EXP_TYPE_PLUS:
+                                obj->data.number = number_a + number_b;
+                                break;
+                        case SCRIPT_EXP_TYPE_MINUS:
+                                obj->data.number = number_a - number_b;
+                                break;
+                        case SCRIPT_EXP_TYPE_MUL:
+                                obj->data.number = number_a * number_b;
+                                break;
+                        case SCRIPT_EXP_TYPE_DIV:
+                                obj->data.number = number_a / number_b;
+                                break;
+                        default:
+                                obj->data.number = fmodl (number_a, number_b);
+                                break;
+                        }
+                        script_obj_ref (obj);
+                        script_obj_unref (script_obj_a);
+                        script_obj_unref (script_obj_b);
+                        return obj;
+                }
+        }
+
+        obj = function (script_obj_a, script_obj_b);
+        script_obj_unref (script_obj_a);
+        script_obj_unref (script_obj_b);
+        return obj;
+}
+
 static script_obj_t *script_evaluate_apply_function_and_assign (script_state_t *state,
                                                                 script_exp_t   *exp,
                                                                 script_obj_t *(*function)(script_obj_t *,
@@ -135,22 +191,18 @@ static script_obj_t *script_evaluate_var (script_state_t *state,
 static script_obj_t *script_evaluate_set (script_state_t *state,
                                           script_exp_t   *exp)
 {
-        ply_list_t *parameter_data = exp->data.parameters;
-        ply_list_node_t *node_data = ply_list_get_first_node (parameter_data);
+        script_exp_t **data_exp;
         int index = 0;
         script_obj_t *obj = script_obj_new_hash ();
 
-        while (node_data) {
-                script_exp_t *data_exp = ply_list_node_get_data (node_data);
-                script_obj_t *data_obj = script_evaluate (state, data_exp);
+        for (data_exp = exp->data.parameters; *data_exp; data_exp++) {
+                script_obj_t *data_obj = script_evaluate (state, *data_exp);
                 char *name;
                 asprintf (&name, "%d", index);
                 index++;
                 script_obj_hash_add_element (obj, data_obj, name);
                 script_obj_unref (data_obj);
                 free (name);
-
-                node_data = ply_list_get_next_node (parameter_data, node_data);
         }
         return obj;
 }
@@ -178,9 +230,7 @@ static script_obj_t *script_evaluate_cmp (script_state_t         *state,
         script_obj_unref (script_obj_a);
         script_obj_unref (script_obj_b);
 
-        if (cmp_result & condition)
-                return script_obj_new_number (1);
-        return script_obj_new_number (0);
+        return script_obj_new_shared_bool (cmp_result & condition);
 }
 
 static script_obj_t *script_evaluate_logic (script_state_t *state,
@@ -204,13 +254,17 @@ static script_obj_t *script_evaluate_unary (script_state_t *state,
         script_obj_t *new_obj;
 
         if (exp->type == SCRIPT_EXP_TYPE_NOT) {
-                new_obj = script_obj_new_number (!script_obj_as_bool (obj));
+                new_obj = script_obj_new_shared_bool (!script_obj_as_bool (obj));
                 script_obj_unref (obj);
                 return new_obj;
         }
         if (exp->type == SCRIPT_EXP_TYPE_POS) /* FIXME what should happen on non number operands? */
-                return obj;                   /* Does nothing, maybe just remove at parse stage */
+                return obj;                   /* Does nothing, the parser drops it */
         if (exp->type == SCRIPT_EXP_TYPE_NEG) {
+                if (script_obj_is_temporary_number (obj)) {
+                        obj->data.number = -obj->data.number;
+                        return obj;
+                }
                 if (script_obj_is_number (obj)) {
                         new_obj = script_obj_new_number (-script_obj_as_number (obj));
                 } else {
@@ -253,7 +307,8 @@ typedef struct
 {
         script_state_t *state;
         script_obj_t   *this;
-        ply_list_t     *parameter_data;
+        script_obj_t  **arguments;
+        int             number_of_arguments;
 } script_obj_execute_data_t;
 
 static void *script_obj_execute (script_obj_t *obj,
@@ -263,26 +318,29 @@ static void *script_obj_execute (script_obj_t *obj,
 
         if (obj->type == SCRIPT_OBJ_TYPE_FUNCTION) {
                 script_function_t *function = obj->data.function;
-                script_return_t reply = script_execute_function_with_parlist (execute_data->state,
-                                                                              function,
-                                                                              execute_data->this,
-                                                                              execute_data->parameter_data);
+                script_return_t reply = script_execute_function_with_arguments (execute_data->state,
+                                                                                function,
+                                                                                execute_data->this,
+                                                                                execute_data->arguments,
+                                                                                execute_data->number_of_arguments);
                 if (reply.type != SCRIPT_RETURN_TYPE_FAIL)
                         return reply.object ? reply.object : script_obj_new_null ();
         }
         return NULL;
 }
 
-static script_return_t script_execute_object_with_parlist (script_state_t *state,
-                                                           script_obj_t   *obj,
-                                                           script_obj_t   *this,
-                                                           ply_list_t     *parameter_data)
+static script_return_t script_execute_object_with_arguments (script_state_t *state,
+                                                             script_obj_t   *obj,
+                                                             script_obj_t   *this,
+                                                             script_obj_t  **arguments,
+                                                             int             number_of_arguments)
 {
         script_obj_execute_data_t execute_data;
 
         execute_data.state = state;
         execute_data.this = this;
-        execute_data.parameter_data = parameter_data;
+        execute_data.arguments = arguments;
+        execute_data.number_of_arguments = number_of_arguments;
 
         obj = script_obj_as_custom (obj, script_obj_execute, &execute_data);
 
@@ -331,29 +389,29 @@ static script_obj_t *script_evaluate_func (script_state_t *state,
                 func_obj = script_evaluate (state, name_exp);
         }
 
-        ply_list_t *parameter_expressions = exp->data.function_exe.parameters;
-        ply_list_t *parameter_data = ply_list_new ();
+        script_exp_t **parameter_expressions = exp->data.function_exe.parameters;
+        script_obj_t *stack_arguments[SCRIPT_EXECUTE_STACK_ARGUMENTS];
+        script_obj_t **arguments = stack_arguments;
+        int number_of_arguments = 0;
+        int index;
 
-        ply_list_node_t *node_expression = ply_list_get_first_node (parameter_expressions);
+        while (parameter_expressions[number_of_arguments])
+                number_of_arguments++;
+        if (number_of_arguments > SCRIPT_EXECUTE_STACK_ARGUMENTS)
+                arguments = malloc (number_of_arguments * sizeof(script_obj_t *));
 
-        while (node_expression) {
-                script_exp_t *data_exp = ply_list_node_get_data (node_expression);
-                script_obj_t *data_obj = script_evaluate (state, data_exp);
-                ply_list_append_data (parameter_data, data_obj);
-                node_expression = ply_list_get_next_node (parameter_expressions,
-                                                          node_expression);
+        for (index = 0; index < number_of_arguments; index++) {
+                arguments[index] = script_evaluate (state, parameter_expressions[index]);
         }
 
-        script_return_t reply = script_execute_object_with_parlist (state, func_obj, this_obj, parameter_data);
+        script_return_t reply = script_execute_object_with_arguments (state, func_obj, this_obj,
+                                                                      arguments, number_of_arguments);
 
-        ply_list_node_t *node_data = ply_list_get_first_node (parameter_data);
-
-        while (node_data) {
-                script_obj_t *data_obj = ply_list_node_get_data (node_data);
-                script_obj_unref (data_obj);
-                node_data = ply_list_get_next_node (parameter_data, node_data);
+        for (index = 0; index < number_of_arguments; index++) {
+                script_obj_unref (arguments[index]);
         }
-        ply_list_free (parameter_data);
+        if (arguments != stack_arguments)
+                free (arguments);
 
         script_obj_unref (func_obj);
         if (this_obj) script_obj_unref (this_obj);
@@ -367,24 +425,24 @@ static script_obj_t *script_evaluate (script_state_t *state,
         switch (exp->type) {
         case SCRIPT_EXP_TYPE_PLUS:
         {
-                return script_evaluate_apply_function (state, exp, script_obj_plus);
+                return script_evaluate_arithmetic (state, exp, script_obj_plus);
         }
         case SCRIPT_EXP_TYPE_MINUS:
         {
-                return script_evaluate_apply_function (state, exp, script_obj_minus);
+                return script_evaluate_arithmetic (state, exp, script_obj_minus);
         }
 
         case SCRIPT_EXP_TYPE_MUL:
         {
-                return script_evaluate_apply_function (state, exp, script_obj_mul);
+                return script_evaluate_arithmetic (state, exp, script_obj_mul);
         }
         case SCRIPT_EXP_TYPE_DIV:
         {
-                return script_evaluate_apply_function (state, exp, script_obj_div);
+                return script_evaluate_arithmetic (state, exp, script_obj_div);
         }
         case SCRIPT_EXP_TYPE_MOD:
         {
-                return script_evaluate_apply_function (state, exp, script_obj_mod);
+                return script_evaluate_arithmetic (state, exp, script_obj_mod);
         }
 
         case SCRIPT_EXP_TYPE_EQ:
@@ -439,18 +497,15 @@ static script_obj_t *script_evaluate (script_state_t *state,
         }
 
         case SCRIPT_EXP_TYPE_TERM_NUMBER:
-        {
-                return script_obj_new_number (exp->data.number);
-        }
-
         case SCRIPT_EXP_TYPE_TERM_STRING:
         {
-                return script_obj_new_string (exp->data.string);
+                script_obj_ref (exp->data.literal);
+                return exp->data.literal;
         }
 
         case SCRIPT_EXP_TYPE_TERM_NULL:
         {
-                return script_obj_new_null ();
+                return script_obj_new_shared_null ();
         }
 
         case SCRIPT_EXP_TYPE_TERM_LOCAL:
@@ -546,17 +601,14 @@ static script_obj_t *script_evaluate (script_state_t *state,
 }
 
 static script_return_t script_execute_list (script_state_t *state,
-                                            ply_list_t     *op_list)                      /* FIXME script_execute returns the return obj */
+                                            script_op_t   **op_list)                      /* FIXME script_execute returns the return obj */
 {
         script_return_t reply = script_return_normal ();
-        ply_list_node_t *node = ply_list_get_first_node (op_list);
+        script_op_t **op;
 
-        for (node = ply_list_get_first_node (op_list);
-             node;
-             node = ply_list_get_next_node (op_list, node)) {
-                script_op_t *op = ply_list_node_get_data (node);
+        for (op = op_list; *op; op++) {
                 script_obj_unref (reply.object);
-                reply = script_execute (state, op);
+                reply = script_execute (state, *op);
                 switch (reply.type) {
                 case SCRIPT_RETURN_TYPE_NORMAL:
                         break;
@@ -570,62 +622,102 @@ static script_return_t script_execute_list (script_state_t *state,
         return reply;
 }
 
-/* parameter_data list should be freed by caller */
-static script_return_t script_execute_function_with_parlist (script_state_t    *state,
-                                                             script_function_t *function,
-                                                             script_obj_t      *this,
-                                                             ply_list_t        *parameter_data)
+static script_obj_t *script_execute_new_args (script_obj_t **arguments,
+                                              int            number_of_arguments)
 {
-        script_state_t *sub_state = script_state_init_sub (state, this);
-        ply_list_t *parameter_names = function->parameters;
-        ply_list_node_t *node_name = ply_list_get_first_node (parameter_names);
-        ply_list_node_t *node_data = ply_list_get_first_node (parameter_data);
-        int index = 0;
-        script_obj_t *arg_obj = script_obj_new_hash ();
+        script_obj_t *args_obj = script_obj_new_hash ();
+        script_obj_t *count_obj = script_obj_new_number (number_of_arguments);
+        char name[16];
+        int index;
 
-        while (node_data) {
-                script_obj_t *data_obj = ply_list_node_get_data (node_data);
-                char *name;
-                asprintf (&name, "%d", index);
-                index++;
-                script_obj_hash_add_element (arg_obj, data_obj, name);
-                free (name);
-
-                if (node_name) {
-                        name = ply_list_node_get_data (node_name);
-                        script_obj_hash_add_element (sub_state->local, data_obj, name);
-                        node_name = ply_list_get_next_node (parameter_names, node_name);
-                }
-                node_data = ply_list_get_next_node (parameter_data, node_data);
+        for (index = 0; index < number_of_arguments; index++) {
+                snprintf (name, sizeof(name), "%d", index);
+                script_obj_hash_add_element (args_obj, arguments[index], name);
         }
+        script_obj_hash_add_element (args_obj, count_obj, "count");
+        script_obj_unref (count_obj);
+        return args_obj;
+}
 
-        script_obj_t *count_obj = script_obj_new_number (index);
+static script_return_t script_execute_script_function (script_state_t    *state,
+                                                       script_function_t *function,
+                                                       script_obj_t      *this,
+                                                       script_obj_t     **arguments,
+                                                       int                number_of_arguments)
+{
+        script_state_t *sub_state = script_state_init_sub (state, this);
+        char **parameter_name = function->parameters;
+        script_return_t reply;
+        int index;
 
-        script_obj_hash_add_element (arg_obj, count_obj, "count");
-        script_obj_hash_add_element (sub_state->local, arg_obj, "_args");
-        script_obj_unref (count_obj);
-        script_obj_unref (arg_obj);
+        for (index = 0; index < number_of_arguments && *parameter_name; index++, parameter_name++) {
+                script_obj_hash_add_element (sub_state->local, arguments[index], *parameter_name);
+        }
+
+        /* Only built for functions the parser saw mention it */
+        if (function->uses_args) {
+                script_obj_t *args_obj = script_execute_new_args (arguments, number_of_arguments);
+                script_obj_hash_add_element (sub_state->local, args_obj, "_args");
+                script_obj_unref (args_obj);
+        }
 
         if (this)
                 script_obj_hash_add_element (sub_state->local, this, "this");
 
+        reply = script_execute (sub_state, function->data.script);
+        script_state_destroy (sub_state);
+        return reply;
+}
+
+/* Natives read their arguments straight from the caller's array, so the
+ * frame needs no local hash and can live on the stack.
+ */
+static script_return_t script_execute_native_function (script_state_t    *state,
+                                                       script_function_t *function,
+                                                       script_obj_t      *this,
+                                                       script_obj_t     **arguments,
+                                                       int                number_of_arguments)
+{
+        script_state_t frame;
+        script_return_t reply;
+
+        frame.user_data = state->user_data;
+        frame.global = state->global;
+        frame.local = script_obj_new_shared_null ();
+        frame.this = this ? this : state->this;
+        frame.function = function;
+        frame.arguments = arguments;
+        frame.number_of_arguments = number_of_arguments;
+
+        reply = function->data.native (&frame, function->user_data);
+
+        script_obj_unref (frame.local);
+        return reply;
+}
+
+static script_return_t script_execute_function_with_arguments (script_state_t    *state,
+                                                               script_function_t *function,
+                                                               script_obj_t      *this,
+                                                               script_obj_t     **arguments,
+                                                               int                number_of_arguments)
+{
         script_return_t reply;
 
         switch (function->type) {
         case SCRIPT_FUNCTION_TYPE_SCRIPT:
         {
-                script_op_t *op = function->data.script;
-                reply = script_execute (sub_state, op);
+                reply = script_execute_script_function (state, function, this,
+                                                        arguments, number_of_arguments);
                 break;
         }
 
         case SCRIPT_FUNCTION_TYPE_NATIVE:
         {
-                reply = function->data.native (sub_state, function->user_data);
+                reply = script_execute_native_function (state, function, this,
+                                                        arguments, number_of_arguments);
                 break;
         }
         }
-        script_state_destroy (sub_state);
         if (reply.type != SCRIPT_RETURN_TYPE_FAIL)
                 reply.type = SCRIPT_RETURN_TYPE_RETURN;
         return reply;
@@ -637,21 +729,23 @@ script_return_t script_execute_object (script_state_t *state,
                                        script_obj_t   *first_arg,
                                        ...)
 {
+        script_obj_t *arguments[SCRIPT_EXECUTE_STACK_ARGUMENTS];
+        int number_of_arguments = 0;
         script_return_t reply;
         va_list args;
         script_obj_t *arg;
-        ply_list_t *parameter_data = ply_list_new ();
 
         arg = first_arg;
         va_start (args, first_arg);
         while (arg) {
-                ply_list_append_data (parameter_data, arg);
+                assert (number_of_arguments < SCRIPT_EXECUTE_STACK_ARGUMENTS);
+                arguments[number_of_arguments++] = arg;
                 arg = va_arg (args, script_obj_t *);
         }
         va_end (args);
 
-        reply = script_execute_object_with_parlist (state, function, this, parameter_data);
-        ply_list_free (parameter_data);
+        reply = script_execute_object_with_arguments (state, function, this,
+                                                      arguments, number_of_arguments);
 
         return reply;
 }
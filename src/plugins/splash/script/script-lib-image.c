@@ -39,10 +39,148 @@
 
 #include "script-lib-image.script.h"
 
+/* Scaled and rotated images are kept around since themes tend to redo
+ * the same few transforms on every frame
+ */
+#define IMAGE_CACHE_MAX_ENTRIES 32
+#define IMAGE_CACHE_MAX_PIXELS (8 * 1024 * 1024)
+
+typedef enum
+{
+        IMAGE_OPERATION_SCALE,
+        IMAGE_OPERATION_ROTATE,
+} image_operation_t;
+
+typedef struct
+{
+        ply_pixel_buffer_t *source;
+        image_operation_t   operation;
+        double              parameters[2];
+        script_obj_t       *result;
+        unsigned long       pixels;
+} image_cache_entry_t;
+
+static void
+image_cache_entry_free (script_lib_image_data_t *data,
+                        image_cache_entry_t     *entry)
+{
+        data->cache_pixels -= entry->pixels;
+        script_obj_unref (entry->result);
+        free (entry);
+}
+
+static void
+image_cache_forget_source (script_lib_image_data_t *data,
+                           ply_pixel_buffer_t      *source)
+{
+        ply_list_node_t *node;
+
+        /* Freeing a result can drop entries derived from it in turn, so
+         * start over after each removal
+         */
+        node = ply_list_get_first_node (data->cache);
+        while (node != NULL) {
+                image_cache_entry_t *entry = ply_list_node_get_data (node);
+
+                if (entry->source != source) {
+                        node = ply_list_get_next_node (data->cache, node);
+                        continue;
+                }
+
+                ply_list_remove_node (data->cache, node);
+                image_cache_entry_free (data, entry);
+                node = ply_list_get_first_node (data->cache);
+        }
+}
+
+static script_obj_t *
+image_cache_lookup (script_lib_image_data_t *data,
+                    ply_pixel_buffer_t      *source,
+                    image_operation_t        operation,
+                    double                   parameter_a,
+                    double                   parameter_b)
+{
+        ply_list_node_t *node;
+
+        ply_list_foreach (data->cache, node) {
+                image_cache_entry_t *entry = ply_list_node_get_data (node);
+
+                if (entry->source != source ||
+                    entry->operation != operation ||
+                    entry->parameters[0] != parameter_a ||
+                    entry->parameters[1] != parameter_b)
+                        continue;
+
+                /* Most recently used entries live at the front */
+                if (node != ply_list_get_first_node (data->cache)) {
+                        ply_list_remove_node (data->cache, node);
+                        ply_list_prepend_data (data->cache, entry);
+                }
+
+                data->cache_hits++;
+                return script_obj_new_ref (entry->result);
+        }
+
+        data->cache_misses++;
+        return NULL;
+}
+
+/* Takes over the result and returns what to hand to the script. Scripts
+ * only ever get a reference to a cached image, so assigning to what
+ * they got (e.g. "image._Scale (10, 10).foo = 1") can't change the image
+ * later lookups return.
+ */
+static script_obj_t *
+image_cache_add (script_lib_image_data_t *data,
+                 ply_pixel_buffer_t      *source,
+                 image_operation_t        operation,
+                 double                   parameter_a,
+                 double                   parameter_b,
+                 script_obj_t            *result)
+{
+        image_cache_entry_t *entry;
+        ply_pixel_buffer_t *image;
+        ply_list_node_t *node;
+        unsigned long pixels;
+
+        image = script_obj_as_native_of_class (result, data->class);
+        if (image == NULL)
+                return result;
+
+        pixels = ply_pixel_buffer_get_width (image) * ply_pixel_buffer_get_height (image);
+        if (pixels > IMAGE_CACHE_MAX_PIXELS)
+                return result;
+
+        while (ply_list_get_length (data->cache) >= IMAGE_CACHE_MAX_ENTRIES ||
+               data->cache_pixels + pixels > IMAGE_CACHE_MAX_PIXELS) {
+                node = ply_list_get_last_node (data->cache);
+                entry = ply_list_node_get_data (node);
+                ply_list_remove_node (data->cache, node);
+                image_cache_entry_free (data, entry);
+        }
+
+        entry = calloc (1, sizeof(image_cache_entry_t));
+        entry->source = source;
+        entry->operation = operation;
+        entry->parameters[0] = parameter_a;
+        entry->parameters[1] = parameter_b;
+        entry->result = result;
+        entry->pixels = pixels;
+
+        data->cache_pixels += pixels;
+        ply_list_prepend_data (data->cache, entry);
+
+        return script_obj_new_ref (result);
+}
+
 static void image_free (script_obj_t *obj)
 {
+        script_lib_image_data_t *data = obj->data.native.class->user_data;
         ply_pixel_buffer_t *image = obj->data.native.object_data;
 
+        if (data->cache != NULL)
+                image_cache_forget_source (data, image);
+
         ply_pixel_buffer_free (image);
 }
 
@@ -52,7 +190,7 @@ static script_return_t image_new (script_state_t *state,
         script_lib_image_data_t *data = user_data;
         script_obj_t *reply;
         char *path_filename;
-        char *filename = script_obj_hash_get_string (state->local, "filename");
+        char *filename = script_state_get_argument_string (state, "filename");
         char *test_string = filename;
         const char *prefix_string = "special://";
 
@@ -117,16 +255,23 @@ static script_return_t image_rotate (script_state_t *state,
 {
         script_lib_image_data_t *data = user_data;
         ply_pixel_buffer_t *image = script_obj_as_native_of_class (state->this, data->class);
-        float angle = script_obj_hash_get_number (state->local, "angle");
+        float angle = script_state_get_argument_number (state, "angle");
         ply_rectangle_t size;
+        script_obj_t *reply;
 
         if (image) {
+                reply = image_cache_lookup (data, image, IMAGE_OPERATION_ROTATE, angle, 0);
+                if (reply != NULL)
+                        return script_return_obj (reply);
+
                 ply_pixel_buffer_get_size (image, &size);
                 ply_pixel_buffer_t *new_image = ply_pixel_buffer_rotate (image,
                                                                          size.width / 2,
                                                                          size.height / 2,
                                                                          angle);
-                return script_return_obj (script_obj_new_native (new_image, data->class));
+                reply = script_obj_new_native (new_image, data->class);
+                reply = image_cache_add (data, image, IMAGE_OPERATION_ROTATE, angle, 0, reply);
+                return script_return_obj (reply);
         }
         return script_return_obj_null ();
 }
@@ -136,10 +281,10 @@ static script_return_t image_crop (script_state_t *state,
 {
         script_lib_image_data_t *data = user_data;
         ply_pixel_buffer_t *image = script_obj_as_native_of_class (state->this, data->class);
-        int x = script_obj_hash_get_number (state->local, "x");
-        int y = script_obj_hash_get_number (state->local, "y");
-        int width = script_obj_hash_get_number (state->local, "width");
-        int height = script_obj_hash_get_number (state->local, "height");
+        int x = script_state_get_argument_number (state, "x");
+        int y = script_state_get_argument_number (state, "y");
+        int width = script_state_get_argument_number (state, "width");
+        int height = script_state_get_argument_number (state, "height");
 
         if (image) {
                 ply_rectangle_t clip_area = { 0, 0, width, height };
@@ -155,12 +300,20 @@ static script_return_t image_scale (script_state_t *state,
 {
         script_lib_image_data_t *data = user_data;
         ply_pixel_buffer_t *image = script_obj_as_native_of_class (state->this, data->class);
-        int width = script_obj_hash_get_number (state->local, "width");
-        int height = script_obj_hash_get_number (state->local, "height");
+        int width = script_state_get_argument_number (state, "width");
+        int height = script_state_get_argument_number (state, "height");
+
+        script_obj_t *reply;
 
         if (image) {
+                reply = image_cache_lookup (data, image, IMAGE_OPERATION_SCALE, width, height);
+                if (reply != NULL)
+                        return script_return_obj (reply);
+
                 ply_pixel_buffer_t *new_image = ply_pixel_buffer_resize (image, width, height);
-                return script_return_obj (script_obj_new_native (new_image, data->class));
+                reply = script_obj_new_native (new_image, data->class);
+                reply = image_cache_add (data, image, IMAGE_OPERATION_SCALE, width, height, reply);
+                return script_return_obj (reply);
         }
         return script_return_obj_null ();
 }
@@ -170,8 +323,8 @@ static script_return_t image_tile (script_state_t *state,
 {
         script_lib_image_data_t *data = user_data;
         ply_pixel_buffer_t *image = script_obj_as_native_of_class (state->this, data->class);
-        int width = script_obj_hash_get_number (state->local, "width");
-        int height = script_obj_hash_get_number (state->local, "height");
+        int width = script_state_get_argument_number (state, "width");
+        int height = script_state_get_argument_number (state, "height");
 
         if (image) {
                 ply_pixel_buffer_t *new_image = ply_pixel_buffer_tile (image, width, height);
@@ -191,14 +344,14 @@ static script_return_t image_text (script_state_t *state,
         int align = PLY_LABEL_ALIGN_LEFT;
         char *font;
 
-        char *text = script_obj_hash_get_string (state->local, "text");
+        char *text = script_state_get_argument_string (state, "text");
 
         float alpha;
-        float red = CLAMP (script_obj_hash_get_number (state->local, "red"), 0, 1);
-        float green = CLAMP (script_obj_hash_get_number (state->local, "green"), 0, 1);
-        float blue = CLAMP (script_obj_hash_get_number (state->local, "blue"), 0, 1);
+        float red = CLAMP (script_state_get_argument_number (state, "red"), 0, 1);
+        float green = CLAMP (script_state_get_argument_number (state, "green"), 0, 1);
+        float blue = CLAMP (script_state_get_argument_number (state, "blue"), 0, 1);
 
-        alpha_obj = script_obj_hash_peek_element (state->local, "alpha");
+        alpha_obj = script_state_peek_argument (state, "alpha");
 
         if (script_obj_is_number (alpha_obj))
                 alpha = CLAMP (script_obj_as_number (alpha_obj), 0, 1);
@@ -206,7 +359,7 @@ static script_return_t image_text (script_state_t *state,
                 alpha = 1;
         script_obj_unref (alpha_obj);
 
-        font_obj = script_obj_hash_peek_element (state->local, "font");
+        font_obj = script_state_peek_argument (state, "font");
 
         if (script_obj_is_string (font_obj))
                 font = script_obj_as_string (font_obj);
@@ -215,7 +368,7 @@ static script_return_t image_text (script_state_t *state,
 
         script_obj_unref (font_obj);
 
-        align_obj = script_obj_hash_peek_element (state->local, "align");
+        align_obj = script_state_peek_argument (state, "align");
 
         if (script_obj_is_string (align_obj)) {
                 char *align_str = script_obj_as_string (align_obj);
@@ -267,6 +420,10 @@ script_lib_image_data_t *script_lib_image_setup (script_state_t *state,
 
         data->class = script_obj_native_class_new (image_free, "image", data);
         data->image_dir = strdup (image_dir);
+        data->cache = ply_list_new ();
+        data->cache_pixels = 0;
+        data->cache_hits = 0;
+        data->cache_misses = 0;
 
         script_obj_t *image_hash = script_obj_hash_get_element (state->global, "Image");
 
@@ -338,6 +495,20 @@ script_lib_image_data_t *script_lib_image_setup (script_state_t *state,
 
 void script_lib_image_destroy (script_lib_image_data_t *data)
 {
+        ply_list_t *cache;
+        ply_list_node_t *node;
+
+        ply_trace ("image transform cache: %lu hits, %lu misses",
+                   data->cache_hits, data->cache_misses);
+
+        /* Detach the cache first, dropping results may free other images */
+        cache = data->cache;
+        data->cache = NULL;
+        ply_list_foreach (cache, node) {
+                image_cache_entry_free (data, ply_list_node_get_data (node));
+        }
+        ply_list_free (cache);
+
         script_obj_native_class_destroy (data->class);
         free (data->image_dir);
         script_parse_op_free (data->script_main_op);
@@ -41,7 +41,7 @@ static script_return_t script_lib_math_double_from_double_function (script_state
                                                                     void           *user_data)
 {
         double (*function)(double) = user_data;
-        double value = script_obj_hash_get_number (state->local, "value");
+        double value = script_state_get_argument_number (state, "value");
         double reply_double = function (value);
         return script_return_obj (script_obj_new_number (reply_double));
 }
@@ -51,8 +51,8 @@ static script_return_t script_lib_math_double_from_double_double_function (scrip
 {
         double (*function)(double,
                            double) = user_data;
-        double value1 = script_obj_hash_get_number (state->local, "value_a");
-        double value2 = script_obj_hash_get_number (state->local, "value_b");
+        double value1 = script_state_get_argument_number (state, "value_a");
+        double value2 = script_state_get_argument_number (state, "value_b");
         double reply_double = function (value1, value2);
         return script_return_obj (script_obj_new_number (reply_double));
 }
@@ -40,7 +40,7 @@ static script_return_t plymouth_set_function (script_state_t *state,
                                               void           *user_data)
 {
         script_obj_t **script_func = user_data;
-        script_obj_t *obj = script_obj_hash_get_element (state->local, "function");
+        script_obj_t *obj = script_state_get_argument (state, "function");
 
         script_obj_deref (&obj);
         script_obj_unref (*script_func);
@@ -53,7 +53,7 @@ static script_return_t plymouth_set_refresh_rate (script_state_t *state,
 {
         script_lib_plymouth_data_t *data = user_data;
 
-        data->refresh_rate = script_obj_hash_get_number (state->local, "value");
+        data->refresh_rate = script_state_get_argument_number (state, "value");
 
         return script_return_obj_null ();
 }
@@ -39,6 +39,166 @@
 
 #include "script-lib-sprite.script.h"
 
+#define SPRITE_GRID_CELL_SIZE 128
+
+/* Past this many separate areas, redrawing their bounding box in one go
+ * is cheaper, as long as it isn't mostly empty
+ */
+#define SPRITE_MAX_REDRAW_AREAS 32
+
+/* The sprite list is kept sorted by z.  A sprite whose z goes up lands
+ * below the sprites already at its new z and one whose z goes down lands
+ * above them, which is the order a stable sort of the list would give.
+ */
+static void
+sprite_list_place (script_lib_sprite_data_t *data,
+                   sprite_t                 *sprite,
+                   bool                      is_raised)
+{
+        ply_list_node_t *node, *node_before;
+        sprite_t *other_sprite;
+
+        if (is_raised) {
+                node_before = ply_list_get_previous_node (data->sprite_list, sprite->node);
+                node = ply_list_get_next_node (data->sprite_list, sprite->node);
+                while (node != NULL) {
+                        other_sprite = ply_list_node_get_data (node);
+                        if (other_sprite->z >= sprite->z)
+                                break;
+                        node_before = node;
+                        node = ply_list_get_next_node (data->sprite_list, node);
+                }
+        } else {
+                node_before = ply_list_get_previous_node (data->sprite_list, sprite->node);
+                while (node_before != NULL) {
+                        other_sprite = ply_list_node_get_data (node_before);
+                        if (other_sprite->z <= sprite->z)
+                                break;
+                        node_before = ply_list_get_previous_node (data->sprite_list, node_before);
+                }
+        }
+
+        if (node_before == ply_list_get_previous_node (data->sprite_list, sprite->node))
+                return;
+
+        ply_list_remove_node (data->sprite_list, sprite->node);
+        sprite->node = ply_list_insert_data (data->sprite_list, sprite, node_before);
+        data->sprite_order_is_stale = true;
+}
+
+static void
+sprite_list_update_order (script_lib_sprite_data_t *data)
+{
+        ply_list_node_t *node;
+        unsigned int order = 0;
+
+        if (!data->sprite_order_is_stale)
+                return;
+
+        ply_list_foreach (data->sprite_list, node) {
+                sprite_t *sprite = ply_list_node_get_data (node);
+                sprite->order = order++;
+        }
+
+        data->sprite_order_is_stale = false;
+}
+
+/* The grid buckets sprites by the screen cells their last refreshed bounds
+ * touch, so drawing a damaged rectangle only looks at sprites near it.
+ */
+static void
+sprite_grid_remove (script_lib_sprite_data_t *data,
+                    sprite_t                 *sprite)
+{
+        int column, row;
+
+        if (!sprite->is_in_grid)
+                return;
+
+        for (row = sprite->grid_y1; row <= sprite->grid_y2; row++) {
+                for (column = sprite->grid_x1; column <= sprite->grid_x2; column++) {
+                        ply_list_remove_data (data->sprite_grid[row * data->sprite_grid_columns + column],
+                                              sprite);
+                }
+        }
+
+        sprite->is_in_grid = false;
+}
+
+static void
+sprite_grid_add (script_lib_sprite_data_t *data,
+                 sprite_t                 *sprite)
+{
+        int column, row;
+
+        if (data->sprite_grid == NULL)
+                return;
+
+        if (sprite->image == NULL || sprite->old_width <= 0 || sprite->old_height <= 0)
+                return;
+
+        sprite->grid_x1 = CLAMP (sprite->old_x / SPRITE_GRID_CELL_SIZE, 0, data->sprite_grid_columns - 1);
+        sprite->grid_y1 = CLAMP (sprite->old_y / SPRITE_GRID_CELL_SIZE, 0, data->sprite_grid_rows - 1);
+        sprite->grid_x2 = CLAMP ((sprite->old_x + sprite->old_width - 1) / SPRITE_GRID_CELL_SIZE, 0, data->sprite_grid_columns - 1);
+        sprite->grid_y2 = CLAMP ((sprite->old_y + sprite->old_height - 1) / SPRITE_GRID_CELL_SIZE, 0, data->sprite_grid_rows - 1);
+
+        for (row = sprite->grid_y1; row <= sprite->grid_y2; row++) {
+                for (column = sprite->grid_x1; column <= sprite->grid_x2; column++) {
+                        ply_list_append_data (data->sprite_grid[row * data->sprite_grid_columns + column],
+                                              sprite);
+                }
+        }
+
+        sprite->is_in_grid = true;
+}
+
+static void
+sprite_grid_free (script_lib_sprite_data_t *data)
+{
+        ply_list_node_t *node;
+        int i;
+
+        if (data->sprite_grid == NULL)
+                return;
+
+        for (i = 0; i < data->sprite_grid_columns * data->sprite_grid_rows; i++) {
+                ply_list_free (data->sprite_grid[i]);
+        }
+
+        free (data->sprite_grid);
+        data->sprite_grid = NULL;
+
+        ply_list_foreach (data->sprite_list, node) {
+                sprite_t *sprite = ply_list_node_get_data (node);
+                sprite->is_in_grid = false;
+        }
+}
+
+static void
+sprite_grid_rebuild (script_lib_sprite_data_t *data)
+{
+        ply_list_node_t *node;
+        int i;
+
+        sprite_grid_free (data);
+
+        data->sprite_grid_columns = MAX (1, ((int) data->max_width + SPRITE_GRID_CELL_SIZE - 1) / SPRITE_GRID_CELL_SIZE);
+        data->sprite_grid_rows = MAX (1, ((int) data->max_height + SPRITE_GRID_CELL_SIZE - 1) / SPRITE_GRID_CELL_SIZE);
+        data->sprite_grid = calloc (data->sprite_grid_columns * data->sprite_grid_rows,
+                                    sizeof(ply_list_t *));
+
+        for (i = 0; i < data->sprite_grid_columns * data->sprite_grid_rows; i++) {
+                data->sprite_grid[i] = ply_list_new ();
+        }
+
+        ply_list_foreach (data->sprite_list, node) {
+                sprite_t *sprite = ply_list_node_get_data (node);
+
+                if (!sprite->remove_me)
+                        sprite_grid_add (data, sprite);
+        }
+}
+
 static void sprite_free (script_obj_t *obj)
 {
         sprite_t *sprite = obj->data.native.object_data;
@@ -68,7 +228,8 @@ static script_return_t sprite_new (script_state_t *state,
         sprite->remove_me = false;
         sprite->image = NULL;
         sprite->image_obj = NULL;
-        ply_list_append_data (data->sprite_list, sprite);
+        sprite->node = ply_list_append_data (data->sprite_list, sprite);
+        sprite_list_place (data, sprite, false);
 
         reply = script_obj_new_native (sprite, data->class);
         return script_return_obj (reply);
@@ -92,8 +253,7 @@ static script_return_t sprite_set_image (script_state_t *state,
 {
         script_lib_sprite_data_t *data = user_data;
         sprite_t *sprite = script_obj_as_native_of_class (state->this, data->class);
-        script_obj_t *script_obj_image = script_obj_hash_get_element (state->local,
-                                                                      "image");
+        script_obj_t *script_obj_image = script_state_get_argument (state, "image");
 
         script_obj_deref (&script_obj_image);
         ply_pixel_buffer_t *image = script_obj_as_native_of_class_name (script_obj_image,
@@ -105,6 +265,7 @@ static script_return_t sprite_set_image (script_state_t *state,
                 sprite->image = image;
                 sprite->image_obj = script_obj_image;
                 sprite->refresh_me = true;
+                data->sprite_grid_is_stale = true;
         }
         script_obj_unref (script_obj_image);
 
@@ -161,8 +322,10 @@ static script_return_t sprite_set_x (script_state_t *state,
         script_lib_sprite_data_t *data = user_data;
         sprite_t *sprite = script_obj_as_native_of_class (state->this, data->class);
 
-        if (sprite)
-                sprite->x = script_obj_hash_get_number (state->local, "value");
+        if (sprite) {
+                sprite->x = script_state_get_argument_number (state, "value");
+                data->sprite_grid_is_stale = true;
+        }
         return script_return_obj_null ();
 }
 
@@ -172,8 +335,10 @@ static script_return_t sprite_set_y (script_state_t *state,
         script_lib_sprite_data_t *data = user_data;
         sprite_t *sprite = script_obj_as_native_of_class (state->this, data->class);
 
-        if (sprite)
-                sprite->y = script_obj_hash_get_number (state->local, "value");
+        if (sprite) {
+                sprite->y = script_state_get_argument_number (state, "value");
+                data->sprite_grid_is_stale = true;
+        }
         return script_return_obj_null ();
 }
 
@@ -183,8 +348,16 @@ static script_return_t sprite_set_z (script_state_t *state,
         script_lib_sprite_data_t *data = user_data;
         sprite_t *sprite = script_obj_as_native_of_class (state->this, data->class);
 
-        if (sprite)
-                sprite->z = script_obj_hash_get_number (state->local, "value");
+        if (sprite) {
+                int z = script_state_get_argument_number (state, "value");
+
+                if (z != sprite->z) {
+                        bool is_raised = z > sprite->z;
+
+                        sprite->z = z;
+                        sprite_list_place (data, sprite, is_raised);
+                }
+        }
         return script_return_obj_null ();
 }
 
@@ -195,7 +368,7 @@ static script_return_t sprite_set_opacity (script_state_t *state,
         sprite_t *sprite = script_obj_as_native_of_class (state->this, data->class);
 
         if (sprite)
-                sprite->opacity = script_obj_hash_get_number (state->local, "value");
+                sprite->opacity = script_state_get_argument_number (state, "value");
         return script_return_obj_null ();
 }
 
@@ -209,7 +382,7 @@ static script_return_t sprite_window_get_width (script_state_t *state,
         script_lib_display_t *display;
         unsigned int width;
 
-        index_obj = script_obj_hash_peek_element (state->local, "window");
+        index_obj = script_state_peek_argument (state, "window");
 
         if (index_obj) {
                 index = script_obj_as_number (index_obj);
@@ -237,7 +410,7 @@ static script_return_t sprite_window_get_height (script_state_t *state,
         script_lib_display_t *display;
         unsigned int height;
 
-        index_obj = script_obj_hash_peek_element (state->local, "window");
+        index_obj = script_state_peek_argument (state, "window");
 
         if (index_obj) {
                 index = script_obj_as_number (index_obj);
@@ -265,7 +438,7 @@ static script_return_t sprite_window_get_x (script_state_t *state,
         script_lib_display_t *display;
         int x;
 
-        index_obj = script_obj_hash_peek_element (state->local, "window");
+        index_obj = script_state_peek_argument (state, "window");
 
         if (index_obj) {
                 index = script_obj_as_number (index_obj);
@@ -300,7 +473,7 @@ static script_return_t sprite_window_get_y (script_state_t *state,
         script_lib_display_t *display;
         int y;
 
-        index_obj = script_obj_hash_peek_element (state->local, "window");
+        index_obj = script_state_peek_argument (state, "window");
 
         if (index_obj) {
                 index = script_obj_as_number (index_obj);
@@ -333,8 +506,8 @@ static script_return_t sprite_window_set_x (script_state_t *state,
         int index;
         int x;
 
-        index = script_obj_hash_get_number (state->local, "window");
-        x = script_obj_hash_get_number (state->local, "value");
+        index = script_state_get_argument_number (state, "window");
+        x = script_state_get_argument_number (state, "value");
         node = ply_list_get_nth_node (data->displays, index);
         if (node) {
                 display = ply_list_node_get_data (node);
@@ -355,8 +528,8 @@ static script_return_t sprite_window_set_y (script_state_t *state,
         int index;
         int y;
 
-        index = script_obj_hash_get_number (state->local, "window");
-        y = script_obj_hash_get_number (state->local, "value");
+        index = script_state_get_argument_number (state, "window");
+        y = script_state_get_argument_number (state, "value");
         node = ply_list_get_nth_node (data->displays, index);
         if (node) {
                 display = ply_list_node_get_data (node);
@@ -370,9 +543,9 @@ static script_return_t sprite_window_set_y (script_state_t *state,
 
 static uint32_t extract_rgb_color (script_state_t *state)
 {
-        uint8_t red = CLAMP (255 * script_obj_hash_get_number (state->local, "red"), 0, 255);
-        uint8_t green = CLAMP (255 * script_obj_hash_get_number (state->local, "green"), 0, 255);
-        uint8_t blue = CLAMP (255 * script_obj_hash_get_number (state->local, "blue"), 0, 255);
+        uint8_t red = CLAMP (255 * script_state_get_argument_number (state, "red"), 0, 255);
+        uint8_t green = CLAMP (255 * script_state_get_argument_number (state, "green"), 0, 255);
+        uint8_t blue = CLAMP (255 * script_state_get_argument_number (state, "blue"), 0, 255);
 
         return (uint32_t) red << 16 | green << 8 | blue;
 }
@@ -417,6 +590,123 @@ static void script_lib_draw_brackground (ply_pixel_buffer_t       *pixel_buffer,
 
 }
 
+static bool
+sprite_is_visible_in_area (sprite_t        *sprite,
+                           int              x,
+                           int              y,
+                           ply_rectangle_t *area)
+{
+        if (!sprite->image) return false;
+        if (sprite->remove_me) return false;
+        if (sprite->opacity < 0.011) return false;
+
+        if (x >= (area->x + (int) area->width)) return false;
+        if (y >= (area->y + (int) area->height)) return false;
+
+        if ((x + (int) ply_pixel_buffer_get_width (sprite->image)) <= area->x) return false;
+        if ((y + (int) ply_pixel_buffer_get_height (sprite->image)) <= area->y) return false;
+
+        return true;
+}
+
+static bool
+sprite_covers_area (sprite_t        *sprite,
+                    int              x,
+                    int              y,
+                    ply_rectangle_t *area)
+{
+        if (!ply_pixel_buffer_is_opaque (sprite->image) || sprite->opacity < 1.0)
+                return false;
+
+        return x <= area->x && y <= area->y &&
+               (x + (int) ply_pixel_buffer_get_width (sprite->image)) >= (area->x + (int) area->width) &&
+               (y + (int) ply_pixel_buffer_get_height (sprite->image)) >= (area->y + (int) area->height);
+}
+
+static void
+add_draw_sprite (script_lib_sprite_data_t *data,
+                 int                      *sprite_count,
+                 sprite_t                 *sprite)
+{
+        if (*sprite_count >= data->draw_sprites_size) {
+                data->draw_sprites_size = MAX (32, data->draw_sprites_size * 2);
+                data->draw_sprites = realloc (data->draw_sprites,
+                                              data->draw_sprites_size * sizeof(sprite_t *));
+        }
+
+        data->draw_sprites[(*sprite_count)++] = sprite;
+}
+
+static int
+compare_draw_sprites (const void *a,
+                      const void *b)
+{
+        const sprite_t *sprite_a = *(sprite_t *const *) a;
+        const sprite_t *sprite_b = *(sprite_t *const *) b;
+
+        return (sprite_a->order > sprite_b->order) - (sprite_a->order < sprite_b->order);
+}
+
+/* Collects the sprites visible in the area, bottom-most first */
+static int
+find_draw_sprites (script_lib_sprite_data_t *data,
+                   script_lib_display_t     *display,
+                   ply_rectangle_t          *clip_area)
+{
+        ply_list_node_t *node;
+        int sprite_count = 0;
+        int column, row;
+        int x1, y1, x2, y2;
+
+        if (data->sprite_grid == NULL || data->sprite_grid_is_stale) {
+                ply_list_foreach (data->sprite_list, node) {
+                        sprite_t *sprite = ply_list_node_get_data (node);
+
+                        if (sprite_is_visible_in_area (sprite,
+                                                       sprite->x - display->x,
+                                                       sprite->y - display->y,
+                                                       clip_area))
+                                add_draw_sprite (data, &sprite_count, sprite);
+                }
+                return sprite_count;
+        }
+
+        x1 = CLAMP ((clip_area->x + display->x) / SPRITE_GRID_CELL_SIZE, 0, data->sprite_grid_columns - 1);
+        y1 = CLAMP ((clip_area->y + display->y) / SPRITE_GRID_CELL_SIZE, 0, data->sprite_grid_rows - 1);
+        x2 = CLAMP ((clip_area->x + display->x + (int) clip_area->width - 1) / SPRITE_GRID_CELL_SIZE, 0, data->sprite_grid_columns - 1);
+        y2 = CLAMP ((clip_area->y + display->y + (int) clip_area->height - 1) / SPRITE_GRID_CELL_SIZE, 0, data->sprite_grid_rows - 1);
+
+        /* A sprite spanning several cells is only picked up once */
+        data->draw_serial++;
+
+        for (row = y1; row <= y2; row++) {
+                for (column = x1; column <= x2; column++) {
+                        ply_list_t *cell = data->sprite_grid[row * data->sprite_grid_columns + column];
+
+                        ply_list_foreach (cell, node) {
+                                sprite_t *sprite = ply_list_node_get_data (node);
+
+                                if (sprite->draw_serial == data->draw_serial)
+                                        continue;
+                                sprite->draw_serial = data->draw_serial;
+
+                                if (sprite_is_visible_in_area (sprite,
+                                                               sprite->x - display->x,
+                                                               sprite->y - display->y,
+                                                               clip_area))
+                                        add_draw_sprite (data, &sprite_count, sprite);
+                        }
+                }
+        }
+
+        if (sprite_count > 1) {
+                sprite_list_update_order (data);
+                qsort (data->draw_sprites, sprite_count, sizeof(sprite_t *), compare_draw_sprites);
+        }
+
+        return sprite_count;
+}
+
 static void script_lib_sprite_draw_area (script_lib_display_t *display,
                                          ply_pixel_buffer_t   *pixel_buffer,
                                          int                   x,
@@ -425,9 +715,10 @@ static void script_lib_sprite_draw_area (script_lib_display_t *display,
                                          int                   height)
 {
         ply_rectangle_t clip_area;
-        ply_list_node_t *node;
-        sprite_t *sprite;
         script_lib_sprite_data_t *data = display->data;
+        sprite_t **sprites;
+        int sprite_count, first_sprite;
+        int i, j;
 
         clip_area.x = x;
         clip_area.y = y;
@@ -440,54 +731,60 @@ static void script_lib_sprite_draw_area (script_lib_display_t *display,
                 return;
         }
 
-        node = ply_list_get_first_node (data->sprite_list);
-        if (node == NULL)
+        if (ply_list_get_length (data->sprite_list) == 0)
                 return;
 
-        sprite = ply_list_node_get_data (node);
-
-        /* Check If the first sprite should be rendered opaque */
-        if (sprite->image && !sprite->remove_me &&
-            ply_pixel_buffer_is_opaque (sprite->image) && sprite->opacity == 1.0) {
-                int position_x = sprite->x - display->x;
-                int position_y = sprite->y - display->y;
-
-                /* In that case only draw the background if the sprite doesn't
-                 * cover the complete area */
-                if (position_x > x || position_y > y ||
-                    ((int) ply_pixel_buffer_get_width (sprite->image) + position_x) < (x + width) ||
-                    ((int) ply_pixel_buffer_get_height (sprite->image) + position_y) < (y + height))
-                        script_lib_draw_brackground (pixel_buffer, &clip_area, data);
-        } else {
-                script_lib_draw_brackground (pixel_buffer, &clip_area, data);
+        sprite_count = find_draw_sprites (data, display, &clip_area);
+        sprites = (sprite_t **) data->draw_sprites;
+
+        /* Nothing below an opaque sprite covering the whole area shows,
+         * including the background */
+        first_sprite = 0;
+        for (i = sprite_count - 1; i >= 0; i--) {
+                if (sprite_covers_area (sprites[i],
+                                        sprites[i]->x - display->x,
+                                        sprites[i]->y - display->y,
+                                        &clip_area)) {
+                        first_sprite = i;
+                        break;
+                }
         }
 
-        for (node = ply_list_get_first_node (data->sprite_list);
-             node;
-             node = ply_list_get_next_node (data->sprite_list, node)) {
-                int position_x, position_y;
-
-                sprite = ply_list_node_get_data (node);
-
-                if (!sprite->image) continue;
-                if (sprite->remove_me) continue;
-                if (sprite->opacity < 0.011) continue;
-
-                position_x = sprite->x - display->x;
-                position_y = sprite->y - display->y;
+        if (i < 0)
+                script_lib_draw_brackground (pixel_buffer, &clip_area, data);
 
-                if (position_x >= (x + width)) continue;
-                if (position_y >= (y + height)) continue;
+        /* Drop sprites whose visible part is hidden by an opaque sprite
+         * above them */
+        for (i = first_sprite; i < sprite_count - 1; i++) {
+                ply_rectangle_t sprite_area, visible_area;
+
+                sprite_area.x = sprites[i]->x - display->x;
+                sprite_area.y = sprites[i]->y - display->y;
+                sprite_area.width = ply_pixel_buffer_get_width (sprites[i]->image);
+                sprite_area.height = ply_pixel_buffer_get_height (sprites[i]->image);
+                ply_rectangle_intersect (&sprite_area, &clip_area, &visible_area);
+
+                for (j = i + 1; j < sprite_count; j++) {
+                        if (sprite_covers_area (sprites[j],
+                                                sprites[j]->x - display->x,
+                                                sprites[j]->y - display->y,
+                                                &visible_area)) {
+                                sprites[i] = NULL;
+                                break;
+                        }
+                }
+        }
 
-                if ((position_x + (int) ply_pixel_buffer_get_width (sprite->image)) <= x) continue;
-                if ((position_y + (int) ply_pixel_buffer_get_height (sprite->image)) <= y) continue;
+        for (i = first_sprite; i < sprite_count; i++) {
+                if (sprites[i] == NULL)
+                        continue;
 
                 ply_pixel_buffer_fill_with_buffer_at_opacity_with_clip (pixel_buffer,
-                                                                        sprite->image,
-                                                                        position_x,
-                                                                        position_y,
+                                                                        sprites[i]->image,
+                                                                        sprites[i]->x - display->x,
+                                                                        sprites[i]->y - display->y,
                                                                         &clip_area,
-                                                                        sprite->opacity);
+                                                                        sprites[i]->opacity);
         }
 }
 
@@ -537,6 +834,7 @@ update_displays (script_lib_sprite_data_t *data)
                 script_display->y = (data->max_height - ply_pixel_display_get_height (script_display->pixel_display)) / 2;
         }
 
+        sprite_grid_free (data);
         data->full_refresh = true;
 }
 
@@ -579,6 +877,14 @@ script_lib_sprite_data_t *script_lib_sprite_setup (script_state_t *state,
 
         data->class = script_obj_native_class_new (sprite_free, "sprite", data);
         data->sprite_list = ply_list_new ();
+        data->sprite_grid = NULL;
+        data->sprite_grid_columns = 0;
+        data->sprite_grid_rows = 0;
+        data->sprite_grid_is_stale = true;
+        data->sprite_order_is_stale = true;
+        data->draw_serial = 0;
+        data->draw_sprites = NULL;
+        data->draw_sprites_size = 0;
         data->displays = ply_list_new ();
 
         data->boot_buffer = boot_buffer;
@@ -732,16 +1038,6 @@ script_lib_sprite_data_t *script_lib_sprite_setup (script_state_t *state,
         return data;
 }
 
-static int
-sprite_compare_z (void *data_a,
-                  void *data_b)
-{
-        sprite_t *sprite_a = data_a;
-        sprite_t *sprite_b = data_b;
-
-        return sprite_a->z - sprite_b->z;
-}
-
 static void
 region_add_area (ply_region_t *region,
                  long          x,
@@ -803,7 +1099,8 @@ script_lib_sprite_refresh (script_lib_sprite_data_t *data)
 {
         ply_list_node_t *node;
         ply_region_t *region;
-        ply_list_t *rectable_list;
+        ply_rectangle_t *rectangles;
+        size_t number_of_rectangles, i;
 
         if (!data)
                 return;
@@ -813,8 +1110,6 @@ script_lib_sprite_refresh (script_lib_sprite_data_t *data)
 
         region = ply_region_new ();
 
-        ply_list_sort_stable (data->sprite_list, &sprite_compare_z);
-
         if (data->full_refresh) {
                 data->console_viewer_needs_redraw = true;
                 for (node = ply_list_get_first_node (data->displays);
@@ -844,9 +1139,11 @@ script_lib_sprite_refresh (script_lib_sprite_data_t *data)
                                                  sprite->old_width,
                                                  sprite->old_height);
                         }
+                        sprite_grid_remove (data, sprite);
                         ply_list_remove_node (data->sprite_list, node);
                         script_obj_unref (sprite->image_obj);
                         free (sprite);
+                        data->sprite_order_is_stale = true;
                 }
                 node = next_node;
         }
@@ -884,20 +1181,27 @@ script_lib_sprite_refresh (script_lib_sprite_data_t *data)
                         sprite->old_height = size.height;
                         sprite->old_opacity = sprite->opacity;
                         sprite->refresh_me = false;
+
+                        sprite_grid_remove (data, sprite);
+                        sprite_grid_add (data, sprite);
                 }
         }
 
-        rectable_list = ply_region_get_rectangle_list (region);
+        if (!data->should_show_console_messages) {
+                if (data->sprite_grid == NULL)
+                        sprite_grid_rebuild (data);
+                data->sprite_grid_is_stale = false;
+        }
+
+        ply_region_simplify (region, SPRITE_MAX_REDRAW_AREAS);
+        rectangles = ply_region_get_rectangles (region, &number_of_rectangles);
 
-        for (node = ply_list_get_first_node (rectable_list);
-             node;
-             node = ply_list_get_next_node (rectable_list, node)) {
-                ply_rectangle_t *rectangle = ply_list_node_get_data (node);
+        for (i = 0; i < number_of_rectangles; i++) {
                 draw_area (data,
-                           rectangle->x,
-                           rectangle->y,
-                           rectangle->width,
-                           rectangle->height);
+                           rectangles[i].x,
+                           rectangles[i].y,
+                           rectangles[i].width,
+                           rectangles[i].height);
         }
 
         if (data->console_viewer_needs_redraw == true) {
@@ -947,6 +1251,8 @@ void script_lib_sprite_destroy (script_lib_sprite_data_t *data)
                 node = next_node;
         }
 
+        sprite_grid_free (data);
+        free (data->draw_sprites);
         ply_list_free (data->sprite_list);
         script_parse_op_free (data->script_main_op);
         script_obj_native_class_destroy (data->class);
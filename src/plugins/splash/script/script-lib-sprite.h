@@ -47,6 +47,15 @@ typedef struct
         bool                       plugin_console_messages_updating;
         bool                       should_show_console_messages;
         bool                       console_viewer_needs_redraw;
+
+        ply_list_t               **sprite_grid;
+        int                        sprite_grid_columns;
+        int                        sprite_grid_rows;
+        bool                       sprite_grid_is_stale;
+        bool                       sprite_order_is_stale;
+        unsigned int               draw_serial;
+        void                     **draw_sprites;
+        int                        draw_sprites_size;
 } script_lib_sprite_data_t;
 
 typedef struct
@@ -75,6 +84,15 @@ typedef struct
         bool                remove_me;
         ply_pixel_buffer_t *image;
         script_obj_t       *image_obj;
+
+        ply_list_node_t    *node;
+        unsigned int        order;
+        unsigned int        draw_serial;
+        bool                is_in_grid;
+        int                 grid_x1;
+        int                 grid_y1;
+        int                 grid_x2;
+        int                 grid_y2;
 } sprite_t;
 
 script_lib_sprite_data_t *script_lib_sprite_setup (script_state_t *state,
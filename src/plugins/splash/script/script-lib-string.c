@@ -39,7 +39,7 @@ static script_return_t script_lib_string_char_at (script_state_t *state,
                                                   void           *user_data)
 {
         char *text = script_obj_as_string (state->this);
-        int index = script_obj_hash_get_number (state->local, "index");
+        int index = script_state_get_argument_number (state, "index");
         int count;
         char charstring[2];
 
@@ -63,8 +63,8 @@ static script_return_t script_lib_string_sub_string (script_state_t *state,
                                                      void           *user_data)
 {
         char *text = script_obj_as_string (state->this);
-        int start = script_obj_hash_get_number (state->local, "start");
-        int end = script_obj_hash_get_number (state->local, "end");
+        int start = script_state_get_argument_number (state, "start");
+        int end = script_state_get_argument_number (state, "end");
         int text_count;
         char *substring;
         script_obj_t *substring_obj;
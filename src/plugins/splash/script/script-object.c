@@ -34,18 +34,111 @@
 #include <string.h>
 #include <stdbool.h>
 #include <math.h>
+#include <stdalign.h>
+#include <stddef.h>
 #include <values.h>
 
 #include "script.h"
 #include "script-object.h"
 
-void script_obj_reset (script_obj_t *obj);
+static void script_obj_clear (script_obj_t *obj);
+
+/* Shared objects for values the executor hands out all the time. They are
+ * never freed, so they start with a reference nobody ever drops.
+ */
+static script_obj_t script_obj_shared_null = {
+        .type = SCRIPT_OBJ_TYPE_NULL, .refcount = 1, .immutable = true
+};
+static script_obj_t script_obj_shared_false = {
+        .type = SCRIPT_OBJ_TYPE_NUMBER, .refcount = 1, .immutable = true, .data.number = 0
+};
+static script_obj_t script_obj_shared_true = {
+        .type = SCRIPT_OBJ_TYPE_NUMBER, .refcount = 1, .immutable = true, .data.number = 1
+};
+
+/* Objects and variables are all one size and churn constantly while a theme
+ * runs, so they come from slabs and go back on a free list. When nothing is
+ * live any more the slabs are given back, so unloading the plugin leaves
+ * nothing behind.
+ */
+#define SCRIPT_OBJ_POOL_SLAB_ITEMS 128
+
+typedef struct _script_obj_pool_slab
+{
+        struct _script_obj_pool_slab *next;
+        alignas (max_align_t) char    items[];
+} script_obj_pool_slab_t;
+
+typedef struct
+{
+        size_t                        item_size;
+        void                         *free_items;
+        script_obj_pool_slab_t       *slabs;
+        script_obj_pool_statistics_t  statistics;
+} script_obj_pool_t;
+
+static script_obj_pool_t script_obj_pool = { .item_size = sizeof(script_obj_t) };
+static script_obj_pool_t script_variable_pool = { .item_size = sizeof(script_variable_t) };
+
+static void *script_obj_pool_alloc (script_obj_pool_t *pool)
+{
+        void *item;
+
+        if (!pool->free_items) {
+                script_obj_pool_slab_t *slab;
+                int i;
+
+                slab = malloc (sizeof(script_obj_pool_slab_t) + pool->item_size * SCRIPT_OBJ_POOL_SLAB_ITEMS);
+                slab->next = pool->slabs;
+                pool->slabs = slab;
+                pool->statistics.allocations++;
+
+                for (i = SCRIPT_OBJ_POOL_SLAB_ITEMS - 1; i >= 0; i--) {
+                        item = slab->items + i * pool->item_size;
+                        *(void **) item = pool->free_items;
+                        pool->free_items = item;
+                }
+                pool->statistics.pooled += SCRIPT_OBJ_POOL_SLAB_ITEMS;
+        }
+
+        item = pool->free_items;
+        pool->free_items = *(void **) item;
+        pool->statistics.pooled--;
+        pool->statistics.live++;
+        return item;
+}
+
+static void script_obj_pool_release (script_obj_pool_t *pool,
+                                     void              *item)
+{
+        *(void **) item = pool->free_items;
+        pool->free_items = item;
+        pool->statistics.pooled++;
+        pool->statistics.live--;
+
+        if (pool->statistics.live == 0) {
+                while (pool->slabs) {
+                        script_obj_pool_slab_t *next_slab = pool->slabs->next;
+                        free (pool->slabs);
+                        pool->slabs = next_slab;
+                }
+                pool->free_items = NULL;
+                pool->statistics.pooled = 0;
+        }
+}
+
+void script_obj_get_pool_statistics (script_obj_pool_statistics_t *objects,
+                                     script_obj_pool_statistics_t *variables)
+{
+        if (objects) *objects = script_obj_pool.statistics;
+        if (variables) *variables = script_variable_pool.statistics;
+}
 
 void script_obj_free (script_obj_t *obj)
 {
         assert (!obj->refcount);
-        script_obj_reset (obj);
-        free (obj);
+        script_obj_clear (obj);
+        script_obj_pool_release (&script_obj_pool, obj);
 }
 
 void script_obj_ref (script_obj_t *obj)
@@ -70,10 +163,10 @@ static void foreach_free_variable (void *key,
 
         script_obj_unref (variable->object);
         free (variable->name);
-        free (variable);
+        script_obj_pool_release (&script_variable_pool, variable);
 }
 
-void script_obj_reset (script_obj_t *obj)
+static void script_obj_clear (script_obj_t *obj)
 {
         switch (obj->type) {
         case SCRIPT_OBJ_TYPE_REF:
@@ -100,17 +193,13 @@ void script_obj_reset (script_obj_t *obj)
         case SCRIPT_OBJ_TYPE_FUNCTION:
         {
                 if (obj->data.function->freeable) {
-                        ply_list_node_t *node;
-                        for (node =
-                                     ply_list_get_first_node (obj->data.function->parameters);
-                             node;
-                             node =
-                                     ply_list_get_next_node (obj->data.function->parameters,
-                                                             node)) {
-                                char *operand = ply_list_node_get_data (node);
-                                free (operand);
+                        char **parameter;
+                        for (parameter = obj->data.function->parameters;
+                             *parameter;
+                             parameter++) {
+                                free (*parameter);
                         }
-                        ply_list_free (obj->data.function->parameters);
+                        free (obj->data.function->parameters);
                         free (obj->data.function);
                 }
         }
@@ -127,6 +216,17 @@ void script_obj_reset (script_obj_t *obj)
         obj->type = SCRIPT_OBJ_TYPE_NULL;
 }
 
+void script_obj_reset (script_obj_t *obj)
+{
+        if (obj->immutable) return;
+        script_obj_clear (obj);
+}
+
+void script_obj_make_immutable (script_obj_t *obj)
+{
+        obj->immutable = true;
+}
+
 script_obj_t *script_obj_deref_direct (script_obj_t *obj)
 {
         while (obj->type == SCRIPT_OBJ_TYPE_REF) {
@@ -145,21 +245,39 @@ void script_obj_deref (script_obj_t **obj_ptr)
         *obj_ptr = obj;
 }
 
-script_obj_t *script_obj_new_null (void)
+static script_obj_t *script_obj_alloc (script_obj_type_t type)
 {
-        script_obj_t *obj = malloc (sizeof(script_obj_t));
+        script_obj_t *obj = script_obj_pool_alloc (&script_obj_pool);
 
-        obj->type = SCRIPT_OBJ_TYPE_NULL;
+        obj->type = type;
         obj->refcount = 1;
+        obj->immutable = false;
+        return obj;
+}
+
+script_obj_t *script_obj_new_null (void)
+{
+        return script_obj_alloc (SCRIPT_OBJ_TYPE_NULL);
+}
+
+script_obj_t *script_obj_new_shared_null (void)
+{
+        script_obj_ref (&script_obj_shared_null);
+        return &script_obj_shared_null;
+}
+
+script_obj_t *script_obj_new_shared_bool (bool value)
+{
+        script_obj_t *obj = value ? &script_obj_shared_true : &script_obj_shared_false;
+
+        script_obj_ref (obj);
         return obj;
 }
 
 script_obj_t *script_obj_new_number (script_number_t number)
 {
-        script_obj_t *obj = malloc (sizeof(script_obj_t));
+        script_obj_t *obj = script_obj_alloc (SCRIPT_OBJ_TYPE_NUMBER);
 
-        obj->type = SCRIPT_OBJ_TYPE_NUMBER;
-        obj->refcount = 1;
         obj->data.number = number;
         return obj;
 }
@@ -167,59 +285,49 @@ script_obj_t *script_obj_new_number (script_number_t number)
 script_obj_t *script_obj_new_string (const char *string)
 {
         if (!string) return script_obj_new_null ();
-        script_obj_t *obj = malloc (sizeof(script_obj_t));
-        obj->type = SCRIPT_OBJ_TYPE_STRING;
-        obj->refcount = 1;
+        script_obj_t *obj = script_obj_alloc (SCRIPT_OBJ_TYPE_STRING);
         obj->data.string = strdup (string);
         return obj;
 }
 
 script_obj_t *script_obj_new_hash (void)
 {
-        script_obj_t *obj = malloc (sizeof(script_obj_t));
+        script_obj_t *obj = script_obj_alloc (SCRIPT_OBJ_TYPE_HASH);
 
-        obj->type = SCRIPT_OBJ_TYPE_HASH;
         obj->data.hash = ply_hashtable_new (ply_hashtable_string_hash,
                                             ply_hashtable_string_compare);
-        obj->refcount = 1;
         return obj;
 }
 
 script_obj_t *script_obj_new_function (script_function_t *function)
 {
-        script_obj_t *obj = malloc (sizeof(script_obj_t));
+        script_obj_t *obj = script_obj_alloc (SCRIPT_OBJ_TYPE_FUNCTION);
 
-        obj->type = SCRIPT_OBJ_TYPE_FUNCTION;
         obj->data.function = function;
-        obj->refcount = 1;
         return obj;
 }
 
 script_obj_t *script_obj_new_ref (script_obj_t *sub_obj)
 {
-        script_obj_t *obj = malloc (sizeof(script_obj_t));
+        script_obj_t *obj = script_obj_alloc (SCRIPT_OBJ_TYPE_REF);
 
         sub_obj = script_obj_deref_direct (sub_obj);
         script_obj_ref (sub_obj);
-        obj->type = SCRIPT_OBJ_TYPE_REF;
         obj->data.obj = sub_obj;
-        obj->refcount = 1;
         return obj;
 }
 
 script_obj_t *script_obj_new_extend (script_obj_t *obj_a,
                                      script_obj_t *obj_b)
 {
-        script_obj_t *obj = malloc (sizeof(script_obj_t));
+        script_obj_t *obj = script_obj_alloc (SCRIPT_OBJ_TYPE_EXTEND);
 
         obj_a = script_obj_deref_direct (obj_a);
         obj_b = script_obj_deref_direct (obj_b);
         script_obj_ref (obj_a);
         script_obj_ref (obj_b);
-        obj->type = SCRIPT_OBJ_TYPE_EXTEND;
         obj->data.dual_obj.obj_a = obj_a;
         obj->data.dual_obj.obj_b = obj_b;
-        obj->refcount = 1;
         return obj;
 }
 
@@ -227,11 +335,9 @@ script_obj_t *script_obj_new_native (void                      *object_data,
                                      script_obj_native_class_t *class)
 {
         if (!object_data) return script_obj_new_null ();
-        script_obj_t *obj = malloc (sizeof(script_obj_t));
-        obj->type = SCRIPT_OBJ_TYPE_NATIVE;
+        script_obj_t *obj = script_obj_alloc (SCRIPT_OBJ_TYPE_NATIVE);
         obj->data.native.class = class;
         obj->data.native.object_data = object_data;
-        obj->refcount = 1;
         return obj;
 }
 
@@ -399,6 +505,7 @@ bool script_obj_is_native_of_class_name (script_obj_t *obj,
 void script_obj_assign (script_obj_t *obj_a,
                         script_obj_t *obj_b)
 {
+        if (obj_a->immutable) return;  /* e.g. "5 = 6", leave the literal alone */
         obj_b = script_obj_deref_direct (obj_b);
         script_obj_ref (obj_b);
         script_obj_reset (obj_a);
@@ -440,16 +547,19 @@ script_obj_t *script_obj_hash_get_element (script_obj_t *hash,
         if (obj) return obj;
         script_obj_t *realhash = script_obj_as_obj_type (hash, SCRIPT_OBJ_TYPE_HASH);
 
-        if (!realhash) {
+        if (realhash) {
+                script_obj_ref (realhash);
+        } else {
                 realhash = script_obj_new_hash (); /* If it wasn't a hash then make it into one */
                 script_obj_assign (hash, realhash);
         }
-        script_variable_t *variable = malloc (sizeof(script_variable_t));
+        script_variable_t *variable = script_obj_pool_alloc (&script_variable_pool);
 
         variable->name = strdup (name);
         variable->object = script_obj_new_null ();
         ply_hashtable_insert (realhash->data.hash, variable->name, variable);
         script_obj_ref (variable->object);
+        script_obj_unref (realhash);
         return variable->object;
 }
 
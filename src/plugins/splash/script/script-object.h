@@ -24,6 +24,7 @@
 
 #include "script.h"
 #include <stdbool.h>
+#include <stddef.h>
 
 
 typedef enum
@@ -35,19 +36,31 @@ typedef enum
 } script_obj_cmp_result_t;
 
 
+typedef struct
+{
+        size_t live;        /* Handed out and not yet freed */
+        size_t pooled;      /* Freed and waiting to be handed out again */
+        size_t allocations; /* Slabs malloced to back the pool, ever */
+} script_obj_pool_statistics_t;
+
 typedef void *(*script_obj_direct_func_t)(script_obj_t *,
                                           void *);
 
 
 void script_obj_free (script_obj_t *obj);
+void script_obj_get_pool_statistics (script_obj_pool_statistics_t *objects,
+                                     script_obj_pool_statistics_t *variables);
 void script_obj_ref (script_obj_t *obj);
 void script_obj_unref (script_obj_t *obj);
 void script_obj_reset (script_obj_t *obj);
+void script_obj_make_immutable (script_obj_t *obj);
 script_obj_t *script_obj_deref_direct (script_obj_t *obj);
 void script_obj_deref (script_obj_t **obj_ptr);
 script_obj_t *script_obj_new_number (script_number_t number);
 script_obj_t *script_obj_new_string (const char *string);
 script_obj_t *script_obj_new_null (void);
+script_obj_t *script_obj_new_shared_null (void);
+script_obj_t *script_obj_new_shared_bool (bool value);
 script_obj_t *script_obj_new_hash (void);
 script_obj_t *script_obj_new_function (script_function_t *function);
 script_obj_t *script_obj_new_ref (script_obj_t *sub_obj);
@@ -32,11 +32,14 @@
 #include <fcntl.h>
 #include <assert.h>
 #include <math.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include <string.h>
 #include <stdbool.h>
 
+#include "script-arena.h"
 #include "script-debug.h"
+#include "script-object.h"
 #include "script-scan.h"
 #include "script-parse.h"
 
@@ -51,133 +54,231 @@ typedef struct
 
 static script_op_t *script_parse_op (script_scan_t *scan);
 static script_exp_t *script_parse_exp (script_scan_t *scan);
-static ply_list_t *script_parse_op_list (script_scan_t *scan);
-static void script_parse_op_list_free (ply_list_t *op_list);
-static void script_parse_exp_free (script_exp_t *exp);
+static script_op_t **script_parse_op_list (script_scan_t *scan);
 
-static script_exp_t *script_parse_new_exp (script_exp_type_t        type,
+/* The whole tree lives in one arena, which the root op is allocated from */
+typedef struct
+{
+        script_arena_t *arena;
+        script_op_t     root;
+} script_parse_tree_t;
+
+static script_exp_t *script_parse_new_exp (script_scan_t           *scan,
+                                           script_exp_type_t        type,
                                            script_debug_location_t *location)
 {
-        script_exp_t *exp = malloc (sizeof(script_exp_t));
+        script_exp_t *exp = script_arena_alloc (scan->arena, sizeof(script_exp_t));
 
         exp->type = type;
-        script_debug_add_element (exp, location);
+        exp->location = *location;
         return exp;
 }
 
-static script_exp_t *script_parse_new_exp_single (script_exp_type_t        type,
+static script_exp_t *script_parse_new_exp_single (script_scan_t           *scan,
+                                                  script_exp_type_t        type,
                                                   script_exp_t            *sub,
                                                   script_debug_location_t *location)
 {
-        script_exp_t *exp = script_parse_new_exp (type, location);
+        script_exp_t *exp = script_parse_new_exp (scan, type, location);
 
         exp->data.sub = sub;
         return exp;
 }
 
-static script_exp_t *script_parse_new_exp_dual (script_exp_type_t        type,
+static script_exp_t *script_parse_new_exp_dual (script_scan_t           *scan,
+                                                script_exp_type_t        type,
                                                 script_exp_t            *sub_a,
                                                 script_exp_t            *sub_b,
                                                 script_debug_location_t *location)
 {
-        script_exp_t *exp = script_parse_new_exp (type, location);
+        script_exp_t *exp = script_parse_new_exp (scan, type, location);
 
         exp->data.dual.sub_a = sub_a;
         exp->data.dual.sub_b = sub_b;
         return exp;
 }
 
-static script_exp_t *script_parse_new_exp_number (script_number_t          number,
-                                                  script_debug_location_t *location)
+/* Literals are built once, here, and shared by every evaluation. The
+ * arena holds the tree's reference to them.
+ */
+static script_exp_t *script_parse_new_exp_literal (script_scan_t           *scan,
+                                                   script_obj_t            *literal,
+                                                   script_debug_location_t *location)
 {
-        script_exp_t *exp = script_parse_new_exp (SCRIPT_EXP_TYPE_TERM_NUMBER, location);
+        script_exp_type_t type;
+        script_exp_t *exp;
+
+        type = script_obj_is_number (literal) ? SCRIPT_EXP_TYPE_TERM_NUMBER : SCRIPT_EXP_TYPE_TERM_STRING;
+        exp = script_parse_new_exp (scan, type, location);
 
-        exp->data.number = number;
+        script_obj_make_immutable (literal);
+        script_arena_add_cleanup (scan->arena,
+                                  (script_arena_cleanup_handler_t) script_obj_unref,
+                                  literal);
+        exp->data.literal = literal;
         return exp;
 }
 
-static script_exp_t *script_parse_new_exp_string (char                    *string,
+static script_exp_t *script_parse_new_exp_number (script_scan_t           *scan,
+                                                  script_number_t          number,
                                                   script_debug_location_t *location)
 {
-        script_exp_t *exp = script_parse_new_exp (SCRIPT_EXP_TYPE_TERM_STRING, location);
+        return script_parse_new_exp_literal (scan, script_obj_new_number (number), location);
+}
 
-        exp->data.string = strdup (string);
-        return exp;
+static script_exp_t *script_parse_new_exp_string (script_scan_t           *scan,
+                                                  const char              *string,
+                                                  script_debug_location_t *location)
+{
+        return script_parse_new_exp_literal (scan, script_obj_new_string (string), location);
 }
 
-static script_exp_t *script_parse_new_exp_var (char                    *string,
+static script_exp_t *script_parse_new_exp_var (script_scan_t           *scan,
+                                               char                    *string,
                                                script_debug_location_t *location)
 {
-        script_exp_t *exp = script_parse_new_exp (SCRIPT_EXP_TYPE_TERM_VAR, location);
+        script_exp_t *exp = script_parse_new_exp (scan, SCRIPT_EXP_TYPE_TERM_VAR, location);
 
-        exp->data.string = strdup (string);
+        exp->data.string = string;
         return exp;
 }
 
-static script_exp_t *script_parse_new_exp_function_exe (script_exp_t            *name,
-                                                        ply_list_t              *parameters,
+static script_exp_t *script_parse_new_exp_function_exe (script_scan_t           *scan,
+                                                        script_exp_t            *name,
+                                                        script_exp_t           **parameters,
                                                         script_debug_location_t *location)
 {
-        script_exp_t *exp = script_parse_new_exp (SCRIPT_EXP_TYPE_FUNCTION_EXE, location);
+        script_exp_t *exp = script_parse_new_exp (scan, SCRIPT_EXP_TYPE_FUNCTION_EXE, location);
 
         exp->data.function_exe.name = name;
         exp->data.function_exe.parameters = parameters;
         return exp;
 }
 
-static script_exp_t *script_parse_new_exp_function_def (script_function_t       *function_def,
+static script_exp_t *script_parse_new_exp_function_def (script_scan_t           *scan,
+                                                        script_function_t       *function_def,
                                                         script_debug_location_t *location)
 {
-        script_exp_t *exp = script_parse_new_exp (SCRIPT_EXP_TYPE_FUNCTION_DEF, location);
+        script_exp_t *exp = script_parse_new_exp (scan, SCRIPT_EXP_TYPE_FUNCTION_DEF, location);
 
         exp->data.function_def = function_def;
         return exp;
 }
 
-static script_exp_t *script_parse_new_exp_set (ply_list_t              *parameters,
+static script_exp_t *script_parse_new_exp_set (script_scan_t           *scan,
+                                               script_exp_t           **parameters,
                                                script_debug_location_t *location)
 {
-        script_exp_t *exp = script_parse_new_exp (SCRIPT_EXP_TYPE_TERM_SET, location);
+        script_exp_t *exp = script_parse_new_exp (scan, SCRIPT_EXP_TYPE_TERM_SET, location);
 
         exp->data.parameters = parameters;
         return exp;
 }
 
-static script_op_t *script_parse_new_op (script_op_type_t         type,
+static bool script_parse_exp_is_literal (script_exp_t *exp)
+{
+        return exp && (exp->type == SCRIPT_EXP_TYPE_TERM_NUMBER ||
+                       exp->type == SCRIPT_EXP_TYPE_TERM_STRING);
+}
+
+/* Works out operations on literals once, using the same functions the
+ * executor would, so folding never changes what a script computes.
+ */
+static script_exp_t *script_parse_fold_exp (script_scan_t *scan,
+                                            script_exp_t  *exp)
+{
+        script_obj_t *(*function)(script_obj_t *,
+                                  script_obj_t *) = NULL;
+        script_obj_t *obj;
+
+        switch (exp->type) {
+        case SCRIPT_EXP_TYPE_PLUS:
+                function = script_obj_plus;
+                break;
+        case SCRIPT_EXP_TYPE_MINUS:
+                function = script_obj_minus;
+                break;
+        case SCRIPT_EXP_TYPE_MUL:
+                function = script_obj_mul;
+                break;
+        case SCRIPT_EXP_TYPE_DIV:
+                function = script_obj_div;
+                break;
+        case SCRIPT_EXP_TYPE_MOD:
+                function = script_obj_mod;
+                break;
+        case SCRIPT_EXP_TYPE_POS:       /* Evaluates to its operand, whatever it is */
+                return exp->data.sub ? exp->data.sub : exp;
+        case SCRIPT_EXP_TYPE_NEG:
+        case SCRIPT_EXP_TYPE_NOT:
+                break;
+        default:
+                return exp;
+        }
+
+        if (function) {
+                if (!script_parse_exp_is_literal (exp->data.dual.sub_a) ||
+                    !script_parse_exp_is_literal (exp->data.dual.sub_b))
+                        return exp;
+                obj = function (exp->data.dual.sub_a->data.literal,
+                                exp->data.dual.sub_b->data.literal);
+        } else {
+                if (!script_parse_exp_is_literal (exp->data.sub))
+                        return exp;
+                if (exp->type == SCRIPT_EXP_TYPE_NOT)
+                        obj = script_obj_new_number (!script_obj_as_bool (exp->data.sub->data.literal));
+                else if (script_obj_is_number (exp->data.sub->data.literal))
+                        obj = script_obj_new_number (-script_obj_as_number (exp->data.sub->data.literal));
+                else
+                        return exp;     /* Leave the error to the executor */
+        }
+
+        if (!script_obj_is_number (obj) && !script_obj_is_string (obj)) {
+                script_obj_unref (obj);
+                return exp;
+        }
+        return script_parse_new_exp_literal (scan, obj, &exp->location);
+}
+
+static script_op_t *script_parse_new_op (script_scan_t           *scan,
+                                         script_op_type_t         type,
                                          script_debug_location_t *location)
 {
-        script_op_t *op = malloc (sizeof(script_op_t));
+        script_op_t *op = script_arena_alloc (scan->arena, sizeof(script_op_t));
 
         op->type = type;
-        script_debug_add_element (op, location);
+        op->location = *location;
         return op;
 }
 
-static script_op_t *script_parse_new_op_exp (script_exp_t            *exp,
+static script_op_t *script_parse_new_op_exp (script_scan_t           *scan,
+                                             script_exp_t            *exp,
                                              script_debug_location_t *location)
 {
-        script_op_t *op = script_parse_new_op (SCRIPT_OP_TYPE_EXPRESSION, location);
+        script_op_t *op = script_parse_new_op (scan, SCRIPT_OP_TYPE_EXPRESSION, location);
 
         op->data.exp = exp;
         return op;
 }
 
-static script_op_t *script_parse_new_op_block (ply_list_t              *list,
+static script_op_t *script_parse_new_op_block (script_scan_t           *scan,
+                                               script_op_t            **list,
                                                script_debug_location_t *location)
 {
-        script_op_t *op = script_parse_new_op (SCRIPT_OP_TYPE_OP_BLOCK, location);
+        script_op_t *op = script_parse_new_op (scan, SCRIPT_OP_TYPE_OP_BLOCK, location);
 
         op->data.list = list;
         return op;
 }
 
-static script_op_t *script_parse_new_op_cond (script_op_type_t         type,
+static script_op_t *script_parse_new_op_cond (script_scan_t           *scan,
+                                              script_op_type_t         type,
                                               script_exp_t            *cond,
                                               script_op_t             *op1,
                                               script_op_t             *op2,
                                               script_debug_location_t *location)
 {
-        script_op_t *op = script_parse_new_op (type, location);
+        script_op_t *op = script_parse_new_op (scan, type, location);
 
         op->data.cond_op.cond = cond;
         op->data.cond_op.op1 = op1;
@@ -230,33 +331,102 @@ static void script_parse_advance_scan_by_string (script_scan_t *scan,
         }
 }
 
-static void
-free_parameter_list (script_scan_t *scan,
-                     ply_list_t    *parameter_list)
+static bool script_parse_op_mentions (script_op_t *op,
+                                      const char  *name);
+
+/* Looks for a variable or key called name, without going into nested
+ * function definitions, which have names of their own.
+ */
+static bool script_parse_exp_mentions (script_exp_t *exp,
+                                       const char   *name)
+{
+        script_exp_t **sub;
+
+        if (!exp) return false;
+
+        switch (exp->type) {
+        case SCRIPT_EXP_TYPE_TERM_VAR:
+                return strcmp (exp->data.string, name) == 0;
+
+        case SCRIPT_EXP_TYPE_TERM_STRING:
+                return script_obj_is_string (exp->data.literal) &&
+                       strcmp (exp->data.literal->data.string, name) == 0;
+
+        case SCRIPT_EXP_TYPE_TERM_NULL:
+        case SCRIPT_EXP_TYPE_TERM_NUMBER:
+        case SCRIPT_EXP_TYPE_TERM_LOCAL:
+        case SCRIPT_EXP_TYPE_TERM_GLOBAL:
+        case SCRIPT_EXP_TYPE_TERM_THIS:
+        case SCRIPT_EXP_TYPE_FUNCTION_DEF:
+                return false;
+
+        case SCRIPT_EXP_TYPE_TERM_SET:
+                for (sub = exp->data.parameters; *sub; sub++) {
+                        if (script_parse_exp_mentions (*sub, name)) return true;
+                }
+                return false;
+
+        case SCRIPT_EXP_TYPE_FUNCTION_EXE:
+                if (script_parse_exp_mentions (exp->data.function_exe.name, name)) return true;
+                for (sub = exp->data.function_exe.parameters; *sub; sub++) {
+                        if (script_parse_exp_mentions (*sub, name)) return true;
+                }
+                return false;
+
+        case SCRIPT_EXP_TYPE_NOT:
+        case SCRIPT_EXP_TYPE_POS:
+        case SCRIPT_EXP_TYPE_NEG:
+        case SCRIPT_EXP_TYPE_PRE_INC:
+        case SCRIPT_EXP_TYPE_PRE_DEC:
+        case SCRIPT_EXP_TYPE_POST_INC:
+        case SCRIPT_EXP_TYPE_POST_DEC:
+                return script_parse_exp_mentions (exp->data.sub, name);
+
+        default:
+                return script_parse_exp_mentions (exp->data.dual.sub_a, name) ||
+                       script_parse_exp_mentions (exp->data.dual.sub_b, name);
+        }
+}
+
+static bool script_parse_op_mentions (script_op_t *op,
+                                      const char  *name)
 {
-        if (parameter_list != NULL) {
-                ply_list_node_t *node;
+        script_op_t **sub;
 
-                node = ply_list_get_first_node (parameter_list);
-                while (node != NULL) {
-                        ply_list_node_t *next_node;
-                        char *parameter;
+        if (!op) return false;
 
-                        parameter = ply_list_node_get_data (node);
-                        next_node = ply_list_get_next_node (parameter_list, node);
-                        free (parameter);
-                        ply_list_remove_node (parameter_list, node);
+        switch (op->type) {
+        case SCRIPT_OP_TYPE_EXPRESSION:
+        case SCRIPT_OP_TYPE_RETURN:
+                return script_parse_exp_mentions (op->data.exp, name);
 
-                        node = next_node;
+        case SCRIPT_OP_TYPE_OP_BLOCK:
+                for (sub = op->data.list; *sub; sub++) {
+                        if (script_parse_op_mentions (*sub, name)) return true;
                 }
+                return false;
+
+        case SCRIPT_OP_TYPE_IF:
+        case SCRIPT_OP_TYPE_WHILE:
+        case SCRIPT_OP_TYPE_DO_WHILE:
+        case SCRIPT_OP_TYPE_FOR:
+                return script_parse_exp_mentions (op->data.cond_op.cond, name) ||
+                       script_parse_op_mentions (op->data.cond_op.op1, name) ||
+                       script_parse_op_mentions (op->data.cond_op.op2, name);
+
+        case SCRIPT_OP_TYPE_FAIL:
+        case SCRIPT_OP_TYPE_BREAK:
+        case SCRIPT_OP_TYPE_CONTINUE:
+                break;
         }
+        return false;
 }
 
 static script_function_t *script_parse_function_def (script_scan_t *scan)
 {
         script_scan_token_t *curtoken = script_scan_get_current_token (scan);
-        script_function_t *function = NULL;
-        ply_list_t *parameter_list = NULL;
+        script_function_t *function;
+        size_t parameters_start;
 
         if (!script_scan_token_is_symbol_of_value (curtoken, '(')) {
                 script_parse_error (&curtoken->location,
@@ -264,17 +434,17 @@ static script_function_t *script_parse_function_def (script_scan_t *scan)
                 return NULL;
         }
         curtoken = script_scan_get_next_token (scan);
-        parameter_list = ply_list_new ();
+        parameters_start = script_arena_start_array (scan->arena);
 
         while (true) {
                 if (script_scan_token_is_symbol_of_value (curtoken, ')')) break;
                 if (!script_scan_token_is_identifier (curtoken)) {
                         script_parse_error (&curtoken->location,
                                             "Function declaration parameters must be valid identifiers");
-                        goto out;
+                        script_arena_finish_array (scan->arena, parameters_start);
+                        return NULL;
                 }
-                char *parameter = strdup (curtoken->data.string);
-                ply_list_append_data (parameter_list, parameter);
+                script_arena_append_to_array (scan->arena, curtoken->data.string);
 
                 curtoken = script_scan_get_next_token (scan);
 
@@ -282,21 +452,24 @@ static script_function_t *script_parse_function_def (script_scan_t *scan)
                 if (!script_scan_token_is_symbol_of_value (curtoken, ',')) {
                         script_parse_error (&curtoken->location,
                                             "Function declaration parameters must separated with ',' and terminated with a ')'");
-                        goto out;
+                        script_arena_finish_array (scan->arena, parameters_start);
+                        return NULL;
                 }
                 curtoken = script_scan_get_next_token (scan);
         }
 
+        /* Owned by the tree, so the function object must never free it */
+        function = script_arena_alloc (scan->arena, sizeof(script_function_t));
+        function->type = SCRIPT_FUNCTION_TYPE_SCRIPT;
+        function->parameters = (char **) script_arena_finish_array (scan->arena, parameters_start);
+        function->user_data = NULL;
+        function->freeable = false;
+
         curtoken = script_scan_get_next_token (scan);
 
-        script_op_t *func_op = script_parse_op (scan);
+        function->data.script = script_parse_op (scan);
+        function->uses_args = script_parse_op_mentions (function->data.script, "_args");
 
-        function = script_function_script_new (func_op,
-                                               NULL,
-                                               parameter_list);
-        parameter_list = NULL;
-out:
-        free_parameter_list (scan, parameter_list);
         return function;
 }
 
@@ -306,76 +479,69 @@ static script_exp_t *script_parse_exp_tm (script_scan_t *scan)
         script_exp_t *exp = NULL;
 
         if (script_scan_token_is_integer (curtoken)) {
-                exp = script_parse_new_exp_number (curtoken->data.integer, &curtoken->location);
+                exp = script_parse_new_exp_number (scan, curtoken->data.integer, &curtoken->location);
                 script_scan_get_next_token (scan);
                 return exp;
         }
         if (script_scan_token_is_float (curtoken)) {
-                exp = script_parse_new_exp_number (curtoken->data.floatpoint, &curtoken->location);
+                exp = script_parse_new_exp_number (scan, curtoken->data.floatpoint, &curtoken->location);
                 script_scan_get_next_token (scan);
                 return exp;
         }
         if (script_scan_token_is_identifier (curtoken)) {
                 if (script_scan_token_is_identifier_of_value (curtoken, "NULL")) {
-                        exp = script_parse_new_exp (SCRIPT_EXP_TYPE_TERM_NULL, &curtoken->location);
+                        exp = script_parse_new_exp (scan, SCRIPT_EXP_TYPE_TERM_NULL, &curtoken->location);
                 } else if (script_scan_token_is_identifier_of_value (curtoken, "INFINITY")) {
-                        exp = script_parse_new_exp_number (INFINITY, &curtoken->location);
+                        exp = script_parse_new_exp_number (scan, INFINITY, &curtoken->location);
                 } else if (script_scan_token_is_identifier_of_value (curtoken, "NAN")) {
-                        exp = script_parse_new_exp_number (NAN, &curtoken->location);
+                        exp = script_parse_new_exp_number (scan, NAN, &curtoken->location);
                 } else if (script_scan_token_is_identifier_of_value (curtoken, "global")) {
-                        exp = script_parse_new_exp (SCRIPT_EXP_TYPE_TERM_GLOBAL, &curtoken->location);
+                        exp = script_parse_new_exp (scan, SCRIPT_EXP_TYPE_TERM_GLOBAL, &curtoken->location);
                 } else if (script_scan_token_is_identifier_of_value (curtoken, "local")) {
-                        exp = script_parse_new_exp (SCRIPT_EXP_TYPE_TERM_LOCAL, &curtoken->location);
+                        exp = script_parse_new_exp (scan, SCRIPT_EXP_TYPE_TERM_LOCAL, &curtoken->location);
                 } else if (script_scan_token_is_identifier_of_value (curtoken, "this")) {
-                        exp = script_parse_new_exp (SCRIPT_EXP_TYPE_TERM_THIS, &curtoken->location);
+                        exp = script_parse_new_exp (scan, SCRIPT_EXP_TYPE_TERM_THIS, &curtoken->location);
                 } else if (script_scan_token_is_identifier_of_value (curtoken, "fun")) {
                         script_debug_location_t location = curtoken->location;
                         script_scan_get_next_token (scan);
-                        exp = script_parse_new_exp_function_def (script_parse_function_def (scan), &location);
+                        exp = script_parse_new_exp_function_def (scan, script_parse_function_def (scan), &location);
                         return exp;
                 } else {
-                        exp = script_parse_new_exp_var (curtoken->data.string, &curtoken->location);
+                        exp = script_parse_new_exp_var (scan, curtoken->data.string, &curtoken->location);
                 }
                 curtoken = script_scan_get_next_token (scan);
                 return exp;
         }
         if (script_scan_token_is_string (curtoken)) {
-                exp = script_parse_new_exp_string (curtoken->data.string, &curtoken->location);
+                exp = script_parse_new_exp_string (scan, curtoken->data.string, &curtoken->location);
                 script_scan_get_next_token (scan);
                 return exp;
         }
 
         if (script_scan_token_is_symbol_of_value (curtoken, '[')) {
-                ply_list_t *parameters = ply_list_new ();
+                size_t parameters_start = script_arena_start_array (scan->arena);
                 script_debug_location_t location = curtoken->location;
                 script_scan_get_next_token (scan);
                 while (true) {
                         if (script_scan_token_is_symbol_of_value (curtoken, ']')) break;
                         script_exp_t *parameter = script_parse_exp (scan);
 
-                        ply_list_append_data (parameters, parameter);
+                        script_arena_append_to_array (scan->arena, parameter);
 
                         curtoken = script_scan_get_current_token (scan);
                         if (script_scan_token_is_symbol_of_value (curtoken, ']')) break;
                         if (!script_scan_token_is_symbol_of_value (curtoken, ',')) {
-                                ply_list_node_t *node;
                                 script_parse_error (&curtoken->location,
                                                     "Set parameters should be separated with a ',' and terminated with a ']'");
-
-
-                                for (node = ply_list_get_first_node (parameters);
-                                     node;
-                                     node = ply_list_get_next_node (parameters, node)) {
-                                        script_exp_t *sub = ply_list_node_get_data (node);
-                                        script_parse_exp_free (sub);
-                                }
-                                ply_list_free (parameters);
+                                script_arena_finish_array (scan->arena, parameters_start);
                                 return NULL;
                         }
                         curtoken = script_scan_get_next_token (scan);
                 }
                 script_scan_get_next_token (scan);
-                exp = script_parse_new_exp_set (parameters, &location);
+                exp = script_parse_new_exp_set (scan,
+                                                (script_exp_t **) script_arena_finish_array (scan->arena, parameters_start),
+                                                &location);
                 return exp;
         }
         if (script_scan_token_is_symbol_of_value (curtoken, '(')) {
@@ -407,35 +573,29 @@ static script_exp_t *script_parse_exp_pi (script_scan_t *scan)
                 script_debug_location_t location = curtoken->location;
                 if (!script_scan_token_is_symbol (curtoken)) break;
                 if (script_scan_token_is_symbol_of_value (curtoken, '(')) {
-                        ply_list_t *parameters = ply_list_new ();
+                        size_t parameters_start = script_arena_start_array (scan->arena);
                         script_scan_get_next_token (scan);
                         while (true) {
                                 if (script_scan_token_is_symbol_of_value (curtoken, ')')) break;
                                 script_exp_t *parameter = script_parse_exp (scan);
 
-                                ply_list_append_data (parameters, parameter);
+                                script_arena_append_to_array (scan->arena, parameter);
 
                                 curtoken = script_scan_get_current_token (scan);
                                 if (script_scan_token_is_symbol_of_value (curtoken, ')')) break;
                                 if (!script_scan_token_is_symbol_of_value (curtoken, ',')) {
-                                        ply_list_node_t *node;
-
                                         script_parse_error (&curtoken->location,
                                                             "Function parameters should be separated with a ',' and terminated with a ')'");
-
-                                        for (node = ply_list_get_first_node (parameters);
-                                             node;
-                                             node = ply_list_get_next_node (parameters, node)) {
-                                                script_exp_t *sub = ply_list_node_get_data (node);
-                                                script_parse_exp_free (sub);
-                                        }
-                                        ply_list_free (parameters);
+                                        script_arena_finish_array (scan->arena, parameters_start);
                                         return NULL;
                                 }
                                 curtoken = script_scan_get_next_token (scan);
                         }
                         script_scan_get_next_token (scan);
-                        exp = script_parse_new_exp_function_exe (exp, parameters, &location);
+                        exp = script_parse_new_exp_function_exe (scan,
+                                                                 exp,
+                                                                 (script_exp_t **) script_arena_finish_array (scan->arena, parameters_start),
+                                                                 &location);
                         continue;
                 }
                 script_exp_t *key;
@@ -443,7 +603,7 @@ static script_exp_t *script_parse_exp_pi (script_scan_t *scan)
                 if (script_scan_token_is_symbol_of_value (curtoken, '.')) {
                         script_scan_get_next_token (scan);
                         if (script_scan_token_is_identifier (curtoken)) {
-                                key = script_parse_new_exp_string (curtoken->data.string, &curtoken->location);
+                                key = script_parse_new_exp_string (scan, curtoken->data.string, &curtoken->location);
                         } else {
                                 script_parse_error (&curtoken->location,
                                                     "A dot based hash index must be an identifier");
@@ -468,7 +628,7 @@ static script_exp_t *script_parse_exp_pi (script_scan_t *scan)
                 } else {
                         break;
                 }
-                exp = script_parse_new_exp_dual (SCRIPT_EXP_TYPE_HASH, exp, key, &location);
+                exp = script_parse_new_exp_dual (scan, SCRIPT_EXP_TYPE_HASH, exp, key, &location);
         }
         return exp;
 }
@@ -491,7 +651,8 @@ static script_exp_t *script_parse_exp_pr (script_scan_t *scan)
         script_debug_location_t location = script_scan_get_current_token (scan)->location;
 
         script_parse_advance_scan_by_string (scan, entry->symbol);
-        return script_parse_new_exp_single (entry->exp_type, script_parse_exp_pr (scan), &location);
+        return script_parse_fold_exp (scan,
+                                      script_parse_new_exp_single (scan, entry->exp_type, script_parse_exp_pr (scan), &location));
 }
 
 static script_exp_t *script_parse_exp_po (script_scan_t *scan)
@@ -508,7 +669,7 @@ static script_exp_t *script_parse_exp_po (script_scan_t *scan)
                 const script_parse_operator_table_entry_t *entry;
                 entry = script_parse_operator_table_entry_lookup (scan, operator_table);
                 if (entry->presedence < 0) break;
-                exp = script_parse_new_exp_single (entry->exp_type, exp, &script_scan_get_current_token (scan)->location);
+                exp = script_parse_new_exp_single (scan, entry->exp_type, exp, &script_scan_get_current_token (scan)->location);
                 script_parse_advance_scan_by_string (scan, entry->symbol);
         }
         return exp;
@@ -553,12 +714,13 @@ static script_exp_t *script_parse_exp_ltr (script_scan_t *scan,
                 if (entry->presedence != presedence) break;
                 script_debug_location_t location = script_scan_get_current_token (scan)->location;
                 script_parse_advance_scan_by_string (scan, entry->symbol);
-                exp = script_parse_new_exp_dual (entry->exp_type, exp, script_parse_exp_ltr (scan, presedence + 1), &location);
+                exp = script_parse_new_exp_dual (scan, entry->exp_type, exp, script_parse_exp_ltr (scan, presedence + 1), &location);
                 if (!exp->data.dual.sub_b) {
                         script_parse_error (&script_scan_get_current_token (scan)->location,
                                             "An invalid RHS of an operation");
                         return NULL;
                 }
+                exp = script_parse_fold_exp (scan, exp);
         }
         return exp;
 }
@@ -594,7 +756,7 @@ static script_exp_t *script_parse_exp_as (script_scan_t *scan)
                                     "An invalid RHS of an assign");
                 return NULL;
         }
-        return script_parse_new_exp_dual (entry->exp_type, lhs, rhs, &location);
+        return script_parse_new_exp_dual (scan, entry->exp_type, lhs, rhs, &location);
 }
 
 static script_exp_t *script_parse_exp (script_scan_t *scan)
@@ -611,7 +773,7 @@ static script_op_t *script_parse_op_block (script_scan_t *scan)
         script_debug_location_t location = curtoken->location;
 
         script_scan_get_next_token (scan);
-        ply_list_t *sublist = script_parse_op_list (scan);
+        script_op_t **sublist = script_parse_op_list (scan);
 
         curtoken = script_scan_get_current_token (scan);
         if (!script_scan_token_is_symbol_of_value (curtoken, '}')) {
@@ -621,7 +783,7 @@ static script_op_t *script_parse_op_block (script_scan_t *scan)
         }
         curtoken = script_scan_get_next_token (scan);
 
-        script_op_t *op = script_parse_new_op_block (sublist, &location);
+        script_op_t *op = script_parse_new_op_block (scan, sublist, &location);
 
         return op;
 }
@@ -669,7 +831,7 @@ static script_op_t *script_parse_if_while (script_scan_t *scan)
                 script_scan_get_next_token (scan);
                 else_op = script_parse_op (scan);
         }
-        script_op_t *op = script_parse_new_op_cond (type, cond, cond_op, else_op, &location);
+        script_op_t *op = script_parse_new_op_cond (scan, type, cond, cond_op, else_op, &location);
 
         return op;
 }
@@ -719,7 +881,7 @@ static script_op_t *script_parse_do_while (script_scan_t *scan)
                 return NULL;
         }
         script_scan_get_next_token (scan);
-        script_op_t *op = script_parse_new_op_cond (SCRIPT_OP_TYPE_DO_WHILE, cond, cond_op, NULL, &location);
+        script_op_t *op = script_parse_new_op_cond (scan, SCRIPT_OP_TYPE_DO_WHILE, cond, cond_op, NULL, &location);
 
         return op;
 }
@@ -782,16 +944,17 @@ static script_op_t *script_parse_for (script_scan_t *scan)
         script_scan_get_next_token (scan);
         script_op_t *op_body = script_parse_op (scan);
 
-        script_op_t *op_first = script_parse_new_op_exp (first, &location_first);
-        script_op_t *op_last = script_parse_new_op_exp (last, &location_last);
-        script_op_t *op_for = script_parse_new_op_cond (SCRIPT_OP_TYPE_FOR, cond, op_body, op_last, &location_for);
+        script_op_t *op_first = script_parse_new_op_exp (scan, first, &location_first);
+        script_op_t *op_last = script_parse_new_op_exp (scan, last, &location_last);
+        script_op_t *op_for = script_parse_new_op_cond (scan, SCRIPT_OP_TYPE_FOR, cond, op_body, op_last, &location_for);
 
-        ply_list_t *op_list = ply_list_new ();
+        size_t op_list_start = script_arena_start_array (scan->arena);
 
-        ply_list_append_data (op_list, op_first);
-        ply_list_append_data (op_list, op_for);
+        script_arena_append_to_array (scan->arena, op_first);
+        script_arena_append_to_array (scan->arena, op_for);
+        script_op_t **op_list = (script_op_t **) script_arena_finish_array (scan->arena, op_list_start);
 
-        script_op_t *op_block = script_parse_new_op_block (op_list, &location_for);
+        script_op_t *op_block = script_parse_new_op_block (scan, op_list, &location_for);
 
         return op_block;
 }
@@ -809,17 +972,17 @@ static script_op_t *script_parse_function (script_scan_t *scan)
                                     "A function declaration requires a valid name");
                 return NULL;
         }
-        script_exp_t *name = script_parse_new_exp_var (curtoken->data.string, &curtoken->location);
+        script_exp_t *name = script_parse_new_exp_var (scan, curtoken->data.string, &curtoken->location);
 
         curtoken = script_scan_get_next_token (scan); /* FIXME parse any type of exp as target and do an assign*/
 
         script_function_t *function = script_parse_function_def (scan);
 
         if (!function) return NULL;
-        script_exp_t *func_exp = script_parse_new_exp_function_def (function, &location);
-        script_exp_t *func_def = script_parse_new_exp_dual (SCRIPT_EXP_TYPE_ASSIGN, name, func_exp, &location);
+        script_exp_t *func_exp = script_parse_new_exp_function_def (scan, function, &location);
+        script_exp_t *func_def = script_parse_new_exp_dual (scan, SCRIPT_EXP_TYPE_ASSIGN, name, func_exp, &location);
 
-        script_op_t *op = script_parse_new_op_exp (func_def, &location);
+        script_op_t *op = script_parse_new_op_exp (scan, func_def, &location);
 
         return op;
 }
@@ -840,7 +1003,7 @@ static script_op_t *script_parse_return (script_scan_t *scan)
         else return NULL;
         curtoken = script_scan_get_next_token (scan);
 
-        script_op_t *op = script_parse_new_op (type, &curtoken->location);
+        script_op_t *op = script_parse_new_op (scan, type, &curtoken->location);
 
         if (type == SCRIPT_OP_TYPE_RETURN) {
                 op->data.exp = script_parse_exp (scan);        /* May be NULL */
@@ -890,167 +1053,61 @@ static script_op_t *script_parse_op (script_scan_t *scan)
                 curtoken = script_scan_get_next_token (scan);
 #endif
 
-                script_op_t *op = script_parse_new_op_exp (exp, &location);
+                script_op_t *op = script_parse_new_op_exp (scan, exp, &location);
                 return op;
         }
         return NULL;
 }
 
-static ply_list_t *script_parse_op_list (script_scan_t *scan)
+static script_op_t **script_parse_op_list (script_scan_t *scan)
 {
-        ply_list_t *op_list = ply_list_new ();
+        size_t op_list_start = script_arena_start_array (scan->arena);
 
         while (true) {
                 script_op_t *op = script_parse_op (scan);
                 if (!op) break;
-                ply_list_append_data (op_list, op);
+                script_arena_append_to_array (scan->arena, op);
         }
 
-        return op_list;
+        return (script_op_t **) script_arena_finish_array (scan->arena, op_list_start);
 }
 
-static void script_parse_exp_free (script_exp_t *exp)
+void script_parse_op_free (script_op_t *op)
 {
-        if (!exp) return;
-        switch (exp->type) {
-        case SCRIPT_EXP_TYPE_PLUS:
-        case SCRIPT_EXP_TYPE_MINUS:
-        case SCRIPT_EXP_TYPE_MUL:
-        case SCRIPT_EXP_TYPE_DIV:
-        case SCRIPT_EXP_TYPE_MOD:
-        case SCRIPT_EXP_TYPE_EQ:
-        case SCRIPT_EXP_TYPE_NE:
-        case SCRIPT_EXP_TYPE_GT:
-        case SCRIPT_EXP_TYPE_GE:
-        case SCRIPT_EXP_TYPE_LT:
-        case SCRIPT_EXP_TYPE_LE:
-        case SCRIPT_EXP_TYPE_AND:
-        case SCRIPT_EXP_TYPE_OR:
-        case SCRIPT_EXP_TYPE_EXTEND:
-        case SCRIPT_EXP_TYPE_ASSIGN:
-        case SCRIPT_EXP_TYPE_ASSIGN_PLUS:
-        case SCRIPT_EXP_TYPE_ASSIGN_MINUS:
-        case SCRIPT_EXP_TYPE_ASSIGN_MUL:
-        case SCRIPT_EXP_TYPE_ASSIGN_DIV:
-        case SCRIPT_EXP_TYPE_ASSIGN_MOD:
-        case SCRIPT_EXP_TYPE_ASSIGN_EXTEND:
-        case SCRIPT_EXP_TYPE_HASH:
-                script_parse_exp_free (exp->data.dual.sub_a);
-                script_parse_exp_free (exp->data.dual.sub_b);
-                break;
-
-        case SCRIPT_EXP_TYPE_NOT:
-        case SCRIPT_EXP_TYPE_POS:
-        case SCRIPT_EXP_TYPE_NEG:
-        case SCRIPT_EXP_TYPE_PRE_INC:
-        case SCRIPT_EXP_TYPE_PRE_DEC:
-        case SCRIPT_EXP_TYPE_POST_INC:
-        case SCRIPT_EXP_TYPE_POST_DEC:
-                script_parse_exp_free (exp->data.sub);
-                break;
+        script_parse_tree_t *tree;
 
-        case SCRIPT_EXP_TYPE_TERM_NUMBER:
-        case SCRIPT_EXP_TYPE_TERM_NULL:
-        case SCRIPT_EXP_TYPE_TERM_LOCAL:
-        case SCRIPT_EXP_TYPE_TERM_GLOBAL:
-        case SCRIPT_EXP_TYPE_TERM_THIS:
-                break;
-        case SCRIPT_EXP_TYPE_TERM_SET:
-        {
-                ply_list_node_t *node;
-                for (node = ply_list_get_first_node (exp->data.parameters);
-                     node;
-                     node = ply_list_get_next_node (exp->data.parameters, node)) {
-                        script_exp_t *sub = ply_list_node_get_data (node);
-                        script_parse_exp_free (sub);
-                }
-                ply_list_free (exp->data.parameters);
-                break;
-        }
-        case SCRIPT_EXP_TYPE_FUNCTION_EXE:
-        {
-                ply_list_node_t *node;
-                for (node = ply_list_get_first_node (exp->data.function_exe.parameters);
-                     node;
-                     node = ply_list_get_next_node (exp->data.function_exe.parameters, node)) {
-                        script_exp_t *sub = ply_list_node_get_data (node);
-                        script_parse_exp_free (sub);
-                }
-                ply_list_free (exp->data.function_exe.parameters);
-                script_parse_exp_free (exp->data.function_exe.name);
-                break;
-        }
-        case SCRIPT_EXP_TYPE_FUNCTION_DEF: /* FIXME merge the frees with one from op_free */
-        {
-                if (exp->data.function_def->type == SCRIPT_FUNCTION_TYPE_SCRIPT)
-                        script_parse_op_free (exp->data.function_def->data.script);
-                ply_list_node_t *node;
-                for (node = ply_list_get_first_node (exp->data.function_def->parameters);
-                     node;
-                     node = ply_list_get_next_node (exp->data.function_def->parameters, node)) {
-                        char *arg = ply_list_node_get_data (node);
-                        free (arg);
-                }
-                ply_list_free (exp->data.function_def->parameters);
-                free (exp->data.function_def);
-                break;
-        }
+        if (!op) return;
 
-        case SCRIPT_EXP_TYPE_TERM_STRING:
-        case SCRIPT_EXP_TYPE_TERM_VAR:
-                free (exp->data.string);
-                break;
-        }
-        script_debug_remove_element (exp);
-        free (exp);
+        tree = (script_parse_tree_t *) ((char *) op - offsetof (script_parse_tree_t, root));
+        script_arena_free (tree->arena);
 }
 
-void script_parse_op_free (script_op_t *op)
+static script_op_t *script_parse_scan (script_scan_t *scan)
 {
-        if (!op) return;
-        switch (op->type) {
-        case SCRIPT_OP_TYPE_EXPRESSION:
-                script_parse_exp_free (op->data.exp);
-                break;
-
-        case SCRIPT_OP_TYPE_OP_BLOCK:
-                script_parse_op_list_free (op->data.list);
-                break;
-
-        case SCRIPT_OP_TYPE_IF:
-        case SCRIPT_OP_TYPE_WHILE:
-        case SCRIPT_OP_TYPE_DO_WHILE:
-        case SCRIPT_OP_TYPE_FOR:
-                script_parse_exp_free (op->data.cond_op.cond);
-                script_parse_op_free (op->data.cond_op.op1);
-                script_parse_op_free (op->data.cond_op.op2);
-                break;
+        script_scan_token_t *curtoken = script_scan_get_current_token (scan);
+        script_parse_tree_t *tree;
 
-        case SCRIPT_OP_TYPE_RETURN:
-                if (op->data.exp) script_parse_exp_free (op->data.exp);
-                break;
+        tree = script_arena_alloc (scan->arena, sizeof(script_parse_tree_t));
+        tree->root.type = SCRIPT_OP_TYPE_OP_BLOCK;
+        tree->root.location = curtoken->location;
+        tree->root.data.list = script_parse_op_list (scan);
 
-        case SCRIPT_OP_TYPE_FAIL:
-        case SCRIPT_OP_TYPE_BREAK:
-        case SCRIPT_OP_TYPE_CONTINUE:
-                break;
+        curtoken = script_scan_get_current_token (scan);
+        if (scan->has_error ||
+            curtoken->type != SCRIPT_SCAN_TOKEN_TYPE_EOF) {
+                if (!scan->has_error)
+                        script_parse_error (&curtoken->location,
+                                            "Unparsed characters at end of file");
+                script_scan_free (scan);
+                return NULL;
         }
-        script_debug_remove_element (op);
-        free (op);
-}
 
-static void script_parse_op_list_free (ply_list_t *op_list)
-{
-        ply_list_node_t *node;
+        /* The tree takes over the arena, and with it the interned strings */
+        tree->arena = scan->arena;
+        scan->arena = NULL;
+        script_scan_free (scan);
 
-        for (node = ply_list_get_first_node (op_list);
-             node;
-             node = ply_list_get_next_node (op_list, node)) {
-                script_op_t *op = ply_list_node_get_data (node);
-                script_parse_op_free (op);
-        }
-        ply_list_free (op_list);
-        return;
+        return &tree->root;
 }
 
 script_op_t *script_parse_file (const char *filename)
@@ -1061,24 +1118,8 @@ script_op_t *script_parse_file (const char *filename)
                 ply_error ("Parser error : Error opening file %s\n", filename);
                 return NULL;
         }
-        script_scan_token_t *curtoken = script_scan_get_current_token (scan);
-        script_debug_location_t location = curtoken->location;
-        ply_list_t *list = script_parse_op_list (scan);
 
-        curtoken = script_scan_get_current_token (scan);
-        if (scan->has_error ||
-            curtoken->type != SCRIPT_SCAN_TOKEN_TYPE_EOF) {
-                if (!scan->has_error)
-                        script_parse_error (&curtoken->location,
-                                            "Unparsed characters at end of file");
-                script_parse_op_list_free (list);
-                script_scan_free (scan);
-                return NULL;
-        }
-        script_op_t *op = script_parse_new_op_block (list, &location);
-
-        script_scan_free (scan);
-        return op;
+        return script_parse_scan (scan);
 }
 
 script_op_t *script_parse_string (const char *string,
@@ -1090,22 +1131,6 @@ script_op_t *script_parse_string (const char *string,
                 ply_error ("Parser error : Error creating a parser with a string");
                 return NULL;
         }
-        script_scan_token_t *curtoken = script_scan_get_current_token (scan);
-        script_debug_location_t location = curtoken->location;
-        ply_list_t *list = script_parse_op_list (scan);
-
-        curtoken = script_scan_get_current_token (scan);
-        if (scan->has_error ||
-            curtoken->type != SCRIPT_SCAN_TOKEN_TYPE_EOF) {
-                if (!scan->has_error)
-                        script_parse_error (&curtoken->location,
-                                            "Unparsed characters at end of file");
-                script_parse_op_list_free (list);
-                script_scan_free (scan);
-                return NULL;
-        }
-        script_op_t *op = script_parse_new_op_block (list, &location);
 
-        script_scan_free (scan);
-        return op;
+        return script_parse_scan (scan);
 }
@@ -27,6 +27,7 @@
 script_op_t *script_parse_file (const char *filename);
 script_op_t *script_parse_string (const char *string,
                                   const char *name);
+/* Frees a whole tree returned by script_parse_file or script_parse_string */
 void script_parse_op_free (script_op_t *op);
 
 #endif /* SCRIPT_PARSE_H */
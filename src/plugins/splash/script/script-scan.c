@@ -24,14 +24,18 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <assert.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <string.h>
 #include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "ply-bitarray.h"
+#include "ply-utils.h"
 #include "script-scan.h"
 
 #define COLUMN_START_INDEX 0
@@ -47,6 +51,8 @@ static script_scan_t *script_scan_new (void)
         scan->line_index = 1;           /* According to Nedit the first line is 1 but first column is 0 */
         scan->column_index = COLUMN_START_INDEX;
 
+        scan->arena = script_arena_new ();
+
         scan->identifier_1st_char = ply_bitarray_new (256);
         scan->identifier_nth_char = ply_bitarray_new (256);
 
@@ -65,6 +71,57 @@ static script_scan_t *script_scan_new (void)
         return scan;
 }
 
+static bool
+script_scan_read_file (script_scan_t *scan,
+                       int            fd)
+{
+        struct stat file_info;
+        size_t allocated_size;
+        char *data;
+
+        if (fstat (fd, &file_info) < 0)
+                return false;
+
+        if (S_ISREG (file_info.st_mode) && file_info.st_size > 0) {
+                data = mmap (NULL, file_info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data != MAP_FAILED) {
+                        scan->file_data = data;
+                        scan->file_size = file_info.st_size;
+                        scan->file_is_mapped = true;
+                        return true;
+                }
+        }
+
+        /* Not mappable (or empty, or a pipe), so read it all in */
+        allocated_size = 4096;
+        data = malloc (allocated_size);
+        scan->file_size = 0;
+
+        while (true) {
+                ssize_t bytes_read;
+
+                if (scan->file_size == allocated_size) {
+                        allocated_size *= 2;
+                        data = realloc (data, allocated_size);
+                }
+
+                bytes_read = read (fd, data + scan->file_size, allocated_size - scan->file_size);
+                if (bytes_read == 0)
+                        break;
+                if (bytes_read < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        free (data);
+                        return false;
+                }
+                scan->file_size += bytes_read;
+        }
+
+        scan->file_data = data;
+        scan->file_is_mapped = false;
+        return true;
+}
+
 script_scan_t *script_scan_file (const char *filename)
 {
         int fd = open (filename, O_RDONLY | O_CLOEXEC);
@@ -72,9 +129,16 @@ script_scan_t *script_scan_file (const char *filename)
         if (fd < 0) return NULL;
         script_scan_t *scan = script_scan_new ();
 
-        scan->name = strdup (filename);
-        scan->source.fd = fd;
-        scan->source_is_file = true;
+        if (!script_scan_read_file (scan, fd)) {
+                close (fd);
+                script_scan_free (scan);
+                return NULL;
+        }
+        close (fd);
+
+        scan->name = script_arena_intern_string (scan->arena, filename);
+        scan->source = scan->file_data;
+        scan->source_end = scan->source + scan->file_size;
         script_scan_get_next_char (scan);
         return scan;
 }
@@ -84,29 +148,16 @@ script_scan_t *script_scan_string (const char *string,
 {
         script_scan_t *scan = script_scan_new ();
 
-        scan->name = strdup (name);
-        scan->source.string = string;
-        scan->source_is_file = false;
+        scan->name = script_arena_intern_string (scan->arena, name);
+        scan->source = string;
+        scan->source_end = string + strlen (string);
         script_scan_get_next_char (scan);
         return scan;
 }
 
+/* Token strings belong to the scan's arena, so there's nothing to free */
 void script_scan_token_clean (script_scan_token_t *token)
 {
-        switch (token->type) {
-        case SCRIPT_SCAN_TOKEN_TYPE_EMPTY:
-        case SCRIPT_SCAN_TOKEN_TYPE_EOF:
-        case SCRIPT_SCAN_TOKEN_TYPE_INTEGER:
-        case SCRIPT_SCAN_TOKEN_TYPE_FLOAT:
-        case SCRIPT_SCAN_TOKEN_TYPE_SYMBOL:
-                break;
-        case SCRIPT_SCAN_TOKEN_TYPE_IDENTIFIER:
-        case SCRIPT_SCAN_TOKEN_TYPE_STRING:
-        case SCRIPT_SCAN_TOKEN_TYPE_COMMENT:
-        case SCRIPT_SCAN_TOKEN_TYPE_ERROR:
-                free (token->data.string);
-                break;
-        }
         token->type = SCRIPT_SCAN_TOKEN_TYPE_EMPTY;
         token->whitespace = 0;
 }
@@ -115,14 +166,18 @@ void script_scan_free (script_scan_t *scan)
 {
         int i;
 
-        if (scan->source_is_file) close (scan->source.fd);
+        if (scan->file_is_mapped)
+                munmap (scan->file_data, scan->file_size);
+        else
+                free (scan->file_data);
         for (i = 0; i < scan->tokencount; i++) {
                 script_scan_token_clean (scan->tokens[i]);
                 free (scan->tokens[i]);
         }
         ply_bitarray_free (scan->identifier_1st_char);
         ply_bitarray_free (scan->identifier_nth_char);
-        free (scan->name);
+        script_arena_free (scan->arena);
+        free (scan->text);
         free (scan->tokens);
         free (scan);
 }
@@ -140,16 +195,40 @@ unsigned char script_scan_get_next_char (script_scan_t *scan)
         } else if (scan->cur_char != '\0') {
                 scan->column_index++;
         }
-        if (scan->source_is_file) {
-                int got = read (scan->source.fd, &scan->cur_char, 1);
-                if (!got) scan->cur_char = 0;          /* FIXME a better way of doing EOF etc */
-        } else {
-                scan->cur_char = *scan->source.string;
-                if (scan->cur_char) scan->source.string++;
-        }
+        if (scan->source < scan->source_end)
+                scan->cur_char = *scan->source++;
+        else
+                scan->cur_char = '\0';
         return scan->cur_char;
 }
 
+static void script_scan_text_append (script_scan_t *scan,
+                                     unsigned char  character)
+{
+        if (scan->text_length + 2 > scan->text_size) {
+                scan->text_size = MAX (scan->text_size * 2, 64);
+                scan->text = realloc (scan->text, scan->text_size);
+        }
+        scan->text[scan->text_length++] = character;
+        scan->text[scan->text_length] = '\0';
+}
+
+static char *script_scan_text_finish (script_scan_t *scan)
+{
+        const char *text = scan->text_length > 0 ? scan->text : "";
+
+        scan->text_length = 0;
+        return script_arena_intern_string (scan->arena, text);
+}
+
+static void script_scan_set_error (script_scan_t       *scan,
+                                   script_scan_token_t *token,
+                                   const char          *message)
+{
+        token->type = SCRIPT_SCAN_TOKEN_TYPE_ERROR;
+        token->data.string = script_arena_intern_string (scan->arena, message);
+}
+
 void script_scan_read_next_token (script_scan_t       *scan,
                                   script_scan_token_t *token)
 {
@@ -181,20 +260,14 @@ void script_scan_read_next_token (script_scan_t       *scan,
         nextchar = script_scan_get_next_char (scan);
 
         if (ply_bitarray_lookup (scan->identifier_1st_char, curchar)) {
-                int index = 1;
                 token->type = SCRIPT_SCAN_TOKEN_TYPE_IDENTIFIER;
-                token->data.string = malloc (2 * sizeof(char));
-                token->data.string[0] = curchar;
-                token->data.string[1] = '\0';
+                script_scan_text_append (scan, curchar);
                 curchar = nextchar;
                 while (ply_bitarray_lookup (scan->identifier_nth_char, curchar)) {
-                        token->data.string = realloc (token->data.string,
-                                                      (index + 2) * sizeof(char));
-                        token->data.string[index] = curchar;
-                        token->data.string[index + 1] = '\0';
-                        index++;
+                        script_scan_text_append (scan, curchar);
                         curchar = script_scan_get_next_char (scan);
                 }
+                token->data.string = script_scan_text_finish (scan);
                 return;
         }
         if ((curchar >= '0') && (curchar <= '9')) {
@@ -216,8 +289,7 @@ void script_scan_read_next_token (script_scan_t       *scan,
                 }
 
                 if (!integer_is_in_range) {
-                        token->type = SCRIPT_SCAN_TOKEN_TYPE_ERROR;
-                        token->data.string = strdup ("Integer literal is out of range");
+                        script_scan_set_error (scan, token, "Integer literal is out of range");
                         return;
                 }
 
@@ -245,22 +317,17 @@ void script_scan_read_next_token (script_scan_t       *scan,
         }
         if (curchar == '\"') {
                 token->type = SCRIPT_SCAN_TOKEN_TYPE_STRING;
-                int index = 0;
-                token->data.string = malloc (sizeof(char));
-                token->data.string[0] = '\0';
                 curchar = nextchar;
 
                 while (curchar != '\"') {
                         if (curchar == '\0') {
-                                free (token->data.string);
-                                token->data.string = strdup ("End of file before end of string");
-                                token->type = SCRIPT_SCAN_TOKEN_TYPE_ERROR;
+                                scan->text_length = 0;
+                                script_scan_set_error (scan, token, "End of file before end of string");
                                 return;
                         }
                         if (curchar == '\n') {
-                                free (token->data.string);
-                                token->data.string = strdup ("Line terminator before end of string");
-                                token->type = SCRIPT_SCAN_TOKEN_TYPE_ERROR;
+                                scan->text_length = 0;
+                                script_scan_set_error (scan, token, "Line terminator before end of string");
                                 return;
                         }
                         if (curchar == '\\') {
@@ -286,13 +353,10 @@ void script_scan_read_next_token (script_scan_t       *scan,
                                         break;
                                 }
                         }
-                        token->data.string = realloc (token->data.string,
-                                                      (index + 2) * sizeof(char));
-                        token->data.string[index] = curchar;
-                        token->data.string[index + 1] = '\0';
-                        index++;
+                        script_scan_text_append (scan, curchar);
                         curchar = script_scan_get_next_char (scan);
                 }
+                token->data.string = script_scan_text_finish (scan);
                 script_scan_get_next_char (scan);
                 return;
         }
@@ -303,38 +367,26 @@ void script_scan_read_next_token (script_scan_t       *scan,
                         linecomment = true;
                         nextchar = script_scan_get_next_char (scan);
                 }
+                /* Comments are skipped, so their text isn't kept */
                 if (linecomment) {
-                        int index = 0;
-                        token->data.string = malloc (sizeof(char));
-                        token->data.string[0] = '\0';
-                        curchar = nextchar;
                         for (curchar = nextchar;
                              curchar != '\n' && curchar != '\0';
                              curchar = script_scan_get_next_char (scan)) {
-                                token->data.string = realloc (token->data.string,
-                                                              (index + 2) * sizeof(char));
-                                token->data.string[index] = curchar;
-                                token->data.string[index + 1] = '\0';
-                                index++;
                         }
                         token->type = SCRIPT_SCAN_TOKEN_TYPE_COMMENT;
+                        token->data.string = NULL;
                         return;
                 }
         }
 
         if ((curchar == '/') && (nextchar == '*')) {
-                int index = 0;
                 int depth = 1;
-                token->data.string = malloc (sizeof(char));
-                token->data.string[0] = '\0';
                 curchar = script_scan_get_next_char (scan);
                 nextchar = script_scan_get_next_char (scan);
 
                 while (true) {
                         if (nextchar == '\0') {
-                                free (token->data.string);
-                                token->data.string = strdup ("End of file before end of comment");
-                                token->type = SCRIPT_SCAN_TOKEN_TYPE_ERROR;
+                                script_scan_set_error (scan, token, "End of file before end of comment");
                                 return;
                         }
                         if ((curchar == '/') && (nextchar == '*'))
@@ -343,16 +395,12 @@ void script_scan_read_next_token (script_scan_t       *scan,
                                 depth--;
                                 if (!depth) break;
                         }
-                        token->data.string = realloc (token->data.string,
-                                                      (index + 2) * sizeof(char));
-                        token->data.string[index] = curchar;
-                        token->data.string[index + 1] = '\0';
-                        index++;
                         curchar = nextchar;
                         nextchar = script_scan_get_next_char (scan);
                 }
                 script_scan_get_next_char (scan);
                 token->type = SCRIPT_SCAN_TOKEN_TYPE_COMMENT;
+                token->data.string = NULL;
                 return;
         }
         /* all other */
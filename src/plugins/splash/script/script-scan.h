@@ -22,9 +22,11 @@
 #ifndef SCRIPT_SCAN_H
 #define SCRIPT_SCAN_H
 
+#include "script-arena.h"
 #include "script-debug.h"
 #include "ply-bitarray.h"
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef enum
 {
@@ -55,11 +57,14 @@ typedef struct
 
 typedef struct
 {
-        union
-        {
-                int         fd;
-                const char *string;
-        } source;
+        const char           *source;
+        const char           *source_end;
+        void                 *file_data;
+        size_t                file_size;
+        script_arena_t       *arena;
+        char                 *text;
+        size_t                text_length;
+        size_t                text_size;
         char                 *name;
         unsigned char         cur_char;
         ply_bitarray_t       *identifier_1st_char;
@@ -68,7 +73,7 @@ typedef struct
         script_scan_token_t **tokens;
         int                   line_index;
         int                   column_index;
-        bool                  source_is_file;
+        bool                  file_is_mapped;
         bool                  has_error;
 } script_scan_t;
 
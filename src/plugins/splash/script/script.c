@@ -39,30 +39,17 @@
 #include "script-parse.h"
 #include "script-object.h"
 
-script_function_t *script_function_script_new (script_op_t *script,
-                                               void        *user_data,
-                                               ply_list_t  *parameter_list)
-{
-        script_function_t *function = malloc (sizeof(script_function_t));
-
-        function->type = SCRIPT_FUNCTION_TYPE_SCRIPT;
-        function->parameters = parameter_list;
-        function->data.script = script;
-        function->freeable = false;
-        function->user_data = user_data;
-        return function;
-}
-
 script_function_t *script_function_native_new (script_native_function_t native_function,
                                                void                    *user_data,
-                                               ply_list_t              *parameter_list)
+                                               char                   **parameters)
 {
         script_function_t *function = malloc (sizeof(script_function_t));
 
         function->type = SCRIPT_FUNCTION_TYPE_NATIVE;
-        function->parameters = parameter_list;
+        function->parameters = parameters;
         function->data.native = native_function;
         function->freeable = true;
+        function->uses_args = false;
         function->user_data = user_data;
         return function;
 }
@@ -76,19 +63,26 @@ void script_add_native_function (script_obj_t            *hash,
 {
         va_list args;
         const char *arg;
-        ply_list_t *parameter_list = ply_list_new ();
+        char **parameters;
+        int count = 0;
 
-        arg = first_arg;
         va_start (args, first_arg);
-        while (arg) {
-                ply_list_append_data (parameter_list, strdup (arg));
-                arg = va_arg (args, const char *);
+        for (arg = first_arg; arg; arg = va_arg (args, const char *)) {
+                count++;
+        }
+        va_end (args);
+
+        parameters = calloc (count + 1, sizeof(char *));
+        count = 0;
+        va_start (args, first_arg);
+        for (arg = first_arg; arg; arg = va_arg (args, const char *)) {
+                parameters[count++] = strdup (arg);
         }
         va_end (args);
 
         script_function_t *function = script_function_native_new (native_function,
                                                                   user_data,
-                                                                  parameter_list);
+                                                                  parameters);
         script_obj_t *obj = script_obj_new_function (function);
 
         script_obj_hash_add_element (hash, obj, name);
@@ -124,6 +118,9 @@ script_state_t *script_state_new (void *user_data)
         state->local = script_obj_new_ref (global_hash);
         state->this = script_obj_new_null ();
         state->user_data = user_data;
+        state->function = NULL;
+        state->arguments = NULL;
+        state->number_of_arguments = 0;
         return state;
 }
 
@@ -139,6 +136,9 @@ script_state_t *script_state_init_sub (script_state_t *oldstate,
         if (this) newstate->this = script_obj_new_ref (this);
         else newstate->this = script_obj_new_ref (oldstate->this);
         newstate->user_data = oldstate->user_data;
+        newstate->function = NULL;
+        newstate->arguments = NULL;
+        newstate->number_of_arguments = 0;
         return newstate;
 }
 
@@ -149,3 +149,54 @@ void script_state_destroy (script_state_t *state)
         script_obj_unref (state->this);
         free (state);
 }
+
+/* Natives get their arguments straight from the caller, matched up with the
+ * parameter names they were registered with.
+ */
+script_obj_t *script_state_peek_argument (script_state_t *state,
+                                          const char     *name)
+{
+        script_obj_t *obj;
+        int index;
+
+        if (!state->function) return NULL;
+
+        for (index = 0; index < state->number_of_arguments; index++) {
+                if (!state->function->parameters[index]) break;
+                if (strcmp (state->function->parameters[index], name)) continue;
+
+                obj = script_obj_deref_direct (state->arguments[index]);
+                script_obj_ref (obj);
+                return obj;
+        }
+        return NULL;
+}
+
+script_obj_t *script_state_get_argument (script_state_t *state,
+                                         const char     *name)
+{
+        script_obj_t *obj = script_state_peek_argument (state, name);
+
+        if (obj) return obj;
+        return script_obj_new_shared_null ();
+}
+
+script_number_t script_state_get_argument_number (script_state_t *state,
+                                                  const char     *name)
+{
+        script_obj_t *obj = script_state_get_argument (state, name);
+        script_number_t reply = script_obj_as_number (obj);
+
+        script_obj_unref (obj);
+        return reply;
+}
+
+char *script_state_get_argument_string (script_state_t *state,
+                                        const char     *name)
+{
+        script_obj_t *obj = script_state_get_argument (state, name);
+        char *reply = script_obj_as_string (obj);
+
+        script_obj_unref (obj);
+        return reply;
+}
@@ -24,6 +24,7 @@
 
 #include "ply-hashtable.h"
 #include "ply-list.h"
+#include "script-debug.h"
 #include <stdbool.h>
 
 typedef enum                        /* FIXME add _t to all types */
@@ -45,10 +46,15 @@ typedef struct
 
 typedef struct
 {
-        void                *user_data;
-        struct script_obj_t *global;
-        struct script_obj_t *local;
-        struct script_obj_t *this;
+        void                     *user_data;
+        struct script_obj_t      *global;
+        struct script_obj_t      *local;
+        struct script_obj_t      *this;
+
+        /* Set while a native function runs, see script_state_get_argument () */
+        struct script_function_t *function;
+        struct script_obj_t     **arguments;
+        int                       number_of_arguments;
 } script_state_t;
 
 typedef enum
@@ -63,7 +69,7 @@ typedef script_return_t (*script_native_function_t)(script_state_t *,
 typedef struct script_function_t
 {
         script_function_type_t type;
-        ply_list_t            *parameters; /*  list of char* typedef names */
+        char                 **parameters; /* NULL terminated names */
         void                  *user_data;
         union
         {
@@ -71,6 +77,7 @@ typedef struct script_function_t
                 struct script_op_t      *script;
         } data;
         bool                   freeable;
+        bool                   uses_args; /* Needs the _args hash built for it */
 } script_function_t;
 
 typedef void (*script_obj_function_t)(struct script_obj_t *);
@@ -106,6 +113,7 @@ typedef struct script_obj_t
 {
         script_obj_type_t type;
         int               refcount;
+        bool              immutable;
         union
         {
                 script_number_t      number;
@@ -177,15 +185,16 @@ typedef struct script_exp_t
                 } dual;
                 struct script_exp_t *sub;
                 char                *string;
-                script_number_t      number;
+                struct script_obj_t *literal;
                 struct
                 {
-                        struct script_exp_t *name;
-                        ply_list_t          *parameters;
+                        struct script_exp_t  *name;
+                        struct script_exp_t **parameters;
                 } function_exe;
-                ply_list_t          *parameters;
-                script_function_t   *function_def;
+                struct script_exp_t **parameters;
+                script_function_t    *function_def;
         } data;
+        script_debug_location_t location;
 } script_exp_t;
 
 typedef enum
@@ -207,8 +216,8 @@ typedef struct script_op_t
         script_op_type_t type;
         union
         {
-                script_exp_t *exp;
-                ply_list_t   *list;
+                script_exp_t        *exp;
+                struct script_op_t **list;
                 struct
                 {
                         script_exp_t       *cond;
@@ -216,6 +225,7 @@ typedef struct script_op_t
                         struct script_op_t *op2;
                 } cond_op;
         } data;
+        script_debug_location_t location;
 } script_op_t;
 
 typedef struct
@@ -233,12 +243,9 @@ typedef struct
 #define script_return_break() ((script_return_t) { SCRIPT_RETURN_TYPE_BREAK, NULL })
 #define script_return_continue() ((script_return_t) { SCRIPT_RETURN_TYPE_CONTINUE, NULL })
 
-script_function_t *script_function_script_new (script_op_t *script,
-                                               void        *user_data,
-                                               ply_list_t  *parameter_list);
 script_function_t *script_function_native_new (script_native_function_t native_function,
                                                void                    *user_data,
-                                               ply_list_t              *parameter_list);
+                                               char                   **parameters);
 void script_add_native_function (script_obj_t            *hash,
                                  const char              *name,
                                  script_native_function_t native_function,
@@ -254,4 +261,13 @@ script_state_t *script_state_new (void *user_data);
 script_state_t *script_state_init_sub (script_state_t * oldstate, script_obj_t * this);
 void script_state_destroy (script_state_t *state);
 
+script_obj_t *script_state_peek_argument (script_state_t *state,
+                                          const char     *name);
+script_obj_t *script_state_get_argument (script_state_t *state,
+                                         const char     *name);
+script_number_t script_state_get_argument_number (script_state_t *state,
+                                                  const char     *name);
+char *script_state_get_argument_string (script_state_t *state,
+                                        const char     *name);
+
 #endif /* SCRIPT_H */
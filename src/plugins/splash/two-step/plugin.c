@@ -93,25 +93,34 @@ typedef enum
 
 typedef struct
 {
-        ply_boot_splash_plugin_t *plugin;
-        ply_pixel_display_t      *display;
-        ply_entry_t              *entry;
-        ply_keymap_icon_t        *keymap_icon;
-        ply_capslock_icon_t      *capslock_icon;
-        ply_animation_t          *end_animation;
-        ply_progress_animation_t *progress_animation;
-        ply_progress_bar_t       *progress_bar;
-        ply_throbber_t           *throbber;
-        ply_label_t              *label;
-        ply_label_t              *message_label;
-        ply_label_t              *title_label;
-        ply_label_t              *subtitle_label;
-        ply_rectangle_t           box_area, lock_area, watermark_area, dialog_area, secure_boot_area;
-        ply_trigger_t            *end_trigger;
-        ply_pixel_buffer_t       *background_buffer;
-        int                       animation_bottom;
-
-        ply_console_viewer_t     *console_viewer;
+        ply_boot_splash_plugin_t      *plugin;
+        ply_pixel_display_t           *display;
+        ply_entry_t                   *entry;
+        ply_keymap_icon_t             *keymap_icon;
+        ply_capslock_icon_t           *capslock_icon;
+        ply_animation_t               *end_animation;
+        ply_progress_animation_t      *progress_animation;
+        ply_progress_bar_t            *progress_bar;
+        ply_throbber_t                *throbber;
+        ply_label_t                   *label;
+        ply_label_t                   *message_label;
+        ply_label_t                   *title_label;
+        ply_label_t                   *subtitle_label;
+        ply_rectangle_t                box_area, lock_area, watermark_area, dialog_area, secure_boot_area;
+        ply_trigger_t                 *end_trigger;
+        ply_pixel_buffer_t            *background_buffer;
+        int                            animation_bottom;
+
+        /* Static background layers (gradient, firmware background,
+         * watermark and secure boot warning) rendered once per mode,
+         * state and size, so redraws only need to copy the damaged area.
+         */
+        ply_pixel_buffer_t            *background_cache;
+        ply_boot_splash_mode_t         background_cache_mode;
+        ply_boot_splash_display_type_t background_cache_state;
+        uint32_t                       background_cache_shows_console_messages : 1;
+
+        ply_console_viewer_t          *console_viewer;
 } view_t;
 
 typedef struct
@@ -305,6 +314,8 @@ view_free (view_t *view)
         if (view->background_buffer != NULL)
                 ply_pixel_buffer_free (view->background_buffer);
 
+        ply_pixel_buffer_free (view->background_cache);
+
         free (view);
 }
 
@@ -591,6 +602,9 @@ view_load (view_t *view)
                 ply_pixel_display_get_renderer_head (view->display));
         screen_scale = ply_pixel_buffer_get_device_scale (buffer);
 
+        ply_pixel_buffer_free (view->background_cache);
+        view->background_cache = NULL;
+
         view_set_bgrt_background (view);
 
         if (!view->background_buffer && plugin->background_bgrt_fallback_image != NULL)
@@ -612,7 +626,14 @@ view_load (view_t *view)
                                                               plugin->background_start_color);
 
                 if (plugin->background_image_is_scaled) {
-                        buffer = ply_pixel_buffer_resize (ply_image_get_buffer (plugin->background_image), screen_width, screen_height);
+                        ply_pixel_buffer_t *image_buffer = ply_image_get_buffer (plugin->background_image);
+
+                        /* Bilinear sampling skips most source pixels on large downscales, so average them instead */
+                        if (ply_pixel_buffer_get_width (image_buffer) >= 2 * screen_width &&
+                            ply_pixel_buffer_get_height (image_buffer) >= 2 * screen_height)
+                                buffer = ply_pixel_buffer_resize_area (image_buffer, screen_width, screen_height);
+                        else
+                                buffer = ply_pixel_buffer_resize (image_buffer, screen_width, screen_height);
                 } else {
                         buffer = ply_pixel_buffer_tile (ply_image_get_buffer (plugin->background_image), screen_width, screen_height);
                 }
@@ -1550,15 +1571,10 @@ detach_from_event_loop (ply_boot_splash_plugin_t *plugin)
 }
 
 static void
-draw_background (view_t             *view,
-                 ply_pixel_buffer_t *pixel_buffer,
-                 int                 x,
-                 int                 y,
-                 int                 width,
-                 int                 height)
+view_render_background (view_t             *view,
+                        ply_pixel_buffer_t *pixel_buffer)
 {
         ply_boot_splash_plugin_t *plugin;
-        ply_rectangle_t area;
         bool use_black_background = false;
         bool using_fw_background;
 
@@ -1566,11 +1582,6 @@ draw_background (view_t             *view,
 
         using_fw_background = (plugin->background_bgrt_image || plugin->background_bgrt_fallback_image);
 
-        area.x = x;
-        area.y = y;
-        area.width = width;
-        area.height = height;
-
         /* When using the firmware logo as background and we should not use
          * it for this mode, use solid black as background.
          */
@@ -1586,21 +1597,26 @@ draw_background (view_t             *view,
             using_fw_background && plugin->dialog_clears_firmware_background)
                 use_black_background = true;
 
-        if (use_black_background)
-                ply_pixel_buffer_fill_with_hex_color (pixel_buffer, &area, 0);
-        else if (view->background_buffer != NULL)
-                ply_pixel_buffer_fill_with_buffer (pixel_buffer, view->background_buffer, 0, 0);
-        else if (plugin->background_start_color != plugin->background_end_color)
-                ply_pixel_buffer_fill_with_gradient (pixel_buffer, &area,
-                                                     plugin->background_start_color,
-                                                     plugin->background_end_color);
-        else
-                ply_pixel_buffer_fill_with_hex_color (pixel_buffer, &area,
-                                                      plugin->background_start_color);
+        /* Start from solid black so the result is opaque even if the
+         * theme's colors are not
+         */
+        ply_pixel_buffer_fill_with_hex_color (pixel_buffer, NULL, 0);
 
-        if (plugin->should_show_console_messages && use_black_background == false) {
-                ply_pixel_buffer_fill_with_hex_color (pixel_buffer, &area, plugin->console_background_color);
-                return;
+        if (!use_black_background) {
+                if (view->background_buffer != NULL)
+                        ply_pixel_buffer_fill_with_buffer (pixel_buffer, view->background_buffer, 0, 0);
+                else if (plugin->background_start_color != plugin->background_end_color)
+                        ply_pixel_buffer_fill_with_gradient (pixel_buffer, NULL,
+                                                             plugin->background_start_color,
+                                                             plugin->background_end_color);
+                else
+                        ply_pixel_buffer_fill_with_hex_color (pixel_buffer, NULL,
+                                                              plugin->background_start_color);
+
+                if (plugin->should_show_console_messages) {
+                        ply_pixel_buffer_fill_with_hex_color (pixel_buffer, NULL, plugin->console_background_color);
+                        return;
+                }
         }
 
         if (plugin->watermark_image != NULL) {
@@ -1618,6 +1634,76 @@ draw_background (view_t             *view,
         }
 }
 
+static bool
+view_background_cache_is_valid (view_t *view)
+{
+        ply_boot_splash_plugin_t *plugin = view->plugin;
+
+        if (view->background_cache == NULL)
+                return false;
+
+        if (view->background_cache_mode != plugin->mode ||
+            view->background_cache_state != plugin->state ||
+            view->background_cache_shows_console_messages != plugin->should_show_console_messages)
+                return false;
+
+        if (ply_pixel_buffer_get_width (view->background_cache) != ply_pixel_display_get_width (view->display) ||
+            ply_pixel_buffer_get_height (view->background_cache) != ply_pixel_display_get_height (view->display) ||
+            ply_pixel_buffer_get_device_scale (view->background_cache) != ply_pixel_display_get_device_scale (view->display))
+                return false;
+
+        return true;
+}
+
+static ply_pixel_buffer_t *
+view_get_background (view_t *view)
+{
+        ply_boot_splash_plugin_t *plugin = view->plugin;
+        unsigned long screen_width, screen_height;
+        int screen_scale;
+
+        if (view_background_cache_is_valid (view))
+                return view->background_cache;
+
+        screen_width = ply_pixel_display_get_width (view->display);
+        screen_height = ply_pixel_display_get_height (view->display);
+        screen_scale = ply_pixel_display_get_device_scale (view->display);
+
+        ply_trace ("rendering %lux%lu background cache", screen_width, screen_height);
+
+        ply_pixel_buffer_free (view->background_cache);
+        view->background_cache = ply_pixel_buffer_new (screen_width * screen_scale,
+                                                       screen_height * screen_scale);
+        ply_pixel_buffer_set_device_scale (view->background_cache, screen_scale);
+
+        view_render_background (view, view->background_cache);
+
+        /* Everything is drawn on top of solid black, so the cache can be
+         * copied to the screen without blending
+         */
+        ply_pixel_buffer_set_opaque (view->background_cache, true);
+
+        view->background_cache_mode = plugin->mode;
+        view->background_cache_state = plugin->state;
+        view->background_cache_shows_console_messages = plugin->should_show_console_messages;
+
+        return view->background_cache;
+}
+
+static void
+draw_background (view_t             *view,
+                 ply_pixel_buffer_t *pixel_buffer,
+                 int                 x,
+                 int                 y,
+                 int                 width,
+                 int                 height)
+{
+        /* The pixel display clips drawing to the damaged area, so this only
+         * copies the part of the cached background that needs repainting.
+         */
+        ply_pixel_buffer_fill_with_buffer (pixel_buffer, view_get_background (view), 0, 0);
+}
+
 static void
 on_draw (view_t             *view,
          ply_pixel_buffer_t *pixel_buffer,
@@ -0,0 +1,536 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Runs the insert, lookup and remove mixes that script execution puts
+ * on its object tables through ply_hashtable_t and through the hash
+ * table code from before its hashes were mixed, and reports the total
+ * time each takes.
+ *
+ *   benchmark-hashtable [-n ROUNDS]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ply-bitarray.h"
+#include "ply-hashtable.h"
+#include "ply-utils.h"
+
+#define DEFAULT_ROUNDS 50
+
+#define NUMBER_OF_KEYS 20000
+
+/* The old implementation, unchanged apart from the names */
+typedef struct _old_hashtable old_hashtable_t;
+
+static void old_hashtable_resize (old_hashtable_t *hashtable);
+
+#define MASKGEN(x) { x |= x >> 16; x |= x >> 8; x |= x >> 4; x |= x >> 2;  x |= x >> 1; }
+
+struct _old_hashtable_node
+{
+        void *data;
+        void *key;
+};
+
+struct _old_hashtable
+{
+        struct _old_hashtable_node   *nodes;
+        unsigned int                  total_node_count; /* must be a 2^X */
+        ply_bitarray_t               *dirty_node_bitmap;
+        unsigned int                  dirty_node_count; /* live + dead nodes */
+        ply_bitarray_t               *live_node_bitmap;
+        unsigned int                  live_node_count;
+        ply_hashtable_compare_func_t *compare_func;
+        ply_hashtable_hash_func_t    *hash_func;
+};
+
+static unsigned int
+old_hashtable_direct_hash (void *element)
+{
+        return (unsigned int) (intptr_t) element;
+}
+
+static int
+old_hashtable_direct_compare (void *elementa,
+                              void *elementb)
+{
+        return (int) ((intptr_t) elementa - (intptr_t) elementb);
+}
+
+static unsigned int
+old_hashtable_string_hash (void *element)
+{
+        char *strptr;
+        unsigned int hash = 0;
+
+        for (strptr = element; *strptr; strptr++) {
+                hash ^= *strptr;
+                hash ^= hash << 1;
+        }
+        return hash;
+}
+
+static int
+old_hashtable_string_compare (void *elementa,
+                              void *elementb)
+{
+        return strcmp (elementa, elementb);
+}
+
+static old_hashtable_t *
+old_hashtable_new (ply_hashtable_hash_func_t    *hash_func,
+                   ply_hashtable_compare_func_t *compare_func)
+{
+        old_hashtable_t *hashtable;
+
+        hashtable = malloc (sizeof(old_hashtable_t));
+        hashtable->total_node_count = 0;
+        hashtable->dirty_node_count = 0;
+        hashtable->live_node_count = 0;
+        hashtable->nodes = NULL;
+        hashtable->dirty_node_bitmap = NULL;
+        hashtable->live_node_bitmap = NULL;
+        hashtable->compare_func = compare_func;
+        hashtable->hash_func = hash_func;
+
+        if (hashtable->compare_func == NULL)
+                hashtable->compare_func = old_hashtable_direct_compare;
+        if (hashtable->hash_func == NULL)
+                hashtable->hash_func = old_hashtable_direct_hash;
+        old_hashtable_resize (hashtable);
+        return hashtable;
+}
+
+static void
+old_hashtable_free (old_hashtable_t *hashtable)
+{
+        if (hashtable == NULL) return;
+        ply_bitarray_free (hashtable->dirty_node_bitmap);
+        ply_bitarray_free (hashtable->live_node_bitmap);
+        free (hashtable->nodes);
+        free (hashtable);
+}
+
+static void
+old_hashtable_insert_internal (old_hashtable_t *hashtable,
+                               void            *key,
+                               void            *data)
+{
+        unsigned int hash_index;
+        int step = 0;
+
+        hash_index = hashtable->hash_func (key);
+        hash_index &= hashtable->total_node_count - 1;
+
+        while (ply_bitarray_lookup (hashtable->dirty_node_bitmap, hash_index)) {
+                step++;
+                hash_index += step;
+                hash_index &= hashtable->total_node_count - 1;
+        }
+        ply_bitarray_set (hashtable->dirty_node_bitmap, hash_index);
+        ply_bitarray_set (hashtable->live_node_bitmap, hash_index);
+        hashtable->nodes[hash_index].key = key;
+        hashtable->nodes[hash_index].data = data;
+
+        hashtable->live_node_count++;
+        hashtable->dirty_node_count++;
+}
+
+static void
+old_hashtable_resize (old_hashtable_t *hashtable)
+{
+        unsigned int newsize, oldsize;
+        unsigned int i;
+        struct _old_hashtable_node *oldnodes;
+        ply_bitarray_t *old_live_node_bitmap;
+
+        newsize = (hashtable->live_node_count + 1) * 4; /* make table 4x to 8x the number of live elements (at least 8) */
+        MASKGEN (newsize);
+        newsize++;
+        oldsize = hashtable->total_node_count;
+        oldnodes = hashtable->nodes;
+
+        hashtable->total_node_count = newsize;
+        hashtable->nodes = malloc (newsize * sizeof(struct _old_hashtable_node));
+        ply_bitarray_free (hashtable->dirty_node_bitmap);
+        hashtable->dirty_node_bitmap = ply_bitarray_new (newsize);
+        old_live_node_bitmap = hashtable->live_node_bitmap;
+        hashtable->live_node_bitmap = ply_bitarray_new (newsize);
+        hashtable->dirty_node_count = 0;
+        hashtable->live_node_count = 0;
+
+        for (i = 0; i < oldsize; i++) {
+                if (ply_bitarray_lookup (old_live_node_bitmap, i))
+                        old_hashtable_insert_internal (hashtable, oldnodes[i].key, oldnodes[i].data);
+        }
+        ply_bitarray_free (old_live_node_bitmap);
+        free (oldnodes);
+}
+
+static inline void
+old_hashtable_resize_check (old_hashtable_t *hashtable)
+{
+        if (hashtable->total_node_count < (hashtable->dirty_node_count * 2))
+                old_hashtable_resize (hashtable); /* hash tables work best below 50% occupancy */
+}
+
+static void
+old_hashtable_insert (old_hashtable_t *hashtable,
+                      void            *key,
+                      void            *data)
+{
+        old_hashtable_resize_check (hashtable);
+        old_hashtable_insert_internal (hashtable, key, data);
+}
+
+static int
+old_hashtable_lookup_index (old_hashtable_t *hashtable,
+                            void            *key)
+{
+        unsigned int hash_index;
+        int step = 0;
+
+        hash_index = hashtable->hash_func (key);
+        while (1) {
+                hash_index &= hashtable->total_node_count - 1;
+                if (!ply_bitarray_lookup (hashtable->dirty_node_bitmap, hash_index))
+                        break;
+                if (ply_bitarray_lookup (hashtable->live_node_bitmap, hash_index))
+                        if (!hashtable->compare_func (hashtable->nodes[hash_index].key, key))
+                                return hash_index;
+                hash_index += step;
+                step++;
+        }
+        return -1;
+}
+
+static void *
+old_hashtable_remove (old_hashtable_t *hashtable,
+                      void            *key)
+{
+        int index;
+
+        index = old_hashtable_lookup_index (hashtable, key);
+        if (index < 0)
+                return NULL;
+
+        ply_bitarray_clear (hashtable->live_node_bitmap, index);
+        hashtable->live_node_count--;
+        return hashtable->nodes[index].data;
+}
+
+static void *
+old_hashtable_lookup (old_hashtable_t *hashtable,
+                      void            *key)
+{
+        int index;
+
+        index = old_hashtable_lookup_index (hashtable, key);
+        if (index < 0)
+                return NULL;
+        return hashtable->nodes[index].data;
+}
+
+/* Both implementations behind the same calls, so each mix below is
+ * only written once
+ */
+typedef struct
+{
+        void *(*new)(bool has_string_keys);
+        void  (*free)(void *hashtable);
+        void  (*insert)(void *hashtable,
+                        void *key,
+                        void *data);
+        void *(*remove)(void *hashtable,
+                        void *key);
+        void *(*lookup)(void *hashtable,
+                        void *key);
+} hashtable_implementation_t;
+
+static void *
+new_hashtable (bool has_string_keys)
+{
+        if (has_string_keys)
+                return ply_hashtable_new (ply_hashtable_string_hash,
+                                          ply_hashtable_string_compare);
+
+        return ply_hashtable_new (NULL, NULL);
+}
+
+static void
+free_hashtable (void *hashtable)
+{
+        ply_hashtable_free (hashtable);
+}
+
+static void
+insert_into_hashtable (void *hashtable,
+                       void *key,
+                       void *data)
+{
+        ply_hashtable_insert (hashtable, key, data);
+}
+
+static void *
+remove_from_hashtable (void *hashtable,
+                       void *key)
+{
+        return ply_hashtable_remove (hashtable, key);
+}
+
+static void *
+look_up_in_hashtable (void *hashtable,
+                      void *key)
+{
+        return ply_hashtable_lookup (hashtable, key);
+}
+
+static void *
+new_old_hashtable (bool has_string_keys)
+{
+        if (has_string_keys)
+                return old_hashtable_new (old_hashtable_string_hash,
+                                          old_hashtable_string_compare);
+
+        return old_hashtable_new (NULL, NULL);
+}
+
+static void
+free_old_hashtable (void *hashtable)
+{
+        old_hashtable_free (hashtable);
+}
+
+static void
+insert_into_old_hashtable (void *hashtable,
+                           void *key,
+                           void *data)
+{
+        old_hashtable_insert (hashtable, key, data);
+}
+
+static void *
+remove_from_old_hashtable (void *hashtable,
+                           void *key)
+{
+        return old_hashtable_remove (hashtable, key);
+}
+
+static void *
+look_up_in_old_hashtable (void *hashtable,
+                          void *key)
+{
+        return old_hashtable_lookup (hashtable, key);
+}
+
+static const hashtable_implementation_t old_implementation =
+{
+        .new    = new_old_hashtable,
+        .free   = free_old_hashtable,
+        .insert = insert_into_old_hashtable,
+        .remove = remove_from_old_hashtable,
+        .lookup = look_up_in_old_hashtable,
+};
+
+static const hashtable_implementation_t implementation =
+{
+        .new    = new_hashtable,
+        .free   = free_hashtable,
+        .insert = insert_into_hashtable,
+        .remove = remove_from_hashtable,
+        .lookup = look_up_in_hashtable,
+};
+
+/* Script arrays are objects keyed by the index as a string, "0", "1"
+ * and so on. They get filled, read over and over, thinned out and
+ * grown again. Half of the lookups miss.
+ */
+static unsigned long
+run_string_key_mix (const hashtable_implementation_t *hashtable_implementation,
+                    char                             *keys[])
+{
+        unsigned long found = 0;
+        void *hashtable;
+        int i, j;
+
+        hashtable = hashtable_implementation->new (true);
+
+        for (i = 0; i < 5000; i++) {
+                hashtable_implementation->insert (hashtable, keys[i], keys[i]);
+        }
+
+        for (j = 0; j < 4; j++) {
+                for (i = 0; i < 10000; i++) {
+                        found += hashtable_implementation->lookup (hashtable, keys[i]) != NULL;
+                }
+        }
+
+        for (i = 0; i < 5000; i += 2) {
+                hashtable_implementation->remove (hashtable, keys[i]);
+        }
+
+        for (i = 5000; i < 7000; i++) {
+                hashtable_implementation->insert (hashtable, keys[i], keys[i]);
+        }
+
+        for (i = 0; i < 7000; i++) {
+                found += hashtable_implementation->lookup (hashtable, keys[i]) != NULL;
+        }
+
+        hashtable_implementation->free (hashtable);
+
+        return found;
+}
+
+/* Tables keyed by pointer, like the object references the script
+ * engine hands around, looked up twice as often as they hold entries,
+ * half of them misses
+ */
+static unsigned long
+run_pointer_key_mix (const hashtable_implementation_t *hashtable_implementation,
+                     char                             *objects,
+                     size_t                            object_size)
+{
+        unsigned long found = 0;
+        void *hashtable;
+        int i, j;
+
+        hashtable = hashtable_implementation->new (false);
+
+        for (i = 0; i < 10000; i++) {
+                hashtable_implementation->insert (hashtable,
+                                                  objects + i * object_size,
+                                                  objects + i * object_size);
+        }
+
+        for (j = 0; j < 4; j++) {
+                for (i = 0; i < 20000; i++) {
+                        found += hashtable_implementation->lookup (hashtable, objects + i * object_size) != NULL;
+                }
+        }
+
+        hashtable_implementation->free (hashtable);
+
+        return found;
+}
+
+typedef enum
+{
+        MIX_STRING_KEYS,
+        MIX_POINTERS_TO_64_BYTE_OBJECTS,
+        MIX_POINTERS_TO_4_BYTE_OBJECTS,
+        NUMBER_OF_MIXES
+} mix_t;
+
+static const char *mix_names[NUMBER_OF_MIXES] =
+{
+        [MIX_STRING_KEYS]                 = "string keys, 5k inserts, 47k lookups, 2.5k removals",
+        [MIX_POINTERS_TO_64_BYTE_OBJECTS] = "direct keys, 10k 64 byte objects, 80k lookups",
+        [MIX_POINTERS_TO_4_BYTE_OBJECTS]  = "direct keys, 10k 4 byte objects, 80k lookups",
+};
+
+static double
+run_mix (const hashtable_implementation_t *hashtable_implementation,
+         mix_t                             mix,
+         int                               number_of_rounds,
+         char                             *keys[],
+         char                             *objects,
+         unsigned long                    *found)
+{
+        double start_time;
+        int round;
+
+        start_time = ply_get_timestamp ();
+        for (round = 0; round < number_of_rounds; round++) {
+                switch (mix) {
+                case MIX_STRING_KEYS:
+                        *found += run_string_key_mix (hashtable_implementation, keys);
+                        break;
+                case MIX_POINTERS_TO_64_BYTE_OBJECTS:
+                        *found += run_pointer_key_mix (hashtable_implementation, objects, 64);
+                        break;
+                case MIX_POINTERS_TO_4_BYTE_OBJECTS:
+                        *found += run_pointer_key_mix (hashtable_implementation, objects, 4);
+                        break;
+                case NUMBER_OF_MIXES:
+                        break;
+                }
+        }
+
+        return ply_get_timestamp () - start_time;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+        static char *keys[NUMBER_OF_KEYS];
+        int number_of_rounds = DEFAULT_ROUNDS;
+        char *objects;
+        mix_t mix;
+        int i;
+
+        if (argc == 3 && strcmp (argv[1], "-n") == 0) {
+                number_of_rounds = atoi (argv[2]);
+        } else if (argc != 1) {
+                fprintf (stderr, "usage: %s [-n ROUNDS]\n", argv[0]);
+                return 1;
+        }
+
+        if (number_of_rounds <= 0) {
+                fprintf (stderr, "usage: %s [-n ROUNDS]\n", argv[0]);
+                return 1;
+        }
+
+        for (i = 0; i < NUMBER_OF_KEYS; i++) {
+                asprintf (&keys[i], "%d", i);
+        }
+
+        objects = calloc (NUMBER_OF_KEYS, 64);
+
+        for (mix = 0; mix < NUMBER_OF_MIXES; mix++) {
+                unsigned long old_found = 0, new_found = 0;
+                double old_time, new_time;
+
+                old_time = run_mix (&old_implementation, mix, number_of_rounds,
+                                    keys, objects, &old_found);
+                new_time = run_mix (&implementation, mix, number_of_rounds,
+                                    keys, objects, &new_found);
+
+                if (old_found != new_found) {
+                        fprintf (stderr, "%s: old hash table found %lu keys, new one %lu\n",
+                                 mix_names[mix], old_found, new_found);
+                        return 1;
+                }
+
+                printf ("%s: old %.3f s, new %.3f s for %d rounds (%.1fx)\n",
+                        mix_names[mix], old_time, new_time, number_of_rounds,
+                        old_time / MAX (new_time, 1e-9));
+        }
+
+        free (objects);
+        for (i = 0; i < NUMBER_OF_KEYS; i++) {
+                free (keys[i]);
+        }
+
+        return 0;
+}
@@ -0,0 +1,733 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Times inserting, removing and sorting 1k to 10k element lists with
+ * ply_list_t and with the list code from before nodes were recycled
+ * and sorting became a merge sort, and reports the time per round.
+ *
+ *   benchmark-list [-n ROUNDS]
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ply-list.h"
+#include "ply-test-seeded-random.h"
+#include "ply-utils.h"
+
+#define DEFAULT_ROUNDS 3
+
+/* The old implementation, unchanged apart from the names */
+typedef struct _old_list old_list_t;
+typedef struct _old_list_node old_list_node_t;
+
+static void old_list_remove_all_nodes (old_list_t *list);
+
+struct _old_list
+{
+        old_list_node_t *first_node;
+        old_list_node_t *last_node;
+
+        int              number_of_nodes;
+};
+
+struct _old_list_node
+{
+        void                  *data;
+        struct _old_list_node *previous;
+        struct _old_list_node *next;
+};
+
+static old_list_t *
+old_list_new (void)
+{
+        old_list_t *list;
+
+        list = calloc (1, sizeof(old_list_t));
+
+        list->first_node = NULL;
+        list->last_node = NULL;
+        list->number_of_nodes = 0;
+
+        return list;
+}
+
+static void
+old_list_free (old_list_t *list)
+{
+        old_list_remove_all_nodes (list);
+        free (list);
+}
+
+static old_list_node_t *
+old_list_node_new (void *data)
+{
+        old_list_node_t *node;
+
+        node = calloc (1, sizeof(old_list_node_t));
+        node->data = data;
+
+        return node;
+}
+
+static void
+old_list_node_free (old_list_node_t *node)
+{
+        if (node == NULL)
+                return;
+
+        assert ((node->previous == NULL) && (node->next == NULL));
+
+        free (node);
+}
+
+static old_list_node_t *
+old_list_find_node (old_list_t *list,
+                    void       *data)
+{
+        old_list_node_t *node;
+
+        node = list->first_node;
+        while (node != NULL) {
+                if (node->data == data)
+                        break;
+
+                node = node->next;
+        }
+        return node;
+}
+
+static void
+old_list_insert_node (old_list_t      *list,
+                      old_list_node_t *node_before,
+                      old_list_node_t *new_node)
+{
+        if (new_node == NULL)
+                return;
+
+        if (node_before == NULL) {
+                if (list->first_node == NULL) {
+                        assert (list->last_node == NULL);
+
+                        list->first_node = new_node;
+                        list->last_node = new_node;
+                } else {
+                        list->first_node->previous = new_node;
+                        new_node->next = list->first_node;
+                        list->first_node = new_node;
+                }
+        } else {
+                new_node->next = node_before->next;
+                if (node_before->next != NULL)
+                        node_before->next->previous = new_node;
+                node_before->next = new_node;
+                new_node->previous = node_before;
+
+                if (node_before == list->last_node)
+                        list->last_node = new_node;
+        }
+
+        list->number_of_nodes++;
+}
+
+static old_list_node_t *
+old_list_insert_data (old_list_t      *list,
+                      void            *data,
+                      old_list_node_t *node_before)
+{
+        old_list_node_t *node;
+
+        node = old_list_node_new (data);
+
+        old_list_insert_node (list, node_before, node);
+
+        return node;
+}
+
+static old_list_node_t *
+old_list_append_data (old_list_t *list,
+                      void       *data)
+{
+        return old_list_insert_data (list, data, list->last_node);
+}
+
+static void
+old_list_unlink_node (old_list_t      *list,
+                      old_list_node_t *node)
+{
+        old_list_node_t *node_before, *node_after;
+
+        assert (list != NULL);
+
+        if (node == NULL)
+                return;
+
+        node_before = node->previous;
+        node_after = node->next;
+
+        if (node_before != NULL)
+                node_before->next = node_after;
+
+        if (node_after != NULL)
+                node_after->previous = node_before;
+
+        if (list->first_node == node)
+                list->first_node = node_after;
+
+        if (list->last_node == node)
+                list->last_node = node_before;
+
+        node->previous = NULL;
+        node->next = NULL;
+
+        list->number_of_nodes--;
+        assert (old_list_find_node (list, node->data) != node);
+}
+
+static void
+old_list_remove_node (old_list_t      *list,
+                      old_list_node_t *node)
+{
+        old_list_unlink_node (list, node);
+        old_list_node_free (node);
+}
+
+static void
+old_list_remove_all_nodes (old_list_t *list)
+{
+        old_list_node_t *node;
+
+        if (list == NULL)
+                return;
+
+        node = list->first_node;
+        while (node != NULL) {
+                old_list_node_t *next_node;
+                next_node = node->next;
+                old_list_remove_node (list, node);
+                node = next_node;
+        }
+}
+
+static old_list_node_t *
+old_list_get_first_node (old_list_t *list)
+{
+        return list->first_node;
+}
+
+static old_list_node_t *
+old_list_get_next_node (old_list_t      *list,
+                        old_list_node_t *node)
+{
+        return node->next;
+}
+
+static void
+old_list_sort_swap (void **element_a,
+                    void **element_b)
+{
+        void *temp;
+
+        temp = *element_a;
+        *element_a = *element_b;
+        *element_b = temp;
+}
+
+static void
+old_list_sort_body (old_list_node_t         *node_start,
+                    old_list_node_t         *node_end,
+                    ply_list_compare_func_t *compare)
+{
+        if (node_start == node_end) return;
+        old_list_node_t *cur_node = node_start;
+        old_list_node_t *top_node = node_end;
+        old_list_node_t *next_node = cur_node->next;
+        while (cur_node != top_node) {
+                int diff = compare (cur_node->data, next_node->data);
+                if (diff > 0) {
+                        old_list_sort_swap (&next_node->data,
+                                            &cur_node->data);
+                        cur_node = next_node;
+                        next_node = cur_node->next;
+                } else {
+                        old_list_sort_swap (&next_node->data,
+                                            &top_node->data);
+                        top_node = top_node->previous;
+                }
+        }
+
+        if (cur_node != node_end)
+                old_list_sort_body (cur_node->next,
+                                    node_end,
+                                    compare);
+        if (cur_node != node_start)
+                old_list_sort_body (node_start,
+                                    cur_node->previous,
+                                    compare);
+}
+
+static void
+old_list_sort (old_list_t              *list,
+               ply_list_compare_func_t *compare)
+{
+        old_list_sort_body (old_list_get_first_node (list),
+                            list->last_node,
+                            compare);
+}
+
+static void
+old_list_sort_stable (old_list_t              *list,
+                      ply_list_compare_func_t *compare)
+{
+        old_list_node_t *top_node;
+        old_list_node_t *cur_node;
+
+        top_node = old_list_get_first_node (list);
+        if (top_node == NULL) return;
+        top_node = top_node->next;
+
+        while (top_node) {
+                cur_node = top_node->previous;
+                while (cur_node && compare (cur_node->data, cur_node->next->data) > 0) {
+                        old_list_sort_swap (&cur_node->data,
+                                            &cur_node->next->data);
+                        cur_node = cur_node->previous;
+                }
+                top_node = top_node->next;
+        }
+}
+
+static void *
+old_list_node_get_data (old_list_node_t *node)
+{
+        return node->data;
+}
+
+
+/* Both implementations behind the same calls, so each operation below
+ * is only written once
+ */
+typedef struct
+{
+        const char *name;
+        void       *(*new)(void);
+        void        (*free)(void *list);
+        void       *(*append_data)(void *list,
+                                   void *data);
+        void        (*remove_node)(void *list,
+                                   void *node);
+        void       *(*get_first_node)(void *list);
+        void       *(*get_next_node)(void *list,
+                                     void *node);
+        void       *(*node_get_data)(void *node);
+        void        (*sort)(void                    *list,
+                            ply_list_compare_func_t *compare);
+        void        (*sort_stable)(void                    *list,
+                                   ply_list_compare_func_t *compare);
+} list_implementation_t;
+
+static void *
+new_list (void)
+{
+        return ply_list_new ();
+}
+
+static void
+free_list (void *list)
+{
+        ply_list_free (list);
+}
+
+static void *
+append_to_list (void *list,
+                void *data)
+{
+        return ply_list_append_data (list, data);
+}
+
+static void
+remove_from_list (void *list,
+                  void *node)
+{
+        ply_list_remove_node (list, node);
+}
+
+static void *
+get_first_list_node (void *list)
+{
+        return ply_list_get_first_node (list);
+}
+
+static void *
+get_next_list_node (void *list,
+                    void *node)
+{
+        return ply_list_get_next_node (list, node);
+}
+
+static void *
+get_list_node_data (void *node)
+{
+        return ply_list_node_get_data (node);
+}
+
+static void
+sort_list (void                    *list,
+           ply_list_compare_func_t *compare)
+{
+        ply_list_sort (list, compare);
+}
+
+static void
+sort_list_stably (void                    *list,
+                  ply_list_compare_func_t *compare)
+{
+        ply_list_sort_stable (list, compare);
+}
+
+static void *
+new_old_list (void)
+{
+        return old_list_new ();
+}
+
+static void
+free_old_list (void *list)
+{
+        old_list_free (list);
+}
+
+static void *
+append_to_old_list (void *list,
+                    void *data)
+{
+        return old_list_append_data (list, data);
+}
+
+static void
+remove_from_old_list (void *list,
+                      void *node)
+{
+        old_list_remove_node (list, node);
+}
+
+static void *
+get_first_old_list_node (void *list)
+{
+        return old_list_get_first_node (list);
+}
+
+static void *
+get_next_old_list_node (void *list,
+                        void *node)
+{
+        return old_list_get_next_node (list, node);
+}
+
+static void *
+get_old_list_node_data (void *node)
+{
+        return old_list_node_get_data (node);
+}
+
+static void
+sort_old_list (void                    *list,
+               ply_list_compare_func_t *compare)
+{
+        old_list_sort (list, compare);
+}
+
+static void
+sort_old_list_stably (void                    *list,
+                      ply_list_compare_func_t *compare)
+{
+        old_list_sort_stable (list, compare);
+}
+
+static const list_implementation_t old_implementation =
+{
+        .name           = "old",
+        .new            = new_old_list,
+        .free           = free_old_list,
+        .append_data    = append_to_old_list,
+        .remove_node    = remove_from_old_list,
+        .get_first_node = get_first_old_list_node,
+        .get_next_node  = get_next_old_list_node,
+        .node_get_data  = get_old_list_node_data,
+        .sort           = sort_old_list,
+        .sort_stable    = sort_old_list_stably,
+};
+
+static const list_implementation_t implementation =
+{
+        .name           = "new",
+        .new            = new_list,
+        .free           = free_list,
+        .append_data    = append_to_list,
+        .remove_node    = remove_from_list,
+        .get_first_node = get_first_list_node,
+        .get_next_node  = get_next_list_node,
+        .node_get_data  = get_list_node_data,
+        .sort           = sort_list,
+        .sort_stable    = sort_list_stably,
+};
+
+typedef struct
+{
+        int key;
+        int index;
+} element_t;
+
+typedef enum
+{
+        OPERATION_INSERT,
+        OPERATION_REMOVE,
+        OPERATION_CHURN,
+        OPERATION_SORT,
+        OPERATION_SORT_STABLE,
+        OPERATION_SORT_STABLE_NEARLY_SORTED,
+        NUMBER_OF_OPERATIONS
+} operation_t;
+
+static const char *operation_names[NUMBER_OF_OPERATIONS] =
+{
+        [OPERATION_INSERT]                    = "insert",
+        [OPERATION_REMOVE]                    = "remove, random order",
+        [OPERATION_CHURN]                     = "remove first, append",
+        [OPERATION_SORT]                      = "sort",
+        [OPERATION_SORT_STABLE]               = "stable sort",
+        [OPERATION_SORT_STABLE_NEARLY_SORTED] = "stable sort, 1% moved",
+};
+
+static int
+compare_elements (void *element_a,
+                  void *element_b)
+{
+        return ((element_t *) element_a)->key - ((element_t *) element_b)->key;
+}
+
+static bool
+list_is_sorted (const list_implementation_t *list_implementation,
+                void                        *list,
+                bool                         should_be_stable)
+{
+        element_t *previous_element = NULL;
+        void *node;
+
+        for (node = list_implementation->get_first_node (list);
+             node != NULL;
+             node = list_implementation->get_next_node (list, node)) {
+                element_t *element = list_implementation->node_get_data (node);
+
+                if (previous_element != NULL) {
+                        if (previous_element->key > element->key)
+                                return false;
+
+                        if (should_be_stable &&
+                            previous_element->key == element->key &&
+                            previous_element->index > element->index)
+                                return false;
+                }
+
+                previous_element = element;
+        }
+
+        return true;
+}
+
+static void
+fill_list (const list_implementation_t *list_implementation,
+           void                        *list,
+           element_t                   *elements,
+           size_t                       number_of_elements,
+           void                       **nodes)
+{
+        size_t i;
+
+        for (i = 0; i < number_of_elements; i++) {
+                nodes[i] = list_implementation->append_data (list, &elements[i]);
+        }
+}
+
+/* Returns the time the operation took, not counting the setup around it */
+static double
+run_operation (const list_implementation_t *list_implementation,
+               operation_t                  operation,
+               element_t                   *elements,
+               size_t                       number_of_elements,
+               void                       **nodes,
+               size_t                      *order)
+{
+        double start_time, elapsed;
+        void *list;
+        size_t i;
+
+        list = list_implementation->new ();
+
+        if (operation != OPERATION_INSERT)
+                fill_list (list_implementation, list, elements, number_of_elements, nodes);
+
+        start_time = ply_get_timestamp ();
+        switch (operation) {
+        case OPERATION_INSERT:
+                fill_list (list_implementation, list, elements, number_of_elements, nodes);
+                break;
+
+        case OPERATION_REMOVE:
+                for (i = 0; i < number_of_elements; i++) {
+                        list_implementation->remove_node (list, nodes[order[i]]);
+                }
+                break;
+
+        case OPERATION_CHURN:
+                for (i = 0; i < number_of_elements; i++) {
+                        void *node;
+
+                        node = list_implementation->get_first_node (list);
+                        list_implementation->append_data (list, list_implementation->node_get_data (node));
+                        list_implementation->remove_node (list, node);
+                }
+                break;
+
+        case OPERATION_SORT:
+                list_implementation->sort (list, compare_elements);
+                break;
+
+        case OPERATION_SORT_STABLE:
+        case OPERATION_SORT_STABLE_NEARLY_SORTED:
+                list_implementation->sort_stable (list, compare_elements);
+                break;
+
+        case NUMBER_OF_OPERATIONS:
+                break;
+        }
+        elapsed = ply_get_timestamp () - start_time;
+
+        if (operation >= OPERATION_SORT &&
+            !list_is_sorted (list_implementation, list, operation != OPERATION_SORT)) {
+                fprintf (stderr, "%s list came out of %s out of order\n",
+                         list_implementation->name, operation_names[operation]);
+                exit (1);
+        }
+
+        list_implementation->free (list);
+
+        return elapsed;
+}
+
+/* Random keys with plenty of ties for the sorts, or, for the sprite
+ * lists that barely change between frames, keys in order except for
+ * every hundredth one
+ */
+static void
+fill_elements (element_t                *elements,
+               size_t                    number_of_elements,
+               operation_t               operation,
+               ply_test_seeded_random_t *random)
+{
+        size_t i;
+
+        for (i = 0; i < number_of_elements; i++) {
+                elements[i].index = (int) i;
+
+                if (operation != OPERATION_SORT_STABLE_NEARLY_SORTED)
+                        elements[i].key = (int) ply_test_seeded_random_range (random, number_of_elements / 4);
+                else if (i % 100 == 0)
+                        elements[i].key = (int) ply_test_seeded_random_range (random, number_of_elements);
+                else
+                        elements[i].key = (int) i;
+        }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+        static const size_t sizes[] = { 1000, 4000, 10000 };
+        ply_test_seeded_random_t random = { .state = 0x11571 };
+        int number_of_rounds = DEFAULT_ROUNDS;
+        size_t i;
+
+        if (argc == 3 && strcmp (argv[1], "-n") == 0) {
+                number_of_rounds = atoi (argv[2]);
+        } else if (argc != 1) {
+                fprintf (stderr, "usage: %s [-n ROUNDS]\n", argv[0]);
+                return 1;
+        }
+
+        if (number_of_rounds <= 0) {
+                fprintf (stderr, "usage: %s [-n ROUNDS]\n", argv[0]);
+                return 1;
+        }
+
+        for (i = 0; i < PLY_NUMBER_OF_ELEMENTS (sizes); i++) {
+                size_t number_of_elements = sizes[i];
+                element_t *elements;
+                void **nodes;
+                size_t *order;
+                operation_t operation;
+                size_t j;
+
+                elements = calloc (number_of_elements, sizeof(element_t));
+                nodes = calloc (number_of_elements, sizeof(void *));
+                order = calloc (number_of_elements, sizeof(size_t));
+
+                /* removal order, shuffled */
+                for (j = 0; j < number_of_elements; j++) {
+                        order[j] = j;
+                }
+                for (j = number_of_elements - 1; j > 0; j--) {
+                        size_t other = ply_test_seeded_random_range (&random, j + 1);
+                        size_t temp = order[j];
+
+                        order[j] = order[other];
+                        order[other] = temp;
+                }
+
+                for (operation = 0; operation < NUMBER_OF_OPERATIONS; operation++) {
+                        double old_time = 0.0, new_time = 0.0;
+                        int round;
+
+                        fill_elements (elements, number_of_elements, operation, &random);
+
+                        for (round = 0; round < number_of_rounds; round++) {
+                                old_time += run_operation (&old_implementation, operation,
+                                                           elements, number_of_elements,
+                                                           nodes, order);
+                                new_time += run_operation (&implementation, operation,
+                                                           elements, number_of_elements,
+                                                           nodes, order);
+                        }
+
+                        printf ("%5zu nodes, %s: old %.3f ms, new %.3f ms per round (%.1fx)\n",
+                                number_of_elements, operation_names[operation],
+                                1000.0 * old_time / number_of_rounds,
+                                1000.0 * new_time / number_of_rounds,
+                                old_time / MAX (new_time, 1e-9));
+                }
+
+                free (order);
+                free (nodes);
+                free (elements);
+        }
+
+        return 0;
+}
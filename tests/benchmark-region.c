@@ -0,0 +1,722 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Feeds the damage that the stock themes generate frame after frame
+ * through the banded ply_region_t and through the list based region
+ * code it replaced, and reports the time each takes per frame.
+ *
+ *   benchmark-region [-n FRAMES]
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ply-list.h"
+#include "ply-rectangle.h"
+#include "ply-region.h"
+#include "ply-utils.h"
+
+#define DEFAULT_FRAMES 60
+
+#define SCREEN_WIDTH 1024
+#define SCREEN_HEIGHT 768
+
+/* The list based implementation from before regions were banded,
+ * unchanged apart from the names
+ */
+typedef struct _old_region old_region_t;
+
+struct _old_region
+{
+        ply_list_t *rectangle_list;
+};
+
+static old_region_t *
+old_region_new (void)
+{
+        old_region_t *region;
+
+        region = calloc (1, sizeof(old_region_t));
+
+        region->rectangle_list = ply_list_new ();
+
+        return region;
+}
+
+static void
+old_region_clear (old_region_t *region)
+{
+        ply_list_node_t *node;
+
+        node = ply_list_get_first_node (region->rectangle_list);
+        while (node != NULL) {
+                ply_list_node_t *next_node;
+                ply_rectangle_t *rectangle;
+
+                rectangle = (ply_rectangle_t *) ply_list_node_get_data (node);
+
+                next_node = ply_list_get_next_node (region->rectangle_list, node);
+
+                free (rectangle);
+                ply_list_remove_node (region->rectangle_list, node);
+
+                node = next_node;
+        }
+}
+
+static void
+old_region_free (old_region_t *region)
+{
+        old_region_clear (region);
+        ply_list_free (region->rectangle_list);
+        free (region);
+}
+
+static ply_rectangle_t *
+copy_rectangle (ply_rectangle_t *rectangle)
+{
+        ply_rectangle_t *new_rectangle;
+
+        new_rectangle = malloc (sizeof(*rectangle));
+        *new_rectangle = *rectangle;
+
+        return new_rectangle;
+}
+
+static void
+merge_rectangle_with_sub_list (old_region_t    *region,
+                               ply_rectangle_t *new_area,
+                               ply_list_node_t *node)
+{
+        if (ply_rectangle_is_empty (new_area)) {
+                free (new_area);
+                return;
+        }
+
+        while (node != NULL) {
+                ply_list_node_t *next_node;
+                ply_rectangle_t *old_area;
+                ply_rectangle_overlap_t overlap;
+
+                old_area = (ply_rectangle_t *) ply_list_node_get_data (node);
+
+                next_node = ply_list_get_next_node (region->rectangle_list, node);
+
+                if (ply_rectangle_is_empty (new_area))
+                        overlap = PLY_RECTANGLE_OVERLAP_NO_EDGES;
+                else if (ply_rectangle_is_empty (old_area))
+                        overlap = PLY_RECTANGLE_OVERLAP_ALL_EDGES;
+                else
+                        overlap = ply_rectangle_find_overlap (old_area, new_area);
+
+                switch (overlap) {
+                /* NNNN      The new rectangle and node rectangle don't touch,
+                 * NNNN OOOO so let's move on to the next one.
+                 *      OOOO
+                 */
+                case PLY_RECTANGLE_OVERLAP_NONE:
+                        break;
+
+                /* NNNNN   We need to split the new rectangle into
+                 * NNOOOOO two rectangles:  The top row of Ns and
+                 * NNOOOOO the left side of Ns.
+                 *   OOOOO
+                 */
+                case PLY_RECTANGLE_OVERLAP_TOP_AND_LEFT_EDGES:
+                {
+                        ply_rectangle_t *rectangle;
+
+                        rectangle = copy_rectangle (new_area);
+                        rectangle->y = old_area->y;
+                        rectangle->width = old_area->x - new_area->x;
+                        rectangle->height = (new_area->y + new_area->height) - old_area->y;
+
+                        merge_rectangle_with_sub_list (region, rectangle, next_node);
+
+                        new_area->height = old_area->y - new_area->y;
+                }
+                break;
+
+                /*   NNNNN We need to split the new rectangle into
+                 * OOOOONN two rectangles:  The top row of Ns and
+                 * OOOOONN the right side of Ns.
+                 * OOOOO
+                 */
+                case PLY_RECTANGLE_OVERLAP_TOP_AND_RIGHT_EDGES:
+                {
+                        ply_rectangle_t *rectangle;
+
+                        rectangle = copy_rectangle (new_area);
+                        rectangle->x = old_area->x + old_area->width;
+                        rectangle->y = old_area->y;
+                        rectangle->width = (new_area->x + new_area->width) - (old_area->x + old_area->width);
+                        rectangle->height = (new_area->y + new_area->height) - old_area->y;
+
+                        merge_rectangle_with_sub_list (region, rectangle, next_node);
+
+                        new_area->height = old_area->y - new_area->y;
+                }
+                break;
+
+                /* NNNNNNN We need to trim out the part of
+                 * NOOOOON old rectangle that overlaps the new
+                 * NOOOOON rectangle by shrinking and moving it
+                 *  OOOOO  and then we need to add the new rectangle.
+                 */
+                case PLY_RECTANGLE_OVERLAP_TOP_AND_SIDE_EDGES:
+                {
+                        old_area->height = (old_area->y + old_area->height)
+                                           - (new_area->y + new_area->height);
+                        old_area->y = new_area->y + new_area->height;
+                }
+                break;
+
+                /*   NNN  We only care about the top row of Ns,
+                 *  ONNNO everything below that is already handled by
+                 *  ONNNO the old rectangle.
+                 *  OOOOO
+                 */
+                case PLY_RECTANGLE_OVERLAP_TOP_EDGE:
+                        new_area->height = old_area->y - new_area->y;
+                        break;
+
+                /*   OOOOO We need to split the new rectangle into
+                 * NNOOOOO two rectangles:  The left side of Ns and
+                 * NNOOOOO the bottom row of Ns.
+                 * NNOOOOO
+                 * NNNNN
+                 */
+                case PLY_RECTANGLE_OVERLAP_BOTTOM_AND_LEFT_EDGES:
+                {
+                        ply_rectangle_t *rectangle;
+
+                        rectangle = copy_rectangle (new_area);
+
+                        rectangle->width = old_area->x - new_area->x;
+                        rectangle->height = (old_area->y + old_area->height) - new_area->y;
+
+                        merge_rectangle_with_sub_list (region, rectangle, next_node);
+
+                        new_area->height = (new_area->y + new_area->height) - (old_area->y + old_area->height);
+                        new_area->y = old_area->y + old_area->height;
+                }
+                break;
+
+                /*   OOOOO   We need to split the new rectangle into
+                 *   OOOOONN two rectangles:  The right side of Ns and
+                 *   OOOOONN the bottom row of Ns.
+                 *   OOOOONN
+                 *     NNNNN
+                 */
+                case PLY_RECTANGLE_OVERLAP_BOTTOM_AND_RIGHT_EDGES:
+                {
+                        ply_rectangle_t *rectangle;
+
+                        rectangle = copy_rectangle (new_area);
+
+                        rectangle->x = old_area->x + old_area->width;
+                        rectangle->width = (new_area->x + new_area->width) - (old_area->x + old_area->width);
+                        rectangle->height = (old_area->y + old_area->height) - new_area->y;
+
+                        merge_rectangle_with_sub_list (region, rectangle, next_node);
+
+                        new_area->height = (new_area->y + new_area->height) - (old_area->y + old_area->height);
+                        new_area->y = old_area->y + old_area->height;
+                }
+                break;
+
+                /*  OOOOO  We need to trim out the part of
+                 * NOOOOON old rectangle that overlaps the new
+                 * NOOOOON rectangle by shrinking it
+                 * NNNNNNN and then we need to add the new rectangle.
+                 */
+                case PLY_RECTANGLE_OVERLAP_BOTTOM_AND_SIDE_EDGES:
+                {
+                        old_area->height = new_area->y - old_area->y;
+                }
+                break;
+
+                /*  OOOOO We only care about the bottom row of Ns,
+                 *  ONNNO everything above that is already handled by
+                 *  ONNNO the old rectangle.
+                 *   NNN
+                 */
+                case PLY_RECTANGLE_OVERLAP_BOTTOM_EDGE:
+                {
+                        new_area->height = (new_area->y + new_area->height) - (old_area->y + old_area->height);
+                        new_area->y = old_area->y + old_area->height;
+                }
+                break;
+
+                /*  NNNN   We need to trim out the part of
+                 *  NNNNO  old rectangle that overlaps the new
+                 *  NNNNO  rectangle by shrinking it and moving it
+                 *  NNNN   and then we need to add the new rectangle.
+                 */
+                case PLY_RECTANGLE_OVERLAP_TOP_LEFT_AND_BOTTOM_EDGES:
+                {
+                        old_area->width = (old_area->x + old_area->width)
+                                          - (new_area->x + new_area->width);
+                        old_area->x = new_area->x + new_area->width;
+                }
+                break;
+
+                /*  NNNN  We need to trim out the part of
+                 * ONNNN  old rectangle that overlaps the new
+                 * ONNNN  rectangle by shrinking it and then we
+                 *  NNNN  need to add the new rectangle.
+                 */
+                case PLY_RECTANGLE_OVERLAP_TOP_RIGHT_AND_BOTTOM_EDGES:
+                        old_area->width = new_area->x - old_area->x;
+                        break;
+
+                /* NNNNNNN The old rectangle is completely inside the new rectangle
+                 * NOOOOON so replace the old rectangle with the new rectangle.
+                 * NOOOOON
+                 * NNNNNNN
+                 */
+                case PLY_RECTANGLE_OVERLAP_ALL_EDGES:
+                        merge_rectangle_with_sub_list (region, new_area, next_node);
+                        free (old_area);
+                        ply_list_remove_node (region->rectangle_list, node);
+                        return;
+
+                /*  NNN  We need to split the new rectangle into
+                 * ONNNO two rectangles: the top and bottom row of Ns
+                 * ONNNO
+                 *  NNN
+                 */
+                case PLY_RECTANGLE_OVERLAP_TOP_AND_BOTTOM_EDGES:
+                {
+                        ply_rectangle_t *rectangle;
+
+                        rectangle = copy_rectangle (new_area);
+                        rectangle->y = old_area->y + old_area->height;
+                        rectangle->width = new_area->width;
+                        rectangle->height = (new_area->y + new_area->height) - (old_area->y + old_area->height);
+                        merge_rectangle_with_sub_list (region, rectangle, next_node);
+
+                        new_area->height = old_area->y - new_area->y;
+                }
+                break;
+
+                /*  OOOOO We only care about the side row of Ns,
+                 * NNNNOO everything rigth of that is already handled by
+                 * NNNNOO the old rectangle.
+                 *  OOOOO
+                 */
+                case PLY_RECTANGLE_OVERLAP_LEFT_EDGE:
+                        new_area->width = old_area->x - new_area->x;
+                        break;
+
+                /* OOOOO  We only care about the side row of Ns,
+                 * NNNNNN everything left of that is already handled by
+                 * NNNNNN the old rectangle.
+                 * OOOOO
+                 */
+                case PLY_RECTANGLE_OVERLAP_RIGHT_EDGE:
+                {
+                        long temp = new_area->x;
+                        new_area->x = old_area->x + old_area->width;
+                        new_area->width = (temp + new_area->width) - (old_area->x + old_area->width);
+                }
+                break;
+
+                /*  OOOOO  We need to split the new rectangle into
+                 * NNNNNNN two rectangles: the side columns of Ns
+                 * NNNNNNN
+                 *  OOOOO
+                 */
+                case PLY_RECTANGLE_OVERLAP_SIDE_EDGES:
+                {
+                        ply_rectangle_t *rectangle;
+
+                        rectangle = copy_rectangle (new_area);
+
+                        rectangle->x = old_area->x + old_area->width;
+                        rectangle->width = (new_area->x + new_area->width) - (old_area->x + old_area->width);
+
+                        merge_rectangle_with_sub_list (region, rectangle, next_node);
+
+                        new_area->width = old_area->x - new_area->x;
+                }
+                break;
+
+                /* OOOOOOO The new rectangle is completely inside an old rectangle
+                 * ONNNNNO so return early without adding the new rectangle.
+                 * ONNNNNO
+                 * OOOOOOO
+                 */
+                case PLY_RECTANGLE_OVERLAP_NO_EDGES:
+                        free (new_area);
+                        return;
+
+                /*  NNNNN We expand the old rectangle up and throw away the new.
+                 *  NNNNN We must merge it because the new region may have overlapped
+                 *  NNNNN something further down the list.
+                 *  OOOOO
+                 */
+                case PLY_RECTANGLE_OVERLAP_EXACT_TOP_EDGE:
+                {
+                        old_area->height = (old_area->y + old_area->height) - new_area->y;
+                        old_area->y = new_area->y;
+                        free (new_area);
+                        merge_rectangle_with_sub_list (region, old_area, next_node);
+                        ply_list_remove_node (region->rectangle_list, node);
+                }
+                        return;
+
+                /*  OOOOO We expand the old rectangle down and throw away the new.
+                 *  NNNNN We must merge it because the new region may have overlapped
+                 *  NNNNN something further down the list.
+                 *  NNNNN
+                 */
+                case PLY_RECTANGLE_OVERLAP_EXACT_BOTTOM_EDGE:
+                {
+                        old_area->height = (new_area->y + new_area->height) - old_area->y;
+                        free (new_area);
+                        merge_rectangle_with_sub_list (region, old_area, next_node);
+                        ply_list_remove_node (region->rectangle_list, node);
+                }
+                        return;
+
+                /*  NNNNNO We expand the old rectangle left and throw away the new.
+                 *  NNNNNO We must merge it because the new region may have overlapped
+                 *  NNNNNO something further down the list.
+                 */
+                case PLY_RECTANGLE_OVERLAP_EXACT_LEFT_EDGE:
+                {
+                        old_area->width = (old_area->x + old_area->width) - new_area->x;
+                        old_area->x = new_area->x;
+                        free (new_area);
+                        merge_rectangle_with_sub_list (region, old_area, next_node);
+                        ply_list_remove_node (region->rectangle_list, node);
+                }
+                        return;
+
+                /*  ONNNNN We expand the old rectangle right and throw away the new.
+                 *  ONNNNN We must merge it because the new region may have overlapped
+                 *  ONNNNN something further down the list.
+                 */
+                case PLY_RECTANGLE_OVERLAP_EXACT_RIGHT_EDGE:
+                {
+                        old_area->width = (new_area->x + new_area->width) - old_area->x;
+                        free (new_area);
+                        merge_rectangle_with_sub_list (region, old_area, next_node);
+                        ply_list_remove_node (region->rectangle_list, node);
+                }
+                        return;
+                }
+
+                node = ply_list_get_next_node (region->rectangle_list, node);
+        }
+
+        ply_list_append_data (region->rectangle_list, new_area);
+}
+
+static void
+old_region_add_rectangle (old_region_t    *region,
+                          ply_rectangle_t *rectangle)
+{
+        ply_list_node_t *first_node;
+        ply_rectangle_t *rectangle_copy;
+
+        assert (region != NULL);
+        assert (rectangle != NULL);
+
+        first_node = ply_list_get_first_node (region->rectangle_list);
+
+        rectangle_copy = copy_rectangle (rectangle);
+        merge_rectangle_with_sub_list (region,
+                                       rectangle_copy,
+                                       first_node);
+}
+
+static int
+rectangle_compare_y (void *element_a,
+                     void *element_b)
+{
+        ply_rectangle_t *rectangle_a = element_a;
+        ply_rectangle_t *rectangle_b = element_b;
+
+        return rectangle_a->y - rectangle_b->y;
+}
+
+static ply_list_t *
+old_region_get_sorted_rectangle_list (old_region_t *region)
+{
+        ply_list_sort (region->rectangle_list, &rectangle_compare_y);
+        return region->rectangle_list;
+}
+
+/* Damage patterns, one frame at a time */
+#define MAX_DAMAGE_PER_FRAME 2048
+
+typedef struct
+{
+        const char *name;
+        size_t      (*get_damage)(int              frame,
+                                  ply_rectangle_t *rectangles);
+} damage_pattern_t;
+
+static void
+get_jittering_sprite (int              sprite,
+                      int              frame,
+                      ply_rectangle_t *rectangle)
+{
+        double angle = frame / 25.0 + sprite;
+
+        rectangle->x = (sprite % 25) * SCREEN_WIDTH / 25 + (long) (sin (angle) * 8);
+        rectangle->y = (sprite / 25) * SCREEN_HEIGHT / 20 + (long) (cos (angle) * 8);
+        rectangle->width = 24;
+        rectangle->height = 24;
+}
+
+/* A script theme moving sprites around redraws where each one was and
+ * where it is now
+ */
+static size_t
+get_script_sprite_damage (int              frame,
+                          ply_rectangle_t *rectangles,
+                          int              number_of_sprites)
+{
+        size_t count = 0;
+        int i;
+
+        for (i = 0; i < number_of_sprites; i++) {
+                get_jittering_sprite (i, frame, &rectangles[count++]);
+                get_jittering_sprite (i, frame - 1, &rectangles[count++]);
+        }
+
+        return count;
+}
+
+static size_t
+get_50_script_sprite_damage (int              frame,
+                             ply_rectangle_t *rectangles)
+{
+        return get_script_sprite_damage (frame, rectangles, 50);
+}
+
+static size_t
+get_500_script_sprite_damage (int              frame,
+                              ply_rectangle_t *rectangles)
+{
+        return get_script_sprite_damage (frame, rectangles, 500);
+}
+
+/* two-step redraws its throbber, the part of the progress bar that
+ * moved and, now and then, the message below it
+ */
+static size_t
+get_two_step_damage (int              frame,
+                     ply_rectangle_t *rectangles)
+{
+        size_t count = 0;
+
+        rectangles[count++] = (ply_rectangle_t) { 480, 352, 64, 64 };
+        rectangles[count++] = (ply_rectangle_t) { 312 + frame * 400 / DEFAULT_FRAMES, 440, 8, 8 };
+        rectangles[count++] = (ply_rectangle_t) { 312, 440, 400, 8 };
+
+        if (frame % 10 == 0)
+                rectangles[count++] = (ply_rectangle_t) { 362, 470, 300, 20 };
+
+        return count;
+}
+
+/* space-flares draws a lot of small stars that cluster and overlap
+ * around the flare, which is redrawn as a whole
+ */
+static size_t
+get_space_flares_damage (int              frame,
+                         ply_rectangle_t *rectangles)
+{
+        uint32_t seed = 0x5eed;
+        size_t count = 0;
+        int i;
+
+        rectangles[count++] = (ply_rectangle_t) { 412, 284, 200, 200 };
+
+        for (i = 0; i < 150; i++) {
+                long x, y;
+
+                seed = seed * 1103515245 + 12345;
+                x = 312 + (seed >> 8) % 400;
+                seed = seed * 1103515245 + 12345;
+                y = 234 + (seed >> 8) % 300;
+
+                rectangles[count++] = (ply_rectangle_t) { x + frame % 7, y + frame % 5, 12, 12 };
+        }
+
+        return count;
+}
+
+/* A fade redraws the whole screen, while the sprites on top still
+ * report their own damage
+ */
+static size_t
+get_fade_damage (int              frame,
+                 ply_rectangle_t *rectangles)
+{
+        size_t count;
+
+        count = get_script_sprite_damage (frame, rectangles, 100);
+        rectangles[count++] = (ply_rectangle_t) { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+
+        return count;
+}
+
+static const damage_pattern_t damage_patterns[] =
+{
+        { "script, 50 sprites",  get_50_script_sprite_damage  },
+        { "script, 500 sprites", get_500_script_sprite_damage },
+        { "two-step",            get_two_step_damage          },
+        { "space-flares",        get_space_flares_damage      },
+        { "fade",                get_fade_damage              },
+};
+
+static double
+run_old_region (const damage_pattern_t *pattern,
+                int                     number_of_frames,
+                unsigned long          *area,
+                unsigned long          *number_of_rectangles)
+{
+        static ply_rectangle_t damage[MAX_DAMAGE_PER_FRAME];
+        old_region_t *region;
+        double start_time;
+        int frame;
+
+        region = old_region_new ();
+
+        start_time = ply_get_timestamp ();
+        for (frame = 1; frame <= number_of_frames; frame++) {
+                ply_list_node_t *node;
+                ply_list_t *rectangles;
+                size_t count, i;
+
+                count = pattern->get_damage (frame, damage);
+                for (i = 0; i < count; i++) {
+                        old_region_add_rectangle (region, &damage[i]);
+                }
+
+                rectangles = old_region_get_sorted_rectangle_list (region);
+                ply_list_foreach (rectangles, node) {
+                        ply_rectangle_t *rectangle = ply_list_node_get_data (node);
+
+                        *area += rectangle->width * rectangle->height;
+                        (*number_of_rectangles)++;
+                }
+
+                old_region_clear (region);
+        }
+
+        old_region_free (region);
+
+        return ply_get_timestamp () - start_time;
+}
+
+static double
+run_region (const damage_pattern_t *pattern,
+            int                     number_of_frames,
+            unsigned long          *area,
+            unsigned long          *number_of_rectangles)
+{
+        static ply_rectangle_t damage[MAX_DAMAGE_PER_FRAME];
+        ply_region_t *region;
+        double start_time;
+        int frame;
+
+        region = ply_region_new ();
+
+        start_time = ply_get_timestamp ();
+        for (frame = 1; frame <= number_of_frames; frame++) {
+                ply_rectangle_t *rectangles;
+                size_t count, i;
+
+                count = pattern->get_damage (frame, damage);
+                for (i = 0; i < count; i++) {
+                        ply_region_add_rectangle (region, &damage[i]);
+                }
+
+                rectangles = ply_region_get_rectangles (region, &count);
+                for (i = 0; i < count; i++) {
+                        *area += rectangles[i].width * rectangles[i].height;
+                }
+                *number_of_rectangles += count;
+
+                ply_region_clear (region);
+        }
+
+        ply_region_free (region);
+
+        return ply_get_timestamp () - start_time;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+        int number_of_frames = DEFAULT_FRAMES;
+        size_t i;
+
+        if (argc == 3 && strcmp (argv[1], "-n") == 0) {
+                number_of_frames = atoi (argv[2]);
+        } else if (argc != 1) {
+                fprintf (stderr, "usage: %s [-n FRAMES]\n", argv[0]);
+                return 1;
+        }
+
+        if (number_of_frames <= 0) {
+                fprintf (stderr, "usage: %s [-n FRAMES]\n", argv[0]);
+                return 1;
+        }
+
+        for (i = 0; i < PLY_NUMBER_OF_ELEMENTS (damage_patterns); i++) {
+                unsigned long old_area = 0, old_rectangles = 0;
+                unsigned long new_area = 0, new_rectangles = 0;
+                double old_time, new_time;
+
+                old_time = run_old_region (&damage_patterns[i], number_of_frames,
+                                           &old_area, &old_rectangles);
+                new_time = run_region (&damage_patterns[i], number_of_frames,
+                                       &new_area, &new_rectangles);
+
+                /* Both hand back non-overlapping rectangles, so they
+                 * have to cover the same number of pixels
+                 */
+                if (old_area != new_area) {
+                        fprintf (stderr, "%s: old region covers %lu pixels, new one %lu\n",
+                                 damage_patterns[i].name, old_area, new_area);
+                        return 1;
+                }
+
+                printf ("%s: old %.3f ms, new %.3f ms per frame (%.1fx), %lu -> %lu rectangles\n",
+                        damage_patterns[i].name,
+                        1000.0 * old_time / number_of_frames,
+                        1000.0 * new_time / number_of_frames,
+                        old_time / MAX (new_time, 1e-9),
+                        old_rectangles / number_of_frames,
+                        new_rectangles / number_of_frames);
+        }
+
+        return 0;
+}
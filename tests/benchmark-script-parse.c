@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Parses each script given on the command line repeatedly and reports
+ * the time taken per parse and per KiB of source.
+ *
+ *   benchmark-script-parse [-n ITERATIONS] SCRIPT...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "ply-utils.h"
+#include "script-parse.h"
+
+#define DEFAULT_ITERATIONS 200
+
+int
+main (int    argc,
+      char **argv)
+{
+        int iterations = DEFAULT_ITERATIONS;
+        int first_script = 1;
+        int i, j;
+
+        if (argc > 2 && strcmp (argv[1], "-n") == 0) {
+                iterations = atoi (argv[2]);
+                first_script = 3;
+        }
+
+        if (first_script >= argc || iterations <= 0) {
+                fprintf (stderr, "usage: %s [-n ITERATIONS] SCRIPT...\n", argv[0]);
+                return 1;
+        }
+
+        for (i = first_script; i < argc; i++) {
+                struct stat file_info;
+                double start_time, elapsed;
+
+                if (stat (argv[i], &file_info) < 0) {
+                        fprintf (stderr, "could not stat %s\n", argv[i]);
+                        return 1;
+                }
+
+                start_time = ply_get_timestamp ();
+                for (j = 0; j < iterations; j++) {
+                        script_op_t *op;
+
+                        op = script_parse_file (argv[i]);
+                        if (op == NULL) {
+                                fprintf (stderr, "could not parse %s\n", argv[i]);
+                                return 1;
+                        }
+                        script_parse_op_free (op);
+                }
+                elapsed = (ply_get_timestamp () - start_time) / iterations;
+
+                printf ("%s: %lld bytes, %.3f ms per parse, %.3f ms per KiB\n",
+                        argv[i], (long long) file_info.st_size,
+                        1000.0 * elapsed,
+                        1000.0 * elapsed * 1024.0 / MAX (file_info.st_size, 1));
+        }
+
+        return 0;
+}
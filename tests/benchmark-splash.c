@@ -0,0 +1,282 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Runs a splash plugin against the headless renderer for a while and
+ * reports how much CPU time each frame took.
+ *
+ *   benchmark-splash PLUGIN THEME [SECONDS [HEADS]]
+ *
+ * HEADS uses the headless renderer's head syntax, e.g. "1920x1080,800x600@2".
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ply-boot-splash-plugin.h"
+#include "ply-event-loop.h"
+#include "ply-key-file.h"
+#include "ply-list.h"
+#include "ply-pixel-display.h"
+#include "ply-renderer-private.h"
+#include "ply-utils.h"
+
+#include "headless-renderer.h"
+
+#define DEFAULT_DURATION 5.0
+#define DEFAULT_HEADS "1920x1080"
+#define PROGRESS_INTERVAL 0.1
+
+typedef ply_boot_splash_plugin_interface_t *
+(*get_plugin_interface_function_t) (void);
+
+typedef struct
+{
+        ply_event_loop_t                         *loop;
+        const ply_boot_splash_plugin_interface_t *interface;
+        ply_boot_splash_plugin_t                 *plugin;
+
+        double                                    start_time;
+        double                                    duration;
+
+        double                                   *frame_times;
+        size_t                                    number_of_frames;
+        size_t                                    frame_capacity;
+
+        uint32_t                                  is_done : 1;
+} benchmark_t;
+
+static double
+get_cpu_time (void)
+{
+        struct timespec now = { 0L, };
+
+        clock_gettime (CLOCK_THREAD_CPUTIME_ID, &now);
+
+        return now.tv_sec + now.tv_nsec / 1000000000.0;
+}
+
+static int
+compare_doubles (const void *element_a,
+                 const void *element_b)
+{
+        double a = *(const double *) element_a;
+        double b = *(const double *) element_b;
+
+        return (a > b) - (a < b);
+}
+
+static void
+print_percentiles (const char *name,
+                   double     *values,
+                   size_t      number_of_values)
+{
+        if (number_of_values == 0) {
+                printf ("%s: no samples\n", name);
+                return;
+        }
+
+        qsort (values, number_of_values, sizeof(double), compare_doubles);
+
+        printf ("%s (ms): p50 %.3f p90 %.3f p99 %.3f max %.3f\n",
+                name,
+                1000.0 * values[number_of_values * 50 / 100],
+                1000.0 * values[number_of_values * 90 / 100],
+                1000.0 * values[number_of_values * 99 / 100],
+                1000.0 * values[number_of_values - 1]);
+}
+
+static void
+record_frame (benchmark_t *benchmark,
+              double       frame_time)
+{
+        if (benchmark->number_of_frames == benchmark->frame_capacity) {
+                benchmark->frame_capacity = MAX (benchmark->frame_capacity * 2, 1024);
+                benchmark->frame_times = realloc (benchmark->frame_times,
+                                                  benchmark->frame_capacity * sizeof(double));
+        }
+
+        benchmark->frame_times[benchmark->number_of_frames++] = frame_time;
+}
+
+static void
+on_progress_timeout (benchmark_t      *benchmark,
+                     ply_event_loop_t *loop)
+{
+        double elapsed;
+
+        elapsed = ply_get_timestamp () - benchmark->start_time;
+
+        if (elapsed >= benchmark->duration) {
+                benchmark->is_done = true;
+                return;
+        }
+
+        if (benchmark->interface->on_boot_progress != NULL)
+                benchmark->interface->on_boot_progress (benchmark->plugin,
+                                                        elapsed,
+                                                        elapsed / benchmark->duration);
+
+        ply_event_loop_watch_for_timeout (loop, PROGRESS_INTERVAL,
+                                          (ply_event_loop_timeout_handler_t)
+                                          on_progress_timeout, benchmark);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+        ply_renderer_headless_get_statistics_function_t get_statistics;
+        const ply_renderer_headless_statistics_t *statistics;
+        get_plugin_interface_function_t get_interface;
+        benchmark_t benchmark = { NULL };
+        ply_module_handle_t *plugin_module, *renderer_module;
+        ply_key_file_t *key_file;
+        ply_renderer_t *renderer;
+        ply_list_t *displays;
+        ply_list_node_t *node;
+        const char *heads;
+        char *device_name;
+        double *flush_times;
+        size_t i;
+
+        if (argc < 3) {
+                fprintf (stderr, "usage: %s PLUGIN THEME [SECONDS [HEADS]]\n", argv[0]);
+                return 1;
+        }
+
+        benchmark.duration = argc > 3 ? ply_strtod (argv[3]) : DEFAULT_DURATION;
+        heads = argc > 4 ? argv[4] : DEFAULT_HEADS;
+
+        plugin_module = ply_open_module (argv[1]);
+        if (plugin_module == NULL) {
+                fprintf (stderr, "could not load splash plugin %s\n", argv[1]);
+                return 1;
+        }
+
+        get_interface = (get_plugin_interface_function_t)
+                        ply_module_look_up_function (plugin_module,
+                                                     "ply_boot_splash_plugin_get_interface");
+        benchmark.interface = get_interface ();
+
+        key_file = ply_key_file_new (argv[2]);
+        if (!ply_key_file_load (key_file)) {
+                fprintf (stderr, "could not load theme %s\n", argv[2]);
+                return 1;
+        }
+
+        benchmark.plugin = benchmark.interface->create_plugin (key_file);
+        benchmark.loop = ply_event_loop_get_default ();
+
+        if (asprintf (&device_name, "headless:%s", heads) < 0)
+                return 1;
+
+        renderer = ply_renderer_new_with_plugin_directory (PLY_RENDERER_TYPE_HEADLESS,
+                                                           BENCHMARK_RENDERER_PLUGIN_DIR,
+                                                           device_name,
+                                                           NULL,
+                                                           NULL);
+        free (device_name);
+
+        if (!ply_renderer_open (renderer, true)) {
+                fprintf (stderr, "could not open headless renderer for %s\n", heads);
+                return 1;
+        }
+
+        /* Already loaded by the renderer, this just finds it again */
+        renderer_module = ply_open_module (BENCHMARK_HEADLESS_RENDERER_PATH);
+        get_statistics = (ply_renderer_headless_get_statistics_function_t)
+                         ply_module_look_up_function (renderer_module,
+                                                      "ply_renderer_headless_get_statistics");
+        statistics = get_statistics ();
+
+        displays = ply_list_new ();
+        ply_list_foreach (ply_renderer_get_heads (renderer), node) {
+                ply_pixel_display_t *display;
+
+                display = ply_pixel_display_new (renderer, ply_list_node_get_data (node));
+                ply_list_append_data (displays, display);
+                benchmark.interface->add_pixel_display (benchmark.plugin, display);
+        }
+
+        benchmark.start_time = ply_get_timestamp ();
+        if (!benchmark.interface->show_splash_screen (benchmark.plugin,
+                                                      benchmark.loop,
+                                                      NULL,
+                                                      PLY_BOOT_SPLASH_MODE_BOOT_UP)) {
+                fprintf (stderr, "could not show splash screen for theme %s\n", argv[2]);
+                return 1;
+        }
+        on_progress_timeout (&benchmark, benchmark.loop);
+
+        while (!benchmark.is_done) {
+                unsigned long number_of_flushes = statistics->number_of_flushes;
+                double start_time;
+
+                start_time = get_cpu_time ();
+                ply_event_loop_process_pending_events (benchmark.loop);
+
+                if (statistics->number_of_flushes != number_of_flushes)
+                        record_frame (&benchmark, get_cpu_time () - start_time);
+        }
+
+        printf ("theme: %s\n", argv[2]);
+        printf ("heads: %s\n", heads);
+        printf ("frames: %zu in %.1f seconds (%.1f per second)\n",
+                benchmark.number_of_frames, benchmark.duration,
+                benchmark.number_of_frames / benchmark.duration);
+        print_percentiles ("frame cpu time", benchmark.frame_times, benchmark.number_of_frames);
+
+        flush_times = calloc (statistics->number_of_recorded_flushes + 1, sizeof(double));
+        for (i = 0; i < statistics->number_of_recorded_flushes; i++) {
+                flush_times[i] = statistics->flushes[i].duration;
+        }
+        print_percentiles ("flush time", flush_times, statistics->number_of_recorded_flushes);
+
+        if (statistics->number_of_flushes > 0)
+                printf ("damaged pixels per flush: %llu\n",
+                        statistics->total_damaged_pixels / statistics->number_of_flushes);
+
+        benchmark.interface->hide_splash_screen (benchmark.plugin, benchmark.loop);
+        ply_list_foreach (displays, node) {
+                ply_pixel_display_t *display = ply_list_node_get_data (node);
+
+                benchmark.interface->remove_pixel_display (benchmark.plugin, display);
+                ply_pixel_display_free (display);
+        }
+        benchmark.interface->destroy_plugin (benchmark.plugin);
+
+        ply_list_free (displays);
+        ply_close_module (renderer_module);
+        ply_renderer_close (renderer);
+        ply_renderer_free (renderer);
+        ply_key_file_free (key_file);
+        ply_close_module (plugin_module);
+        free (flush_times);
+        free (benchmark.frame_times);
+
+        /* A theme that never redraws measures nothing */
+        if (benchmark.number_of_frames == 0) {
+                fprintf (stderr, "theme %s drew no frames after the first\n", argv[2]);
+                return 1;
+        }
+
+        return 0;
+}
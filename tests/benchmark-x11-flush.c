@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Moves a filled box across the x11 renderer's first head as fast as
+ * the event loop allows and reports how many frames got flushed, e.g.
+ *
+ *   xvfb-run benchmark-x11-flush [SECONDS [WIDTHxHEIGHT]]
+ *
+ * PLY_X11_FLUSH_METHOD=xshm|xputimage|gtk picks the flush path to
+ * measure. Exits with 77 (skipped) when there's no X display.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ply-event-loop.h"
+#include "ply-list.h"
+#include "ply-pixel-buffer.h"
+#include "ply-rectangle.h"
+#include "ply-renderer-plugin.h"
+#include "ply-utils.h"
+
+#define DEFAULT_DURATION 5.0
+#define DEFAULT_BOX_SIZE 256
+#define FRAME_INTERVAL 0.0001
+
+typedef ply_renderer_plugin_interface_t *
+(*get_backend_interface_function_t) (void);
+
+typedef struct
+{
+        ply_event_loop_t                *loop;
+        ply_renderer_plugin_interface_t *interface;
+        ply_renderer_backend_t          *backend;
+        ply_renderer_head_t             *head;
+        ply_pixel_buffer_t              *buffer;
+        ply_rectangle_t                  box;
+        long                             step_x, step_y;
+
+        double                           start_time;
+        double                           duration;
+
+        double                          *flush_times;
+        double                          *cpu_times;
+        size_t                           number_of_frames;
+        size_t                           frame_capacity;
+
+        uint32_t                         is_done : 1;
+} benchmark_t;
+
+static double
+get_cpu_time (void)
+{
+        struct timespec now = { 0L, };
+
+        clock_gettime (CLOCK_THREAD_CPUTIME_ID, &now);
+
+        return now.tv_sec + now.tv_nsec / 1000000000.0;
+}
+
+static int
+compare_doubles (const void *element_a,
+                 const void *element_b)
+{
+        double a = *(const double *) element_a;
+        double b = *(const double *) element_b;
+
+        return (a > b) - (a < b);
+}
+
+static void
+print_percentiles (const char *name,
+                   double     *values,
+                   size_t      number_of_values)
+{
+        if (number_of_values == 0) {
+                printf ("%s: no samples\n", name);
+                return;
+        }
+
+        qsort (values, number_of_values, sizeof(double), compare_doubles);
+
+        printf ("%s (ms): p50 %.3f p90 %.3f p99 %.3f max %.3f\n",
+                name,
+                1000.0 * values[number_of_values * 50 / 100],
+                1000.0 * values[number_of_values * 90 / 100],
+                1000.0 * values[number_of_values * 99 / 100],
+                1000.0 * values[number_of_values - 1]);
+}
+
+static void
+move_box (benchmark_t *benchmark)
+{
+        unsigned long width = ply_pixel_buffer_get_width (benchmark->buffer);
+        unsigned long height = ply_pixel_buffer_get_height (benchmark->buffer);
+
+        if (benchmark->box.x + benchmark->step_x < 0 ||
+            benchmark->box.x + benchmark->step_x + benchmark->box.width > width)
+                benchmark->step_x = -benchmark->step_x;
+        if (benchmark->box.y + benchmark->step_y < 0 ||
+            benchmark->box.y + benchmark->step_y + benchmark->box.height > height)
+                benchmark->step_y = -benchmark->step_y;
+
+        benchmark->box.x += benchmark->step_x;
+        benchmark->box.y += benchmark->step_y;
+}
+
+static void
+on_frame_timeout (benchmark_t      *benchmark,
+                  ply_event_loop_t *loop)
+{
+        double start_time, start_cpu_time;
+
+        if (ply_get_timestamp () - benchmark->start_time >= benchmark->duration) {
+                benchmark->is_done = true;
+                return;
+        }
+
+        if (benchmark->number_of_frames == benchmark->frame_capacity) {
+                benchmark->frame_capacity = MAX (benchmark->frame_capacity * 2, 1024);
+                benchmark->flush_times = realloc (benchmark->flush_times,
+                                                  benchmark->frame_capacity * sizeof(double));
+                benchmark->cpu_times = realloc (benchmark->cpu_times,
+                                                benchmark->frame_capacity * sizeof(double));
+        }
+
+        start_time = ply_get_timestamp ();
+        start_cpu_time = get_cpu_time ();
+
+        /* the old spot gets the background back, the new one the box */
+        ply_pixel_buffer_fill_with_hex_color (benchmark->buffer, &benchmark->box, 0x000000);
+        move_box (benchmark);
+        ply_pixel_buffer_fill_with_hex_color (benchmark->buffer, &benchmark->box,
+                                              benchmark->number_of_frames % 2 ? 0xff8000 : 0x0080ff);
+        benchmark->interface->flush_head (benchmark->backend, benchmark->head);
+
+        benchmark->flush_times[benchmark->number_of_frames] = ply_get_timestamp () - start_time;
+        benchmark->cpu_times[benchmark->number_of_frames] = get_cpu_time () - start_cpu_time;
+        benchmark->number_of_frames++;
+
+        ply_event_loop_watch_for_timeout (loop, FRAME_INTERVAL,
+                                          (ply_event_loop_timeout_handler_t)
+                                          on_frame_timeout, benchmark);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+        get_backend_interface_function_t get_backend_interface;
+        benchmark_t benchmark = { NULL };
+        ply_module_handle_t *module;
+        const char *flush_method;
+        unsigned long box_width = DEFAULT_BOX_SIZE, box_height = DEFAULT_BOX_SIZE;
+        double elapsed;
+
+        benchmark.duration = argc > 1 ? ply_strtod (argv[1]) : DEFAULT_DURATION;
+        if (argc > 2 && sscanf (argv[2], "%lux%lu", &box_width, &box_height) != 2) {
+                fprintf (stderr, "usage: %s [SECONDS [WIDTHxHEIGHT]]\n", argv[0]);
+                return 1;
+        }
+
+        if (getenv ("DISPLAY") == NULL) {
+                printf ("no X display, skipping\n");
+                return 77;
+        }
+
+        module = ply_open_module (BENCHMARK_X11_RENDERER_PLUGIN_PATH);
+        if (module == NULL) {
+                fprintf (stderr, "could not load %s\n", BENCHMARK_X11_RENDERER_PLUGIN_PATH);
+                return 1;
+        }
+
+        get_backend_interface = (get_backend_interface_function_t)
+                                ply_module_look_up_function (module,
+                                                             "ply_renderer_backend_get_interface");
+        benchmark.interface = get_backend_interface ();
+
+        benchmark.backend = benchmark.interface->create_backend (NULL, NULL, NULL);
+        if (benchmark.backend == NULL) {
+                printf ("could not connect to X display, skipping\n");
+                return 77;
+        }
+
+        if (!benchmark.interface->open_device (benchmark.backend) ||
+            !benchmark.interface->query_device (benchmark.backend, false) ||
+            !benchmark.interface->map_to_device (benchmark.backend)) {
+                fprintf (stderr, "could not set up x11 renderer\n");
+                return 1;
+        }
+
+        benchmark.loop = ply_event_loop_get_default ();
+        benchmark.head = ply_list_node_get_data (ply_list_get_first_node (benchmark.interface->get_heads (benchmark.backend)));
+        benchmark.buffer = benchmark.interface->get_buffer_for_head (benchmark.backend, benchmark.head);
+
+        benchmark.box.width = MIN (box_width, ply_pixel_buffer_get_width (benchmark.buffer));
+        benchmark.box.height = MIN (box_height, ply_pixel_buffer_get_height (benchmark.buffer));
+        benchmark.step_x = 7;
+        benchmark.step_y = 5;
+
+        flush_method = getenv ("PLY_X11_FLUSH_METHOD");
+
+        benchmark.start_time = ply_get_timestamp ();
+        on_frame_timeout (&benchmark, benchmark.loop);
+
+        while (!benchmark.is_done) {
+                ply_event_loop_process_pending_events (benchmark.loop);
+        }
+        elapsed = ply_get_timestamp () - benchmark.start_time;
+
+        printf ("flush method: %s\n", flush_method != NULL ? flush_method : "default");
+        printf ("head: %lux%lu, box: %lux%lu\n",
+                ply_pixel_buffer_get_width (benchmark.buffer),
+                ply_pixel_buffer_get_height (benchmark.buffer),
+                benchmark.box.width, benchmark.box.height);
+        printf ("frames: %zu in %.1f seconds (%.1f per second)\n",
+                benchmark.number_of_frames, elapsed,
+                benchmark.number_of_frames / elapsed);
+        print_percentiles ("flush time", benchmark.flush_times, benchmark.number_of_frames);
+        print_percentiles ("flush cpu time", benchmark.cpu_times, benchmark.number_of_frames);
+
+        benchmark.interface->unmap_from_device (benchmark.backend);
+        benchmark.interface->close_device (benchmark.backend);
+        benchmark.interface->destroy_backend (benchmark.backend);
+        ply_close_module (module);
+        free (benchmark.flush_times);
+        free (benchmark.cpu_times);
+
+        return 0;
+}
@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "ply-test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ply-device-probe-queue-private.h"
+#include "ply-event-loop.h"
+
+/* Everything that happens is written down in order, one letter each:
+ * probed devices by name, 'f' for freed ones, '-' for other work on the
+ * loop, 'D' for the deadline and '!' once the queue has drained
+ */
+typedef struct
+{
+        ply_event_loop_t         *loop;
+        ply_device_probe_queue_t *queue;
+        char                      log[64];
+        size_t                    log_length;
+        double                    probe_duration;
+        bool                      has_drained;
+} fixture_t;
+
+static void
+append_to_log (fixture_t *fixture,
+               char       event)
+{
+        if (fixture->log_length + 1 < sizeof(fixture->log))
+                fixture->log[fixture->log_length++] = event;
+}
+
+static void
+on_probe (fixture_t *fixture,
+          char      *device)
+{
+        append_to_log (fixture, *device);
+
+        if (fixture->probe_duration > 0.0)
+                usleep ((useconds_t) (fixture->probe_duration * 1000000));
+
+        free (device);
+}
+
+static void
+on_free (void *device)
+{
+        free (device);
+}
+
+static void
+on_drained (fixture_t *fixture)
+{
+        append_to_log (fixture, '!');
+        fixture->has_drained = true;
+}
+
+static void
+on_other_work (fixture_t        *fixture,
+               ply_event_loop_t *loop)
+{
+        if (fixture->has_drained)
+                return;
+
+        append_to_log (fixture, '-');
+        ply_event_loop_watch_for_timeout (fixture->loop, 0.0001,
+                                          (ply_event_loop_timeout_handler_t)
+                                          on_other_work, fixture);
+}
+
+static void
+on_deadline (fixture_t        *fixture,
+             ply_event_loop_t *loop)
+{
+        append_to_log (fixture, 'D');
+
+        /* like the device timeout, which finds more devices to open and
+         * only falls back once those have had their turn too
+         */
+        ply_device_probe_queue_add (fixture->queue, "/dev/fb0", strdup ("e"));
+        ply_device_probe_queue_call_when_drained (fixture->queue,
+                                                  (ply_device_probe_queue_drained_handler_t)
+                                                  on_drained);
+}
+
+static void
+set_up (fixture_t *fixture)
+{
+        memset (fixture, 0, sizeof(*fixture));
+        fixture->loop = ply_event_loop_new ();
+        fixture->queue = ply_device_probe_queue_new (fixture->loop,
+                                                     (ply_device_probe_handler_t)
+                                                     on_probe,
+                                                     on_free,
+                                                     fixture);
+}
+
+static void
+tear_down (fixture_t *fixture)
+{
+        ply_device_probe_queue_free (fixture->queue);
+        ply_event_loop_free (fixture->loop);
+}
+
+static void
+run_until_drained (fixture_t *fixture)
+{
+        while (!fixture->has_drained) {
+                ply_event_loop_process_pending_events (fixture->loop);
+        }
+}
+
+static bool
+test_devices_are_probed_one_per_loop_turn (void)
+{
+        fixture_t fixture;
+
+        set_up (&fixture);
+
+        PLY_TEST_ASSERT (ply_device_probe_queue_add (fixture.queue, "/dev/dri/card0", strdup ("a")));
+        PLY_TEST_ASSERT (ply_device_probe_queue_add (fixture.queue, "/dev/dri/card1", strdup ("b")));
+        PLY_TEST_ASSERT (ply_device_probe_queue_add (fixture.queue, "/dev/dri/card2", strdup ("c")));
+        PLY_TEST_ASSERT (!ply_device_probe_queue_is_empty (fixture.queue));
+
+        /* nothing is opened until the loop runs */
+        PLY_TEST_ASSERT (fixture.log_length == 0);
+
+        ply_device_probe_queue_call_when_drained (fixture.queue,
+                                                  (ply_device_probe_queue_drained_handler_t)
+                                                  on_drained);
+        on_other_work (&fixture, fixture.loop);
+        run_until_drained (&fixture);
+
+        /* other work gets a turn between each open */
+        PLY_TEST_ASSERT (strcmp (fixture.log, "-a-b-c!") == 0);
+        PLY_TEST_ASSERT (ply_device_probe_queue_is_empty (fixture.queue));
+
+        tear_down (&fixture);
+        return true;
+}
+
+static bool
+test_duplicate_and_removed_devices_are_not_probed (void)
+{
+        fixture_t fixture;
+        char *duplicate;
+
+        set_up (&fixture);
+
+        PLY_TEST_ASSERT (ply_device_probe_queue_add (fixture.queue, "/dev/dri/card0", strdup ("a")));
+        PLY_TEST_ASSERT (ply_device_probe_queue_add (fixture.queue, "/dev/dri/card1", strdup ("b")));
+        PLY_TEST_ASSERT (ply_device_probe_queue_add (fixture.queue, "/dev/dri/card2", strdup ("c")));
+
+        /* a second add doesn't take ownership */
+        duplicate = strdup ("x");
+        PLY_TEST_ASSERT (!ply_device_probe_queue_add (fixture.queue, "/dev/dri/card1", duplicate));
+        free (duplicate);
+
+        /* udev removed it before it had its turn */
+        PLY_TEST_ASSERT (ply_device_probe_queue_remove (fixture.queue, "/dev/dri/card1"));
+        PLY_TEST_ASSERT (!ply_device_probe_queue_remove (fixture.queue, "/dev/dri/card1"));
+
+        ply_device_probe_queue_call_when_drained (fixture.queue,
+                                                  (ply_device_probe_queue_drained_handler_t)
+                                                  on_drained);
+        run_until_drained (&fixture);
+
+        PLY_TEST_ASSERT (strcmp (fixture.log, "ac!") == 0);
+
+        tear_down (&fixture);
+        return true;
+}
+
+static bool
+test_drained_handler_runs_right_away_when_empty (void)
+{
+        fixture_t fixture;
+
+        set_up (&fixture);
+
+        ply_device_probe_queue_call_when_drained (fixture.queue,
+                                                  (ply_device_probe_queue_drained_handler_t)
+                                                  on_drained);
+        PLY_TEST_ASSERT (fixture.has_drained);
+
+        /* and still runs if the last queued device goes away unprobed */
+        fixture.has_drained = false;
+        PLY_TEST_ASSERT (ply_device_probe_queue_add (fixture.queue, "/dev/dri/card0", strdup ("a")));
+        ply_device_probe_queue_call_when_drained (fixture.queue,
+                                                  (ply_device_probe_queue_drained_handler_t)
+                                                  on_drained);
+        PLY_TEST_ASSERT (!fixture.has_drained);
+        PLY_TEST_ASSERT (ply_device_probe_queue_remove (fixture.queue, "/dev/dri/card0"));
+        run_until_drained (&fixture);
+
+        PLY_TEST_ASSERT (strcmp (fixture.log, "!!") == 0);
+
+        tear_down (&fixture);
+        return true;
+}
+
+static void
+on_tick (fixture_t        *fixture,
+         ply_event_loop_t *loop)
+{
+        append_to_log (fixture, '-');
+}
+
+static bool
+test_paused_queue_waits (void)
+{
+        fixture_t fixture;
+
+        set_up (&fixture);
+
+        ply_device_probe_queue_pause (fixture.queue);
+        PLY_TEST_ASSERT (ply_device_probe_queue_add (fixture.queue, "/dev/dri/card0", strdup ("a")));
+        ply_device_probe_queue_call_when_drained (fixture.queue,
+                                                  (ply_device_probe_queue_drained_handler_t)
+                                                  on_drained);
+
+        ply_event_loop_watch_for_timeout (fixture.loop, 0.01,
+                                          (ply_event_loop_timeout_handler_t)
+                                          on_tick, &fixture);
+        while (fixture.log_length == 0) {
+                ply_event_loop_process_pending_events (fixture.loop);
+        }
+        PLY_TEST_ASSERT (strcmp (fixture.log, "-") == 0);
+
+        ply_device_probe_queue_unpause (fixture.queue);
+        run_until_drained (&fixture);
+        PLY_TEST_ASSERT (strcmp (fixture.log, "-a!") == 0);
+
+        tear_down (&fixture);
+        return true;
+}
+
+static bool
+test_deadline_counts_from_before_probing (void)
+{
+        fixture_t fixture;
+
+        set_up (&fixture);
+
+        /* Each open takes 50ms. The deadline is armed before anything is
+         * queued, so it is due part way through the second open and runs
+         * right after it, ahead of the third. The devices it finds wait
+         * behind the ones already queued, and the fallback check waits
+         * for all of them.
+         */
+        fixture.probe_duration = 0.05;
+        ply_event_loop_watch_for_timeout (fixture.loop, 0.075,
+                                          (ply_event_loop_timeout_handler_t)
+                                          on_deadline, &fixture);
+        PLY_TEST_ASSERT (ply_device_probe_queue_add (fixture.queue, "/dev/dri/card0", strdup ("a")));
+        PLY_TEST_ASSERT (ply_device_probe_queue_add (fixture.queue, "/dev/dri/card1", strdup ("b")));
+        PLY_TEST_ASSERT (ply_device_probe_queue_add (fixture.queue, "/dev/dri/card2", strdup ("c")));
+
+        run_until_drained (&fixture);
+
+        PLY_TEST_ASSERT (strcmp (fixture.log, "abDce!") == 0);
+
+        tear_down (&fixture);
+        return true;
+}
+
+static const ply_test_case_t test_cases[] =
+{
+        PLY_TEST_CASE (test_devices_are_probed_one_per_loop_turn),
+        PLY_TEST_CASE (test_duplicate_and_removed_devices_are_not_probed),
+        PLY_TEST_CASE (test_drained_handler_runs_right_away_when_empty),
+        PLY_TEST_CASE (test_paused_queue_waits),
+        PLY_TEST_CASE (test_deadline_counts_from_before_probing),
+};
+
+PLY_TEST_MAIN (test_cases)
@@ -10,10 +10,16 @@
 #include "ply-test.h"
 
 #include <dirent.h>
+#include <stdint.h>
+#include <string.h>
 
+#include "ply-frame-buffer-pixels-private.h"
 #include "ply-renderer-plugin.h"
 #include "ply-utils.h"
 
+#define GRADIENT_WIDTH 256
+#define GRADIENT_HEIGHT 8
+
 typedef ply_renderer_plugin_interface_t *
 (*get_backend_interface_function_t) (void);
 
@@ -75,9 +81,245 @@ test_destroy_backend_closes_device (void)
         return true;
 }
 
+static const ply_frame_buffer_pixel_format_t rgb565_format = {
+        .red_bit_position   = 11,
+        .green_bit_position = 5,
+        .blue_bit_position  = 0,
+        .bits_for_red       = 5,
+        .bits_for_green     = 6,
+        .bits_for_blue      = 5,
+        .bytes_per_pixel    = 2,
+};
+
+static const ply_frame_buffer_pixel_format_t rgb888_format = {
+        .red_bit_position   = 16,
+        .green_bit_position = 8,
+        .blue_bit_position  = 0,
+        .bits_for_red       = 8,
+        .bits_for_green     = 8,
+        .bits_for_blue      = 8,
+        .bytes_per_pixel    = 3,
+};
+
+static const ply_frame_buffer_pixel_format_t bgr888_format = {
+        .red_bit_position   = 0,
+        .green_bit_position = 8,
+        .blue_bit_position  = 16,
+        .bits_for_red       = 8,
+        .bits_for_green     = 8,
+        .bits_for_blue      = 8,
+        .bytes_per_pixel    = 3,
+};
+
+static const ply_frame_buffer_pixel_format_t abgr8888_format = {
+        .red_bit_position   = 0,
+        .green_bit_position = 8,
+        .blue_bit_position  = 16,
+        .alpha_bit_position = 24,
+        .bits_for_red       = 8,
+        .bits_for_green     = 8,
+        .bits_for_blue      = 8,
+        .bits_for_alpha     = 8,
+        .bytes_per_pixel    = 4,
+};
+
+/* The plugin's conversion before it went table driven, without the
+ * error diffusion state it carried from pixel to pixel
+ */
+static uint32_t
+convert_pixel_the_old_way (const ply_frame_buffer_pixel_format_t *format,
+                           uint32_t                               pixel_value)
+{
+        uint8_t r, g, b, a;
+
+        a = (pixel_value >> 24) >> (8 - format->bits_for_alpha);
+        r = ((pixel_value >> 16) & 0xff) >> (8 - format->bits_for_red);
+        g = ((pixel_value >> 8) & 0xff) >> (8 - format->bits_for_green);
+        b = (pixel_value & 0xff) >> (8 - format->bits_for_blue);
+
+        return (a << format->alpha_bit_position)
+               | (r << format->red_bit_position)
+               | (g << format->green_bit_position)
+               | (b << format->blue_bit_position);
+}
+
+static uint32_t
+get_device_pixel (const char  *output,
+                  unsigned int bytes_per_pixel,
+                  int          index)
+{
+        const unsigned char *bytes = (const unsigned char *) output + index * bytes_per_pixel;
+        uint16_t short_value;
+        uint32_t value;
+
+        if (bytes_per_pixel == 2) {
+                memcpy (&short_value, bytes, 2);
+                return short_value;
+        }
+
+        if (bytes_per_pixel == 4) {
+                memcpy (&value, bytes, 4);
+                return value;
+        }
+
+        return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16);
+}
+
+static uint32_t
+get_channel (uint32_t device_pixel_value,
+             uint32_t bit_position,
+             uint32_t bits)
+{
+        return (device_pixel_value >> bit_position) & ((1 << bits) - 1);
+}
+
+static bool
+check_rows_match_old_conversion (const ply_frame_buffer_pixel_format_t *format,
+                                 const uint32_t                        *pixels,
+                                 int                                    width,
+                                 int                                    height)
+{
+        ply_frame_buffer_pixel_tables_t *tables;
+        char *output;
+        int x, y;
+
+        tables = ply_frame_buffer_pixel_tables_new (format);
+        output = malloc (width * format->bytes_per_pixel);
+
+        for (y = 0; y < height; y++) {
+                ply_frame_buffer_pixel_tables_convert_row (tables, pixels + y * width,
+                                                           0, y, width, output);
+
+                for (x = 0; x < width; x++) {
+                        uint32_t expected = convert_pixel_the_old_way (format, pixels[y * width + x]);
+
+                        PLY_TEST_ASSERT (get_device_pixel (output, format->bytes_per_pixel, x) == expected);
+                }
+        }
+
+        free (output);
+        ply_frame_buffer_pixel_tables_free (tables);
+        return true;
+}
+
+static bool
+test_8_bit_channels_match_old_conversion (void)
+{
+        uint32_t pixels[GRADIENT_WIDTH * GRADIENT_HEIGHT];
+        uint32_t seed = 1;
+        int i;
+
+        /* 8 bit channels have nothing to dither, so every pixel must
+         * come out exactly as before
+         */
+        for (i = 0; i < GRADIENT_WIDTH * GRADIENT_HEIGHT; i++) {
+                seed = seed * 1103515245 + 12345;
+                pixels[i] = seed;
+        }
+
+        PLY_TEST_ASSERT (check_rows_match_old_conversion (&rgb888_format, pixels,
+                                                          GRADIENT_WIDTH, GRADIENT_HEIGHT));
+        PLY_TEST_ASSERT (check_rows_match_old_conversion (&bgr888_format, pixels,
+                                                          GRADIENT_WIDTH, GRADIENT_HEIGHT));
+        PLY_TEST_ASSERT (check_rows_match_old_conversion (&abgr8888_format, pixels,
+                                                          GRADIENT_WIDTH, GRADIENT_HEIGHT));
+        return true;
+}
+
+static bool
+test_rgb565_exact_colors_match_old_conversion (void)
+{
+        uint32_t pixels[32 * 64];
+        int red, green;
+
+        /* Colors the device can show exactly aren't touched by dithering */
+        for (green = 0; green < 64; green++) {
+                for (red = 0; red < 32; red++) {
+                        pixels[green * 32 + red] = 0xff000000 |
+                                                   (red << 19) |
+                                                   (green << 10) |
+                                                   ((31 - red) << 3);
+                }
+        }
+
+        PLY_TEST_ASSERT (check_rows_match_old_conversion (&rgb565_format, pixels, 32, 64));
+        return true;
+}
+
+static bool
+test_rgb565_gradient_is_dithered (void)
+{
+        uint32_t pixels[GRADIENT_WIDTH * GRADIENT_HEIGHT];
+        ply_frame_buffer_pixel_tables_t *tables;
+        uint32_t red_sums[GRADIENT_WIDTH / 4] = { 0 };
+        uint32_t green_sums[GRADIENT_WIDTH / 4] = { 0 };
+        char output[GRADIENT_WIDTH * 2], offset_output[GRADIENT_WIDTH * 2];
+        int x, y, block;
+
+        /* Every 4x4 dither cell gets one flat gray, 0, 4, 8, ... 252 */
+        for (y = 0; y < GRADIENT_HEIGHT; y++) {
+                for (x = 0; x < GRADIENT_WIDTH; x++) {
+                        uint32_t value = (x / 4) * 4;
+
+                        pixels[y * GRADIENT_WIDTH + x] = 0xff000000 | (value << 16) | (value << 8) | value;
+                }
+        }
+
+        tables = ply_frame_buffer_pixel_tables_new (&rgb565_format);
+
+        for (y = 0; y < 4; y++) {
+                ply_frame_buffer_pixel_tables_convert_row (tables, pixels + y * GRADIENT_WIDTH,
+                                                           0, y, GRADIENT_WIDTH, output);
+
+                for (x = 0; x < GRADIENT_WIDTH; x++) {
+                        uint32_t device_pixel_value = get_device_pixel (output, 2, x);
+                        uint32_t old_value = convert_pixel_the_old_way (&rgb565_format,
+                                                                        pixels[y * GRADIENT_WIDTH + x]);
+                        uint32_t red = get_channel (device_pixel_value, 11, 5);
+                        uint32_t old_red = get_channel (old_value, 11, 5);
+                        uint32_t green = get_channel (device_pixel_value, 5, 6);
+                        uint32_t old_green = get_channel (old_value, 5, 6);
+
+                        /* Each pixel is at most one device step above plain truncation */
+                        PLY_TEST_ASSERT (red == old_red || red == old_red + 1);
+                        PLY_TEST_ASSERT (green == old_green || green == old_green + 1);
+
+                        red_sums[x / 4] += red;
+                        green_sums[x / 4] += green;
+                }
+
+                /* A row converted in pieces uses the same dither cells */
+                ply_frame_buffer_pixel_tables_convert_row (tables, pixels + y * GRADIENT_WIDTH + 3,
+                                                           3, y, GRADIENT_WIDTH - 3, offset_output);
+                PLY_TEST_ASSERT (memcmp (offset_output, output + 3 * 2, (GRADIENT_WIDTH - 3) * 2) == 0);
+        }
+
+        /* Away from the top, where values clamp, a cell averages out to
+         * exactly the gray it was given
+         */
+        for (block = 0; block < GRADIENT_WIDTH / 4; block++) {
+                uint32_t value = block * 4;
+
+                if (value + 8 > 255)
+                        break;
+
+                PLY_TEST_ASSERT (red_sums[block] * 8 == value * 16);
+                PLY_TEST_ASSERT (green_sums[block] * 4 == value * 16);
+        }
+
+        /* Plain truncation would have lost every gray between steps */
+        PLY_TEST_ASSERT (red_sums[1] > 0);
+
+        ply_frame_buffer_pixel_tables_free (tables);
+        return true;
+}
+
 static const ply_test_case_t test_cases[] =
 {
         PLY_TEST_CASE (test_destroy_backend_closes_device),
+        PLY_TEST_CASE (test_8_bit_channels_match_old_conversion),
+        PLY_TEST_CASE (test_rgb565_exact_colors_match_old_conversion),
+        PLY_TEST_CASE (test_rgb565_gradient_is_dithered),
 };
 
 PLY_TEST_MAIN (test_cases)
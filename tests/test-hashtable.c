@@ -20,6 +20,8 @@
 #include "ply-test.h"
 
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "ply-hashtable.h"
 
@@ -185,6 +187,81 @@ test_foreach_visits_each_live_entry (void)
         return true;
 }
 
+static int
+count_distinct_buckets (unsigned int (*hash) (void *),
+                        void         **keys,
+                        int            number_of_keys)
+{
+        static bool buckets[1024];
+        int i, count = 0;
+
+        memset (buckets, 0, sizeof(buckets));
+
+        for (i = 0; i < number_of_keys; i++) {
+                unsigned int bucket = hash (keys[i]) & 1023;
+
+                if (!buckets[bucket])
+                        count++;
+                buckets[bucket] = true;
+        }
+
+        return count;
+}
+
+static bool
+test_sequential_keys_spread_over_buckets (void)
+{
+        static char names[1024][8];
+        void *keys[1024];
+        int i;
+
+        /* a random hash fills about 1 - 1/e of the buckets */
+        for (i = 0; i < 1024; i++) {
+                snprintf (names[i], sizeof(names[i]), "%d", i);
+                keys[i] = names[i];
+        }
+        PLY_TEST_ASSERT (count_distinct_buckets (ply_hashtable_string_hash, keys, 1024) > 600);
+
+        for (i = 0; i < 1024; i++) {
+                keys[i] = (void *) (intptr_t) (0x10000 + i * 16);
+        }
+        PLY_TEST_ASSERT (count_distinct_buckets (ply_hashtable_direct_hash, keys, 1024) > 600);
+
+        return true;
+}
+
+static bool
+test_table_shrinks_after_mass_removal (void)
+{
+        static int keys[4096];
+        ply_hashtable_t *table;
+        int i;
+
+        table = ply_hashtable_new (NULL, NULL);
+        for (i = 0; i < 4096; i++) {
+                ply_hashtable_insert (table, &keys[i], &keys[i]);
+        }
+
+        for (i = 0; i < 4096; i++) {
+                if (i % 1000 != 0)
+                        PLY_TEST_ASSERT (ply_hashtable_remove (table, &keys[i]) == &keys[i]);
+        }
+
+        /* the next insertion rebuilds the table at its new size */
+        ply_hashtable_insert (table, &keys[1], &keys[1]);
+
+        PLY_TEST_ASSERT (ply_hashtable_get_size (table) == 6);
+        for (i = 0; i < 4096; i++) {
+                if (i % 1000 == 0 || i == 1)
+                        PLY_TEST_ASSERT (ply_hashtable_lookup (table, &keys[i]) == &keys[i]);
+                else
+                        PLY_TEST_ASSERT (ply_hashtable_lookup (table, &keys[i]) == NULL);
+        }
+
+        ply_hashtable_free (table);
+        return true;
+}
+
 static const ply_test_case_t test_cases[] =
 {
         PLY_TEST_CASE (test_new_table_is_empty),
@@ -193,6 +270,8 @@ static const ply_test_case_t test_cases[] =
         PLY_TEST_CASE (test_collision_chain_survives_removal),
         PLY_TEST_CASE (test_resize_preserves_live_entries),
         PLY_TEST_CASE (test_foreach_visits_each_live_entry),
+        PLY_TEST_CASE (test_sequential_keys_spread_over_buckets),
+        PLY_TEST_CASE (test_table_shrinks_after_mass_removal),
 };
 
 PLY_TEST_MAIN (test_cases)
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ */
+
+#include "ply-test.h"
+
+#include "ply-list.h"
+#include "ply-pixel-buffer.h"
+#include "ply-rectangle.h"
+#include "ply-renderer-plugin.h"
+#include "ply-utils.h"
+
+#include "headless-renderer.h"
+
+typedef ply_renderer_plugin_interface_t *
+(*get_backend_interface_function_t) (void);
+
+static ply_module_handle_t *module;
+static ply_renderer_plugin_interface_t *plugin_interface;
+static ply_renderer_headless_get_statistics_function_t get_statistics;
+
+static bool
+load_plugin (void)
+{
+        get_backend_interface_function_t get_backend_interface;
+
+        module = ply_open_module (TEST_HEADLESS_RENDERER_PLUGIN_PATH);
+        PLY_TEST_ASSERT (module != NULL);
+
+        get_backend_interface = (get_backend_interface_function_t)
+                                ply_module_look_up_function (module,
+                                                             "ply_renderer_backend_get_interface");
+        PLY_TEST_ASSERT (get_backend_interface != NULL);
+        plugin_interface = get_backend_interface ();
+
+        get_statistics = (ply_renderer_headless_get_statistics_function_t)
+                         ply_module_look_up_function (module,
+                                                      "ply_renderer_headless_get_statistics");
+        PLY_TEST_ASSERT (get_statistics != NULL);
+
+        return true;
+}
+
+static bool
+test_heads_follow_device_name (void)
+{
+        ply_renderer_backend_t *backend;
+        ply_pixel_buffer_t *buffer;
+        ply_list_t *heads;
+        ply_renderer_head_t *head;
+
+        PLY_TEST_ASSERT (load_plugin ());
+
+        backend = plugin_interface->create_backend ("headless:640x480,800x600@2/90:rgb565", NULL, NULL);
+        PLY_TEST_ASSERT (backend != NULL);
+        PLY_TEST_ASSERT (plugin_interface->open_device (backend));
+        PLY_TEST_ASSERT (plugin_interface->query_device (backend, false));
+
+        heads = plugin_interface->get_heads (backend);
+        PLY_TEST_ASSERT (ply_list_get_length (heads) == 2);
+
+        head = ply_list_node_get_data (ply_list_get_first_node (heads));
+        buffer = plugin_interface->get_buffer_for_head (backend, head);
+        PLY_TEST_ASSERT (ply_pixel_buffer_get_width (buffer) == 640);
+        PLY_TEST_ASSERT (ply_pixel_buffer_get_height (buffer) == 480);
+
+        /* rotated heads are drawn in their logical orientation */
+        head = ply_list_node_get_data (ply_list_get_last_node (heads));
+        buffer = plugin_interface->get_buffer_for_head (backend, head);
+        PLY_TEST_ASSERT (ply_pixel_buffer_get_width (buffer) == 600 / 2);
+        PLY_TEST_ASSERT (ply_pixel_buffer_get_height (buffer) == 800 / 2);
+        PLY_TEST_ASSERT (ply_pixel_buffer_get_device_scale (buffer) == 2);
+
+        plugin_interface->close_device (backend);
+        plugin_interface->destroy_backend (backend);
+
+        /* a bad description means there's nothing to render to */
+        backend = plugin_interface->create_backend ("headless:640by480", NULL, NULL);
+        PLY_TEST_ASSERT (backend != NULL);
+        PLY_TEST_ASSERT (!plugin_interface->query_device (backend, false));
+        plugin_interface->destroy_backend (backend);
+
+        PLY_TEST_ASSERT (plugin_interface->create_backend ("/dev/fb0", NULL, NULL) == NULL);
+
+        ply_close_module (module);
+        return true;
+}
+
+static bool
+test_flushes_record_damage (void)
+{
+        const ply_renderer_headless_statistics_t *statistics;
+        ply_renderer_backend_t *backend;
+        ply_renderer_head_t *head;
+        ply_pixel_buffer_t *buffer;
+        ply_rectangle_t area = { .x = 10, .y = 10, .width = 20, .height = 5 };
+
+        PLY_TEST_ASSERT (load_plugin ());
+
+        backend = plugin_interface->create_backend ("headless:64x64", NULL, NULL);
+        PLY_TEST_ASSERT (plugin_interface->open_device (backend));
+        PLY_TEST_ASSERT (plugin_interface->query_device (backend, false));
+        statistics = get_statistics ();
+
+        /* mapping draws the whole head once */
+        PLY_TEST_ASSERT (plugin_interface->map_to_device (backend));
+        PLY_TEST_ASSERT (statistics->number_of_flushes == 1);
+        PLY_TEST_ASSERT (statistics->total_damaged_pixels == 64 * 64);
+
+        head = ply_list_node_get_data (ply_list_get_first_node (plugin_interface->get_heads (backend)));
+        buffer = plugin_interface->get_buffer_for_head (backend, head);
+
+        ply_pixel_buffer_fill_with_hex_color (buffer, &area, 0xff0000);
+        plugin_interface->flush_head (backend, head);
+        PLY_TEST_ASSERT (statistics->number_of_flushes == 2);
+        PLY_TEST_ASSERT (statistics->number_of_recorded_flushes == 2);
+        PLY_TEST_ASSERT (statistics->flushes[1].damaged_pixels == 20 * 5);
+        PLY_TEST_ASSERT (statistics->flushes[1].number_of_areas == 1);
+
+        /* nothing changed, so there's nothing to flush */
+        plugin_interface->flush_head (backend, head);
+        PLY_TEST_ASSERT (statistics->number_of_flushes == 2);
+
+        plugin_interface->unmap_from_device (backend);
+        plugin_interface->close_device (backend);
+        plugin_interface->destroy_backend (backend);
+        ply_close_module (module);
+        return true;
+}
+
+static const ply_test_case_t test_cases[] =
+{
+        PLY_TEST_CASE (test_heads_follow_device_name),
+        PLY_TEST_CASE (test_flushes_record_damage),
+};
+
+PLY_TEST_MAIN (test_cases)
@@ -41,6 +41,15 @@ static const uint8_t rgba_png[] = {
         0x60, 0x82,
 };
 
+static const uint8_t rgb_png[] = {
+        0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d,
+        0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01,
+        0x08, 0x02, 0x00, 0x00, 0x00, 0x7b, 0x40, 0xe8, 0xdd, 0x00, 0x00, 0x00,
+        0x0f, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x63, 0x10, 0x54, 0x32, 0x76,
+        0x09, 0x4d, 0x03, 0x00, 0x03, 0xbf, 0x01, 0x66, 0xc4, 0xf7, 0x5e, 0x24,
+        0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+};
+
 static const uint8_t bottom_up_bmp[] = {
         0x42, 0x4d, 0x46, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x36, 0x00,
         0x00, 0x00, 0x28, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, 0x00,
@@ -125,6 +134,7 @@ fixture_decodes_rgba_png (const char *path)
         PLY_TEST_ASSERT (ply_image_get_height (image) == 1);
 
         pixels = ply_image_get_data (image);
+        PLY_TEST_ASSERT (!ply_pixel_buffer_is_opaque (ply_image_get_buffer (image)));
         PLY_TEST_ASSERT (pixels[0] == UINT32_C (0xff112233));
         PLY_TEST_ASSERT (pixels[1] == UINT32_C (0x80804000));
 
@@ -132,6 +142,26 @@ fixture_decodes_rgba_png (const char *path)
         return true;
 }
 
+static bool
+fixture_decodes_rgb_png (const char *path)
+{
+        ply_image_t *image;
+        uint32_t *pixels;
+
+        image = ply_image_new (path);
+        PLY_TEST_ASSERT (ply_image_load (image));
+        PLY_TEST_ASSERT (ply_image_get_width (image) == 2);
+        PLY_TEST_ASSERT (ply_image_get_height (image) == 1);
+
+        pixels = ply_image_get_data (image);
+        PLY_TEST_ASSERT (ply_pixel_buffer_is_opaque (ply_image_get_buffer (image)));
+        PLY_TEST_ASSERT (pixels[0] == UINT32_C (0xff112233));
+        PLY_TEST_ASSERT (pixels[1] == UINT32_C (0xff445566));
+
+        ply_image_free (image);
+        return true;
+}
+
 static bool
 test_png_decodes_rgba_pixels (void)
 {
@@ -153,6 +183,14 @@ fixture_is_rejected (const char *path)
         return rejected;
 }
 
+static bool
+test_png_without_alpha_is_opaque (void)
+{
+        return with_fixture (rgb_png,
+                             sizeof(rgb_png),
+                             fixture_decodes_rgb_png);
+}
+
 static bool
 test_truncated_png_is_rejected (void)
 {
@@ -333,6 +371,7 @@ test_image_wrappers_transform_and_transfer (void)
 static const ply_test_case_t test_cases[] =
 {
         PLY_TEST_CASE (test_png_decodes_rgba_pixels),
+        PLY_TEST_CASE (test_png_without_alpha_is_opaque),
         PLY_TEST_CASE (test_truncated_png_is_rejected),
         PLY_TEST_CASE (test_bmp_decodes_bottom_up_rows),
         PLY_TEST_CASE (test_bmp_decodes_top_down_rows),
@@ -18,6 +18,9 @@
  */
 
 #include "ply-test.h"
+#include "ply-test-seeded-random.h"
+
+#include <stdlib.h>
 
 #include "ply-list.h"
 
@@ -183,6 +186,96 @@ test_stable_sort_retains_equal_element_order (void)
         return true;
 }
 
+static bool
+list_is_linked_in_order (ply_list_t *list)
+{
+        ply_list_node_t *node, *previous_node = NULL;
+        int length = 0;
+
+        ply_list_foreach (list, node) {
+                if (ply_list_get_previous_node (list, node) != previous_node)
+                        return false;
+
+                previous_node = node;
+                length++;
+        }
+
+        return previous_node == ply_list_get_last_node (list) &&
+               length == ply_list_get_length (list);
+}
+
+static bool
+test_large_stable_sort_keeps_order (void)
+{
+        ply_test_seeded_random_t random = { .state = 38 };
+        static const int lengths[] = { 1000, 4097, 10000 };
+        sortable_item_t *items;
+        size_t i, j;
+
+        for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+                ply_list_t *list;
+                ply_list_node_t *node;
+                sortable_item_t *previous_item = NULL;
+                int length = lengths[i];
+
+                items = calloc (length, sizeof(sortable_item_t));
+                list = ply_list_new ();
+
+                for (j = 0; j < (size_t) length; j++) {
+                        items[j].key = ply_test_seeded_random_range (&random, 64);
+                        items[j].sequence = j;
+                        ply_list_append_data (list, &items[j]);
+                }
+
+                ply_list_sort_stable (list, compare_sortable_items);
+                PLY_TEST_ASSERT (list_is_linked_in_order (list));
+
+                ply_list_foreach (list, node) {
+                        sortable_item_t *item = ply_list_node_get_data (node);
+
+                        if (previous_item != NULL) {
+                                PLY_TEST_ASSERT (previous_item->key <= item->key);
+                                if (previous_item->key == item->key)
+                                        PLY_TEST_ASSERT (previous_item->sequence < item->sequence);
+                        }
+                        previous_item = item;
+                }
+
+                /* sorting an already sorted list leaves it alone */
+                ply_list_sort (list, compare_sortable_items);
+                PLY_TEST_ASSERT (list_is_linked_in_order (list));
+                PLY_TEST_ASSERT (ply_list_get_length (list) == length);
+
+                ply_list_free (list);
+                free (items);
+        }
+
+        return true;
+}
+
+static bool
+test_removed_nodes_are_reused (void)
+{
+        int values[3] = { 0, 1, 2 };
+        ply_list_node_t *node, *reused_node;
+        ply_list_t *list;
+
+        list = ply_list_new ();
+        ply_list_append_data (list, &values[0]);
+        node = ply_list_append_data (list, &values[1]);
+
+        ply_list_remove_node (list, node);
+        reused_node = ply_list_append_data (list, &values[2]);
+
+        PLY_TEST_ASSERT (reused_node == node);
+        PLY_TEST_ASSERT (ply_list_node_get_data (reused_node) == &values[2]);
+        PLY_TEST_ASSERT (ply_list_get_next_node (list, reused_node) == NULL);
+        PLY_TEST_ASSERT (list_is_linked_in_order (list));
+
+        ply_list_free (list);
+        return true;
+}
+
 static const ply_test_case_t test_cases[] =
 {
         PLY_TEST_CASE (test_new_list_is_empty),
@@ -190,6 +283,8 @@ static const ply_test_case_t test_cases[] =
         PLY_TEST_CASE (test_removal_updates_ends_and_search),
         PLY_TEST_CASE (test_sort_orders_elements),
         PLY_TEST_CASE (test_stable_sort_retains_equal_element_order),
+        PLY_TEST_CASE (test_large_stable_sort_keeps_order),
+        PLY_TEST_CASE (test_removed_nodes_are_reused),
 };
 
 PLY_TEST_MAIN (test_cases)
@@ -28,6 +28,7 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "ply-event-loop.h"
 #include "ply-logger.h"
 
 typedef struct
@@ -298,6 +299,104 @@ test_full_buffer_retains_recent_injections (void)
         return true;
 }
 
+static bool
+test_deferred_policy_flushes_in_batches (void)
+{
+        static const char message[] = "deferred line\n";
+        char output[sizeof(message) - 1];
+        ply_event_loop_t *loop;
+        ply_logger_t *logger;
+        uint8_t *injection;
+        int pipe_fds[2];
+
+        PLY_TEST_ASSERT (pipe (pipe_fds) == 0);
+        loop = ply_event_loop_new ();
+        logger = ply_logger_new ();
+        ply_logger_set_output_fd (logger, pipe_fds[1]);
+        ply_logger_set_flush_policy (logger, PLY_LOGGER_FLUSH_POLICY_DEFERRED);
+        ply_logger_attach_to_event_loop (logger, loop);
+
+        /* small amounts of output wait for the event loop */
+        ply_logger_inject_bytes (logger, message, sizeof(message) - 1);
+        ply_logger_inject_bytes (logger, message, sizeof(message) - 1);
+        PLY_TEST_ASSERT (!fd_has_data (pipe_fds[0]));
+
+        while (!fd_has_data (pipe_fds[0])) {
+                ply_event_loop_process_pending_events (loop);
+        }
+        PLY_TEST_ASSERT (read_exactly (pipe_fds[0], output, sizeof(output)));
+        PLY_TEST_ASSERT (memcmp (output, message, sizeof(output)) == 0);
+        PLY_TEST_ASSERT (read_exactly (pipe_fds[0], output, sizeof(output)));
+        PLY_TEST_ASSERT (!fd_has_data (pipe_fds[0]));
+
+        /* but a lot of it is written right away */
+        injection = malloc (16384);
+        PLY_TEST_ASSERT (injection != NULL);
+        memset (injection, 'x', 16384);
+        ply_logger_inject_bytes (logger, injection, 16384);
+        PLY_TEST_ASSERT (fd_has_data (pipe_fds[0]));
+
+        ply_logger_free (logger);
+        ply_event_loop_free (loop);
+        free (injection);
+        close (pipe_fds[0]);
+        return true;
+}
+
+static void
+on_wait_timeout (bool             *timeout_fired,
+                 ply_event_loop_t *loop)
+{
+        *timeout_fired = true;
+}
+
+static bool
+test_deferred_policy_waits_for_an_output_fd (void)
+{
+        static const char message[] = "early line\n";
+        char output[sizeof(message) - 1];
+        ply_event_loop_t *loop;
+        ply_logger_t *logger;
+        bool timeout_fired;
+        int pipe_fds[2];
+
+        PLY_TEST_ASSERT (pipe (pipe_fds) == 0);
+        loop = ply_event_loop_new ();
+        logger = ply_logger_new ();
+        ply_logger_set_flush_policy (logger, PLY_LOGGER_FLUSH_POLICY_DEFERRED);
+        ply_logger_attach_to_event_loop (logger, loop);
+
+        /* with nowhere to write, no flush gets scheduled, so output that
+         * arrived too early waits for the next line rather than the timer
+         */
+        ply_logger_inject_bytes (logger, message, sizeof(message) - 1);
+        ply_logger_set_output_fd (logger, pipe_fds[1]);
+
+        timeout_fired = false;
+        ply_event_loop_watch_for_timeout (loop, 0.7,
+                                          (ply_event_loop_timeout_handler_t)
+                                          on_wait_timeout,
+                                          &timeout_fired);
+        while (!timeout_fired) {
+                ply_event_loop_process_pending_events (loop);
+        }
+        PLY_TEST_ASSERT (!fd_has_data (pipe_fds[0]));
+
+        ply_logger_inject_bytes (logger, message, sizeof(message) - 1);
+        while (!fd_has_data (pipe_fds[0])) {
+                ply_event_loop_process_pending_events (loop);
+        }
+        PLY_TEST_ASSERT (read_exactly (pipe_fds[0], output, sizeof(output)));
+        PLY_TEST_ASSERT (memcmp (output, message, sizeof(output)) == 0);
+        PLY_TEST_ASSERT (read_exactly (pipe_fds[0], output, sizeof(output)));
+        PLY_TEST_ASSERT (memcmp (output, message, sizeof(output)) == 0);
+
+        ply_logger_free (logger);
+        ply_event_loop_free (loop);
+        close (pipe_fds[0]);
+        return true;
+}
+
 static const ply_test_case_t test_cases[] =
 {
         PLY_TEST_CASE (test_new_logger_has_deferred_defaults),
@@ -307,6 +406,8 @@ static const ply_test_case_t test_cases[] =
         PLY_TEST_CASE (test_filter_transforms_injected_bytes),
         PLY_TEST_CASE (test_invalid_format_does_not_write_through_percent_n),
         PLY_TEST_CASE (test_full_buffer_retains_recent_injections),
+        PLY_TEST_CASE (test_deferred_policy_flushes_in_batches),
+        PLY_TEST_CASE (test_deferred_policy_waits_for_an_output_fd),
 };
 
 PLY_TEST_MAIN (test_cases)
@@ -19,11 +19,15 @@
 
 #include "ply-test.h"
 
+#include <math.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "ply-list.h"
 #include "ply-pixel-buffer.h"
 #include "ply-region.h"
+#include "ply-test-seeded-random.h"
+#include "ply-utils.h"
 
 static bool
 test_new_buffer_reports_empty_geometry (void)
@@ -264,6 +268,358 @@ test_tile_and_resize_preserve_sample_points (void)
         return true;
 }
 
+/* ply_pixels_interpolate as it was before it went fixed point */
+static uint32_t
+interpolate_the_old_way (uint32_t *bytes,
+                         int       width,
+                         int       height,
+                         double    x,
+                         double    y)
+{
+        int ix;
+        int iy;
+        int i;
+        int offset_x;
+        int offset_y;
+        uint32_t pixels[2][2];
+        uint32_t reply = 0;
+
+        for (offset_y = 0; offset_y < 2; offset_y++) {
+                for (offset_x = 0; offset_x < 2; offset_x++) {
+                        ix = x + offset_x;
+                        iy = y + offset_y;
+
+                        if (ix >= width)
+                                ix = width - 1;
+
+                        if (iy >= height)
+                                iy = height - 1;
+
+                        if (ix < 0 || iy < 0)
+                                pixels[offset_y][offset_x] = 0x00000000;
+                        else
+                                pixels[offset_y][offset_x] = bytes[ix + iy * width];
+                }
+        }
+        if (!pixels[0][0] && !pixels[0][1] && !pixels[1][0] && !pixels[1][1]) return 0;
+
+        ix = x;
+        iy = y;
+        x -= ix;
+        y -= iy;
+        for (i = 0; i < 4; i++) {
+                uint32_t value = 0;
+                uint32_t mask = UINT32_C (0xff) << (i * 8);
+                value += ((pixels[0][0]) & mask) * (1 - x) * (1 - y);
+                value += ((pixels[0][1]) & mask) * x * (1 - y);
+                value += ((pixels[1][0]) & mask) * (1 - x) * y;
+                value += ((pixels[1][1]) & mask) * x * y;
+                reply |= value & mask;
+        }
+        return reply;
+}
+
+/* The same bilinear sample, but summed in double so it isn't truncated
+ * after every term
+ */
+static uint32_t
+interpolate_exactly (uint32_t *bytes,
+                     int       width,
+                     int       height,
+                     double    x,
+                     double    y)
+{
+        uint32_t pixels[2][2];
+        uint32_t reply = 0;
+        int offset_x, offset_y;
+        int i;
+
+        for (offset_y = 0; offset_y < 2; offset_y++) {
+                for (offset_x = 0; offset_x < 2; offset_x++) {
+                        int ix = MIN ((int) x + offset_x, width - 1);
+                        int iy = MIN ((int) y + offset_y, height - 1);
+
+                        pixels[offset_y][offset_x] = bytes[ix + iy * width];
+                }
+        }
+
+        x -= (int) x;
+        y -= (int) y;
+        for (i = 0; i < 4; i++) {
+                double value = 0;
+                uint32_t mask = UINT32_C (0xff) << (i * 8);
+                value += ((pixels[0][0]) & mask) * (1 - x) * (1 - y);
+                value += ((pixels[0][1]) & mask) * x * (1 - y);
+                value += ((pixels[1][0]) & mask) * (1 - x) * y;
+                value += ((pixels[1][1]) & mask) * x * y;
+                reply |= (uint32_t) value & mask;
+        }
+        return reply;
+}
+
+static int
+get_channel_difference (uint32_t a,
+                        uint32_t b,
+                        int      channel)
+{
+        return (int) ((a >> (channel * 8)) & 0xff) - (int) ((b >> (channel * 8)) & 0xff);
+}
+
+/* A sample has to be within 1 of the exact value in every channel, and
+ * within 1 of what the old code produced in red, green and alpha.  The
+ * old code truncated each of its four blue terms separately, so its blue
+ * could read up to 3 low, and the new blue may be up to 3 above it.
+ */
+static bool
+sample_is_close (uint32_t  sample,
+                 uint32_t *bytes,
+                 int       width,
+                 int       height,
+                 double    x,
+                 double    y)
+{
+        uint32_t exact, old;
+        int channel;
+
+        exact = interpolate_exactly (bytes, width, height, x, y);
+        old = interpolate_the_old_way (bytes, width, height, x, y);
+
+        for (channel = 0; channel < 4; channel++) {
+                int old_difference = get_channel_difference (sample, old, channel);
+
+                if (abs (get_channel_difference (sample, exact, channel)) > 1)
+                        return false;
+
+                if (channel == 0) {
+                        if (old_difference < -1 || old_difference > 3)
+                                return false;
+                } else if (abs (old_difference) > 1) {
+                        return false;
+                }
+        }
+
+        return true;
+}
+
+static ply_pixel_buffer_t *
+create_random_buffer (uint32_t state,
+                      long     width,
+                      long     height)
+{
+        ply_test_seeded_random_t random = { .state = state };
+        ply_pixel_buffer_t *buffer;
+
+        buffer = ply_pixel_buffer_new (width, height);
+        ply_test_seeded_random_fill (&random,
+                                     (uint8_t *) ply_pixel_buffer_get_argb32_data (buffer),
+                                     width * height * sizeof(uint32_t));
+
+        return buffer;
+}
+
+static bool
+check_resize_against_old_sampling (ply_pixel_buffer_t *source,
+                                   long                width,
+                                   long                height)
+{
+        ply_pixel_buffer_t *resized;
+        uint32_t *source_pixels, *pixels;
+        long source_width, source_height;
+        double scale_x, scale_y;
+        long x, y;
+        bool matches = true;
+
+        source_width = ply_pixel_buffer_get_width (source);
+        source_height = ply_pixel_buffer_get_height (source);
+        source_pixels = ply_pixel_buffer_get_argb32_data (source);
+
+        resized = ply_pixel_buffer_resize (source, width, height);
+        pixels = ply_pixel_buffer_get_argb32_data (resized);
+
+        scale_x = ((double) source_width - 1) / MAX (width - 1, 1);
+        scale_y = ((double) source_height - 1) / MAX (height - 1, 1);
+
+        for (y = 0; y < height && matches; y++) {
+                for (x = 0; x < width && matches; x++) {
+                        matches = sample_is_close (pixels[x + y * width],
+                                                   source_pixels,
+                                                   source_width, source_height,
+                                                   x * scale_x, y * scale_y);
+                }
+        }
+
+        ply_pixel_buffer_free (resized);
+        return matches;
+}
+
+static bool
+test_resize_matches_old_sampling (void)
+{
+        ply_pixel_buffer_t *source;
+
+        source = create_random_buffer (30, 37, 23);
+
+        PLY_TEST_ASSERT (check_resize_against_old_sampling (source, 61, 17));
+        PLY_TEST_ASSERT (check_resize_against_old_sampling (source, 13, 29));
+        PLY_TEST_ASSERT (check_resize_against_old_sampling (source, 37, 23));
+        PLY_TEST_ASSERT (check_resize_against_old_sampling (source, 1, 1));
+
+        ply_pixel_buffer_free (source);
+        return true;
+}
+
+static bool
+check_rotate_against_old_sampling (ply_pixel_buffer_t *source,
+                                   long                center_x,
+                                   long                center_y,
+                                   double              theta_offset)
+{
+        ply_pixel_buffer_t *rotated;
+        uint32_t *source_pixels, *pixels;
+        double start_x, start_y, step_x, step_y, theta, distance;
+        int width, height;
+        int x, y;
+        bool matches = true;
+
+        width = ply_pixel_buffer_get_width (source);
+        height = ply_pixel_buffer_get_height (source);
+        source_pixels = ply_pixel_buffer_get_argb32_data (source);
+
+        rotated = ply_pixel_buffer_rotate (source, center_x, center_y, theta_offset);
+        pixels = ply_pixel_buffer_get_argb32_data (rotated);
+
+        /* Walks the source the same way ply_pixel_buffer_rotate does */
+        distance = sqrt (center_x * center_x + center_y * center_y);
+        theta = atan2 (-center_y, -center_x) - theta_offset;
+        start_x = center_x + distance * cos (theta);
+        start_y = center_y + distance * sin (theta);
+        step_x = cos (-theta_offset);
+        step_y = sin (-theta_offset);
+
+        for (y = 0; y < height && matches; y++) {
+                double old_x = start_x;
+                double old_y = start_y;
+
+                start_y += step_x;
+                start_x -= step_y;
+                for (x = 0; x < width && matches; x++) {
+                        if (old_x < 0 || old_x > width || old_y < 0 || old_y > height)
+                                matches = pixels[x + y * width] == 0;
+                        else
+                                matches = sample_is_close (pixels[x + y * width],
+                                                           source_pixels, width, height,
+                                                           old_x, old_y);
+                        old_x += step_x;
+                        old_y += step_y;
+                }
+        }
+
+        ply_pixel_buffer_free (rotated);
+        return matches;
+}
+
+static bool
+test_rotate_matches_old_sampling (void)
+{
+        ply_pixel_buffer_t *source;
+
+        source = create_random_buffer (31, 37, 23);
+
+        PLY_TEST_ASSERT (check_rotate_against_old_sampling (source, 18, 11, 0.3));
+        PLY_TEST_ASSERT (check_rotate_against_old_sampling (source, 18, 11, M_PI / 2));
+        PLY_TEST_ASSERT (check_rotate_against_old_sampling (source, 18, 11, 2.5));
+        PLY_TEST_ASSERT (check_rotate_against_old_sampling (source, 5, 20, -0.7));
+
+        ply_pixel_buffer_free (source);
+        return true;
+}
+
+static bool
+check_device_scale_fill_against_old_sampling (int scale)
+{
+        ply_rectangle_t fill_area = { .x = 2, .y = 1, .width = 9, .height = 7 };
+        ply_pixel_buffer_t *source, *buffer;
+        uint32_t *data, *pixels;
+        unsigned long column, row, i;
+        long width;
+        bool matches = true;
+
+        /* Opaque, so each sample is stored as is rather than blended */
+        source = create_random_buffer (scale, fill_area.width, fill_area.height);
+        data = ply_pixel_buffer_get_argb32_data (source);
+        for (i = 0; i < fill_area.width * fill_area.height; i++) {
+                data[i] |= UINT32_C (0xff000000);
+        }
+
+        width = 14 * scale;
+        buffer = ply_pixel_buffer_new (width, 10 * scale);
+        ply_pixel_buffer_set_device_scale (buffer, scale);
+        ply_pixel_buffer_fill_with_argb32_data (buffer, &fill_area, data);
+        pixels = ply_pixel_buffer_get_argb32_data (buffer);
+
+        /* Each device pixel samples the data at its logical position */
+        for (row = 0; row < fill_area.height * scale && matches; row++) {
+                for (column = 0; column < fill_area.width * scale && matches; column++) {
+                        unsigned long device_x = fill_area.x * scale + column;
+                        unsigned long device_y = fill_area.y * scale + row;
+
+                        matches = sample_is_close (pixels[device_x + device_y * width],
+                                                   data, fill_area.width, fill_area.height,
+                                                   (double) device_x / scale - fill_area.x,
+                                                   (double) device_y / scale - fill_area.y);
+                }
+        }
+
+        ply_pixel_buffer_free (buffer);
+        ply_pixel_buffer_free (source);
+        return matches;
+}
+
+static bool
+test_device_scale_fill_matches_old_sampling (void)
+{
+        PLY_TEST_ASSERT (check_device_scale_fill_against_old_sampling (2));
+        PLY_TEST_ASSERT (check_device_scale_fill_against_old_sampling (3));
+        return true;
+}
+
+static bool
+test_resize_area_averages_covered_pixels (void)
+{
+        uint32_t source_pixels[] = {
+                UINT32_C (0xff000000), UINT32_C (0xff000004), UINT32_C (0xff102030), UINT32_C (0xff102030),
+                UINT32_C (0xff000008), UINT32_C (0xff00000c), UINT32_C (0xff102030), UINT32_C (0xff102030),
+                UINT32_C (0x00000000), UINT32_C (0x00000000), UINT32_C (0xffffffff), UINT32_C (0x00000000),
+                UINT32_C (0x00000000), UINT32_C (0x00000000), UINT32_C (0x00000000), UINT32_C (0x00000000),
+        };
+        ply_rectangle_t source_area = { .x = 0, .y = 0, .width = 4, .height = 4 };
+        ply_pixel_buffer_t *source;
+        ply_pixel_buffer_t *resized;
+        uint32_t *pixels;
+
+        source = ply_pixel_buffer_new (4, 4);
+        ply_pixel_buffer_fill_with_argb32_data (source, &source_area, source_pixels);
+
+        resized = ply_pixel_buffer_resize_area (source, 2, 2);
+        pixels = ply_pixel_buffer_get_argb32_data (resized);
+        PLY_TEST_ASSERT (ply_pixel_buffer_get_width (resized) == 2);
+        PLY_TEST_ASSERT (ply_pixel_buffer_get_height (resized) == 2);
+        PLY_TEST_ASSERT (pixels[0] == UINT32_C (0xff000006));
+        PLY_TEST_ASSERT (pixels[1] == UINT32_C (0xff102030));
+        PLY_TEST_ASSERT (pixels[2] == UINT32_C (0x00000000));
+        PLY_TEST_ASSERT (pixels[3] == UINT32_C (0x40404040));
+        ply_pixel_buffer_free (resized);
+
+        /* upscaling falls back to bilinear sampling */
+        resized = ply_pixel_buffer_resize_area (source, 8, 8);
+        PLY_TEST_ASSERT (ply_pixel_buffer_get_width (resized) == 8);
+        PLY_TEST_ASSERT (ply_pixel_buffer_get_argb32_data (resized)[0] == source_pixels[0]);
+        ply_pixel_buffer_free (resized);
+
+        ply_pixel_buffer_free (source);
+        return true;
+}
+
 static bool
 test_rotation_transitions_preserve_axes (void)
 {
@@ -340,6 +696,10 @@ static const ply_test_case_t test_cases[] =
         PLY_TEST_CASE (test_buffer_composition_applies_offset),
         PLY_TEST_CASE (test_device_scale_maps_logical_fill_to_pixels),
         PLY_TEST_CASE (test_tile_and_resize_preserve_sample_points),
+        PLY_TEST_CASE (test_resize_matches_old_sampling),
+        PLY_TEST_CASE (test_rotate_matches_old_sampling),
+        PLY_TEST_CASE (test_device_scale_fill_matches_old_sampling),
+        PLY_TEST_CASE (test_resize_area_averages_covered_pixels),
         PLY_TEST_CASE (test_rotation_transitions_preserve_axes),
         PLY_TEST_CASE (test_rotate_upright_maps_clockwise_pixels),
 };
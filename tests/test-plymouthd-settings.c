@@ -75,6 +75,7 @@ test_settings_start_unset (void)
         PLY_TEST_ASSERT (plymouthd_settings_get_device_scale (settings) == -1);
         PLY_TEST_ASSERT (plymouthd_settings_get_extra_escape_key (settings) == XKB_KEY_NoSymbol);
         PLY_TEST_ASSERT (plymouthd_settings_get_use_simpledrm (settings) == -1);
+        PLY_TEST_ASSERT (plymouthd_settings_get_headless_heads (settings) == NULL);
         PLY_TEST_ASSERT (plymouthd_settings_get_override_splash_path (settings) == NULL);
         PLY_TEST_ASSERT (plymouthd_settings_get_system_default_splash_path (settings) == NULL);
         PLY_TEST_ASSERT (plymouthd_settings_get_distribution_default_splash_path (settings) == NULL);
@@ -200,7 +201,8 @@ test_first_config_source_keeps_scalar_precedence (void)
                                    "DeviceTimeout=8.0\n"
                                    "DeviceScale=2\n"
                                    "XkbExtraEscButton=123\n"
-                                   "UseSimpledrm=1\n",
+                                   "UseSimpledrm=1\n"
+                                   "HeadlessRenderer=640x480,800x600@2\n",
                                    alpha_directory) >= 0);
         PLY_TEST_ASSERT (asprintf (&second_config,
                                    "[Daemon]\n"
@@ -210,7 +212,8 @@ test_first_config_source_keeps_scalar_precedence (void)
                                    "DeviceTimeout=12.0\n"
                                    "DeviceScale=4\n"
                                    "XkbExtraEscButton=456\n"
-                                   "UseSimpledrm=0\n",
+                                   "UseSimpledrm=0\n"
+                                   "HeadlessRenderer=1920x1080\n",
                                    beta_directory) >= 0);
         PLY_TEST_ASSERT (write_file (first_config_path, first_config));
         PLY_TEST_ASSERT (write_file (second_config_path, second_config));
@@ -230,6 +233,8 @@ test_first_config_source_keeps_scalar_precedence (void)
         PLY_TEST_ASSERT (plymouthd_settings_get_device_scale (settings) == 2);
         PLY_TEST_ASSERT (plymouthd_settings_get_extra_escape_key (settings) == 123);
         PLY_TEST_ASSERT (plymouthd_settings_get_use_simpledrm (settings) == 1);
+        PLY_TEST_ASSERT (strcmp (plymouthd_settings_get_headless_heads (settings),
+                                 "640x480,800x600@2") == 0);
 
         plymouthd_settings_free (settings);
         unlink (first_config_path);
@@ -177,12 +177,213 @@ test_random_union_matches_cell_oracle (void)
         return true;
 }
 
+static void
+random_rectangle (uint32_t        *random_state,
+                  ply_rectangle_t *rectangle)
+{
+        rectangle->x = next_random (random_state) % 24;
+        rectangle->y = next_random (random_state) % 24;
+        rectangle->width = next_random (random_state) % 9;
+        rectangle->height = next_random (random_state) % 9;
+}
+
+static void
+mark_rectangle (bool             cells[GRID_SIZE][GRID_SIZE],
+                ply_rectangle_t *rectangle,
+                bool             value)
+{
+        long x, y;
+
+        for (y = rectangle->y; y < rectangle->y + (long) rectangle->height; y++) {
+                for (x = rectangle->x; x < rectangle->x + (long) rectangle->width; x++) {
+                        cells[y][x] = value;
+                }
+        }
+}
+
+static bool
+region_matches_cells (ply_region_t *region,
+                      bool          expected[GRID_SIZE][GRID_SIZE])
+{
+        unsigned char observed[GRID_SIZE][GRID_SIZE];
+        ply_rectangle_t *rectangles;
+        size_t number_of_rectangles, i;
+        long x, y;
+
+        memset (observed, 0, sizeof(observed));
+        rectangles = ply_region_get_rectangles (region, &number_of_rectangles);
+
+        for (i = 0; i < number_of_rectangles; i++) {
+                ply_rectangle_t *rectangle = &rectangles[i];
+
+                if (ply_rectangle_is_empty (rectangle))
+                        return false;
+
+                /* bands run top to bottom and never overlap, and the
+                 * rectangles in a band run left to right without touching
+                 */
+                if (i > 0) {
+                        ply_rectangle_t *previous = &rectangles[i - 1];
+
+                        if (previous->y == rectangle->y) {
+                                if (previous->height != rectangle->height)
+                                        return false;
+                                if (previous->x + (long) previous->width >= rectangle->x)
+                                        return false;
+                        } else if (previous->y + (long) previous->height > rectangle->y) {
+                                return false;
+                        }
+                }
+
+                for (y = rectangle->y; y < rectangle->y + (long) rectangle->height; y++) {
+                        for (x = rectangle->x; x < rectangle->x + (long) rectangle->width; x++) {
+                                observed[y][x]++;
+                        }
+                }
+        }
+
+        for (y = 0; y < GRID_SIZE; y++) {
+                for (x = 0; x < GRID_SIZE; x++) {
+                        if ((observed[y][x] == 1) != expected[y][x] || observed[y][x] > 1)
+                                return false;
+                }
+        }
+
+        return true;
+}
+
+static bool
+test_random_operations_match_cell_oracle (void)
+{
+        bool expected[GRID_SIZE][GRID_SIZE];
+        bool other_expected[GRID_SIZE][GRID_SIZE];
+        uint32_t random_state = UINT32_C (0x9e3779b9);
+        ply_region_t *region, *other_region;
+        ply_rectangle_t rectangle;
+        int i, x, y;
+
+        memset (expected, 0, sizeof(expected));
+        memset (other_expected, 0, sizeof(other_expected));
+        region = ply_region_new ();
+        other_region = ply_region_new ();
+
+        for (i = 0; i < RANDOM_RECTANGLE_COUNT; i++) {
+                random_rectangle (&random_state, &rectangle);
+
+                switch (i % 4) {
+                case 0:
+                case 1:
+                        mark_rectangle (expected, &rectangle, true);
+                        ply_region_add_rectangle (region, &rectangle);
+                        break;
+                case 2:
+                        mark_rectangle (expected, &rectangle, false);
+                        ply_region_subtract_rectangle (region, &rectangle);
+                        break;
+                case 3:
+                        mark_rectangle (other_expected, &rectangle, true);
+                        ply_region_add_rectangle (other_region, &rectangle);
+                        break;
+                }
+
+                PLY_TEST_ASSERT (region_matches_cells (region, expected));
+        }
+
+        PLY_TEST_ASSERT (region_matches_cells (other_region, other_expected));
+
+        ply_region_union (region, other_region);
+        for (y = 0; y < GRID_SIZE; y++) {
+                for (x = 0; x < GRID_SIZE; x++) {
+                        expected[y][x] = expected[y][x] || other_expected[y][x];
+                }
+        }
+        PLY_TEST_ASSERT (region_matches_cells (region, expected));
+
+        rectangle.x = 4;
+        rectangle.y = 6;
+        rectangle.width = 17;
+        rectangle.height = 13;
+        ply_region_intersect_rectangle (region, &rectangle);
+        for (y = 0; y < GRID_SIZE; y++) {
+                for (x = 0; x < GRID_SIZE; x++) {
+                        expected[y][x] = expected[y][x] &&
+                                         x >= 4 && x < 21 && y >= 6 && y < 19;
+                }
+        }
+        PLY_TEST_ASSERT (region_matches_cells (region, expected));
+
+        ply_region_subtract (region, other_region);
+        for (y = 0; y < GRID_SIZE; y++) {
+                for (x = 0; x < GRID_SIZE; x++) {
+                        expected[y][x] = expected[y][x] && !other_expected[y][x];
+                }
+        }
+        PLY_TEST_ASSERT (region_matches_cells (region, expected));
+
+        ply_region_free (other_region);
+        ply_region_free (region);
+        return true;
+}
+
+static bool
+test_touching_rectangles_merge (void)
+{
+        ply_rectangle_t rectangles[] = {
+                { .x = 0, .y = 0,  .width = 10, .height = 5 },
+                { .x = 0, .y = 5,  .width = 10, .height = 5 },
+                { .x = 2, .y = 2,  .width = 4,  .height = 4 },
+                { .x = 0, .y = 10, .width = 4,  .height = 2 },
+                { .x = 4, .y = 10, .width = 6,  .height = 2 },
+        };
+        ply_rectangle_t *stored, bounding_box;
+        size_t number_of_rectangles, i;
+        ply_region_t *region;
+
+        region = ply_region_new ();
+        for (i = 0; i < sizeof(rectangles) / sizeof(rectangles[0]); i++) {
+                ply_region_add_rectangle (region, &rectangles[i]);
+        }
+
+        stored = ply_region_get_rectangles (region, &number_of_rectangles);
+        PLY_TEST_ASSERT (number_of_rectangles == 1);
+        PLY_TEST_ASSERT (stored[0].x == 0);
+        PLY_TEST_ASSERT (stored[0].y == 0);
+        PLY_TEST_ASSERT (stored[0].width == 10);
+        PLY_TEST_ASSERT (stored[0].height == 12);
+
+        /* a hole in the middle splits it into bands */
+        rectangles[0].x = 3;
+        rectangles[0].y = 3;
+        rectangles[0].width = 2;
+        rectangles[0].height = 2;
+        ply_region_subtract_rectangle (region, &rectangles[0]);
+        ply_region_get_rectangles (region, &number_of_rectangles);
+        PLY_TEST_ASSERT (number_of_rectangles == 4);
+
+        ply_region_get_bounding_box (region, &bounding_box);
+        PLY_TEST_ASSERT (bounding_box.x == 0);
+        PLY_TEST_ASSERT (bounding_box.y == 0);
+        PLY_TEST_ASSERT (bounding_box.width == 10);
+        PLY_TEST_ASSERT (bounding_box.height == 12);
+
+        ply_region_simplify (region, 2);
+        stored = ply_region_get_rectangles (region, &number_of_rectangles);
+        PLY_TEST_ASSERT (number_of_rectangles == 1);
+        PLY_TEST_ASSERT (stored[0].width == 10);
+        PLY_TEST_ASSERT (stored[0].height == 12);
+
+        ply_region_free (region);
+        return true;
+}
+
 static const ply_test_case_t test_cases[] =
 {
         PLY_TEST_CASE (test_new_region_is_empty),
         PLY_TEST_CASE (test_region_copies_input_and_clears),
         PLY_TEST_CASE (test_sorted_rectangles_have_monotonic_rows),
         PLY_TEST_CASE (test_random_union_matches_cell_oracle),
+        PLY_TEST_CASE (test_random_operations_match_cell_oracle),
+        PLY_TEST_CASE (test_touching_rectangles_merge),
 };
 
 PLY_TEST_MAIN (test_cases)
@@ -164,9 +164,56 @@ test_renderer_delegates_backend_lifecycle (void)
         return true;
 }
 
+static bool
+is_fake_renderer_device (void       *user_data,
+                         const char *device_name)
+{
+        int *number_of_calls = user_data;
+
+        (*number_of_calls)++;
+        return strcmp (device_name, "/dev/fake-renderer") == 0;
+}
+
+static bool
+test_managed_device_is_not_opened (void)
+{
+        const test_renderer_plugin_state_t *state;
+        ply_module_handle_t *module;
+        ply_renderer_t *renderer;
+        int number_of_calls = 0;
+
+        module = ply_open_module (TEST_RENDERER_PLUGIN_PATH);
+        PLY_TEST_ASSERT (module != NULL);
+
+        /* the plugin renames the device, and it's that name that counts */
+        renderer = ply_renderer_new_with_plugin_directory (PLY_RENDERER_TYPE_FRAME_BUFFER,
+                                                           TEST_RENDERER_PLUGIN_DIR,
+                                                           "/dev/requested",
+                                                           NULL, NULL);
+        ply_renderer_set_device_is_managed_handler (renderer,
+                                                    is_fake_renderer_device,
+                                                    &number_of_calls);
+
+        PLY_TEST_ASSERT (!ply_renderer_open (renderer, true));
+        PLY_TEST_ASSERT (ply_renderer_is_already_managed (renderer));
+        PLY_TEST_ASSERT (number_of_calls == 1);
+
+        /* the backend was created to learn the name, but never opened */
+        state = get_plugin_state (module);
+        PLY_TEST_ASSERT (state != NULL);
+        PLY_TEST_ASSERT (state->create_count == 1);
+        PLY_TEST_ASSERT (state->open_count == 0);
+        PLY_TEST_ASSERT (state->destroy_count == 1);
+        ply_renderer_free (renderer);
+
+        ply_close_module (module);
+        return true;
+}
+
 static const ply_test_case_t test_cases[] =
 {
         PLY_TEST_CASE (test_renderer_delegates_backend_lifecycle),
+        PLY_TEST_CASE (test_managed_device_is_not_opened),
 };
 
 PLY_TEST_MAIN (test_cases)
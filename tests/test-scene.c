@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "ply-test.h"
+
+#include <stdint.h>
+
+#include "ply-list.h"
+#include "ply-pixel-buffer.h"
+#include "ply-rectangle.h"
+#include "ply-region.h"
+#include "ply-scene.h"
+
+typedef struct
+{
+        int             call_count;
+        ply_rectangle_t last_area;
+} draw_record_t;
+
+static void
+record_draw (draw_record_t      *record,
+             ply_pixel_buffer_t *buffer,
+             long                x,
+             long                y,
+             unsigned long       width,
+             unsigned long       height)
+{
+        record->call_count++;
+        record->last_area.x = x;
+        record->last_area.y = y;
+        record->last_area.width = width;
+        record->last_area.height = height;
+}
+
+static void
+fill_with_color (uint32_t           *color,
+                 ply_pixel_buffer_t *buffer,
+                 long                x,
+                 long                y,
+                 unsigned long       width,
+                 unsigned long       height)
+{
+        ply_rectangle_t area = { x, y, width, height };
+
+        ply_pixel_buffer_fill_with_hex_color (buffer, &area, *color);
+}
+
+static ply_pixel_buffer_t *
+create_solid_buffer (unsigned long width,
+                     unsigned long height,
+                     uint32_t      color)
+{
+        ply_pixel_buffer_t *buffer;
+
+        buffer = ply_pixel_buffer_new (width, height);
+        ply_pixel_buffer_fill_with_hex_color (buffer, NULL, color);
+        ply_pixel_buffer_set_opaque (buffer, true);
+
+        return buffer;
+}
+
+static uint32_t
+get_pixel (ply_pixel_buffer_t *buffer,
+           int                 x,
+           int                 y)
+{
+        return ply_pixel_buffer_get_argb32_data (buffer)[y * ply_pixel_buffer_get_width (buffer) + x];
+}
+
+static bool
+test_layers_composite_in_z_order (void)
+{
+        ply_pixel_buffer_t *canvas, *red, *green;
+        ply_scene_layer_t *top, *bottom;
+        ply_scene_t *scene;
+
+        canvas = ply_pixel_buffer_new (8, 8);
+        red = create_solid_buffer (8, 8, 0xff0000);
+        green = create_solid_buffer (2, 2, 0x00ff00);
+
+        scene = ply_scene_new (NULL);
+
+        /* added out of order on purpose */
+        top = ply_scene_add_layer (scene, 1);
+        ply_scene_layer_set_buffer (top, green);
+        ply_scene_layer_set_position (top, 3, 3);
+
+        bottom = ply_scene_add_layer (scene, 0);
+        ply_scene_layer_set_buffer (bottom, red);
+
+        ply_scene_draw_area (scene, canvas, 0, 0, 8, 8);
+
+        PLY_TEST_ASSERT (get_pixel (canvas, 0, 0) == 0xffff0000);
+        PLY_TEST_ASSERT (get_pixel (canvas, 3, 3) == 0xff00ff00);
+        PLY_TEST_ASSERT (get_pixel (canvas, 4, 4) == 0xff00ff00);
+        PLY_TEST_ASSERT (get_pixel (canvas, 5, 5) == 0xffff0000);
+
+        ply_scene_layer_set_z (top, -1);
+        ply_scene_draw_area (scene, canvas, 0, 0, 8, 8);
+        PLY_TEST_ASSERT (get_pixel (canvas, 3, 3) == 0xffff0000);
+
+        ply_scene_free (scene);
+        ply_pixel_buffer_free (green);
+        ply_pixel_buffer_free (red);
+        ply_pixel_buffer_free (canvas);
+        return true;
+}
+
+static bool
+test_opaque_layer_culls_layers_below (void)
+{
+        ply_pixel_buffer_t *canvas, *cover;
+        ply_scene_layer_t *layer;
+        draw_record_t record = { 0 };
+        ply_scene_t *scene;
+
+        canvas = ply_pixel_buffer_new (16, 16);
+        cover = create_solid_buffer (8, 8, 0x0000ff);
+
+        scene = ply_scene_new (NULL);
+
+        layer = ply_scene_add_layer (scene, 0);
+        ply_scene_layer_set_draw_handler (layer,
+                                          (ply_scene_layer_draw_handler_t)
+                                          record_draw, &record, 16, 16);
+
+        layer = ply_scene_add_layer (scene, 1);
+        ply_scene_layer_set_buffer (layer, cover);
+
+        /* fully inside the opaque layer, so the bottom layer is skipped */
+        ply_scene_draw_area (scene, canvas, 2, 2, 4, 4);
+        PLY_TEST_ASSERT (record.call_count == 0);
+        PLY_TEST_ASSERT (get_pixel (canvas, 3, 3) == 0xff0000ff);
+
+        /* partially outside, so the bottom layer is drawn, clipped */
+        ply_scene_draw_area (scene, canvas, 6, 6, 4, 4);
+        PLY_TEST_ASSERT (record.call_count == 1);
+        PLY_TEST_ASSERT (record.last_area.x == 6);
+        PLY_TEST_ASSERT (record.last_area.y == 6);
+        PLY_TEST_ASSERT (record.last_area.width == 4);
+        PLY_TEST_ASSERT (record.last_area.height == 4);
+
+        /* a translucent layer doesn't hide anything */
+        ply_scene_layer_set_opacity (layer, 0.5);
+        ply_scene_draw_area (scene, canvas, 2, 2, 4, 4);
+        PLY_TEST_ASSERT (record.call_count == 2);
+
+        /* neither does a hidden one */
+        ply_scene_layer_set_opacity (layer, 1.0);
+        ply_scene_layer_hide (layer);
+        ply_scene_draw_area (scene, canvas, 2, 2, 4, 4);
+        PLY_TEST_ASSERT (record.call_count == 3);
+
+        ply_scene_free (scene);
+        ply_pixel_buffer_free (cover);
+        ply_pixel_buffer_free (canvas);
+        return true;
+}
+
+static bool
+test_layer_changes_damage_scene (void)
+{
+        ply_pixel_buffer_t *buffer;
+        ply_scene_layer_t *layer;
+        ply_scene_t *scene;
+        ply_list_t *rectangles;
+        ply_list_node_t *node;
+        unsigned long damaged_pixels = 0;
+
+        buffer = create_solid_buffer (4, 4, 0xffffff);
+        scene = ply_scene_new (NULL);
+
+        layer = ply_scene_add_layer (scene, 0);
+        ply_scene_layer_set_buffer (layer, buffer);
+        ply_scene_update (scene);
+        PLY_TEST_ASSERT (ply_region_is_empty (ply_scene_get_damage (scene)));
+
+        /* setting the same values again is not a change */
+        ply_scene_layer_set_position (layer, 0, 0);
+        ply_scene_layer_set_opacity (layer, 1.0);
+        PLY_TEST_ASSERT (ply_region_is_empty (ply_scene_get_damage (scene)));
+
+        /* moving damages both the old and the new position */
+        ply_scene_layer_set_position (layer, 10, 0);
+        rectangles = ply_region_get_rectangle_list (ply_scene_get_damage (scene));
+        ply_list_foreach (rectangles, node) {
+                ply_rectangle_t *rectangle = ply_list_node_get_data (node);
+
+                damaged_pixels += rectangle->width * rectangle->height;
+        }
+        PLY_TEST_ASSERT (damaged_pixels == 32);
+
+        ply_scene_update (scene);
+        PLY_TEST_ASSERT (ply_region_is_empty (ply_scene_get_damage (scene)));
+
+        ply_scene_layer_set_opacity (layer, 0.25);
+        PLY_TEST_ASSERT (!ply_region_is_empty (ply_scene_get_damage (scene)));
+
+        ply_scene_free (scene);
+        ply_pixel_buffer_free (buffer);
+        return true;
+}
+
+static bool
+test_draw_handler_layer_honors_opacity (void)
+{
+        ply_pixel_buffer_t *canvas, *red;
+        ply_scene_layer_t *layer;
+        ply_scene_t *scene;
+        uint32_t white = 0xffffff;
+        uint32_t pixel;
+        int i;
+
+        canvas = ply_pixel_buffer_new (8, 8);
+        red = create_solid_buffer (8, 8, 0xff0000);
+
+        scene = ply_scene_new (NULL);
+
+        layer = ply_scene_add_layer (scene, 0);
+        ply_scene_layer_set_buffer (layer, red);
+
+        layer = ply_scene_add_layer (scene, 1);
+        ply_scene_layer_set_draw_handler (layer,
+                                          (ply_scene_layer_draw_handler_t)
+                                          fill_with_color, &white, 4, 4);
+        ply_scene_layer_set_position (layer, 2, 2);
+        ply_scene_layer_set_opacity (layer, 0.5);
+
+        /* drawn twice so the second pass reuses the scratch area */
+        for (i = 0; i < 2; i++) {
+                ply_scene_draw_area (scene, canvas, 0, 0, 8, 8);
+
+                pixel = get_pixel (canvas, 3, 3);
+                PLY_TEST_ASSERT ((pixel & 0xffff0000) == 0xffff0000);
+                PLY_TEST_ASSERT (((pixel >> 8) & 0xff) >= 0x70 && ((pixel >> 8) & 0xff) <= 0x90);
+                PLY_TEST_ASSERT ((pixel & 0xff) >= 0x70 && (pixel & 0xff) <= 0x90);
+
+                /* the handler's drawing stays inside the layer */
+                PLY_TEST_ASSERT (get_pixel (canvas, 1, 1) == 0xffff0000);
+                PLY_TEST_ASSERT (get_pixel (canvas, 6, 6) == 0xffff0000);
+        }
+
+        ply_scene_layer_set_opacity (layer, 1.0);
+        ply_scene_draw_area (scene, canvas, 0, 0, 8, 8);
+        PLY_TEST_ASSERT (get_pixel (canvas, 3, 3) == 0xffffffff);
+
+        ply_scene_layer_set_opacity (layer, 0.0);
+        ply_scene_draw_area (scene, canvas, 0, 0, 8, 8);
+        PLY_TEST_ASSERT (get_pixel (canvas, 3, 3) == 0xffff0000);
+
+        ply_scene_free (scene);
+        ply_pixel_buffer_free (red);
+        ply_pixel_buffer_free (canvas);
+        return true;
+}
+
+static const ply_test_case_t test_cases[] =
+{
+        PLY_TEST_CASE (test_layers_composite_in_z_order),
+        PLY_TEST_CASE (test_opaque_layer_culls_layers_below),
+        PLY_TEST_CASE (test_layer_changes_damage_scene),
+        PLY_TEST_CASE (test_draw_handler_layer_honors_opacity),
+};
+
+PLY_TEST_MAIN (test_cases)
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "ply-test.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "script-arena.h"
+
+static bool
+test_strings_are_interned (void)
+{
+        script_arena_t *arena;
+        char name[] = "sprite";
+        char *first, *second;
+
+        arena = script_arena_new ();
+
+        first = script_arena_intern_string (arena, name);
+        PLY_TEST_ASSERT (first != name);
+        PLY_TEST_ASSERT (strcmp (first, "sprite") == 0);
+
+        /* changing the source doesn't change the arena's copy */
+        name[0] = 'S';
+        second = script_arena_intern_string (arena, "sprite");
+        PLY_TEST_ASSERT (second == first);
+        PLY_TEST_ASSERT (script_arena_intern_string (arena, name) != first);
+        PLY_TEST_ASSERT (script_arena_intern_string (arena, "") != NULL);
+
+        script_arena_free (arena);
+        return true;
+}
+
+static bool
+test_allocations_are_aligned_and_distinct (void)
+{
+        script_arena_t *arena;
+        char *previous = NULL;
+        size_t size;
+
+        arena = script_arena_new ();
+
+        /* walk past the first few blocks, including one oversized request */
+        for (size = 1; size < 20000; size = size * 3 + 1) {
+                char *memory = script_arena_alloc (arena, size);
+
+                PLY_TEST_ASSERT (((uintptr_t) memory % sizeof(double)) == 0);
+                PLY_TEST_ASSERT (memory != previous);
+                memset (memory, 0xaa, size);
+                previous = memory;
+        }
+
+        script_arena_free (arena);
+        return true;
+}
+
+static bool
+test_nested_arrays_keep_their_own_items (void)
+{
+        script_arena_t *arena;
+        size_t outer_start, inner_start;
+        void **outer, **inner;
+        int values[4];
+
+        arena = script_arena_new ();
+
+        outer_start = script_arena_start_array (arena);
+        script_arena_append_to_array (arena, &values[0]);
+
+        inner_start = script_arena_start_array (arena);
+        script_arena_append_to_array (arena, &values[1]);
+        script_arena_append_to_array (arena, &values[2]);
+        inner = script_arena_finish_array (arena, inner_start);
+
+        script_arena_append_to_array (arena, inner);
+        script_arena_append_to_array (arena, &values[3]);
+        outer = script_arena_finish_array (arena, outer_start);
+
+        PLY_TEST_ASSERT (inner[0] == &values[1]);
+        PLY_TEST_ASSERT (inner[1] == &values[2]);
+        PLY_TEST_ASSERT (inner[2] == NULL);
+
+        PLY_TEST_ASSERT (outer[0] == &values[0]);
+        PLY_TEST_ASSERT (outer[1] == inner);
+        PLY_TEST_ASSERT (outer[2] == &values[3]);
+        PLY_TEST_ASSERT (outer[3] == NULL);
+
+        outer = script_arena_finish_array (arena, script_arena_start_array (arena));
+        PLY_TEST_ASSERT (outer[0] == NULL);
+
+        script_arena_free (arena);
+        return true;
+}
+
+static int number_of_cleanups;
+
+static void
+record_cleanup (void *user_data)
+{
+        int *order = user_data;
+
+        *order = ++number_of_cleanups;
+}
+
+static bool
+test_cleanups_run_newest_first (void)
+{
+        script_arena_t *arena;
+        int first = 0, second = 0;
+
+        number_of_cleanups = 0;
+        arena = script_arena_new ();
+        script_arena_add_cleanup (arena, record_cleanup, &first);
+        script_arena_add_cleanup (arena, record_cleanup, &second);
+        PLY_TEST_ASSERT (number_of_cleanups == 0);
+
+        script_arena_free (arena);
+        PLY_TEST_ASSERT (second == 1);
+        PLY_TEST_ASSERT (first == 2);
+        return true;
+}
+
+static const ply_test_case_t test_cases[] =
+{
+        PLY_TEST_CASE (test_strings_are_interned),
+        PLY_TEST_CASE (test_allocations_are_aligned_and_distinct),
+        PLY_TEST_CASE (test_nested_arrays_keep_their_own_items),
+        PLY_TEST_CASE (test_cleanups_run_newest_first),
+};
+
+PLY_TEST_MAIN (test_cases)
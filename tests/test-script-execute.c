@@ -19,6 +19,7 @@
 
 #include "ply-test.h"
 
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -96,6 +97,68 @@ test_arithmetic_assignment_comparison_and_strings (void)
         return true;
 }
 
+static bool
+test_constant_expressions_are_folded (void)
+{
+        script_op_t *op;
+        script_exp_t *value;
+
+        op = script_parse_string ("value = -(2 + 3 * 4) % 5;"
+                                  "label = \"frame \" + 1 / 2;"
+                                  "unfolded = -\"text\";",
+                                  "fold.script");
+        PLY_TEST_ASSERT (op != NULL);
+
+        value = op->data.list[0]->data.exp->data.dual.sub_b;
+        PLY_TEST_ASSERT (value->type == SCRIPT_EXP_TYPE_TERM_NUMBER);
+        PLY_TEST_ASSERT (script_obj_as_number (value->data.literal) == -4);
+
+        value = op->data.list[1]->data.exp->data.dual.sub_b;
+        PLY_TEST_ASSERT (value->type == SCRIPT_EXP_TYPE_TERM_STRING);
+        PLY_TEST_ASSERT (strcmp (value->data.literal->data.string, "frame 0.5") == 0);
+
+        /* negating a string is an error the executor reports */
+        value = op->data.list[2]->data.exp->data.dual.sub_b;
+        PLY_TEST_ASSERT (value->type == SCRIPT_EXP_TYPE_NEG);
+
+        script_parse_op_free (op);
+        return true;
+}
+
+static bool
+test_literals_are_not_changed_by_evaluation (void)
+{
+        static const char source[] =
+                "fun five() { return 5; }"
+                "five() = 3;"
+                "five()++;"
+                "total = 0;"
+                "for (index = 0; index < 3; index++) {"
+                "  step = 2;"
+                "  step++;"
+                "  total += step * 2 + index;"
+                "}"
+                "nothing = null;"
+                "nothing.field = 1;"
+                "after = five();"
+                "empty = null;";
+        executed_script_t script;
+        script_obj_t *empty;
+
+        PLY_TEST_ASSERT (execute_script (source, &script));
+        PLY_TEST_ASSERT (script_obj_hash_get_number (script.state->global,
+                                                     "after") == 5);
+        PLY_TEST_ASSERT (script_obj_hash_get_number (script.state->global,
+                                                     "total") == 21);
+
+        empty = script_obj_hash_get_element (script.state->global, "empty");
+        PLY_TEST_ASSERT (script_obj_is_null (empty));
+        script_obj_unref (empty);
+
+        free_executed_script (&script);
+        return true;
+}
+
 static bool
 test_loops_break_and_continue_update_state (void)
 {
@@ -149,6 +212,107 @@ test_functions_use_local_parameters_and_global_state (void)
         return true;
 }
 
+static bool
+test_args_are_built_only_when_mentioned (void)
+{
+        static const char source[] =
+                "fun count() { return _args.count; }"
+                "fun last() { return local[\"_args\"][_args.count - 1]; }"
+                "fun first(value) { fun inner() { return _args; } return value; }"
+                "counted = count(1, 2, 3);"
+                "many = count(1, 2, 3, 4, 5, 6, 7, 8, 9, 10);"
+                "final = last(4, 5, 6);"
+                "picked = first(7, 8);";
+        executed_script_t script;
+        script_function_t *function;
+        script_obj_t *object;
+
+        PLY_TEST_ASSERT (execute_script (source, &script));
+        PLY_TEST_ASSERT (script_obj_hash_get_number (script.state->global,
+                                                     "counted") == 3);
+        PLY_TEST_ASSERT (script_obj_hash_get_number (script.state->global,
+                                                     "many") == 10);
+        PLY_TEST_ASSERT (script_obj_hash_get_number (script.state->global,
+                                                     "final") == 6);
+        PLY_TEST_ASSERT (script_obj_hash_get_number (script.state->global,
+                                                     "picked") == 7);
+
+        object = script_obj_hash_get_element (script.state->global, "last");
+        function = script_obj_deref_direct (object)->data.function;
+        PLY_TEST_ASSERT (function->uses_args);
+        script_obj_unref (object);
+
+        /* only the nested function needs its own _args */
+        object = script_obj_hash_get_element (script.state->global, "first");
+        function = script_obj_deref_direct (object)->data.function;
+        PLY_TEST_ASSERT (!function->uses_args);
+        script_obj_unref (object);
+
+        free_executed_script (&script);
+        return true;
+}
+
+static bool
+test_steady_state_frames_reuse_pooled_objects (void)
+{
+        static const char setup_source[] =
+                "for (index = 0; index < 20; index++) {"
+                "  sprites[index].x = index;"
+                "  sprites[index].y = 0;"
+                "}"
+                "fun move(sprite, step) {"
+                "  sprite.x = (sprite.x + step) % 640;"
+                "  sprite.y = sprite.y + step * 0.5;"
+                "  return sprite.x;"
+                "}"
+                "frame = 0;";
+        static const char frame_source[] =
+                "frame++;"
+                "for (index = 0; index < 20; index++) {"
+                "  label = \"x\" + move(sprites[index], index + frame);"
+                "}";
+        script_obj_pool_statistics_t objects, variables;
+        script_obj_pool_statistics_t warm_objects, warm_variables;
+        executed_script_t script;
+        script_op_t *frame_op;
+        script_return_t result;
+        int i;
+
+        PLY_TEST_ASSERT (execute_script (setup_source, &script));
+        frame_op = script_parse_string (frame_source, "frame.script");
+        PLY_TEST_ASSERT (frame_op != NULL);
+
+        for (i = 0; i < 10; i++) {
+                result = script_execute (script.state, frame_op);
+                script_obj_unref (result.object);
+        }
+        script_obj_get_pool_statistics (&warm_objects, &warm_variables);
+        PLY_TEST_ASSERT (warm_objects.live > 0);
+        PLY_TEST_ASSERT (warm_variables.live > 0);
+
+        for (i = 0; i < 100; i++) {
+                result = script_execute (script.state, frame_op);
+                script_obj_unref (result.object);
+        }
+        script_obj_get_pool_statistics (&objects, &variables);
+
+        PLY_TEST_ASSERT (script_obj_hash_get_number (script.state->global,
+                                                     "frame") == 110);
+        PLY_TEST_ASSERT (objects.live == warm_objects.live);
+        PLY_TEST_ASSERT (objects.allocations == warm_objects.allocations);
+        PLY_TEST_ASSERT (variables.live == warm_variables.live);
+        PLY_TEST_ASSERT (variables.allocations == warm_variables.allocations);
+
+        script_parse_op_free (frame_op);
+        free_executed_script (&script);
+
+        /* everything went back, so the slabs did too */
+        script_obj_get_pool_statistics (&objects, &variables);
+        PLY_TEST_ASSERT (objects.live == 0 && objects.pooled == 0);
+        PLY_TEST_ASSERT (variables.live == 0 && variables.pooled == 0);
+        return true;
+}
+
 static bool
 test_sets_and_dynamic_hash_keys_store_values (void)
 {
@@ -187,17 +351,13 @@ native_add_with_offset (script_state_t *state,
                         void           *user_data)
 {
         native_context_t *context = user_data;
-        script_obj_t *arguments;
         double left;
         double right;
 
         context->calls++;
-        arguments = script_obj_hash_get_element (state->local, "_args");
-        context->argument_count = script_obj_hash_get_number (arguments,
-                                                              "count");
-        script_obj_unref (arguments);
-        left = script_obj_hash_get_number (state->local, "left");
-        right = script_obj_hash_get_number (state->local, "right");
+        context->argument_count = state->number_of_arguments;
+        left = script_state_get_argument_number (state, "left");
+        right = script_state_get_argument_number (state, "right");
 
         return script_return_obj (
                 script_obj_new_number (left + right + context->offset));
@@ -221,16 +381,20 @@ test_native_function_receives_named_arguments (void)
                                     "left",
                                     "right",
                                     NULL);
-        op = script_parse_string ("result = NativeAdd(4, 5);",
+        op = script_parse_string ("result = NativeAdd(4, 5);"
+                                  "partial = NativeAdd(4);",
                                   "native.script");
         PLY_TEST_ASSERT (op != NULL);
 
         result = script_execute (state, op);
         PLY_TEST_ASSERT (result.type == SCRIPT_RETURN_TYPE_NORMAL);
-        PLY_TEST_ASSERT (context.calls == 1);
-        PLY_TEST_ASSERT (context.argument_count == 2);
+        PLY_TEST_ASSERT (context.calls == 2);
+        PLY_TEST_ASSERT (context.argument_count == 1);
         PLY_TEST_ASSERT (script_obj_hash_get_number (state->global,
                                                      "result") == 9.5);
+        /* a missing argument reads as null, which isn't a number */
+        PLY_TEST_ASSERT (isnan (script_obj_hash_get_number (state->global,
+                                                            "partial")));
 
         script_obj_unref (result.object);
         script_state_destroy (state);
@@ -357,8 +521,12 @@ test_shipped_default_theme_parses (void)
 static const ply_test_case_t test_cases[] =
 {
         PLY_TEST_CASE (test_arithmetic_assignment_comparison_and_strings),
+        PLY_TEST_CASE (test_constant_expressions_are_folded),
+        PLY_TEST_CASE (test_literals_are_not_changed_by_evaluation),
         PLY_TEST_CASE (test_loops_break_and_continue_update_state),
         PLY_TEST_CASE (test_functions_use_local_parameters_and_global_state),
+        PLY_TEST_CASE (test_args_are_built_only_when_mentioned),
+        PLY_TEST_CASE (test_steady_state_frames_reuse_pooled_objects),
         PLY_TEST_CASE (test_sets_and_dynamic_hash_keys_store_values),
         PLY_TEST_CASE (test_native_function_receives_named_arguments),
         PLY_TEST_CASE (test_native_objects_match_class_and_release_once),
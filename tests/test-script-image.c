@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "ply-test.h"
+
+#include "ply-list.h"
+#include "ply-pixel-buffer.h"
+#include "script-execute.h"
+#include "script-lib-image.h"
+#include "script-object.h"
+#include "script-parse.h"
+#include "script.h"
+
+static bool
+execute_script (script_state_t *state,
+                const char     *source)
+{
+        script_return_t result;
+        script_op_t *op;
+
+        op = script_parse_string (source, "test.script");
+        if (op == NULL)
+                return false;
+
+        result = script_execute (state, op);
+        script_obj_unref (result.object);
+        script_parse_op_free (op);
+
+        return result.type != SCRIPT_RETURN_TYPE_FAIL;
+}
+
+static ply_pixel_buffer_t *
+get_image (script_state_t          *state,
+           script_lib_image_data_t *data,
+           const char              *name)
+{
+        script_obj_t *obj;
+        ply_pixel_buffer_t *image;
+
+        obj = script_obj_hash_peek_element (state->global, name);
+        image = script_obj_as_native_of_class (obj, data->class);
+        script_obj_unref (obj);
+
+        return image;
+}
+
+static bool
+test_repeated_transforms_share_images (void)
+{
+        static const char source[] =
+                "image = Image (\"sprite-panel.png\");"
+                "first = image.Scale (12, 8);"
+                "second = image.Scale (12, 8);"
+                "other = image.Scale (8, 12);"
+                "rotated = image.Rotate (0.5);"
+                "rotated_again = image.Rotate (0.5);";
+        script_lib_image_data_t *data;
+        script_state_t *state;
+
+        state = script_state_new (NULL);
+        data = script_lib_image_setup (state, TEST_IMAGE_DIR);
+
+        PLY_TEST_ASSERT (execute_script (state, source));
+        PLY_TEST_ASSERT (data->cache_hits == 2);
+        PLY_TEST_ASSERT (data->cache_misses == 3);
+
+        PLY_TEST_ASSERT (get_image (state, data, "first") != NULL);
+        PLY_TEST_ASSERT (get_image (state, data, "first") == get_image (state, data, "second"));
+        PLY_TEST_ASSERT (get_image (state, data, "first") != get_image (state, data, "other"));
+        PLY_TEST_ASSERT (get_image (state, data, "rotated") == get_image (state, data, "rotated_again"));
+        PLY_TEST_ASSERT (ply_pixel_buffer_get_width (get_image (state, data, "other")) == 8);
+
+        script_state_destroy (state);
+        script_lib_image_destroy (data);
+        return true;
+}
+
+static bool
+test_freed_source_drops_cached_transforms (void)
+{
+        static const char source[] =
+                "image = Image (\"sprite-panel.png\");"
+                "scaled = image.Scale (12, 8);"
+                "nested = scaled.Rotate (1);"
+                "image = NULL;";
+        script_lib_image_data_t *data;
+        script_state_t *state;
+
+        state = script_state_new (NULL);
+        data = script_lib_image_setup (state, TEST_IMAGE_DIR);
+
+        PLY_TEST_ASSERT (execute_script (state, source));
+        PLY_TEST_ASSERT (ply_list_get_length (data->cache) == 1);
+        PLY_TEST_ASSERT (get_image (state, data, "scaled") != NULL);
+
+        PLY_TEST_ASSERT (execute_script (state, "scaled = NULL;"));
+        PLY_TEST_ASSERT (ply_list_get_length (data->cache) == 0);
+        PLY_TEST_ASSERT (get_image (state, data, "nested") != NULL);
+
+        script_state_destroy (state);
+        script_lib_image_destroy (data);
+        return true;
+}
+
+static bool
+test_assigning_to_a_transform_leaves_the_cache_alone (void)
+{
+        static const char source[] =
+                "image = Image (\"sprite-panel.png\");"
+                "image._Scale (12, 8).foo = 1;"
+                "image._Scale (12, 8).foo = 2;"
+                "image._Rotate (0.5).bar = 3;"
+                "scaled = image.Scale (12, 8);"
+                "rotated = image.Rotate (0.5);";
+        script_lib_image_data_t *data;
+        script_state_t *state;
+
+        state = script_state_new (NULL);
+        data = script_lib_image_setup (state, TEST_IMAGE_DIR);
+
+        PLY_TEST_ASSERT (execute_script (state, source));
+        PLY_TEST_ASSERT (data->cache_hits == 3);
+        PLY_TEST_ASSERT (data->cache_misses == 2);
+
+        PLY_TEST_ASSERT (get_image (state, data, "scaled") != NULL);
+        PLY_TEST_ASSERT (ply_pixel_buffer_get_width (get_image (state, data, "scaled")) == 12);
+        PLY_TEST_ASSERT (ply_pixel_buffer_get_height (get_image (state, data, "scaled")) == 8);
+        PLY_TEST_ASSERT (get_image (state, data, "rotated") != NULL);
+
+        script_state_destroy (state);
+        script_lib_image_destroy (data);
+        return true;
+}
+
+static const ply_test_case_t test_cases[] =
+{
+        PLY_TEST_CASE (test_repeated_transforms_share_images),
+        PLY_TEST_CASE (test_freed_source_drops_cached_transforms),
+        PLY_TEST_CASE (test_assigning_to_a_transform_leaves_the_cache_alone),
+};
+
+PLY_TEST_MAIN (test_cases)
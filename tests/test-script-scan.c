@@ -19,7 +19,9 @@
 
 #include "ply-test.h"
 
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "script-scan.h"
 
@@ -200,6 +202,90 @@ test_reports_out_of_range_integer (void)
         return true;
 }
 
+static bool
+write_script_file (char       *path,
+                   const char *contents)
+{
+        size_t length;
+        int fd;
+
+        strcpy (path, "/tmp/plymouth-script-scan-XXXXXX");
+        fd = mkstemp (path);
+        if (fd < 0)
+                return false;
+
+        length = strlen (contents);
+        if (write (fd, contents, length) != (ssize_t) length) {
+                close (fd);
+                unlink (path);
+                return false;
+        }
+
+        close (fd);
+        return true;
+}
+
+static bool
+scans_match (script_scan_t *file_scan,
+             script_scan_t *string_scan)
+{
+        script_scan_token_t *file_token;
+        script_scan_token_t *string_token;
+
+        file_token = script_scan_get_current_token (file_scan);
+        string_token = script_scan_get_current_token (string_scan);
+
+        while (true) {
+                PLY_TEST_ASSERT (file_token->type == string_token->type);
+                PLY_TEST_ASSERT (file_token->whitespace == string_token->whitespace);
+                PLY_TEST_ASSERT (file_token->location.line_index == string_token->location.line_index);
+                PLY_TEST_ASSERT (file_token->location.column_index == string_token->location.column_index);
+
+                if (file_token->type == SCRIPT_SCAN_TOKEN_TYPE_EOF)
+                        break;
+
+                file_token = script_scan_get_next_token (file_scan);
+                string_token = script_scan_get_next_token (string_scan);
+        }
+
+        return true;
+}
+
+static bool
+test_file_scans_like_string (void)
+{
+        static const char *inputs[] =
+        {
+                "",
+                "value",
+                "fun f (a) {\n\treturn a * 2;\n}\n\n/* done */ f (3);\n",
+                "# no trailing newline\nx = \"text\";",
+                "\"unfinished",
+        };
+        char path[64];
+        size_t i;
+
+        for (i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+                script_scan_t *file_scan;
+                script_scan_t *string_scan;
+
+                PLY_TEST_ASSERT (write_script_file (path, inputs[i]));
+
+                file_scan = script_scan_file (path);
+                unlink (path);
+                PLY_TEST_ASSERT (file_scan != NULL);
+                string_scan = script_scan_string (inputs[i], path);
+
+                PLY_TEST_ASSERT (scans_match (file_scan, string_scan));
+
+                script_scan_free (file_scan);
+                script_scan_free (string_scan);
+        }
+
+        PLY_TEST_ASSERT (script_scan_file ("/nonexistent/theme.script") == NULL);
+        return true;
+}
+
 static const ply_test_case_t test_cases[] =
 {
         PLY_TEST_CASE (test_scans_identifiers_numbers_strings_and_symbols),
@@ -209,6 +295,7 @@ static const ply_test_case_t test_cases[] =
         PLY_TEST_CASE (test_reports_line_break_inside_string),
         PLY_TEST_CASE (test_reports_unterminated_block_comment),
         PLY_TEST_CASE (test_reports_out_of_range_integer),
+        PLY_TEST_CASE (test_file_scans_like_string),
 };
 
 PLY_TEST_MAIN (test_cases)
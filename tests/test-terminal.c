@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "ply-test.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "ply-event-loop.h"
+#include "ply-terminal.h"
+#include "ply-text-display.h"
+
+typedef struct
+{
+        int             master_fd;
+        ply_terminal_t *terminal;
+} test_terminal_t;
+
+static bool
+open_test_terminal (test_terminal_t *test_terminal)
+{
+        struct winsize size = { .ws_row = 25, .ws_col = 80 };
+        struct termios attributes;
+
+        test_terminal->master_fd = posix_openpt (O_RDWR | O_NOCTTY);
+        if (test_terminal->master_fd < 0)
+                return false;
+
+        if (grantpt (test_terminal->master_fd) < 0 ||
+            unlockpt (test_terminal->master_fd) < 0)
+                return false;
+
+        ioctl (test_terminal->master_fd, TIOCSWINSZ, &size);
+
+        test_terminal->terminal = ply_terminal_new (ptsname (test_terminal->master_fd), NULL);
+        if (!ply_terminal_open (test_terminal->terminal))
+                return false;
+
+        /* Keep the line discipline from rewriting what gets sent */
+        tcgetattr (ply_terminal_get_fd (test_terminal->terminal), &attributes);
+        cfmakeraw (&attributes);
+        tcsetattr (ply_terminal_get_fd (test_terminal->terminal), TCSANOW, &attributes);
+
+        fcntl (test_terminal->master_fd, F_SETFL,
+               fcntl (test_terminal->master_fd, F_GETFL) | O_NONBLOCK);
+
+        return true;
+}
+
+static void
+close_test_terminal (test_terminal_t *test_terminal)
+{
+        ply_terminal_free (test_terminal->terminal);
+        close (test_terminal->master_fd);
+}
+
+static bool
+read_output_matches (test_terminal_t *test_terminal,
+                     const char      *expected_output)
+{
+        char output[256] = "";
+        ssize_t size;
+
+        size = read (test_terminal->master_fd, output, sizeof(output) - 1);
+
+        if (size < 0)
+                size = 0;
+
+        output[size] = '\0';
+
+        return strcmp (output, expected_output) == 0;
+}
+
+static bool
+test_held_output_is_written_on_release (void)
+{
+        test_terminal_t test_terminal;
+
+        PLY_TEST_ASSERT (open_test_terminal (&test_terminal));
+
+        ply_terminal_hold_output (test_terminal.terminal);
+        ply_terminal_write (test_terminal.terminal, "%s", "one ");
+        ply_terminal_hold_output (test_terminal.terminal);
+        ply_terminal_write_text (test_terminal.terminal, "%d", 2);
+        ply_terminal_release_output (test_terminal.terminal);
+
+        /* still held by the outer hold */
+        PLY_TEST_ASSERT (read_output_matches (&test_terminal, ""));
+
+        ply_terminal_release_output (test_terminal.terminal);
+        PLY_TEST_ASSERT (read_output_matches (&test_terminal, "one 2"));
+
+        /* unheld output goes out right away */
+        ply_terminal_write (test_terminal.terminal, "%s", "three");
+        PLY_TEST_ASSERT (read_output_matches (&test_terminal, "three"));
+
+        close_test_terminal (&test_terminal);
+        return true;
+}
+
+static bool
+test_redundant_state_changes_are_dropped (void)
+{
+        test_terminal_t test_terminal;
+        ply_text_display_t *display;
+        int i;
+
+        PLY_TEST_ASSERT (open_test_terminal (&test_terminal));
+        display = ply_text_display_new (test_terminal.terminal);
+
+        ply_text_display_hold_output (display);
+        ply_text_display_set_cursor_position (display, 2, 1);
+        ply_text_display_set_cursor_position (display, 2, 1);
+        for (i = 0; i < 3; i++) {
+                ply_text_display_set_background_color (display, PLY_TERMINAL_COLOR_BLUE);
+                ply_text_display_write (display, "%c", ' ');
+        }
+        /* writing text moves the cursor, so moving back isn't redundant */
+        ply_text_display_set_cursor_position (display, 2, 1);
+        ply_text_display_release_output (display);
+
+        PLY_TEST_ASSERT (read_output_matches (&test_terminal,
+                                              "\033[1;2f\033[44m   \033[1;2f"));
+
+        /* what the terminal was sent isn't trusted across batches */
+        ply_text_display_set_background_color (display, PLY_TERMINAL_COLOR_BLUE);
+        PLY_TEST_ASSERT (read_output_matches (&test_terminal, "\033[44m"));
+
+        /* raw writes may change colors behind our back */
+        ply_text_display_hold_output (display);
+        ply_text_display_set_background_color (display, PLY_TERMINAL_COLOR_BLUE);
+        ply_terminal_write (test_terminal.terminal, "%s", "\033[0m");
+        ply_text_display_set_background_color (display, PLY_TERMINAL_COLOR_BLUE);
+        ply_text_display_release_output (display);
+        PLY_TEST_ASSERT (read_output_matches (&test_terminal, "\033[44m\033[0m\033[44m"));
+
+        ply_text_display_free (display);
+        close_test_terminal (&test_terminal);
+        return true;
+}
+
+static size_t
+read_all_output (test_terminal_t *test_terminal,
+                 char            *output,
+                 size_t           output_size,
+                 const char      *last_output)
+{
+        ply_event_loop_t *loop = ply_event_loop_get_default ();
+        size_t size = 0;
+        int i;
+
+        /* Let the terminal drain its queue as the reader catches up */
+        for (i = 0; i < 10000; i++) {
+                ssize_t result;
+
+                while ((result = read (test_terminal->master_fd, output + size,
+                                       output_size - 1 - size)) > 0) {
+                        size += result;
+                }
+                output[size] = '\0';
+
+                if (strstr (output, last_output) != NULL)
+                        break;
+
+                ply_event_loop_process_pending_events (loop);
+        }
+
+        return size;
+}
+
+static bool
+test_slow_terminal_queues_output (void)
+{
+        test_terminal_t test_terminal;
+        static char output[1024 * 1024];
+        size_t size;
+        int i;
+
+        PLY_TEST_ASSERT (open_test_terminal (&test_terminal));
+
+        /* Nothing reads the other end, so most of this has to wait */
+        for (i = 0; i < 64; i++) {
+                ply_terminal_write (test_terminal.terminal, "%04d %1018s|", i, "");
+        }
+        ply_terminal_write (test_terminal.terminal, "%s", "end of log");
+
+        size = read_all_output (&test_terminal, output, sizeof(output), "end of log");
+        PLY_TEST_ASSERT (size == 64 * 1024 + strlen ("end of log"));
+        PLY_TEST_ASSERT (strncmp (output, "0000 ", 5) == 0);
+        PLY_TEST_ASSERT (strncmp (output + 63 * 1024, "0063 ", 5) == 0);
+
+        close_test_terminal (&test_terminal);
+        return true;
+}
+
+static bool
+test_backed_up_terminal_drops_stale_frames (void)
+{
+        test_terminal_t test_terminal;
+        static char output[4 * 1024 * 1024];
+        size_t size;
+        int i;
+
+        PLY_TEST_ASSERT (open_test_terminal (&test_terminal));
+
+        /* Far more frames than the terminal is allowed to queue up */
+        for (i = 0; i < 1024; i++) {
+                ply_terminal_hold_output (test_terminal.terminal);
+                ply_terminal_write (test_terminal.terminal, "[frame %04d %1011s]", i, "");
+                ply_terminal_release_output (test_terminal.terminal);
+        }
+
+        size = read_all_output (&test_terminal, output, sizeof(output), "[frame 1023 ");
+        PLY_TEST_ASSERT (size < 512 * 1024);
+        PLY_TEST_ASSERT (size % 1024 == 0);
+        PLY_TEST_ASSERT (strncmp (output, "[frame 0000 ", 12) == 0);
+        PLY_TEST_ASSERT (strncmp (output + size - 1024, "[frame 1023 ", 12) == 0);
+
+        close_test_terminal (&test_terminal);
+        return true;
+}
+
+static const ply_test_case_t test_cases[] =
+{
+        PLY_TEST_CASE (test_held_output_is_written_on_release),
+        PLY_TEST_CASE (test_redundant_state_changes_are_dropped),
+        PLY_TEST_CASE (test_slow_terminal_queues_output),
+        PLY_TEST_CASE (test_backed_up_terminal_drops_stale_frames),
+};
+
+PLY_TEST_MAIN (test_cases)
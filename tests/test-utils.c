@@ -195,6 +195,64 @@ test_utf8_iterator_and_removal (void)
         return true;
 }
 
+static bool
+test_last_screenful_accounts_for_wrapping (void)
+{
+        static const char short_text[] = "one\ntwo\n";
+        static const char long_text[] = "first\nsecond\n0123456789abcdefghij\nlast";
+        static const char colored_text[] = "old\n\033[0;32mgreen\033[0m line\nend";
+        const char *tail;
+
+        PLY_TEST_ASSERT (ply_utf8_string_get_offset_of_last_screenful (short_text, strlen (short_text), 10, 5) == 0);
+        PLY_TEST_ASSERT (ply_utf8_string_get_offset_of_last_screenful (short_text, strlen (short_text), 0, 0) == 0);
+
+        /* the 20 character line wraps onto two rows of 10 */
+        tail = long_text + ply_utf8_string_get_offset_of_last_screenful (long_text, strlen (long_text), 10, 3);
+        PLY_TEST_ASSERT (strcmp (tail, "0123456789abcdefghij\nlast") == 0);
+
+        /* only the second half of the wrapped line fits */
+        tail = long_text + ply_utf8_string_get_offset_of_last_screenful (long_text, strlen (long_text), 10, 2);
+        PLY_TEST_ASSERT (strcmp (tail, "abcdefghij\nlast") == 0);
+
+        /* escape sequences take up no columns */
+        tail = colored_text + ply_utf8_string_get_offset_of_last_screenful (colored_text, strlen (colored_text), 10, 2);
+        PLY_TEST_ASSERT (strncmp (tail, "\033[0;32mgreen", strlen ("\033[0;32mgreen")) == 0);
+
+        return true;
+}
+
+static bool
+test_last_sgr_sequence_stays_on_the_cut_line (void)
+{
+        static const char text[] = "\033[1mold\033[0m\n\033[0;32m0123456789\033[1mabcdefghij\033[0m\nend";
+        size_t offset, sequence_offset, sequence_size;
+
+        /* a cut part way through the colored line picks up the last
+         * sequence before it
+         */
+        offset = ply_utf8_string_get_offset_of_last_screenful (text, strlen (text), 10, 2);
+        PLY_TEST_ASSERT (strncmp (text + offset, "abcdefghij", strlen ("abcdefghij")) == 0);
+        PLY_TEST_ASSERT (ply_utf8_string_find_last_sgr_sequence (text, offset, &sequence_offset, &sequence_size));
+        PLY_TEST_ASSERT (sequence_size == strlen ("\033[1m"));
+        PLY_TEST_ASSERT (strncmp (text + sequence_offset, "\033[1m", sequence_size) == 0);
+
+        offset = strstr (text, "0123456789") - text + 5;
+        PLY_TEST_ASSERT (ply_utf8_string_find_last_sgr_sequence (text, offset, &sequence_offset, &sequence_size));
+        PLY_TEST_ASSERT (strncmp (text + sequence_offset, "\033[0;32m", sequence_size) == 0);
+
+        /* a cut at the start of a line has nothing to carry over, and
+         * earlier lines don't count
+         */
+        offset = strstr (text, "end") - text;
+        PLY_TEST_ASSERT (!ply_utf8_string_find_last_sgr_sequence (text, offset, &sequence_offset, &sequence_size));
+
+        /* nor does a sequence the cut runs through */
+        offset = strstr (text, "0;32m") - text + 2;
+        PLY_TEST_ASSERT (!ply_utf8_string_find_last_sgr_sequence (text, offset, &sequence_offset, &sequence_size));
+
+        return true;
+}
+
 static bool
 test_kernel_command_line_uses_token_boundaries (void)
 {
@@ -231,6 +289,8 @@ static const ply_test_case_t test_cases[] =
         PLY_TEST_CASE (test_socket_credentials_match_process),
         PLY_TEST_CASE (test_utf8_character_types_and_offsets),
         PLY_TEST_CASE (test_utf8_iterator_and_removal),
+        PLY_TEST_CASE (test_last_screenful_accounts_for_wrapping),
+        PLY_TEST_CASE (test_last_sgr_sequence_stays_on_the_cut_line),
         PLY_TEST_CASE (test_kernel_command_line_uses_token_boundaries),
 };
 